@@ -0,0 +1,105 @@
+/*
+ * Host-side Arduino core API.
+ * Declarations only; the behaviour lives in hostsim/runtime.
+ */
+#ifndef HOSTSIM_ARDUINO_H
+#define HOSTSIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <math.h>
+#include <limits.h>
+#include <float.h>
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define LED_BUILTIN 21
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define IRAM_ATTR
+#define PROGMEM
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef unsigned int word;
+
+#include "WString.h"
+#include "hostsim_site.h"
+
+/* Templates instead of the AVR macros so libstdc++ headers still compile. */
+template <typename A, typename B>
+inline auto min(A a, B b) -> decltype(a < b ? a : b) { return b < a ? b : a; }
+template <typename A, typename B>
+inline auto max(A a, B b) -> decltype(a < b ? a : b) { return a < b ? b : a; }
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+/* noInterrupts() records its line, so masked time can be charged to the call site. */
+void hostsim_no_interrupts(const char *site);
+#define noInterrupts() hostsim_no_interrupts(HOSTSIM_SITE)
+void interrupts(void);
+#define cli() noInterrupts()
+#define sei() interrupts()
+/* AVR status register. Only the I bit is modelled, enough for `s = SREG; cli(); ... SREG = s;`. */
+class HostSreg {
+ public:
+  operator uint8_t() const;
+  HostSreg &operator=(uint8_t value);
+};
+extern HostSreg SREG;
+
+void attachInterrupt(uint8_t interrupt_num, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t interrupt_num);
+#define digitalPinToInterrupt(p) (p)
+
+long random(long max_val);
+long random(long min_val, long max_val);
+void randomSeed(unsigned long seed);
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+inline bool isDigit(int c) { return isdigit(c) != 0; }
+inline bool isAlpha(int c) { return isalpha(c) != 0; }
+inline bool isSpace(int c) { return isspace(c) != 0; }
+inline bool isAlphaNumeric(int c) { return isalnum(c) != 0; }
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+#include "Print.h"
+#include "HardwareSerial.h"
+
+/* Sketch entry points. */
+void setup(void);
+void loop(void);
+
+#endif /* HOSTSIM_ARDUINO_H */
@@ -0,0 +1,45 @@
+/*
+ * Arduino Stream / HardwareSerial. The host Serial reads from a scripted
+ * input queue and records everything written to it.
+ */
+#ifndef HOSTSIM_HARDWARESERIAL_H
+#define HOSTSIM_HARDWARESERIAL_H
+
+#include "Print.h"
+
+class Stream : public Print {
+ public:
+  virtual int available(void) = 0;
+  virtual int read(void) = 0;
+  virtual int peek(void) = 0;
+
+  void setTimeout(unsigned long timeout_ms) { timeout_ms_ = timeout_ms; }
+  size_t readBytes(char *buffer, size_t length);
+  size_t readBytesUntil(char terminator, char *buffer, size_t length);
+  String readString(void);
+  String readStringUntil(char terminator);
+  long parseInt(void);
+  float parseFloat(void);
+
+ protected:
+  int timedRead(void);
+  int timedPeek(void);
+  unsigned long timeout_ms_ = 1000;
+};
+
+class HardwareSerial : public Stream {
+ public:
+  void begin(unsigned long baud);
+  void end(void);
+  int available(void) override;
+  int read(void) override;
+  int peek(void) override;
+  void flush(void);
+  size_t write(uint8_t c) override;
+  using Print::write;
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif /* HOSTSIM_HARDWARESERIAL_H */
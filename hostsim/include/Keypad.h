@@ -0,0 +1,30 @@
+/*
+ * Matrix keypad. Key presses come from the scripted input queue.
+ */
+#ifndef HOSTSIM_KEYPAD_H
+#define HOSTSIM_KEYPAD_H
+
+#include "Arduino.h"
+
+#define NO_KEY '\0'
+#define makeKeymap(x) ((char *)(x))
+
+typedef enum { IDLE, PRESSED, HOLD, RELEASED } KeyState;
+
+class Keypad {
+ public:
+  Keypad(char *user_keymap, byte *row, byte *col, byte num_rows, byte num_cols);
+  char getKey(void);
+  char waitForKey(void);
+  KeyState getState(void);
+  void setDebounceTime(unsigned int debounce_ms);
+  void setHoldTime(unsigned int hold_ms);
+
+ private:
+  char *keymap_;
+  byte rows_;
+  byte cols_;
+  KeyState state_ = IDLE;
+};
+
+#endif /* HOSTSIM_KEYPAD_H */
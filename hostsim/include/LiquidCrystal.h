@@ -0,0 +1,18 @@
+/*
+ * HD44780 16x2 character LCD, parallel 4/8-bit wiring.
+ */
+#ifndef HOSTSIM_LIQUIDCRYSTAL_H
+#define HOSTSIM_LIQUIDCRYSTAL_H
+
+#include "Arduino.h"
+#include "hostsim_lcd.h"
+
+class LiquidCrystal : public HostLcd {
+ public:
+  LiquidCrystal(uint8_t rs, uint8_t enable, uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7);
+  LiquidCrystal(uint8_t rs, uint8_t rw, uint8_t enable, uint8_t d4, uint8_t d5, uint8_t d6,
+                uint8_t d7);
+  void begin(uint8_t cols, uint8_t rows);
+};
+
+#endif /* HOSTSIM_LIQUIDCRYSTAL_H */
@@ -0,0 +1,20 @@
+/*
+ * HD44780 16x2 character LCD behind a PCF8574 I2C backpack.
+ */
+#ifndef HOSTSIM_LIQUIDCRYSTAL_I2C_H
+#define HOSTSIM_LIQUIDCRYSTAL_I2C_H
+
+#include "Arduino.h"
+#include "hostsim_lcd.h"
+
+class LiquidCrystal_I2C : public HostLcd {
+ public:
+  LiquidCrystal_I2C(uint8_t addr, uint8_t cols, uint8_t rows);
+  void init(void);
+  void begin(void);
+  void begin(uint8_t cols, uint8_t rows);
+  void backlight(void);
+  void noBacklight(void);
+};
+
+#endif /* HOSTSIM_LIQUIDCRYSTAL_I2C_H */
@@ -0,0 +1,55 @@
+/*
+ * Arduino Print base class. Subclasses only implement write(uint8_t).
+ */
+#ifndef HOSTSIM_PRINT_H
+#define HOSTSIM_PRINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "WString.h"
+
+class __FlashStringHelper;
+
+class Print {
+ public:
+  virtual ~Print() = default;
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str);
+  size_t write(const char *buffer, size_t size);
+
+  size_t print(const __FlashStringHelper *str);
+  size_t print(const String &s);
+  size_t print(const char *str);
+  size_t print(char c);
+  size_t print(unsigned char n, int base = 10);
+  size_t print(int n, int base = 10);
+  size_t print(unsigned int n, int base = 10);
+  size_t print(long n, int base = 10);
+  size_t print(unsigned long n, int base = 10);
+  size_t print(long long n, int base = 10);
+  size_t print(unsigned long long n, int base = 10);
+  size_t print(double n, int digits = 2);
+
+  size_t println(const __FlashStringHelper *str);
+  size_t println(const String &s);
+  size_t println(const char *str);
+  size_t println(char c);
+  size_t println(unsigned char n, int base = 10);
+  size_t println(int n, int base = 10);
+  size_t println(unsigned int n, int base = 10);
+  size_t println(long n, int base = 10);
+  size_t println(unsigned long n, int base = 10);
+  size_t println(long long n, int base = 10);
+  size_t println(unsigned long long n, int base = 10);
+  size_t println(double n, int digits = 2);
+  size_t println(void);
+
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+ private:
+  size_t printNumber(unsigned long long n, int base);
+};
+
+#endif /* HOSTSIM_PRINT_H */
@@ -0,0 +1,101 @@
+/*
+ * Arduino String, backed by std::string on the host.
+ */
+#ifndef HOSTSIM_WSTRING_H
+#define HOSTSIM_WSTRING_H
+
+#include <string>
+
+class __FlashStringHelper;
+
+class String {
+ public:
+  String(const char *cstr = "");
+  String(const String &other) = default;
+  String(const __FlashStringHelper *str);
+  explicit String(char c);
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(float value, unsigned char decimal_places = 2);
+  explicit String(double value, unsigned char decimal_places = 2);
+
+  String &operator=(const String &rhs) = default;
+  String &operator=(const char *cstr);
+
+  unsigned int length(void) const { return static_cast<unsigned int>(buf_.size()); }
+  bool isEmpty(void) const { return buf_.empty(); }
+  const char *c_str(void) const { return buf_.c_str(); }
+  bool reserve(unsigned int size);
+
+  bool concat(const String &str);
+  bool concat(const char *cstr);
+  bool concat(char c);
+  bool concat(int num);
+  bool concat(unsigned int num);
+  bool concat(long num);
+  bool concat(unsigned long num);
+  bool concat(double num);
+
+  String &operator+=(const String &rhs) { concat(rhs); return *this; }
+  String &operator+=(const char *cstr) { concat(cstr); return *this; }
+  String &operator+=(char c) { concat(c); return *this; }
+  String &operator+=(int num) { concat(num); return *this; }
+  String &operator+=(unsigned int num) { concat(num); return *this; }
+  String &operator+=(long num) { concat(num); return *this; }
+  String &operator+=(unsigned long num) { concat(num); return *this; }
+  String &operator+=(double num) { concat(num); return *this; }
+
+  friend String operator+(const String &lhs, const String &rhs);
+  friend String operator+(const String &lhs, const char *rhs);
+  friend String operator+(const String &lhs, char rhs);
+  friend String operator+(const String &lhs, int rhs);
+  friend String operator+(const String &lhs, unsigned int rhs);
+  friend String operator+(const String &lhs, long rhs);
+  friend String operator+(const String &lhs, unsigned long rhs);
+  friend String operator+(const String &lhs, double rhs);
+  friend String operator+(const char *lhs, const String &rhs);
+
+  bool equals(const String &s) const { return buf_ == s.buf_; }
+  bool equals(const char *cstr) const { return buf_ == cstr; }
+  bool equalsIgnoreCase(const String &s) const;
+  bool operator==(const String &rhs) const { return equals(rhs); }
+  bool operator==(const char *cstr) const { return equals(cstr); }
+  bool operator!=(const String &rhs) const { return !equals(rhs); }
+  bool operator!=(const char *cstr) const { return !equals(cstr); }
+  bool startsWith(const String &prefix) const;
+  bool endsWith(const String &suffix) const;
+
+  char charAt(unsigned int index) const;
+  void setCharAt(unsigned int index, char c);
+  char operator[](unsigned int index) const { return charAt(index); }
+  char &operator[](unsigned int index);
+  void getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index = 0) const;
+  void toCharArray(char *buf, unsigned int bufsize, unsigned int index = 0) const;
+
+  int indexOf(char ch, unsigned int from_index = 0) const;
+  int indexOf(const String &str, unsigned int from_index = 0) const;
+  int lastIndexOf(char ch) const;
+  int lastIndexOf(const String &str) const;
+  String substring(unsigned int begin_index) const;
+  String substring(unsigned int begin_index, unsigned int end_index) const;
+
+  void replace(char find, char replace_with);
+  void replace(const String &find, const String &replace_with);
+  void remove(unsigned int index);
+  void remove(unsigned int index, unsigned int count);
+  void toLowerCase(void);
+  void toUpperCase(void);
+  void trim(void);
+
+  long toInt(void) const;
+  float toFloat(void) const;
+  double toDouble(void) const;
+
+ private:
+  std::string buf_;
+};
+
+#endif /* HOSTSIM_WSTRING_H */
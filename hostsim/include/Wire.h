@@ -0,0 +1,26 @@
+/*
+ * Arduino TwoWire (I2C master).
+ */
+#ifndef HOSTSIM_WIRE_H
+#define HOSTSIM_WIRE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class TwoWire {
+ public:
+  void begin(void);
+  void begin(int sda, int scl);
+  void setClock(uint32_t hz);
+  void beginTransmission(uint8_t address);
+  uint8_t endTransmission(bool send_stop = true);
+  size_t write(uint8_t data);
+  size_t write(const uint8_t *data, size_t length);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity);
+  int available(void);
+  int read(void);
+};
+
+extern TwoWire Wire;
+
+#endif /* HOSTSIM_WIRE_H */
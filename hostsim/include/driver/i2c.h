@@ -0,0 +1,46 @@
+/*
+ * ESP-IDF legacy I2C master driver for the host shim.
+ */
+#ifndef HOSTSIM_DRIVER_I2C_H
+#define HOSTSIM_DRIVER_I2C_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int i2c_port_t;
+#define I2C_NUM_0 0
+#define I2C_NUM_1 1
+
+typedef enum { I2C_MODE_SLAVE = 0, I2C_MODE_MASTER = 1 } i2c_mode_t;
+
+typedef struct {
+    i2c_mode_t mode;
+    int sda_io_num;
+    int scl_io_num;
+    bool sda_pullup_en;
+    bool scl_pullup_en;
+    struct {
+        uint32_t clk_speed;
+    } master;
+    uint32_t clk_flags;
+} i2c_config_t;
+
+esp_err_t i2c_param_config(i2c_port_t port, const i2c_config_t *conf);
+esp_err_t i2c_driver_install(i2c_port_t port, i2c_mode_t mode, size_t slv_rx_buf_len,
+                             size_t slv_tx_buf_len, int intr_alloc_flags);
+esp_err_t i2c_driver_delete(i2c_port_t port);
+esp_err_t i2c_master_write_to_device(i2c_port_t port, uint8_t address, const uint8_t *data,
+                                     size_t length, TickType_t ticks_to_wait);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOSTSIM_DRIVER_I2C_H */
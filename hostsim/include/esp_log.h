@@ -0,0 +1,26 @@
+/*
+ * ESP-IDF logging. Log lines are recorded as device output.
+ */
+#ifndef HOSTSIM_ESP_LOG_H
+#define HOSTSIM_ESP_LOG_H
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void hostsim_log(char level, const char *tag, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#define ESP_LOGE(tag, format, ...) hostsim_log('E', tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) hostsim_log('W', tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) hostsim_log('I', tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) hostsim_log('D', tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) hostsim_log('V', tag, format, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOSTSIM_ESP_LOG_H */
@@ -0,0 +1,61 @@
+/*
+ * FreeRTOS kernel types and configuration for the host shim.
+ */
+#ifndef HOSTSIM_FREERTOS_H
+#define HOSTSIM_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "hostsim_site.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+
+#define configTICK_RATE_HZ 1000
+#define configMAX_PRIORITIES 25
+#define configMINIMAL_STACK_SIZE 768
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portTICK_RATE_MS portTICK_PERIOD_MS
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+#define tskIDLE_PRIORITY ((UBaseType_t)0U)
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+typedef struct {
+    volatile uint32_t owner;
+    volatile uint32_t count;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0, 0}
+#define portMUX_FREE_VAL 0
+
+#define IRAM_ATTR
+
+/* Single simulated core: the mux argument is accepted but the whole CPU is masked. */
+void hostsim_port_enter_critical(const char *site);
+void hostsim_port_exit_critical(const char *site);
+void hostsim_port_yield_from_isr(void);
+
+#define portENTER_CRITICAL(...) hostsim_port_enter_critical(HOSTSIM_SITE)
+#define portEXIT_CRITICAL(...) hostsim_port_exit_critical(HOSTSIM_SITE)
+#define portENTER_CRITICAL_ISR(...) hostsim_port_enter_critical(HOSTSIM_SITE)
+#define portEXIT_CRITICAL_ISR(...) hostsim_port_exit_critical(HOSTSIM_SITE)
+#define portYIELD_FROM_ISR(...) hostsim_port_yield_from_isr()
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOSTSIM_FREERTOS_H */
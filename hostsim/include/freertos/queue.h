@@ -0,0 +1,34 @@
+/*
+ * FreeRTOS queue API for the host shim.
+ */
+#ifndef HOSTSIM_FREERTOS_QUEUE_H
+#define HOSTSIM_FREERTOS_QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct hostsim_queue *QueueHandle_t;
+typedef QueueHandle_t xQueueHandle;
+
+QueueHandle_t hostsim_queue_create(UBaseType_t length, UBaseType_t item_size, const char *site);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait);
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait);
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait);
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *higher_prio_woken);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *buffer, TickType_t ticks_to_wait);
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void *buffer, BaseType_t *higher_prio_woken);
+BaseType_t xQueuePeek(QueueHandle_t queue, void *buffer, TickType_t ticks_to_wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+BaseType_t xQueueReset(QueueHandle_t queue);
+
+#define xQueueCreate(length, item_size) hostsim_queue_create((length), (item_size), HOSTSIM_SITE)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOSTSIM_FREERTOS_QUEUE_H */
@@ -0,0 +1,39 @@
+/*
+ * FreeRTOS semaphore/mutex API for the host shim.
+ */
+#ifndef HOSTSIM_FREERTOS_SEMPHR_H
+#define HOSTSIM_FREERTOS_SEMPHR_H
+
+#include "freertos/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+/* is_mutex: 0 semaphore, 1 mutex, 2 recursive mutex */
+SemaphoreHandle_t hostsim_semaphore_create(int is_mutex, UBaseType_t max_count, UBaseType_t initial,
+                                           const char *name);
+BaseType_t hostsim_semaphore_take(SemaphoreHandle_t sem, TickType_t ticks_to_wait, const char *site);
+BaseType_t hostsim_semaphore_give(SemaphoreHandle_t sem, const char *site);
+BaseType_t hostsim_semaphore_take_recursive(SemaphoreHandle_t sem, TickType_t ticks_to_wait, const char *site);
+BaseType_t hostsim_semaphore_give_recursive(SemaphoreHandle_t sem, const char *site);
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *higher_prio_woken);
+BaseType_t xSemaphoreTakeFromISR(SemaphoreHandle_t sem, BaseType_t *higher_prio_woken);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+
+#define xSemaphoreCreateMutex() hostsim_semaphore_create(1, 1, 1, HOSTSIM_SITE)
+#define xSemaphoreCreateRecursiveMutex() hostsim_semaphore_create(2, 1, 1, HOSTSIM_SITE)
+#define xSemaphoreCreateBinary() hostsim_semaphore_create(0, 1, 0, HOSTSIM_SITE)
+#define xSemaphoreCreateCounting(max, init) hostsim_semaphore_create(0, (max), (init), HOSTSIM_SITE)
+#define xSemaphoreTake(sem, ticks) hostsim_semaphore_take((sem), (ticks), HOSTSIM_SITE)
+#define xSemaphoreGive(sem) hostsim_semaphore_give((sem), HOSTSIM_SITE)
+#define xSemaphoreTakeRecursive(sem, ticks) hostsim_semaphore_take_recursive((sem), (ticks), HOSTSIM_SITE)
+#define xSemaphoreGiveRecursive(sem) hostsim_semaphore_give_recursive((sem), HOSTSIM_SITE)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOSTSIM_FREERTOS_SEMPHR_H */
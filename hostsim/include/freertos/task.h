@@ -0,0 +1,40 @@
+/*
+ * FreeRTOS task API for the host shim.
+ */
+#ifndef HOSTSIM_FREERTOS_TASK_H
+#define HOSTSIM_FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct hostsim_task *TaskHandle_t;
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stack_depth,
+                       void *params, UBaseType_t priority, TaskHandle_t *created_task);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char *name, uint32_t stack_depth,
+                                   void *params, UBaseType_t priority, TaskHandle_t *created_task,
+                                   BaseType_t core_id);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t period);
+TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+void vTaskSuspendAll(void);
+BaseType_t xTaskResumeAll(void);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+void taskYIELD(void);
+
+#define taskENTER_CRITICAL(...) portENTER_CRITICAL(__VA_ARGS__)
+#define taskEXIT_CRITICAL(...) portEXIT_CRITICAL(__VA_ARGS__)
+#define taskENTER_CRITICAL_ISR(...) portENTER_CRITICAL_ISR(__VA_ARGS__)
+#define taskEXIT_CRITICAL_ISR(...) portEXIT_CRITICAL_ISR(__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOSTSIM_FREERTOS_TASK_H */
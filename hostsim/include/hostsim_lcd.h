@@ -0,0 +1,35 @@
+/*
+ * Shared HD44780 model used by every LCD driver on the host.
+ */
+#ifndef HOSTSIM_HOSTSIM_LCD_H
+#define HOSTSIM_HOSTSIM_LCD_H
+
+#include "Print.h"
+
+namespace hostsim {
+class Lcd;
+}
+
+class HostLcd : public Print {
+ public:
+  HostLcd(uint8_t cols, uint8_t rows);
+  ~HostLcd() override;
+  HostLcd(const HostLcd &) = delete;
+  HostLcd &operator=(const HostLcd &) = delete;
+  void clear(void);
+  void home(void);
+  void setCursor(uint8_t col, uint8_t row);
+  void display(void);
+  void noDisplay(void);
+  void cursor(void);
+  void noCursor(void);
+  void blink(void);
+  void noBlink(void);
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+ protected:
+  hostsim::Lcd *model_;
+};
+
+#endif /* HOSTSIM_HOSTSIM_LCD_H */
@@ -0,0 +1,12 @@
+/*
+ * Call-site string ("file:line") the shim macros pass to the runtime, so the
+ * trace can say which line created a semaphore or masked interrupts.
+ */
+#ifndef HOSTSIM_SITE_H
+#define HOSTSIM_SITE_H
+
+#define HOSTSIM_STR2(x) #x
+#define HOSTSIM_STR(x) HOSTSIM_STR2(x)
+#define HOSTSIM_SITE __FILE__ ":" HOSTSIM_STR(__LINE__)
+
+#endif /* HOSTSIM_SITE_H */
@@ -0,0 +1,26 @@
+/*
+ * Parallel HD44780 16x2 LCD component used by the ESP-IDF sketches.
+ * Not an ESP-IDF API; the signatures follow how the generated code calls it.
+ */
+#ifndef HOSTSIM_LCD_H
+#define HOSTSIM_LCD_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct hostsim_lcd_handle *LCD_Handle_t;
+
+LCD_Handle_t lcd_create(int rs, int en, int d4, int d5, int d6, int d7);
+int lcd_init(LCD_Handle_t lcd, uint8_t cols, uint8_t rows);
+int lcd_clear(LCD_Handle_t lcd);
+int lcd_set_cursor(LCD_Handle_t lcd, uint8_t col, uint8_t row);
+int lcd_print(LCD_Handle_t lcd, const char *str);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOSTSIM_LCD_H */
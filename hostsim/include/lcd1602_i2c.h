@@ -0,0 +1,32 @@
+/*
+ * LCD1602 over a PCF8574 I2C backpack, as used by the ESP-IDF sketches.
+ * Not an ESP-IDF API; the signatures follow how the generated code calls it.
+ */
+#ifndef HOSTSIM_LCD1602_I2C_H
+#define HOSTSIM_LCD1602_I2C_H
+
+#include <stdint.h>
+#include "driver/i2c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    i2c_port_t port;
+    uint8_t address;
+    uint8_t col;
+    uint8_t row;
+    void *model;
+} lcd1602_t;
+
+esp_err_t lcd1602_init(lcd1602_t *lcd, i2c_port_t port, uint8_t address);
+esp_err_t lcd1602_clear(lcd1602_t *lcd);
+esp_err_t lcd1602_set_cursor(lcd1602_t *lcd, uint8_t row, uint8_t col);
+esp_err_t lcd1602_puts(lcd1602_t *lcd, const char *str);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOSTSIM_LCD1602_I2C_H */
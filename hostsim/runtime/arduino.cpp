@@ -0,0 +1,343 @@
+/*
+ * Arduino core API on the virtual clock: pins, time, interrupts, Serial, Keypad, Wire.
+ */
+#include <algorithm>
+
+#include "Arduino.h"
+#include "Keypad.h"
+#include "Wire.h"
+#include "hostsim_runtime.h"
+
+using hostsim::dev;
+using hostsim::Time;
+
+/* ------- pins */
+void pinMode(uint8_t pin, uint8_t mode) {
+  hostsim::call();
+  hostsim::set_pin_mode(pin, mode);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) { hostsim::write_pin(pin, val); }
+
+int digitalRead(uint8_t pin) { return hostsim::read_pin(pin); }
+
+int analogRead(uint8_t pin) {
+  if (pin >= hostsim::kMaxPins || !dev->pins[pin].driven) {
+    hostsim::poll_empty();
+    return 0;
+  }
+  hostsim::Pin &p = dev->pins[pin];
+  if (p.last_read == p.in) {
+    hostsim::poll_empty();
+  } else {
+    p.last_read = p.in;
+    hostsim::note_input(p.stim);
+    hostsim::call();
+    hostsim::activity();
+  }
+  return p.in;
+}
+
+void analogWrite(uint8_t pin, int val) {
+  hostsim::call();
+  if (pin >= hostsim::kMaxPins) return;
+  hostsim::Pin &p = dev->pins[pin];
+  if (p.out == val) return;
+  p.out = val;
+  hostsim::emit("pwm", std::to_string(pin) + " " + std::to_string(val));
+}
+
+/* ------- time */
+unsigned long millis(void) {
+  hostsim::poll_empty(true);
+  return static_cast<unsigned long>(dev->now / 1000);
+}
+
+unsigned long micros(void) {
+  hostsim::poll_empty(true);
+  return static_cast<unsigned long>(dev->now);
+}
+
+void delay(unsigned long ms) {
+  dev->api_calls++;
+  hostsim::sleep_for(static_cast<Time>(ms) * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  dev->api_calls++;
+  hostsim::advance(us);
+}
+
+void yield(void) { hostsim::poll_empty(); }
+
+/* ------- interrupts */
+void hostsim_no_interrupts(const char *site) {
+  hostsim::call();
+  hostsim::irq_disable(site);
+}
+
+void interrupts(void) {
+  hostsim::call();
+  hostsim::irq_enable();
+}
+
+HostSreg SREG;
+
+HostSreg::operator uint8_t() const { return dev->irq_enabled ? 0x80 : 0x00; }
+
+HostSreg &HostSreg::operator=(uint8_t value) {
+  if (value & 0x80) {
+    hostsim::irq_enable();
+  } else {
+    hostsim::irq_disable("SREG");
+  }
+  return *this;
+}
+
+void attachInterrupt(uint8_t interrupt_num, void (*isr)(void), int mode) {
+  hostsim::call();
+  if (interrupt_num >= hostsim::kMaxPins) return;
+  dev->pins[interrupt_num].isr = isr;
+  dev->pins[interrupt_num].isr_mode = mode;
+}
+
+void detachInterrupt(uint8_t interrupt_num) {
+  hostsim::call();
+  if (interrupt_num < hostsim::kMaxPins) dev->pins[interrupt_num].isr = nullptr;
+}
+
+/* ------- math */
+long random(long max_val) {
+  if (max_val <= 0) return 0;
+  uint32_t x = dev->rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  dev->rng = x;
+  return static_cast<long>(x % static_cast<uint32_t>(max_val));
+}
+
+long random(long min_val, long max_val) {
+  return min_val >= max_val ? min_val : min_val + random(max_val - min_val);
+}
+
+void randomSeed(unsigned long seed) {
+  if (seed != 0) dev->rng = static_cast<uint32_t>(seed);
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  if (in_max == in_min) return out_min;
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+/* ------- Stream */
+int Stream::timedRead(void) {
+  Time deadline = dev->now + static_cast<Time>(timeout_ms_) * 1000;
+  for (;;) {
+    if (available() > 0) return read();
+    if (dev->now >= deadline) return -1;
+    hostsim::spin_until(deadline);
+  }
+}
+
+int Stream::timedPeek(void) {
+  Time deadline = dev->now + static_cast<Time>(timeout_ms_) * 1000;
+  for (;;) {
+    if (available() > 0) return peek();
+    if (dev->now >= deadline) return -1;
+    hostsim::spin_until(deadline);
+  }
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+  size_t n = 0;
+  while (n < length) {
+    int c = timedRead();
+    if (c < 0) break;
+    buffer[n++] = static_cast<char>(c);
+  }
+  return n;
+}
+
+size_t Stream::readBytesUntil(char terminator, char *buffer, size_t length) {
+  size_t n = 0;
+  while (n < length) {
+    int c = timedRead();
+    if (c < 0 || c == terminator) break;
+    buffer[n++] = static_cast<char>(c);
+  }
+  return n;
+}
+
+String Stream::readString(void) {
+  String s;
+  for (int c = timedRead(); c >= 0; c = timedRead()) s += static_cast<char>(c);
+  return s;
+}
+
+String Stream::readStringUntil(char terminator) {
+  String s;
+  for (int c = timedRead(); c >= 0 && c != terminator; c = timedRead()) s += static_cast<char>(c);
+  return s;
+}
+
+/* Arduino semantics: skip anything that cannot start a number, stop at the first non-digit. */
+long Stream::parseInt(void) {
+  int c = timedPeek();
+  while (c >= 0 && c != '-' && !isdigit(c)) {
+    read();
+    c = timedPeek();
+  }
+  if (c < 0) return 0;
+  bool negative = false;
+  long value = 0;
+  if (c == '-') {
+    negative = true;
+    read();
+    c = timedPeek();
+  }
+  while (c >= 0 && isdigit(c)) {
+    value = value * 10 + (c - '0');
+    read();
+    c = timedPeek();
+  }
+  return negative ? -value : value;
+}
+
+float Stream::parseFloat(void) {
+  int c = timedPeek();
+  while (c >= 0 && c != '-' && c != '.' && !isdigit(c)) {
+    read();
+    c = timedPeek();
+  }
+  std::string text;
+  while (c >= 0 && (isdigit(c) || c == '.' || (c == '-' && text.empty()))) {
+    text += static_cast<char>(c);
+    read();
+    c = timedPeek();
+  }
+  return text.empty() ? 0.0f : strtof(text.c_str(), nullptr);
+}
+
+/* ------- HardwareSerial */
+HardwareSerial Serial;
+
+void HardwareSerial::begin(unsigned long baud) {
+  hostsim::call();
+  dev->serial_baud = baud ? baud : 115200;
+}
+
+void HardwareSerial::end(void) { hostsim::call(); }
+
+int HardwareSerial::available(void) {
+  if (dev->serial_rx.empty()) {
+    hostsim::poll_empty();
+    return 0;
+  }
+  hostsim::call();
+  return static_cast<int>(dev->serial_rx.size());
+}
+
+int HardwareSerial::read(void) {
+  if (dev->serial_rx.empty()) {
+    hostsim::poll_empty();
+    return -1;
+  }
+  hostsim::call();
+  hostsim::activity();
+  return hostsim::pop_serial();
+}
+
+int HardwareSerial::peek(void) {
+  if (dev->serial_rx.empty()) {
+    hostsim::poll_empty();
+    return -1;
+  }
+  hostsim::call();
+  return dev->serial_rx.front();
+}
+
+void HardwareSerial::flush(void) {
+  dev->api_calls++;
+  if (dev->serial_tx_busy > dev->now) hostsim::advance_to(dev->serial_tx_busy);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  hostsim::uart_write(c);
+  return 1;
+}
+
+/* ------- Keypad: key presses come from `key` script events */
+Keypad::Keypad(char *user_keymap, byte *, byte *, byte num_rows, byte num_cols)
+    : keymap_(user_keymap), rows_(num_rows), cols_(num_cols) {
+  dev->keypad = true;
+}
+
+char Keypad::getKey(void) {
+  if (!hostsim::key_ready()) {
+    state_ = IDLE;
+    hostsim::poll_empty();
+    return NO_KEY;
+  }
+  hostsim::call();
+  hostsim::activity();
+  char key = hostsim::pop_key();
+  state_ = PRESSED;
+  return key;
+}
+
+char Keypad::waitForKey(void) {
+  char key = NO_KEY;
+  while ((key = getKey()) == NO_KEY) {
+  }
+  return key;
+}
+
+KeyState Keypad::getState(void) {
+  hostsim::call();
+  return state_;
+}
+
+void Keypad::setDebounceTime(unsigned int) { hostsim::call(); }
+void Keypad::setHoldTime(unsigned int) { hostsim::call(); }
+
+/* ------- Wire: every address acks, reads return nothing */
+TwoWire Wire;
+
+void TwoWire::begin(void) { hostsim::call(); }
+void TwoWire::begin(int, int) { hostsim::call(); }
+void TwoWire::setClock(uint32_t hz) {
+  hostsim::call();
+  if (hz) dev->i2c_hz = hz;
+}
+void TwoWire::beginTransmission(uint8_t) { hostsim::call(); }
+
+uint8_t TwoWire::endTransmission(bool) {
+  hostsim::call();
+  return 0;
+}
+
+size_t TwoWire::write(uint8_t) {
+  hostsim::call();
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *, size_t length) {
+  hostsim::call();
+  return length;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t, uint8_t) {
+  hostsim::call();
+  return 0;
+}
+
+int TwoWire::available(void) {
+  hostsim::poll_empty();
+  return 0;
+}
+
+int TwoWire::read(void) {
+  hostsim::poll_empty();
+  return -1;
+}
@@ -0,0 +1,54 @@
+/*
+ * stdio console on UART0, as ESP-IDF sets it up: printf goes out at the baud
+ * rate next to Serial, and reads from stdin block until script input arrives
+ * (the blocking VFS UART driver).
+ */
+#include <cstdio>
+
+#include "hostsim_runtime.h"
+
+using hostsim::dev;
+
+namespace {
+
+ssize_t console_write(void *, const char *buf, size_t size) {
+  for (size_t i = 0; i < size; i++) hostsim::uart_write(static_cast<uint8_t>(buf[i]));
+  return static_cast<ssize_t>(size);
+}
+
+ssize_t console_read(void *, char *buf, size_t size) {
+  /* a prompt without '\n' is on the terminal by the time the program waits for the answer */
+  if (dev->serial_rx.empty() && !dev->serial_line.empty()) {
+    hostsim::emit("serial", dev->serial_line);
+    dev->serial_line.clear();
+  }
+  while (dev->serial_rx.empty()) hostsim::wait_input();
+  hostsim::call();
+  hostsim::activity();
+  size_t n = 0;
+  while (n < size && !dev->serial_rx.empty()) buf[n++] = static_cast<char>(hostsim::pop_serial());
+  return static_cast<ssize_t>(n);
+}
+
+}  // namespace
+
+namespace hostsim {
+
+FILE *open_console(bool output) {
+  cookie_io_functions_t io{};
+  if (output) {
+    io.write = console_write;
+  } else {
+    io.read = console_read;
+  }
+  FILE *fp = fopencookie(nullptr, output ? "w" : "r", io);
+  /*
+   * Line-buffered stdout like newlib's, which also keeps glibc from putting an
+   * 8 KB scratch buffer on the task stack for every printf. Reading stdin
+   * flushes it first, so prompts still come out before the program blocks.
+   */
+  if (fp) setvbuf(fp, nullptr, output ? _IOLBF : _IONBF, output ? 256 : 0);
+  return fp;
+}
+
+}  // namespace hostsim
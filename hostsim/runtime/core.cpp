@@ -0,0 +1,565 @@
+/*
+ * Virtual clock, scripted input events, interrupt mask and the output trace.
+ */
+#include "hostsim_runtime.h"
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "Arduino.h"
+
+namespace hostsim {
+
+/* constructed before the sketch's global LCD/Keypad objects register themselves */
+static Device g_device __attribute__((init_priority(101)));
+Device *dev = &g_device;
+
+Device::~Device() {
+  if (stack) munmap(stack, stack_size);
+}
+
+namespace {
+
+struct EventLater {
+  bool operator()(const Event &a, const Event &b) const {
+    return a.t != b.t ? a.t > b.t : a.seq > b.seq;
+  }
+};
+
+int idle_level(const Pin &p) { return p.mode == INPUT_PULLUP ? HIGH : LOW; }
+
+/* Offset of a sketch function in the executable, for addr2line; -1 when unknown. */
+long code_offset(const void *fn) {
+  Dl_info info;
+  if (!fn || !dladdr(fn, &info)) return -1;
+  return static_cast<const char *>(fn) - static_cast<const char *>(info.dli_fbase);
+}
+
+void run_isr(int pin) {
+  Pin &p = dev->pins[pin];
+  note_input(p.stim);
+  if (!dev->timeline.ring.empty()) {
+    mark(Mark::IsrBegin, pin, 0,
+         code_offset(p.isr ? reinterpret_cast<const void *>(p.isr) : reinterpret_cast<const void *>(p.handler)));
+  }
+  dev->in_isr = true;
+  if (p.isr) p.isr();
+  if (p.handler) p.handler(p.handler_arg);
+  dev->in_isr = false;
+  mark(Mark::IsrEnd, pin);
+}
+
+void drive_pin(int pin, int level, int id) {
+  if (pin < 0 || pin >= kMaxPins) return;
+  Pin &p = dev->pins[pin];
+  int before = pin_level(pin);
+  p.in = level;
+  p.driven = true;
+  p.stim = id;
+  int after = pin_level(pin);
+  if (before == after || !(p.isr || p.handler)) return;
+  bool fire = p.isr_mode == CHANGE || (p.isr_mode == RISING && after == HIGH) ||
+              (p.isr_mode == FALLING && after == LOW);
+  if (!fire) return;
+  if (dev->irq_enabled && !dev->in_isr) {
+    run_isr(pin);
+  } else if (std::find(dev->pending_irq.begin(), dev->pending_irq.end(), pin) ==
+             dev->pending_irq.end()) {
+    dev->pending_irq.push_back(pin);
+  }
+}
+
+/*
+ * "file:line 0x1a2b,0x1c00,..." for a span that starts now: the masking line,
+ * plus the return addresses (offsets into the executable) of the frames above
+ * it, so a wrapper like EnterCriticalSection() can be charged to its callers.
+ */
+std::string mask_key(const char *site) {
+  /* the sketch is compiled from a temp dir; the line number is what matters */
+  if (const char *slash = strrchr(site, '/')) site = slash + 1;
+  std::string key = site;
+  if (!dev->trace_masks) return key;
+  Dl_info self;
+  if (!dladdr(reinterpret_cast<void *>(&mask_key), &self)) return key;
+  void *frames[12];
+  int n = backtrace(frames, 12);
+  char sep = ' ';
+  for (int i = 1; i < n; i++) {
+    Dl_info info;
+    if (!dladdr(frames[i], &info) || info.dli_fbase != self.dli_fbase) continue;
+    char offset[24];
+    snprintf(offset, sizeof(offset), "%c%#lx", sep,
+             static_cast<unsigned long>(static_cast<char *>(frames[i]) - static_cast<char *>(info.dli_fbase)));
+    key += offset;
+    sep = ',';
+  }
+  return key;
+}
+
+/* Closes the masked span that started at masked_since and charges it to its site. */
+void end_mask(bool open) {
+  MaskStats &m = dev->masks[dev->mask_key];
+  Time us = dev->now - dev->masked_since;
+  int bucket = 0;
+  for (Time limit = 10; bucket < MaskStats::kBuckets - 1 && us >= limit; limit *= 10) bucket++;
+  m.count++;
+  m.total += us;
+  m.max = std::max(m.max, us);
+  m.open += open;
+  m.hist[bucket]++;
+}
+
+void emit_masks() {
+  for (const auto &[key, m] : dev->masks) {
+    std::string payload = key + (key.find(' ') == std::string::npos ? " -" : "") + " " + std::to_string(m.count) + " " + std::to_string(m.total) + " " +
+                          std::to_string(m.max) + " " + std::to_string(m.open);
+    for (uint64_t n : m.hist) payload += " " + std::to_string(n);
+    emit("mask", payload);
+  }
+}
+
+void stim(const Event &ev, const std::string &what) {
+  if (dev->trace_inputs && ev.id) emit("stim", std::to_string(ev.id) + " " + what);
+}
+
+void apply(const Event &ev) {
+  switch (ev.kind) {
+    case EventKind::Serial:
+      stim(ev, "serial");
+      dev->serial_rx.insert(dev->serial_rx.end(), ev.text.begin(), ev.text.end());
+      dev->serial_ids.push_back(ev.id);
+      break;
+    case EventKind::Key:
+      stim(ev, "key " + ev.text + (dev->keypad ? "" : " unmapped"));
+      dev->keys.push_back(ev.text[0]);
+      dev->key_until.push_back(ev.t + static_cast<Time>(ev.value));
+      dev->key_ids.push_back(ev.id);
+      break;
+    case EventKind::Pin:
+      stim(ev, "pin " + std::to_string(ev.pin) + " " + std::to_string(ev.value));
+      drive_pin(ev.pin, ev.value, ev.id);
+      break;
+    case EventKind::Release:
+      drive_pin(ev.pin, ev.value, ev.id);
+      break;
+    case EventKind::Button: {
+      /* `button <k>` is the k-th input pin the sketch configured */
+      if (ev.pin < 0 || ev.pin >= static_cast<int>(dev->input_pins.size())) {
+        stim(ev, "button " + std::to_string(ev.pin) + " unmapped");
+        break;
+      }
+      int pin = dev->input_pins[ev.pin];
+      int idle = idle_level(dev->pins[pin]);
+      stim(ev, "button " + std::to_string(ev.pin) + " pin " + std::to_string(pin));
+      drive_pin(pin, !idle, ev.id);
+      push_event({ev.t + static_cast<Time>(ev.value), 0, EventKind::Release, pin, idle, "", ev.id});
+      break;
+    }
+    case EventKind::Adc:
+      if (ev.pin >= 0 && ev.pin < kMaxPins) {
+        stim(ev, "adc " + std::to_string(ev.pin) + " " + std::to_string(ev.value));
+        dev->pins[ev.pin].in = ev.value;
+        dev->pins[ev.pin].driven = true;
+        dev->pins[ev.pin].stim = ev.id;
+      }
+      break;
+  }
+}
+
+void apply_due() {
+  while (!dev->events.empty() && dev->events.front().t <= dev->now) {
+    std::pop_heap(dev->events.begin(), dev->events.end(), EventLater());
+    Event ev = std::move(dev->events.back());
+    dev->events.pop_back();
+    dev->inputs++;
+    apply(ev);
+  }
+}
+
+ucontext_t g_main_ctx;
+void (*g_entry)(void) = nullptr;
+
+void sketch_trampoline() {
+  g_entry();
+  stop();
+}
+
+}  // namespace
+
+/* ------- clock */
+Time now() { return dev->now; }
+
+/* ISRs run from apply_due() charge their own time, so the clock only ever moves forward here. */
+void move_clock(Time t, TimeClass as) {
+  if (t <= dev->now) return;
+  dev->time_in[static_cast<int>(as)] += t - dev->now;
+  dev->now = t;
+}
+
+void advance_to(Time t, TimeClass as) {
+  if (dev->stopped) stop();
+  if (t < dev->now) t = dev->now;
+  if (t > dev->end) t = dev->end;
+  while (!dev->events.empty() && dev->events.front().t <= t) {
+    move_clock(dev->events.front().t, as);
+    apply_due();
+  }
+  move_clock(t, as);
+  if (dev->now >= dev->end) stop();
+  if (dev->now >= dev->slice_end) swapcontext(&dev->ctx, &g_main_ctx);
+}
+
+void advance(Time us) { advance_to(dev->now + us); }
+
+void sleep_for(Time us) {
+  flush_outputs();
+  if (dev->kernel) {
+    dev->kernel->sleep_until(dev->now + us);
+  } else {
+    advance_to(dev->now + us, TimeClass::Delay);
+  }
+}
+
+void busy(Time us) {
+  dev->api_calls++;
+  advance(us);
+  if (dev->kernel) dev->kernel->preempt();
+}
+
+void call() { busy(kCallUs); }
+
+void spin_until(Time t, TimeClass as) {
+  activity();
+  t = std::min({t, next_event_time(), dev->end});
+  if (dev->kernel) t = std::min(t, dev->kernel->next_wake());
+  if (t <= dev->now) return;
+  dev->skipped_us += t - dev->now;
+  flush_outputs();
+  advance_to(t, as);
+  if (dev->kernel) dev->kernel->preempt();
+}
+
+void wait_input() {
+  Time t = std::min(next_event_time(), dev->end);
+  if (dev->kernel) {
+    flush_outputs();
+    dev->kernel->sleep_until(t);
+  } else {
+    spin_until(t, TimeClass::Idle);
+  }
+}
+
+/* ------- polling */
+Time next_event_time() { return dev->events.empty() ? kForever : dev->events.front().t; }
+
+void poll_empty(bool time_query) {
+  call();
+  dev->idle_time_query |= time_query;
+  if (++dev->idle_polls < kIdlePolls) return;
+  /* nothing can change before the next input, except what the sketch reads off the clock */
+  spin_until(dev->idle_time_query ? dev->now + kTimePollStepUs : kForever);
+}
+
+void activity() {
+  dev->idle_polls = 0;
+  dev->idle_time_query = false;
+}
+
+/* ------- input */
+void push_event(Event ev) {
+  ev.seq = dev->event_seq++;
+  dev->events.push_back(std::move(ev));
+  std::push_heap(dev->events.begin(), dev->events.end(), EventLater());
+}
+
+int pin_level(int pin) {
+  if (pin < 0 || pin >= kMaxPins) return LOW;
+  const Pin &p = dev->pins[pin];
+  if (p.mode == OUTPUT) return p.out;
+  return p.driven ? p.in : idle_level(p);
+}
+
+void set_pin_mode(int pin, int mode) {
+  if (pin < 0 || pin >= kMaxPins) return;
+  Pin &p = dev->pins[pin];
+  p.mode = mode;
+  bool is_input = mode == INPUT || mode == INPUT_PULLUP || mode == INPUT_PULLDOWN;
+  auto &inputs = dev->input_pins;
+  if (is_input && std::find(inputs.begin(), inputs.end(), pin) == inputs.end()) {
+    inputs.push_back(pin);
+  }
+}
+
+/* A read that returns the same value as last time is a poll that saw nothing new. */
+int read_pin(int pin) {
+  int value = pin_level(pin);
+  if (pin < 0 || pin >= kMaxPins) {
+    poll_empty();
+    return value;
+  }
+  Pin &p = dev->pins[pin];
+  if (p.last_read == value) {
+    poll_empty();
+  } else {
+    p.last_read = value;
+    note_input(p.stim);
+    call();
+    activity();
+  }
+  return value;
+}
+
+/* The keypad is scanned, not buffered: a key released before anyone looked is gone. */
+bool key_ready() {
+  while (!dev->keys.empty() && dev->key_until.front() < dev->now) {
+    dev->keys.pop_front();
+    dev->key_until.pop_front();
+    dev->key_ids.pop_front();
+  }
+  return !dev->keys.empty();
+}
+
+char pop_key() {
+  char key = dev->keys.front();
+  dev->keys.pop_front();
+  dev->key_until.pop_front();
+  note_input(dev->key_ids.front());
+  dev->key_ids.pop_front();
+  return key;
+}
+
+/* A serial line counts as seen once its '\n' has been read. */
+uint8_t pop_serial() {
+  uint8_t c = dev->serial_rx.front();
+  dev->serial_rx.pop_front();
+  if (c == '\n' && !dev->serial_ids.empty()) {
+    note_input(dev->serial_ids.front());
+    dev->serial_ids.pop_front();
+  }
+  return c;
+}
+
+void note_input(int id) {
+  if (dev->trace_inputs && id) emit("input", std::to_string(id));
+}
+
+void write_pin(int pin, int level) {
+  call();
+  if (pin < 0 || pin >= kMaxPins) return;
+  Pin &p = dev->pins[pin];
+  level = level ? HIGH : LOW;
+  if (p.out == level) return;
+  p.out = level;
+  emit("pin", std::to_string(pin) + " " + std::to_string(level));
+}
+
+/* ------- UART0: 128-byte TX FIFO draining at the baud rate, output recorded per line */
+namespace {
+constexpr Time kTxFifo = 128;
+}
+
+void uart_cost(size_t bytes) {
+  Time byte_us = std::max<Time>(1, 10000000ULL / dev->serial_baud);
+  dev->serial_tx_busy = std::max(dev->serial_tx_busy, dev->now) + byte_us * bytes;
+  Time backlog = dev->serial_tx_busy - dev->now;
+  /* a full FIFO blocks the writer until there is room */
+  busy(backlog > kTxFifo * byte_us ? backlog - kTxFifo * byte_us : kCallUs);
+}
+
+void uart_write(uint8_t c) {
+  uart_cost(1);
+  if (c == '\n') {
+    if (!dev->serial_line.empty() && dev->serial_line.back() == '\r') dev->serial_line.pop_back();
+    emit("serial", dev->serial_line);
+    dev->serial_line.clear();
+  } else {
+    dev->serial_line += static_cast<char>(c);
+  }
+}
+
+/*
+ * One event per line, times in (fractional) milliseconds:
+ *   1500 key 7              (held for 100 ms; `key 7 80` holds it for 80 ms)
+ *   2000 serial I 9 30      (the text plus '\n' arrives on Serial)
+ *   2500 pin 4 0
+ *   3000 button 2 150       (k-th configured input pin pressed for 150 ms)
+ *   3500 adc 36 2048
+ */
+bool load_script(const char *path) {
+  std::ifstream in(path);
+  if (!in) return false;
+  std::string line;
+  int line_no = 0;
+  while (std::getline(in, line)) {
+    line_no++;
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos || line[start] == '#') continue;
+    std::istringstream is(line);
+    double t_ms = 0;
+    std::string kind;
+    if (!(is >> t_ms >> kind)) continue;
+    Event ev{static_cast<Time>(t_ms * 1000.0 + 0.5), 0, EventKind::Serial, -1, 0, "", line_no};
+    if (kind == "serial") {
+      std::string rest;
+      std::getline(is, rest);
+      if (!rest.empty() && rest[0] == ' ') rest.erase(0, 1);
+      ev.text = rest + "\n";
+    } else if (kind == "key") {
+      std::string key;
+      double hold_ms = 100;
+      is >> key;
+      if (key.empty()) continue;
+      is >> hold_ms;
+      ev.kind = EventKind::Key;
+      ev.text = key.substr(0, 1);
+      ev.value = static_cast<int>(hold_ms * 1000.0);
+    } else if (kind == "pin" || kind == "adc") {
+      ev.kind = kind == "pin" ? EventKind::Pin : EventKind::Adc;
+      is >> ev.pin >> ev.value;
+    } else if (kind == "button") {
+      ev.kind = EventKind::Button;
+      double hold_ms = 100;
+      is >> ev.pin;
+      is >> hold_ms;
+      ev.value = static_cast<int>(hold_ms * 1000.0);
+    } else {
+      fprintf(stderr, "hostsim: %s: unknown event '%s'\n", path, kind.c_str());
+      continue;
+    }
+    push_event(std::move(ev));
+  }
+  return true;
+}
+
+/* ------- interrupts */
+void irq_disable(const char *site) {
+  if (dev->irq_enabled) {
+    dev->masked_since = dev->now;
+    dev->mask_key = mask_key(site);
+  }
+  dev->irq_enabled = false;
+}
+
+void irq_enable() {
+  if (!dev->irq_enabled) end_mask(false);
+  dev->irq_enabled = true;
+  while (!dev->pending_irq.empty() && dev->irq_enabled) {
+    int pin = dev->pending_irq.front();
+    dev->pending_irq.erase(dev->pending_irq.begin());
+    run_isr(pin);
+  }
+}
+
+void enter_critical(const char *site) {
+  if (dev->critical_depth++ == 0) irq_disable(site);
+}
+
+void exit_critical() {
+  if (dev->critical_depth == 0) return;
+  if (--dev->critical_depth == 0) irq_enable();
+}
+
+/* ------- output trace */
+void emit_at(Time t, const char *channel, const std::string &payload) {
+  dev->outputs++;
+  activity();
+  if (!dev->keep_trace) return;
+  std::string line = std::to_string(t);
+  line += ' ';
+  line += channel;
+  if (!payload.empty()) {
+    line += ' ';
+    line += payload;
+  }
+  dev->trace.push_back({t, dev->trace_seq++, std::move(line)});
+}
+
+void emit(const char *channel, const std::string &payload) { emit_at(dev->now, channel, payload); }
+
+void flush_outputs() {
+  for (Lcd *lcd : dev->lcds) lcd->flush();
+}
+
+bool write_trace(const char *path) {
+  /* LCD rows are stamped with the time they were last written, so sort once at the end */
+  std::stable_sort(dev->trace.begin(), dev->trace.end(),
+                   [](const Record &a, const Record &b) { return a.t < b.t; });
+  FILE *fp = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+  if (!fp) return false;
+  fprintf(fp, "# hostsim end_us=%llu loops=%llu api_calls=%llu skipped_us=%llu busy_us=%llu delay_us=%llu idle_us=%llu\n",
+          static_cast<unsigned long long>(dev->now), static_cast<unsigned long long>(dev->loops),
+          static_cast<unsigned long long>(dev->api_calls),
+          static_cast<unsigned long long>(dev->skipped_us),
+          static_cast<unsigned long long>(dev->time_in[static_cast<int>(TimeClass::Busy)]),
+          static_cast<unsigned long long>(dev->time_in[static_cast<int>(TimeClass::Delay)]),
+          static_cast<unsigned long long>(dev->time_in[static_cast<int>(TimeClass::Idle)]));
+  for (const Record &r : dev->trace) {
+    fwrite(r.line.data(), 1, r.line.size(), fp);
+    fputc('\n', fp);
+  }
+  if (fp != stdout) fclose(fp);
+  return true;
+}
+
+/* ------- run */
+void stop() {
+  dev->stopped = true;
+  swapcontext(&dev->ctx, &g_main_ctx);
+  /* a stopped sketch is never resumed */
+  abort();
+}
+
+void fail(const std::string &why) {
+  dev->error = why;
+  emit("panic", why);
+  stop();
+}
+
+/* mapped, not allocated, so a stack only costs the pages the sketch touches */
+void start(void (*entry)(void), size_t stack_size) {
+  g_entry = entry;
+  void *stack = mmap(nullptr, stack_size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+  if (stack == MAP_FAILED) {
+    perror("hostsim: sketch stack");
+    abort();
+  }
+  dev->stack = stack;
+  dev->stack_size = stack_size;
+  getcontext(&dev->ctx);
+  dev->ctx.uc_stack.ss_sp = stack;
+  dev->ctx.uc_stack.ss_size = stack_size;
+  dev->ctx.uc_link = &g_main_ctx;
+  makecontext(&dev->ctx, sketch_trampoline, 0);
+}
+
+void resume() { swapcontext(&g_main_ctx, &dev->ctx); }
+
+void finish() {
+  flush_outputs();
+  if (!dev->irq_enabled) end_mask(true);
+  if (dev->trace_masks) emit_masks();
+  if (dev->trace_bus) {
+    for (const Lcd *lcd : dev->lcds) lcd->emit_bus();
+  }
+  emit("end", "");
+  /* the frames left on the sketch stack are abandoned, not unwound */
+}
+
+void run(void (*entry)(void), size_t stack_size) {
+  start(entry, stack_size);
+  resume();
+  finish();
+}
+
+}  // namespace hostsim
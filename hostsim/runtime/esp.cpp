@@ -0,0 +1,307 @@
+/*
+ * ESP-IDF drivers on the virtual clock: error names, logging, GPIO with ISRs,
+ * I2C master, and the two LCD components the generated code uses.
+ */
+#include <cstdarg>
+#include <cstdio>
+
+#include "Arduino.h"
+#include "driver/gpio.h"
+#include "driver/i2c.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "hostsim_runtime.h"
+#include "lcd.h"
+#include "lcd1602_i2c.h"
+
+using hostsim::dev;
+using hostsim::kMaxPins;
+
+namespace {
+
+bool valid_pin(gpio_num_t pin) { return pin >= 0 && pin < kMaxPins && pin < GPIO_NUM_MAX; }
+
+/* Interrupt config per pin; the device pin only carries the edge while enabled. */
+struct GpioIntr {
+  gpio_int_type_t type = GPIO_INTR_DISABLE;
+  bool enabled = true;
+};
+
+GpioIntr g_intr[kMaxPins];
+bool g_isr_service = false;
+
+/* Level interrupts are modelled as the edge that starts the level. */
+int edge_of(gpio_int_type_t type) {
+  switch (type) {
+    case GPIO_INTR_POSEDGE:
+    case GPIO_INTR_HIGH_LEVEL:
+      return RISING;
+    case GPIO_INTR_NEGEDGE:
+    case GPIO_INTR_LOW_LEVEL:
+      return FALLING;
+    case GPIO_INTR_ANYEDGE:
+      return CHANGE;
+    default:
+      return 0;
+  }
+}
+
+void sync_intr(gpio_num_t pin) {
+  const GpioIntr &intr = g_intr[pin];
+  dev->pins[pin].isr_mode = intr.enabled ? edge_of(intr.type) : 0;
+}
+
+int arduino_mode(gpio_mode_t mode, bool pull_up, bool pull_down) {
+  if (mode & GPIO_MODE_OUTPUT) return OUTPUT;
+  if (!(mode & GPIO_MODE_INPUT)) return -1;
+  if (pull_up) return INPUT_PULLUP;
+  return pull_down ? INPUT_PULLDOWN : INPUT;
+}
+
+}  // namespace
+
+extern "C" {
+
+const char *esp_err_to_name(esp_err_t code) {
+  switch (code) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+    default: return "UNKNOWN ERROR";
+  }
+}
+
+/* The console prints "I (1234) tag: msg\n"; the trace keeps level, tag and message. */
+void hostsim_log(char level, const char *tag, const char *format, ...) {
+  char msg[256];
+  va_list ap;
+  va_start(ap, format);
+  int n = vsnprintf(msg, sizeof(msg), format, ap);
+  va_end(ap);
+  std::string payload = std::string(1, level) + " " + (tag ? tag : "") + ": " + msg;
+  hostsim::emit("log", payload);
+  hostsim::uart_cost(static_cast<size_t>(n > 0 ? n : 0) + 16);
+}
+
+/* ------- gpio */
+esp_err_t gpio_config(const gpio_config_t *config) {
+  hostsim::call();
+  if (!config) return ESP_ERR_INVALID_ARG;
+  int mode = arduino_mode(config->mode, config->pull_up_en, config->pull_down_en);
+  /* ascending bit order, which is also the order `button <k>` counts inputs in */
+  for (int pin = 0; pin < kMaxPins; pin++) {
+    if (!(config->pin_bit_mask & (1ULL << pin))) continue;
+    if (mode >= 0) hostsim::set_pin_mode(pin, mode);
+    g_intr[pin].type = config->intr_type;
+    sync_intr(pin);
+  }
+  return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num) {
+  hostsim::call();
+  if (!valid_pin(gpio_num)) return ESP_ERR_INVALID_ARG;
+  /* reset leaves the pin as an input with the pull-up on */
+  hostsim::set_pin_mode(gpio_num, INPUT_PULLUP);
+  g_intr[gpio_num] = GpioIntr();
+  sync_intr(gpio_num);
+  return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode) {
+  hostsim::call();
+  if (!valid_pin(gpio_num)) return ESP_ERR_INVALID_ARG;
+  int current = dev->pins[gpio_num].mode;
+  int m = arduino_mode(mode, current == INPUT_PULLUP, current == INPUT_PULLDOWN);
+  if (m >= 0) hostsim::set_pin_mode(gpio_num, m);
+  return ESP_OK;
+}
+
+esp_err_t gpio_set_pull_mode(gpio_num_t gpio_num, gpio_pull_mode_t pull) {
+  hostsim::call();
+  if (!valid_pin(gpio_num)) return ESP_ERR_INVALID_ARG;
+  if (dev->pins[gpio_num].mode == OUTPUT) return ESP_OK;
+  int mode = pull == GPIO_PULLUP_ONLY ? INPUT_PULLUP : pull == GPIO_PULLDOWN_ONLY ? INPUT_PULLDOWN : INPUT;
+  hostsim::set_pin_mode(gpio_num, mode);
+  return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+  if (!valid_pin(gpio_num)) return ESP_ERR_INVALID_ARG;
+  hostsim::write_pin(gpio_num, level ? HIGH : LOW);
+  return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+  if (!valid_pin(gpio_num)) return 0;
+  return hostsim::read_pin(gpio_num);
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type) {
+  hostsim::call();
+  if (!valid_pin(gpio_num)) return ESP_ERR_INVALID_ARG;
+  g_intr[gpio_num].type = intr_type;
+  sync_intr(gpio_num);
+  return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int) {
+  hostsim::call();
+  if (g_isr_service) return ESP_ERR_INVALID_STATE;
+  g_isr_service = true;
+  return ESP_OK;
+}
+
+void gpio_uninstall_isr_service(void) {
+  hostsim::call();
+  g_isr_service = false;
+  for (auto &p : dev->pins) p.handler = nullptr;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args) {
+  hostsim::call();
+  if (!g_isr_service) return ESP_ERR_INVALID_STATE;
+  if (!valid_pin(gpio_num)) return ESP_ERR_INVALID_ARG;
+  dev->pins[gpio_num].handler = isr_handler;
+  dev->pins[gpio_num].handler_arg = args;
+  return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num) {
+  hostsim::call();
+  if (!g_isr_service) return ESP_ERR_INVALID_STATE;
+  if (!valid_pin(gpio_num)) return ESP_ERR_INVALID_ARG;
+  dev->pins[gpio_num].handler = nullptr;
+  return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num) {
+  hostsim::call();
+  if (!valid_pin(gpio_num)) return ESP_ERR_INVALID_ARG;
+  g_intr[gpio_num].enabled = true;
+  sync_intr(gpio_num);
+  return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num) {
+  hostsim::call();
+  if (!valid_pin(gpio_num)) return ESP_ERR_INVALID_ARG;
+  g_intr[gpio_num].enabled = false;
+  sync_intr(gpio_num);
+  return ESP_OK;
+}
+
+/* ------- i2c: every address acks; LCD traffic is costed by the LCD model */
+esp_err_t i2c_param_config(i2c_port_t, const i2c_config_t *conf) {
+  hostsim::call();
+  if (!conf) return ESP_ERR_INVALID_ARG;
+  /* one bus on the host: the LCD backpack runs at whatever clock was configured last */
+  if (conf->mode == I2C_MODE_MASTER && conf->master.clk_speed) dev->i2c_hz = conf->master.clk_speed;
+  return ESP_OK;
+}
+
+esp_err_t i2c_driver_install(i2c_port_t, i2c_mode_t, size_t, size_t, int) {
+  hostsim::call();
+  return ESP_OK;
+}
+
+esp_err_t i2c_driver_delete(i2c_port_t) {
+  hostsim::call();
+  return ESP_OK;
+}
+
+esp_err_t i2c_master_write_to_device(i2c_port_t, uint8_t, const uint8_t *, size_t, TickType_t) {
+  hostsim::call();
+  return ESP_OK;
+}
+
+}  // extern "C"
+
+/* ------- parallel HD44780 component */
+struct hostsim_lcd_handle {
+  hostsim::Lcd model{16, 2};
+};
+
+extern "C" {
+
+LCD_Handle_t lcd_create(int, int, int, int, int, int) {
+  hostsim::call();
+  auto *lcd = new hostsim_lcd_handle;
+  lcd->model.set_bus(hostsim::LcdBus::Parallel);
+  return lcd;
+}
+
+int lcd_init(LCD_Handle_t lcd, uint8_t cols, uint8_t rows) {
+  if (!lcd) return ESP_ERR_INVALID_ARG;
+  lcd->model.resize(cols, rows);
+  lcd->model.clear();
+  return ESP_OK;
+}
+
+int lcd_clear(LCD_Handle_t lcd) {
+  if (!lcd) return ESP_ERR_INVALID_ARG;
+  lcd->model.clear();
+  return ESP_OK;
+}
+
+int lcd_set_cursor(LCD_Handle_t lcd, uint8_t col, uint8_t row) {
+  if (!lcd) return ESP_ERR_INVALID_ARG;
+  lcd->model.set_cursor(col, row);
+  return ESP_OK;
+}
+
+int lcd_print(LCD_Handle_t lcd, const char *str) {
+  if (!lcd || !str) return ESP_ERR_INVALID_ARG;
+  for (const char *p = str; *p; p++) lcd->model.put(static_cast<uint8_t>(*p));
+  return ESP_OK;
+}
+
+/* ------- LCD1602 over a PCF8574 backpack */
+static hostsim::Lcd *model_of(lcd1602_t *lcd) { return static_cast<hostsim::Lcd *>(lcd->model); }
+
+esp_err_t lcd1602_init(lcd1602_t *lcd, i2c_port_t port, uint8_t address) {
+  if (!lcd) return ESP_ERR_INVALID_ARG;
+  hostsim::call();
+  lcd->port = port;
+  lcd->address = address;
+  lcd->col = lcd->row = 0;
+  /* the struct often lives uninitialised on app_main's stack, so never trust `model` here */
+  auto *model = new hostsim::Lcd(16, 2);
+  model->set_bus(hostsim::LcdBus::I2c);
+  lcd->model = model;
+  model->clear();
+  return ESP_OK;
+}
+
+esp_err_t lcd1602_clear(lcd1602_t *lcd) {
+  if (!lcd || !lcd->model) return ESP_ERR_INVALID_STATE;
+  model_of(lcd)->clear();
+  lcd->col = lcd->row = 0;
+  return ESP_OK;
+}
+
+esp_err_t lcd1602_set_cursor(lcd1602_t *lcd, uint8_t row, uint8_t col) {
+  if (!lcd || !lcd->model) return ESP_ERR_INVALID_STATE;
+  model_of(lcd)->set_cursor(col, row);
+  lcd->col = col;
+  lcd->row = row;
+  return ESP_OK;
+}
+
+esp_err_t lcd1602_puts(lcd1602_t *lcd, const char *str) {
+  if (!lcd || !lcd->model) return ESP_ERR_INVALID_STATE;
+  if (!str) return ESP_ERR_INVALID_ARG;
+  for (const char *p = str; *p; p++) {
+    model_of(lcd)->put(static_cast<uint8_t>(*p));
+    lcd->col++;
+  }
+  return ESP_OK;
+}
+
+}  // extern "C"
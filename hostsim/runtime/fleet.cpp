@@ -0,0 +1,210 @@
+/*
+ * Fleet mode: many copies of one Arduino sketch in one process, for the
+ * per-device cost of the control logic at scale.
+ *
+ * Every device has its own Device, sketch coroutine and copy of the sketch's
+ * globals. Fleet builds link the sketch between the markers of fleet/marks.cpp,
+ * so its .data, .bss and constructors can be found; the device about to run
+ * gets its copy of them swapped in, the one that ran gets it swapped out.
+ * The scheduler always resumes the device with the earliest clock and lets it
+ * run for one slice of virtual time.
+ *
+ * Device k gets the script shifted by k * spread / devices, so the input
+ * streams overlap instead of arriving in lockstep. Only device 0, which gets
+ * the script as is, records its trace; the others just count their outputs.
+ * A summary line follows the trace:
+ *
+ *   # fleet devices= sim_us= setup_us= wall_us= cpu_us= inputs= outputs= calls= switches=
+ *     image_bytes= device_bytes= stack_kb= rss_base_kb= rss_peak_kb=
+ */
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include "Arduino.h"
+#include "hostsim_runtime.h"
+
+extern "C" {
+/* defined by fleet/marks.cpp in fleet builds only */
+extern char hostsim_fleet_data_begin[] __attribute__((weak));
+extern char hostsim_fleet_data_end[] __attribute__((weak));
+extern char hostsim_fleet_bss_begin[] __attribute__((weak));
+extern char hostsim_fleet_bss_end[] __attribute__((weak));
+extern char *hostsim_fleet_data_image __attribute__((weak));
+extern void (*hostsim_fleet_init_begin)(void) __attribute__((weak));
+extern void (*hostsim_fleet_init_end)(void) __attribute__((weak));
+}
+
+namespace hostsim {
+namespace {
+
+/* Per-device memory that lives at a fixed address: the sketch's globals, and Serial's setTimeout(). */
+struct Region {
+  char *at;
+  size_t size;
+};
+
+struct Member {
+  Device device;
+  std::vector<char> image; /* its regions while another device runs */
+};
+
+Time clock_us(clockid_t clock) {
+  timespec ts;
+  clock_gettime(clock, &ts);
+  return static_cast<Time>(ts.tv_sec) * 1000000 + static_cast<Time>(ts.tv_nsec) / 1000;
+}
+
+long rss_kb() {
+  long pages = 0;
+  if (FILE *fp = fopen("/proc/self/statm", "r")) {
+    if (fscanf(fp, "%*d %ld", &pages) != 1) pages = 0;
+    fclose(fp);
+  }
+  return pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/* Pages of the sketch stack the device has touched. */
+size_t stack_pages(const Device &d) {
+  size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  std::vector<unsigned char> resident(d.stack_size / page);
+  if (!d.stack || mincore(d.stack, d.stack_size, resident.data()) != 0) return 0;
+  return static_cast<size_t>(std::count_if(resident.begin(), resident.end(), [](unsigned char r) { return r & 1; }));
+}
+
+void save(const std::vector<Region> &regions, std::vector<char> &image) {
+  char *out = image.data();
+  for (const Region &r : regions) {
+    memcpy(out, r.at, r.size);
+    out += r.size;
+  }
+}
+
+void load(const std::vector<Region> &regions, const std::vector<char> &image) {
+  const char *in = image.data();
+  for (const Region &r : regions) {
+    memcpy(r.at, in, r.size);
+    in += r.size;
+  }
+}
+
+}  // namespace
+
+int run_fleet(void (*entry)(void), size_t stack_size, const char *script, const FleetOptions &opt,
+              const char *trace) {
+  if (!hostsim_fleet_data_begin || !hostsim_fleet_data_image) {
+    fprintf(stderr, "hostsim: --fleet needs a binary linked with the fleet markers\n");
+    return 2;
+  }
+  const std::vector<Region> regions = {
+      {hostsim_fleet_data_begin, static_cast<size_t>(hostsim_fleet_data_end - hostsim_fleet_data_begin)},
+      {hostsim_fleet_bss_begin, static_cast<size_t>(hostsim_fleet_bss_end - hostsim_fleet_bss_begin)},
+      {reinterpret_cast<char *>(&Serial), sizeof(Serial)},
+  };
+  size_t image_bytes = 0;
+  for (const Region &r : regions) image_bytes += r.size;
+  /* what a device starts from: initialized data, zeroed bss, Serial as constructed */
+  std::vector<char> pristine(image_bytes);
+  save(regions, pristine);
+  memcpy(pristine.data(), hostsim_fleet_data_image, regions[0].size);
+  memset(pristine.data() + regions[0].size, 0, regions[1].size);
+
+  const Device &proto = *dev;
+  long rss_base = rss_kb();
+  Time setup_start = clock_us(CLOCK_MONOTONIC);
+  int n = std::max(1, opt.devices);
+  std::unique_ptr<Member[]> members(new Member[n]);
+  for (int k = 0; k < n; k++) {
+    Member &m = members[k];
+    Device &d = m.device;
+    d.end = proto.end;
+    d.rng = proto.rng;
+    d.trace_inputs = proto.trace_inputs;
+    d.trace_masks = proto.trace_masks;
+    d.trace_bus = proto.trace_bus;
+    d.keep_trace = k == 0;
+    dev = &d;
+    load(regions, pristine);
+    for (auto *ctor = &hostsim_fleet_init_begin + 1; ctor < &hostsim_fleet_init_end; ctor++) (*ctor)();
+    if (script && !load_script(script)) {
+      fprintf(stderr, "hostsim: cannot read script %s\n", script);
+      return 2;
+    }
+    /* a uniform shift keeps the event heap in order */
+    Time shift = opt.spread * static_cast<Time>(k) / static_cast<Time>(n);
+    for (Event &ev : d.events) ev.t += shift;
+    start(entry, stack_size);
+    m.image.resize(image_bytes);
+    save(regions, m.image);
+  }
+  Time setup_us = clock_us(CLOCK_MONOTONIC) - setup_start;
+
+  using Turn = std::pair<Time, int>;
+  std::priority_queue<Turn, std::vector<Turn>, std::greater<Turn>> turns;
+  for (int k = 0; k < n; k++) turns.push({0, k});
+  int live = n - 1; /* whose regions are in place */
+  uint64_t switches = 0;
+  size_t stack_total = 0;
+  Time wall_start = clock_us(CLOCK_MONOTONIC);
+  Time cpu_start = clock_us(CLOCK_PROCESS_CPUTIME_ID);
+  while (!turns.empty()) {
+    int k = turns.top().second;
+    turns.pop();
+    if (k != live) {
+      save(regions, members[live].image);
+      load(regions, members[k].image);
+      live = k;
+      switches++;
+    }
+    dev = &members[k].device;
+    dev->slice_end = dev->now + std::max<Time>(1, opt.slice);
+    resume();
+    if (!dev->stopped) {
+      turns.push({dev->now, k});
+      continue;
+    }
+    finish();
+    stack_total += stack_pages(*dev) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  }
+  Time wall_us = clock_us(CLOCK_MONOTONIC) - wall_start;
+  Time cpu_us = clock_us(CLOCK_PROCESS_CPUTIME_ID) - cpu_start;
+
+  Time sim_us = 0;
+  uint64_t inputs = 0, outputs = 0, calls = 0;
+  for (int k = 0; k < n; k++) {
+    const Device &d = members[k].device;
+    sim_us += d.now;
+    inputs += d.inputs;
+    outputs += d.outputs;
+    calls += d.api_calls;
+  }
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  dev = &members[0].device;
+  if (!write_trace(trace)) {
+    fprintf(stderr, "hostsim: cannot write trace %s\n", trace);
+    return 2;
+  }
+  printf("# fleet devices=%d sim_us=%llu setup_us=%llu wall_us=%llu cpu_us=%llu inputs=%llu outputs=%llu "
+         "calls=%llu switches=%llu image_bytes=%zu device_bytes=%zu stack_kb=%zu rss_base_kb=%ld rss_peak_kb=%ld\n",
+         n, static_cast<unsigned long long>(sim_us), static_cast<unsigned long long>(setup_us),
+         static_cast<unsigned long long>(wall_us), static_cast<unsigned long long>(cpu_us),
+         static_cast<unsigned long long>(inputs), static_cast<unsigned long long>(outputs),
+         static_cast<unsigned long long>(calls), static_cast<unsigned long long>(switches), image_bytes,
+         sizeof(Member), stack_total / 1024, rss_base, usage.ru_maxrss);
+  /* the caller exits right away; tearing down every device would only cost time */
+  members.release();
+  return 0;
+}
+
+}  // namespace hostsim
@@ -0,0 +1,47 @@
+/*
+ * Fleet build markers. Fleet binaries are linked as
+ *
+ *   fleet_begin.o sketch.o fleet_end.o libhostsim.a
+ *
+ * and the linker keeps input sections in command-line order, so these symbols
+ * bracket the sketch's .data, .bss and constructor entries in .init_array.
+ * Compiled twice: once as is (begin) and once with -DHOSTSIM_FLEET_END.
+ *
+ * The begin constructor runs just before the sketch's own and keeps a copy of
+ * the sketch's initialized data, which every fleet device starts from.
+ */
+#include <cstdlib>
+#include <cstring>
+
+extern "C" {
+
+#ifndef HOSTSIM_FLEET_END
+
+__attribute__((used)) char hostsim_fleet_data_begin[1] = {1};
+__attribute__((used)) char hostsim_fleet_bss_begin[1];
+char *hostsim_fleet_data_image = nullptr;
+
+extern char hostsim_fleet_data_end[];
+
+static void hostsim_fleet_snapshot() {
+  size_t size = hostsim_fleet_data_end - hostsim_fleet_data_begin;
+  hostsim_fleet_data_image = static_cast<char *>(malloc(size));
+  memcpy(hostsim_fleet_data_image, hostsim_fleet_data_begin, size);
+}
+
+__attribute__((section(".init_array"), used)) void (*hostsim_fleet_init_begin)(void) =
+    hostsim_fleet_snapshot;
+
+#else
+
+__attribute__((used)) char hostsim_fleet_data_end[1] = {1};
+__attribute__((used)) char hostsim_fleet_bss_end[1];
+
+static void hostsim_fleet_nothing() {}
+
+__attribute__((section(".init_array"), used)) void (*hostsim_fleet_init_end)(void) =
+    hostsim_fleet_nothing;
+
+#endif
+
+}  // extern "C"
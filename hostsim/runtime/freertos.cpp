@@ -0,0 +1,740 @@
+/*
+ * FreeRTOS on the virtual clock: one simulated core, fixed-priority preemptive
+ * scheduling with 1-tick round-robin between equal priorities.
+ *
+ * Tasks are ucontext coroutines. A task only loses the CPU at a preemption
+ * point (every runtime API call), which is where a real tick or a
+ * portYIELD_FROM_ISR would have switched anyway, so runs stay deterministic.
+ */
+#include <ucontext.h>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "hostsim_runtime.h"
+
+using hostsim::dev;
+using hostsim::kForever;
+using hostsim::Mark;
+using hostsim::Time;
+using hostsim::TimeClass;
+
+namespace {
+
+constexpr Time kTickUs = 1000000 / configTICK_RATE_HZ;
+/* host frames are bigger than Xtensa ones, so tasks get at least this much real stack */
+constexpr size_t kTaskStack = 256 * 1024;
+constexpr uint8_t kStackPaint = 0xa5;
+/* CONFIG_ESP_MAIN_TASK_STACK_SIZE / ESP_TASK_MAIN_PRIO */
+constexpr uint32_t kMainStackBytes = 3584;
+constexpr UBaseType_t kMainPriority = 1;
+
+enum class State { Ready, Running, Blocked, Deleted };
+
+Time tick_deadline(TickType_t ticks) {
+  if (ticks == portMAX_DELAY) return kForever;
+  return (dev->now / kTickUs + ticks) * kTickUs;
+}
+
+const char *file_name(const char *site) {
+  const char *slash = site ? strrchr(site, '/') : nullptr;
+  return slash ? slash + 1 : site;
+}
+
+/* timeline name of a queue or semaphore: what it is and the line that created it */
+int timeline_id(const char *kind, const char *site) {
+  site = file_name(site);
+  return hostsim::timeline_name(std::string(kind) + " " + (site ? site : "?"));
+}
+
+}  // namespace
+
+struct hostsim_task {
+  std::string name;
+  UBaseType_t prio = 0;
+  UBaseType_t base_prio = 0; /* before priority inheritance */
+  TaskFunction_t fn = nullptr;
+  void *arg = nullptr;
+  uint32_t stack_bytes = 0; /* what the application asked for */
+  std::vector<uint8_t> stack;
+  ucontext_t ctx;
+  State state = State::Ready;
+  uint64_t ready_seq = 0;                        /* FIFO order among equal priorities */
+  Time wake = kForever;                          /* timeout while Blocked */
+  std::vector<hostsim_task *> *waiting = nullptr; /* wait list it sits on */
+  bool timed_out = false;
+  int id = 0;         /* timeline */
+  int waiting_on = 0; /* timeline id of the queue or semaphore, 0 in vTaskDelay */
+  hostsim_queue *mutex_wait = nullptr; /* mutex it takes with portMAX_DELAY, for deadlock checks */
+};
+
+struct hostsim_queue {
+  std::string name;
+  std::deque<std::vector<uint8_t>> items;
+  UBaseType_t length = 0;
+  UBaseType_t item_size = 0;
+
+  bool semaphore = false;
+  bool mutex = false;
+  UBaseType_t count = 0; /* semaphores keep a count instead of items */
+  UBaseType_t max_count = 0;
+  bool recursive = false; /* xSemaphoreCreateRecursiveMutex */
+  hostsim_task *holder = nullptr;
+  int recursion = 0;      /* xSemaphoreTakeRecursive depth of the holder */
+
+  std::vector<hostsim_task *> receivers;
+  std::vector<hostsim_task *> senders;
+  int id = 0; /* timeline */
+
+  int64_t depth() const { return semaphore ? count : static_cast<int64_t>(items.size()); }
+  std::string site() const { return name.empty() ? "?" : file_name(name.c_str()); }
+};
+
+namespace {
+
+class Rtos : public hostsim::Kernel {
+ public:
+  hostsim_task *current = nullptr;
+  bool yield_pending = false;
+  int suspended = 0;
+
+  hostsim_task *create(TaskFunction_t fn, const char *name, uint32_t stack_bytes, void *arg,
+                       UBaseType_t prio) {
+    auto *t = new hostsim_task;
+    t->name = name ? name : "";
+    t->prio = t->base_prio = std::min<UBaseType_t>(prio, configMAX_PRIORITIES - 1);
+    t->fn = fn;
+    t->arg = arg;
+    t->stack_bytes = stack_bytes;
+    t->id = hostsim::timeline_name("task " + std::to_string(t->prio) + " " + (t->name.empty() ? "?" : t->name));
+    if (fn) {
+      t->stack.assign(std::max<size_t>(kTaskStack, stack_bytes * 8), kStackPaint);
+      getcontext(&t->ctx);
+      t->ctx.uc_stack.ss_sp = t->stack.data();
+      t->ctx.uc_stack.ss_size = t->stack.size();
+      t->ctx.uc_link = nullptr;
+      makecontext(&t->ctx, task_entry, 0);
+    }
+    make_ready(t);
+    tasks_.push_back(t);
+    return t;
+  }
+
+  void adopt_main() {
+    current = create(nullptr, "main", kMainStackBytes, nullptr, kMainPriority);
+    current->state = State::Running;
+  }
+
+  void remove(hostsim_task *t) {
+    unblock(t, false);
+    t->state = State::Deleted;
+    tasks_.erase(std::remove(tasks_.begin(), tasks_.end(), t), tasks_.end());
+    if (t != current) {
+      delete t;
+      return;
+    }
+    zombies_.push_back(t); /* still running on its own stack */
+    schedule();
+  }
+
+  void make_ready(hostsim_task *t) {
+    t->state = State::Ready;
+    t->ready_seq = ready_seq_++;
+  }
+
+  /* Take t off its wait list and make it runnable. */
+  void unblock(hostsim_task *t, bool timed_out) {
+    if (t->state == State::Blocked) hostsim::mark(Mark::Wake, t->id, t->waiting_on, timed_out);
+    if (t->waiting) {
+      auto &list = *t->waiting;
+      list.erase(std::remove(list.begin(), list.end(), t), list.end());
+      t->waiting = nullptr;
+    }
+    t->wake = kForever;
+    t->timed_out = timed_out;
+    if (t->state == State::Blocked) make_ready(t);
+  }
+
+  /* Highest-priority waiter first, like the kernel's event lists. */
+  hostsim_task *wake_one(std::vector<hostsim_task *> &waiters) {
+    if (waiters.empty()) return nullptr;
+    auto it = std::max_element(waiters.begin(), waiters.end(),
+                               [](hostsim_task *a, hostsim_task *b) { return a->prio < b->prio; });
+    hostsim_task *t = *it;
+    unblock(t, false);
+    return t;
+  }
+
+  /* Block the running task on `waiters` until woken or until `deadline`. */
+  bool block_on(std::vector<hostsim_task *> &waiters, Time deadline, int on) {
+    if (deadline <= dev->now || dev->in_isr) return false;
+    hostsim_task *t = current;
+    hostsim::mark(Mark::Block, t->id, on);
+    t->state = State::Blocked;
+    t->wake = deadline;
+    t->waiting = &waiters;
+    t->waiting_on = on;
+    t->timed_out = false;
+    waiters.push_back(t);
+    schedule();
+    return !t->timed_out;
+  }
+
+  void sleep_until(Time t) override {
+    if (dev->in_isr) return;
+    if (t <= dev->now) {
+      yield();
+      return;
+    }
+    hostsim::mark(Mark::Block, current->id, 0);
+    current->state = State::Blocked;
+    current->wake = t;
+    current->waiting_on = 0;
+    schedule();
+  }
+
+  /* Runs after every API call: switch if a tick or an ISR made a better task ready. */
+  void preempt() override {
+    if (dev->in_isr || dev->critical_depth > 0 || suspended > 0) return;
+    Time tick = dev->now / kTickUs;
+    bool ticked = tick != last_tick_;
+    if (!ticked && !yield_pending) return;
+    last_tick_ = tick;
+    yield_pending = false;
+    wake_due();
+    hostsim_task *next = pick(current);
+    if (next && (next->prio > current->prio || (ticked && next->prio == current->prio))) {
+      switch_to(next);
+    }
+  }
+
+  Time next_wake() const override {
+    Time t = kForever;
+    for (hostsim_task *task : tasks_) {
+      if (task->state == State::Blocked) t = std::min(t, task->wake);
+      /* a ready task of the same or higher priority gets the CPU at the next tick */
+      if (task->state == State::Ready && task->prio >= current->prio) {
+        t = std::min(t, (dev->now / kTickUs + 1) * kTickUs);
+      }
+    }
+    return t;
+  }
+
+  /* A task of higher priority than the caller just became ready. */
+  void yield_if_higher(hostsim_task *woken) {
+    if (!woken || woken->prio <= current->prio) return;
+    if (dev->in_isr) {
+      yield_pending = true;
+      return;
+    }
+    if (dev->critical_depth > 0 || suspended > 0) return;
+    switch_to(woken);
+  }
+
+  /* Something changed priorities or readiness: hand over to a strictly better task. */
+  void reschedule() { yield_if_higher(pick(current)); }
+
+  void yield() {
+    if (dev->in_isr || dev->critical_depth > 0 || suspended > 0) return;
+    hostsim_task *next = pick(current);
+    if (next && next->prio >= current->prio) switch_to(next);
+  }
+
+  /* The running task cannot continue: run the next ready one, idling the CPU if there is none. */
+  void schedule() {
+    for (;;) {
+      wake_due();
+      if (hostsim_task *next = pick(nullptr)) {
+        switch_to(next);
+        return;
+      }
+      Time t = std::min({blocked_wake(), hostsim::next_event_time(), dev->end});
+      /* nothing can ever run again: a task stuck on a mutex is the reason worth naming */
+      if (blocked_wake() == kForever && hostsim::next_event_time() == kForever) {
+        for (hostsim_task *task : tasks_) {
+          if (task->state == State::Blocked && task->mutex_wait) hostsim::fail(stuck(task));
+        }
+      }
+      if (t > dev->now) {
+        dev->skipped_us += t - dev->now;
+        hostsim::mark(Mark::Idle, current->id, 0, 0, t - dev->now);
+      }
+      hostsim::flush_outputs();
+      /* the idle task runs: a sleep that ends by t counts as delay, anything else waits on input */
+      hostsim::advance_to(t, delay_wake() <= t ? TimeClass::Delay : TimeClass::Idle);
+    }
+  }
+
+  /*
+   * Follow mutex holders from `t`, which waits forever on t->mutex_wait. A
+   * chain that comes back to `t` can never be released: returns the chain,
+   * or an empty string while some holder can still run and give.
+   */
+  std::string deadlock(hostsim_task *t) const {
+    std::string why = "deadlock: task " + t->name;
+    hostsim_task *task = t;
+    for (size_t hops = 0; hops <= tasks_.size(); hops++) {
+      hostsim_queue *m = task->mutex_wait;
+      hostsim_task *holder = m ? m->holder : nullptr;
+      if (!holder) return "";
+      why += " waits on mutex " + m->site();
+      /* vTaskDelete does not give back what the task held */
+      if (!alive(holder)) return why + " held by a deleted task";
+      why += " held by " + (holder == task ? std::string("itself") : "task " + holder->name);
+      if (holder == t) return why;
+      if (holder->state != State::Blocked || holder->wake != kForever) return "";
+      task = holder;
+      why += ", which";
+    }
+    return "";
+  }
+
+  /* every task waits forever: name the mutex and its holder even without a cycle */
+  std::string stuck(hostsim_task *t) const {
+    std::string why = deadlock(t);
+    if (!why.empty()) return why;
+    hostsim_queue *m = t->mutex_wait;
+    return "deadlock: task " + t->name + " waits on mutex " + m->site() + " held by task " +
+           (m->holder ? m->holder->name : "?") + ", and no task or input can wake anything";
+  }
+
+  bool alive(hostsim_task *t) const { return std::find(tasks_.begin(), tasks_.end(), t) != tasks_.end(); }
+
+  /* Host frames stand in for Xtensa ones, so this errs on the small (pessimistic) side. */
+  UBaseType_t high_water_mark(hostsim_task *t) const {
+    if (t->stack.empty()) return t->stack_bytes; /* the main task's stack is not painted */
+    size_t untouched = 0;
+    while (untouched < t->stack.size() && t->stack[untouched] == kStackPaint) untouched++;
+    size_t used = t->stack.size() - untouched;
+    return used >= t->stack_bytes ? 0 : static_cast<UBaseType_t>(t->stack_bytes - used);
+  }
+
+ private:
+  std::vector<hostsim_task *> tasks_; /* creation order */
+  std::vector<hostsim_task *> zombies_;
+  uint64_t ready_seq_ = 0;
+  Time last_tick_ = 0;
+
+  static void task_entry();
+
+  hostsim_task *pick(hostsim_task *except) const {
+    hostsim_task *best = nullptr;
+    for (hostsim_task *t : tasks_) {
+      if (t == except || t->state != State::Ready) continue;
+      if (!best || t->prio > best->prio || (t->prio == best->prio && t->ready_seq < best->ready_seq)) {
+        best = t;
+      }
+    }
+    return best;
+  }
+
+  Time blocked_wake() const {
+    Time t = kForever;
+    for (hostsim_task *task : tasks_) {
+      if (task->state == State::Blocked) t = std::min(t, task->wake);
+    }
+    return t;
+  }
+
+  /* earliest wake of a task in vTaskDelay(), not waiting on a queue or semaphore */
+  Time delay_wake() const {
+    Time t = kForever;
+    for (hostsim_task *task : tasks_) {
+      if (task->state == State::Blocked && !task->waiting) t = std::min(t, task->wake);
+    }
+    return t;
+  }
+
+  void wake_due() {
+    for (hostsim_task *t : tasks_) {
+      if (t->state == State::Blocked && t->wake <= dev->now) unblock(t, true);
+    }
+  }
+
+  void switch_to(hostsim_task *next) {
+    hostsim_task *prev = current;
+    if (prev->state == State::Running) make_ready(prev);
+    next->state = State::Running;
+    if (next == prev) return;
+    hostsim::mark(Mark::Switch, prev->id, next->id);
+    current = next;
+    hostsim::activity();
+    swapcontext(&prev->ctx, &next->ctx);
+    /* back on prev's stack: nobody is running on a zombie any more */
+    for (hostsim_task *z : zombies_) {
+      if (z != current) delete z;
+    }
+    zombies_.erase(std::remove_if(zombies_.begin(), zombies_.end(),
+                                  [this](hostsim_task *z) { return z != current; }),
+                   zombies_.end());
+  }
+};
+
+Rtos *g_rtos = nullptr;
+
+void Rtos::task_entry() {
+  hostsim_task *t = g_rtos->current;
+  t->fn(t->arg);
+  /* ESP-IDF aborts when a task function returns */
+  hostsim::emit("panic", "task " + t->name + " returned");
+  hostsim::stop();
+}
+
+hostsim_task *self(TaskHandle_t task) { return task ? task : g_rtos->current; }
+
+/* ------- queue operations shared by queues and semaphores */
+bool can_take(hostsim_queue *q) { return q->semaphore ? q->count > 0 : !q->items.empty(); }
+bool can_give(hostsim_queue *q) { return q->semaphore ? q->count < q->max_count : q->items.size() < q->length; }
+
+void put(hostsim_queue *q, const void *item, bool front) {
+  if (q->semaphore) {
+    q->count++;
+    return;
+  }
+  const auto *bytes = static_cast<const uint8_t *>(item);
+  std::vector<uint8_t> copy(bytes, bytes + q->item_size);
+  if (front) {
+    q->items.push_front(std::move(copy));
+  } else {
+    q->items.push_back(std::move(copy));
+  }
+}
+
+void get(hostsim_queue *q, void *buffer, bool remove) {
+  if (q->semaphore) {
+    if (remove) q->count--;
+    return;
+  }
+  if (buffer) memcpy(buffer, q->items.front().data(), q->item_size);
+  if (remove) q->items.pop_front();
+}
+
+BaseType_t send(hostsim_queue *q, const void *item, TickType_t ticks, bool front) {
+  if (!q) return pdFAIL;
+  hostsim::call();
+  Time deadline = tick_deadline(ticks);
+  while (!can_give(q)) {
+    if (!g_rtos->block_on(q->senders, deadline, q->id)) return pdFAIL;
+  }
+  put(q, item, front);
+  hostsim::mark(Mark::Send, g_rtos->current->id, q->id, q->depth());
+  g_rtos->yield_if_higher(g_rtos->wake_one(q->receivers));
+  return pdPASS;
+}
+
+BaseType_t receive(hostsim_queue *q, void *buffer, TickType_t ticks, bool remove) {
+  if (!q) return pdFAIL;
+  hostsim::call();
+  Time deadline = tick_deadline(ticks);
+  while (!can_take(q)) {
+    if (!g_rtos->block_on(q->receivers, deadline, q->id)) return pdFAIL;
+  }
+  get(q, buffer, remove);
+  if (remove) hostsim::mark(Mark::Receive, g_rtos->current->id, q->id, q->depth());
+  g_rtos->yield_if_higher(g_rtos->wake_one(remove ? q->senders : q->receivers));
+  return pdPASS;
+}
+
+BaseType_t send_from_isr(hostsim_queue *q, const void *item, BaseType_t *woken) {
+  if (!q || !can_give(q)) return pdFAIL;
+  put(q, item, false);
+  hostsim::mark(q->semaphore ? Mark::Give : Mark::Send, -1, q->id, q->depth());
+  hostsim_task *t = g_rtos->wake_one(q->receivers);
+  if (woken && t && t->prio > g_rtos->current->prio) *woken = pdTRUE;
+  return pdPASS;
+}
+
+BaseType_t receive_from_isr(hostsim_queue *q, void *buffer, BaseType_t *woken) {
+  if (!q || !can_take(q)) return pdFAIL;
+  get(q, buffer, true);
+  hostsim::mark(q->semaphore ? Mark::Take : Mark::Receive, -1, q->id, q->depth());
+  hostsim_task *t = g_rtos->wake_one(q->senders);
+  if (woken && t && t->prio > g_rtos->current->prio) *woken = pdTRUE;
+  return pdPASS;
+}
+
+void unwait_all(hostsim_queue *q) {
+  while (g_rtos->wake_one(q->receivers)) {
+  }
+  while (g_rtos->wake_one(q->senders)) {
+  }
+}
+
+}  // namespace
+
+/* ------- run */
+namespace hostsim {
+
+void rtos_main(void (*app_main)(void)) {
+  static Rtos rtos;
+  g_rtos = &rtos;
+  rtos.adopt_main();
+  dev->kernel = &rtos;
+  app_main();
+  /* ESP-IDF deletes the main task when app_main returns; the other tasks keep running */
+  rtos.remove(rtos.current);
+}
+
+}  // namespace hostsim
+
+extern "C" {
+
+/* ------- port */
+void hostsim_port_enter_critical(const char *site) {
+  hostsim::call();
+  hostsim::enter_critical(site);
+}
+
+void hostsim_port_exit_critical(const char *) {
+  hostsim::exit_critical();
+  hostsim::call();
+}
+
+void hostsim_port_yield_from_isr(void) { g_rtos->yield_pending = true; }
+
+/* ------- tasks */
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stack_depth, void *params,
+                       UBaseType_t priority, TaskHandle_t *created_task) {
+  hostsim::call();
+  if (!code) return pdFAIL;
+  hostsim_task *t = g_rtos->create(code, name, stack_depth, params, priority);
+  if (created_task) *created_task = t;
+  g_rtos->yield_if_higher(t);
+  return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char *name, uint32_t stack_depth,
+                                   void *params, UBaseType_t priority, TaskHandle_t *created_task,
+                                   BaseType_t) {
+  return xTaskCreate(code, name, stack_depth, params, priority, created_task);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  hostsim::call();
+  g_rtos->remove(self(task));
+}
+
+void vTaskDelay(TickType_t ticks) {
+  dev->api_calls++;
+  hostsim::flush_outputs();
+  if (ticks == 0) {
+    g_rtos->yield();
+    return;
+  }
+  g_rtos->sleep_until(tick_deadline(ticks));
+}
+
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t period) {
+  dev->api_calls++;
+  hostsim::flush_outputs();
+  *previous_wake += period;
+  Time wake = static_cast<Time>(*previous_wake) * kTickUs;
+  if (wake <= dev->now) {
+    g_rtos->yield();
+    return;
+  }
+  g_rtos->sleep_until(wake);
+}
+
+TickType_t xTaskGetTickCount(void) {
+  hostsim::poll_empty(true);
+  return static_cast<TickType_t>(dev->now / kTickUs);
+}
+
+TickType_t xTaskGetTickCountFromISR(void) { return static_cast<TickType_t>(dev->now / kTickUs); }
+
+void vTaskSuspendAll(void) {
+  hostsim::call();
+  g_rtos->suspended++;
+}
+
+BaseType_t xTaskResumeAll(void) {
+  if (g_rtos->suspended > 0) g_rtos->suspended--;
+  g_rtos->yield_pending = true;
+  hostsim::call();
+  return pdFALSE;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  hostsim::call();
+  return g_rtos->high_water_mark(self(task));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return g_rtos->current; }
+
+void taskYIELD(void) {
+  hostsim::call();
+  g_rtos->yield();
+}
+
+/* ------- queues */
+QueueHandle_t hostsim_queue_create(UBaseType_t length, UBaseType_t item_size, const char *site) {
+  hostsim::call();
+  if (length == 0) return nullptr;
+  auto *q = new hostsim_queue;
+  q->length = length;
+  q->item_size = item_size;
+  q->id = timeline_id("queue", site);
+  return q;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+  hostsim::call();
+  if (!queue) return;
+  unwait_all(queue);
+  delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait) {
+  return send(queue, item, ticks_to_wait, false);
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait) {
+  return send(queue, item, ticks_to_wait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait) {
+  return send(queue, item, ticks_to_wait, true);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *higher_prio_woken) {
+  return send_from_isr(queue, item, higher_prio_woken);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *buffer, TickType_t ticks_to_wait) {
+  return receive(queue, buffer, ticks_to_wait, true);
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void *buffer, BaseType_t *higher_prio_woken) {
+  return receive_from_isr(queue, buffer, higher_prio_woken);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *buffer, TickType_t ticks_to_wait) {
+  return receive(queue, buffer, ticks_to_wait, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  hostsim::call();
+  if (!queue) return 0;
+  return queue->semaphore ? queue->count : static_cast<UBaseType_t>(queue->items.size());
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+  hostsim::call();
+  if (!queue) return pdFAIL;
+  queue->items.clear();
+  while (hostsim_task *t = g_rtos->wake_one(queue->senders)) g_rtos->yield_if_higher(t);
+  return pdPASS;
+}
+
+/* ------- semaphores and mutexes */
+SemaphoreHandle_t hostsim_semaphore_create(int is_mutex, UBaseType_t max_count, UBaseType_t initial,
+                                           const char *name) {
+  hostsim::call();
+  auto *q = new hostsim_queue;
+  q->name = name ? name : "";
+  q->semaphore = true;
+  q->mutex = is_mutex != 0;
+  q->recursive = is_mutex == 2;
+  q->max_count = max_count;
+  q->count = std::min(initial, max_count);
+  q->id = timeline_id(q->mutex ? "mutex" : "semaphore", name);
+  return q;
+}
+
+/*
+ * A plain take of a mutex the caller already holds blocks like any other
+ * take; only xSemaphoreTakeRecursive on a recursive mutex nests. With
+ * portMAX_DELAY that, or any cycle of holders, is the hang real FreeRTOS
+ * has, so the run stops there with a `deadlock` error instead.
+ */
+BaseType_t hostsim_semaphore_take(SemaphoreHandle_t sem, TickType_t ticks_to_wait, const char *) {
+  if (!sem) return pdFAIL;
+  hostsim_task *cur = g_rtos->current;
+  hostsim::call();
+  Time deadline = tick_deadline(ticks_to_wait);
+  while (sem->count == 0) {
+    /* priority inheritance: the holder runs at the waiter's priority until it gives */
+    if (sem->mutex && sem->holder && sem->holder->prio < cur->prio) {
+      sem->holder->prio = cur->prio;
+      hostsim::mark(Mark::Inherit, sem->holder->id, sem->id, cur->prio);
+    }
+    /* with portMAX_DELAY a wait that closes a cycle of holders never ends */
+    if (sem->mutex && deadline == kForever) {
+      cur->mutex_wait = sem;
+      std::string why = g_rtos->deadlock(cur);
+      if (!why.empty()) hostsim::fail(why);
+    }
+    bool taken = g_rtos->block_on(sem->receivers, deadline, sem->id);
+    cur->mutex_wait = nullptr;
+    if (!taken) return pdFAIL;
+  }
+  sem->count--;
+  hostsim::mark(Mark::Take, cur->id, sem->id, sem->count);
+  if (sem->mutex) {
+    sem->holder = cur;
+    sem->recursion = 1;
+  }
+  return pdPASS;
+}
+
+/* a plain give releases the mutex whatever the recursion depth, as in FreeRTOS */
+BaseType_t hostsim_semaphore_give(SemaphoreHandle_t sem, const char *) {
+  if (!sem) return pdFAIL;
+  hostsim::call();
+  if (sem->mutex) {
+    if (sem->holder != g_rtos->current) return pdFAIL;
+    sem->holder->prio = sem->holder->base_prio;
+    sem->holder = nullptr;
+    sem->recursion = 0;
+  }
+  if (sem->count >= sem->max_count) return pdFAIL;
+  sem->count++;
+  hostsim::mark(Mark::Give, g_rtos->current->id, sem->id, sem->count);
+  g_rtos->wake_one(sem->receivers);
+  /* also covers the holder dropping an inherited priority */
+  g_rtos->reschedule();
+  return pdPASS;
+}
+
+/* the recursive calls only accept recursive mutexes (FreeRTOS asserts on anything else) */
+BaseType_t hostsim_semaphore_take_recursive(SemaphoreHandle_t sem, TickType_t ticks_to_wait, const char *site) {
+  if (!sem || !sem->recursive) return pdFAIL;
+  if (sem->holder == g_rtos->current) {
+    hostsim::call();
+    sem->recursion++;
+    return pdPASS;
+  }
+  return hostsim_semaphore_take(sem, ticks_to_wait, site);
+}
+
+BaseType_t hostsim_semaphore_give_recursive(SemaphoreHandle_t sem, const char *site) {
+  if (!sem || !sem->recursive || sem->holder != g_rtos->current) return pdFAIL;
+  if (sem->recursion > 1) {
+    hostsim::call();
+    sem->recursion--;
+    return pdPASS;
+  }
+  return hostsim_semaphore_give(sem, site);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *higher_prio_woken) {
+  if (!sem || sem->mutex) return pdFAIL;
+  return send_from_isr(sem, nullptr, higher_prio_woken);
+}
+
+BaseType_t xSemaphoreTakeFromISR(SemaphoreHandle_t sem, BaseType_t *higher_prio_woken) {
+  if (!sem || sem->mutex) return pdFAIL;
+  return receive_from_isr(sem, nullptr, higher_prio_woken);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) { vQueueDelete(sem); }
+
+}  // extern "C"
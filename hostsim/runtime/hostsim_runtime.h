@@ -0,0 +1,338 @@
+/*
+ * Internal runtime state shared by the Arduino and ESP-IDF shims.
+ *
+ * Time is a virtual microsecond clock. Running code costs a small fixed amount
+ * per API call, blocking calls jump the clock, and scripted input events are
+ * applied when the clock passes them. Nothing ever sleeps for real.
+ */
+#ifndef HOSTSIM_RUNTIME_H
+#define HOSTSIM_RUNTIME_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <ucontext.h>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace hostsim {
+
+using Time = uint64_t; /* microseconds */
+
+constexpr Time kForever = ~static_cast<Time>(0);
+
+/* Virtual cost of one cheap API call (pin access, millis, Serial.available ...). */
+constexpr Time kCallUs = 1;
+/* After this many polls in a row that saw nothing new, the clock jumps ahead. */
+constexpr int kIdlePolls = 8;
+/* Upper bound for such a jump when the sketch is also polling millis()/micros(). */
+constexpr Time kTimePollStepUs = 1000;
+
+constexpr int kMaxPins = 64;
+
+/*
+ * What the CPU was doing while the clock moved: running code (API calls,
+ * busy-wait polling, delayMicroseconds), sleeping in delay()/vTaskDelay(), or
+ * blocked with nothing to run until input arrives.
+ */
+enum class TimeClass { Busy, Delay, Idle };
+
+enum class EventKind { Serial, Key, Pin, Button, Release, Adc };
+
+struct Event {
+  Time t;
+  uint64_t seq;
+  EventKind kind;
+  int pin;
+  int value;
+  std::string text;
+  int id = 0; /* script line, to match inputs with their effect */
+};
+
+struct Pin {
+  int mode = -1;        /* Arduino INPUT/OUTPUT/... or -1 when never configured */
+  int out = 0;          /* last written level */
+  int in = 0;           /* level driven from the script */
+  bool driven = false;  /* the script has set `in` */
+  int last_read = -1;   /* last value returned to the sketch, for idle detection */
+  void (*isr)(void) = nullptr;              /* attachInterrupt */
+  void (*handler)(void *) = nullptr;        /* gpio_isr_handler_add */
+  void *handler_arg = nullptr;
+  int isr_mode = 0;                         /* RISING / FALLING / CHANGE */
+  int stim = 0;                             /* script line that last drove the pin */
+};
+
+struct Record {
+  Time t;
+  uint64_t seq;
+  std::string line;
+};
+
+class Lcd;
+
+/* Interrupt-masked spans charged to the line that masked interrupts. */
+struct MaskStats {
+  static constexpr int kBuckets = 7; /* <10 us, <100 us, <1 ms, <10 ms, <100 ms, <1 s, >= 1 s */
+  uint64_t count = 0;
+  Time total = 0;
+  Time max = 0;
+  uint64_t open = 0; /* still masked when the run ended */
+  uint64_t hist[kBuckets] = {};
+};
+
+/*
+ * --timeline: what the scheduler, ISRs, queues, semaphores and LCD buses did,
+ * as fixed-size records in a ring buffer that keeps the most recent ones.
+ * Tasks, queues, semaphores and LCDs are numbered from 1 through `names`,
+ * which is kept apart from the ring so it survives wrapping.
+ */
+enum class Mark : uint8_t {
+  Switch,   /* a: task that ran, b: task that runs now */
+  Idle,     /* a: task that blocked, dur: time with nothing ready */
+  IsrBegin, /* a: pin, c: handler offset in the executable */
+  IsrEnd,   /* a: pin */
+  Block,    /* a: task, b: queue or semaphore it waits on (0: vTaskDelay) */
+  Wake,     /* a: task, b: what it waited on, c: 1 when the wait timed out */
+  Send,     /* a: task (-1: ISR), b: queue, c: items after */
+  Receive,  /* a: task (-1: ISR), b: queue, c: items after */
+  Take,     /* a: task (-1: ISR), b: semaphore or mutex */
+  Give,     /* a: task (-1: ISR), b: semaphore or mutex */
+  Inherit,  /* a: mutex holder, b: mutex, c: priority it inherits */
+  Bus,      /* a: LCD, c: wire bytes, dur: time the transfer held the CPU */
+};
+
+struct TimelineRecord {
+  Time t;
+  Time dur;
+  Mark what;
+  int32_t a;
+  int32_t b;
+  int64_t c;
+};
+
+struct Timeline {
+  std::vector<TimelineRecord> ring; /* empty when not recording */
+  uint64_t recorded = 0;
+  std::vector<std::string> names;   /* "task <prio> <name>", "mutex <site>", "bus lcd i2c" ... */
+};
+
+/*
+ * Installed by the FreeRTOS shim when app_main starts. Arduino sketches run
+ * without one: delay() then simply moves the clock.
+ */
+class Kernel {
+ public:
+  virtual ~Kernel() = default;
+  virtual void sleep_until(Time t) = 0; /* block the running task */
+  virtual void preempt() = 0;           /* preemption point after every API call */
+  virtual Time next_wake() const = 0;   /* when another task next wants the CPU */
+};
+
+/* Everything one simulated device owns. */
+struct Device {
+  Device() = default;
+  Device(const Device &) = delete;
+  Device &operator=(const Device &) = delete;
+  ~Device();
+
+  Time now = 0;
+  Time end = kForever;
+  bool stopped = false;
+  std::string error; /* why the runtime stopped the program (deadlock), empty on a normal run */
+
+  std::vector<Event> events; /* min-heap on (t, seq) */
+  uint64_t event_seq = 0;
+
+  Pin pins[kMaxPins];
+  std::vector<int> input_pins; /* in pinMode order, for `button <k>` events */
+  std::deque<uint8_t> serial_rx;
+  unsigned long serial_baud = 115200;
+  std::string serial_line;   /* TX bytes since the last '\n' */
+  Time serial_tx_busy = 0;   /* when the TX FIFO drains */
+  bool keypad = false;        /* the program has a Keypad to press keys on */
+  std::deque<char> keys;      /* keypad keys being held, oldest first */
+  std::deque<Time> key_until; /* release time of each key */
+  std::deque<int> key_ids;    /* script line of each queued key */
+  std::deque<int> serial_ids; /* script line of each queued serial line */
+  bool trace_inputs = false;  /* record `stim` / `input` lines for latency analysis */
+
+  Kernel *kernel = nullptr;
+
+  bool irq_enabled = true;
+  int critical_depth = 0;
+  Time masked_since = 0;
+  std::string mask_key;      /* site (and callers) of the span in progress */
+  std::map<std::string, MaskStats> masks;
+  bool trace_masks = false;  /* record a `mask` summary line per site at the end */
+  bool trace_bus = false;    /* record a `bus` summary line per LCD at the end */
+  uint32_t i2c_hz = 100000;  /* Wire.setClock / i2c_param_config */
+  std::vector<int> pending_irq;
+  bool in_isr = false;
+
+  int idle_polls = 0;
+  bool idle_time_query = false;
+
+  std::vector<Lcd *> lcds;
+  Timeline timeline;
+  std::vector<Record> trace;
+  uint64_t trace_seq = 0;
+
+  uint64_t api_calls = 0;
+  uint64_t loops = 0;
+  uint64_t inputs = 0;  /* script events applied */
+  uint64_t outputs = 0; /* trace lines emitted, recorded or not */
+  bool keep_trace = true;
+  Time skipped_us = 0;
+  Time time_in[3] = {}; /* by TimeClass */
+  uint32_t rng = 0x2545f491u;
+
+  /* the sketch coroutine; in fleet mode it gives the CPU back once the clock reaches slice_end */
+  ucontext_t ctx;
+  void *stack = nullptr;
+  size_t stack_size = 0;
+  Time slice_end = kForever;
+};
+
+extern Device *dev;
+
+/* ------- clock */
+Time now();
+void advance(Time us);      /* running code: moves the clock and applies due events */
+void advance_to(Time t, TimeClass as = TimeClass::Busy);
+void sleep_for(Time us);    /* blocking wait (delay, vTaskDelay) */
+void busy(Time us);         /* an API call that keeps the CPU busy for us */
+void call();                /* one cheap API call */
+void spin_until(Time t, TimeClass as = TimeClass::Busy); /* busy-wait until t or the next input event */
+void wait_input();          /* block until the next input event */
+
+/* ------- polling: lets busy-wait loops fast-forward to the next input */
+void poll_empty(bool time_query = false);
+void activity();
+Time next_event_time();
+
+/* ------- input */
+void push_event(Event ev);
+bool load_script(const char *path);
+int pin_level(int pin);
+void set_pin_mode(int pin, int mode);
+int read_pin(int pin);                  /* digitalRead / gpio_get_level */
+bool key_ready();                       /* a key is held that has not been read yet */
+char pop_key();
+uint8_t pop_serial();
+void note_input(int id);                /* the program has seen script input `id` */
+void write_pin(int pin, int level);     /* digitalWrite / gpio_set_level */
+
+/* ------- UART0: Serial and the stdio console share it */
+void uart_write(uint8_t c);
+void uart_cost(size_t bytes);           /* TX time only, for log lines */
+FILE *open_console(bool output);        /* stdout / stdin of the ESP-IDF console */
+
+/* ------- interrupts */
+void irq_disable(const char *site);    /* site: "file:line" of the masking call */
+void irq_enable();
+void enter_critical(const char *site);  /* nestable, masks interrupts and preemption */
+void exit_critical();
+
+/* ------- output trace */
+void emit(const char *channel, const std::string &payload);
+void emit_at(Time t, const char *channel, const std::string &payload);
+void flush_outputs();
+bool write_trace(const char *path);
+
+/* ------- timeline */
+int timeline_name(const std::string &name); /* next id, or 0 when not recording */
+void mark(Mark what, int32_t a = 0, int32_t b = 0, int64_t c = 0, Time dur = 0);
+bool write_timeline(const char *path);
+
+/* ------- run */
+void stop();
+void fail(const std::string &why); /* stop with a run error: `panic` line, nonzero exit */
+void start(void (*entry)(void), size_t stack_size); /* set up dev's sketch coroutine */
+void resume();  /* run dev's sketch until it stops or its slice ends */
+void finish();  /* end-of-run summaries and the `end` line */
+void run(void (*entry)(void), size_t stack_size);
+void rtos_main(void (*app_main)(void)); /* run app_main as the ESP-IDF main task */
+
+/* ------- fleet: n copies of an Arduino sketch on one virtual-time scheduler */
+struct FleetOptions {
+  int devices = 1000;
+  Time spread = 1000000; /* device k's script starts k * spread / devices later */
+  Time slice = 100000;   /* virtual time a device runs before the next one gets a turn */
+};
+int run_fleet(void (*entry)(void), size_t stack_size, const char *script, const FleetOptions &opt,
+              const char *trace);
+
+/* How an HD44780 is wired to the MCU. */
+enum class LcdBus { Parallel, I2c };
+
+/* Traffic one LCD put on its bus; bus time is kept for both standard I2C clocks. */
+struct LcdBusStats {
+  uint64_t data = 0;     /* character bytes */
+  uint64_t commands = 0; /* command bytes, clears and homes included */
+  uint64_t clears = 0;   /* clear() and home(), which wait for the controller */
+  uint64_t wire_bytes = 0; /* I2C bytes incl. address, or nibbles on the 4-bit parallel bus */
+  uint64_t transfers = 0; /* I2C transactions, or enable pulses on the parallel bus */
+  Time bus_us[2] = {};    /* at 100 kHz and 400 kHz; the parallel bus has one speed */
+  Time cpu_us = 0;        /* time the driver calls kept the program busy */
+  std::map<Time, Time> per_s[2]; /* bus time per second of run time, at each clock */
+};
+
+/* Shared HD44780 buffer, flushed to the trace as whole rows. */
+class Lcd {
+ public:
+  Lcd(uint8_t cols, uint8_t rows);
+  ~Lcd();
+  void set_bus(LcdBus bus);
+  void resize(uint8_t cols, uint8_t rows);
+  void clear();
+  void home();
+  void set_cursor(uint8_t col, uint8_t row);
+  void put(uint8_t c);
+  void set_display(bool on);
+  void set_backlight(bool on);
+  /* Rows that changed since the last flush go to the trace, stamped with the last write. */
+  void flush();
+  /* One `bus` line with the traffic totals and the busiest second. */
+  void emit_bus() const;
+
+ private:
+  static constexpr int kLineLen = 40;
+  void touch();
+  void send(bool command, Time wait_us = 0);
+  void expander_write();
+  void account(uint64_t wire_bytes, uint64_t transfers, const Time bits[2], Time us);
+  std::string row_text(uint8_t row) const;
+
+  std::string channel_;
+  int timeline_id_ = 0;
+  uint8_t cols_;
+  uint8_t rows_;
+  int addr_ = 0;
+  std::vector<std::string> ddram_; /* two 40-byte DDRAM lines */
+  std::vector<std::string> shown_;
+  bool display_ = true;
+  bool backlight_ = true;
+  bool dirty_ = false;
+  Time changed_at_ = 0;
+  LcdBus bus_ = LcdBus::Parallel;
+  LcdBusStats stats_;
+};
+
+/* Parallel 4-bit wiring: two enable pulses and the library's settle delay per byte. */
+constexpr Time kParallelByteUs = 100;
+/* Clear and home: the libraries wait 2 ms for the controller (1.52 ms in the datasheet). */
+constexpr Time kLcdClearWaitUs = 2000;
+/*
+ * PCF8574 backpack in 4-bit mode: every HD44780 byte is two nibbles, each
+ * written three times (data, data|EN, data) as a 2-byte I2C transaction of
+ * start + 9-bit address + 9-bit data + stop, with 50 us settle per nibble.
+ */
+constexpr int kI2cTransfersPerByte = 6;
+constexpr Time kI2cBitsPerTransfer = 20;
+constexpr Time kI2cSettleUs = 100;
+
+}  // namespace hostsim
+
+#endif /* HOSTSIM_RUNTIME_H */
@@ -0,0 +1,222 @@
+/*
+ * HD44780 character LCD model and the Arduino LCD drivers on top of it.
+ * Each driver only differs in its wiring, which sets what a byte costs on the
+ * bus; the model counts that traffic for --bus.
+ */
+#include <algorithm>
+
+#include "LiquidCrystal.h"
+#include "LiquidCrystal_I2C.h"
+#include "hostsim_runtime.h"
+
+namespace hostsim {
+
+Lcd::Lcd(uint8_t cols, uint8_t rows) : cols_(cols), rows_(rows) {
+  ddram_.assign(2, std::string(kLineLen, ' '));
+  shown_.assign(rows, std::string());
+  size_t idx = dev->lcds.size();
+  channel_ = idx == 0 ? "lcd" : "lcd" + std::to_string(idx);
+  dev->lcds.push_back(this);
+}
+
+Lcd::~Lcd() {
+  auto &lcds = dev->lcds;
+  lcds.erase(std::remove(lcds.begin(), lcds.end(), this), lcds.end());
+}
+
+void Lcd::set_bus(LcdBus bus) { bus_ = bus; }
+
+void Lcd::account(uint64_t wire_bytes, uint64_t transfers, const Time bus_us[2], Time us) {
+  stats_.wire_bytes += wire_bytes;
+  stats_.transfers += transfers;
+  stats_.cpu_us += us;
+  for (int k = 0; k < 2; k++) {
+    stats_.bus_us[k] += bus_us[k];
+    if (dev->trace_bus) stats_.per_s[k][dev->now / 1000000] += bus_us[k];
+  }
+  if (!dev->timeline.ring.empty()) {
+    if (!timeline_id_) timeline_id_ = timeline_name("bus " + channel_ + (bus_ == LcdBus::I2c ? " i2c" : " parallel"));
+    mark(Mark::Bus, timeline_id_, 0, static_cast<int64_t>(wire_bytes), us);
+  }
+  busy(us);
+}
+
+/* One byte to the controller; clear and home then wait for it to finish. */
+void Lcd::send(bool command, Time wait_us) {
+  if (command) {
+    stats_.commands++;
+  } else {
+    stats_.data++;
+  }
+  if (bus_ == LcdBus::Parallel) {
+    const Time bus_us[2] = {kParallelByteUs, kParallelByteUs};
+    account(2, 2, bus_us, kParallelByteUs + wait_us);
+    return;
+  }
+  constexpr Time kBits = kI2cTransfersPerByte * kI2cBitsPerTransfer;
+  const Time bus_us[2] = {kBits * 1000000 / 100000, kBits * 1000000 / 400000};
+  account(2 * kI2cTransfersPerByte, kI2cTransfersPerByte, bus_us,
+          kBits * 1000000 / dev->i2c_hz + kI2cSettleUs + wait_us);
+}
+
+/* The backlight is a PCF8574 pin: a single 2-byte transaction, no HD44780 byte. */
+void Lcd::expander_write() {
+  if (bus_ == LcdBus::Parallel) {
+    call();
+    return;
+  }
+  const Time bus_us[2] = {kI2cBitsPerTransfer * 1000000 / 100000, kI2cBitsPerTransfer * 1000000 / 400000};
+  account(2, 1, bus_us, kI2cBitsPerTransfer * 1000000 / dev->i2c_hz);
+}
+
+void Lcd::emit_bus() const {
+  std::string payload = channel_ + (bus_ == LcdBus::I2c ? " i2c" : " parallel");
+  auto field = [&payload](const char *name, uint64_t value) {
+    payload += ' ';
+    payload += name;
+    payload += '=';
+    payload += std::to_string(value);
+  };
+  field("data", stats_.data);
+  field("commands", stats_.commands);
+  field("clears", stats_.clears);
+  field("wire_bytes", stats_.wire_bytes);
+  field("transfers", stats_.transfers);
+  field("bus_us_100k", stats_.bus_us[0]);
+  field("bus_us_400k", stats_.bus_us[1]);
+  field("cpu_us", stats_.cpu_us);
+  field("active_s", stats_.per_s[0].size());
+  Time peak[2] = {};
+  for (int k = 0; k < 2; k++) {
+    for (const auto &[second, us] : stats_.per_s[k]) peak[k] = std::max(peak[k], us);
+  }
+  field("peak_us_per_s_100k", peak[0]);
+  field("peak_us_per_s_400k", peak[1]);
+  emit("bus", payload);
+}
+
+void Lcd::resize(uint8_t cols, uint8_t rows) {
+  cols_ = cols ? cols : cols_;
+  rows_ = rows ? rows : rows_;
+  shown_.resize(rows_);
+}
+
+void Lcd::touch() {
+  dirty_ = true;
+  changed_at_ = dev->now;
+}
+
+void Lcd::clear() {
+  for (auto &line : ddram_) line.assign(kLineLen, ' ');
+  addr_ = 0;
+  touch();
+  stats_.clears++;
+  send(true, kLcdClearWaitUs);
+}
+
+void Lcd::home() {
+  addr_ = 0;
+  stats_.clears++;
+  send(true, kLcdClearWaitUs);
+}
+
+/* 4-line modules continue line 0/1 at column `cols`, like the real DDRAM map. */
+void Lcd::set_cursor(uint8_t col, uint8_t row) {
+  if (row >= rows_) row = rows_ - 1;
+  addr_ = (row % 2) * kLineLen + (row / 2) * cols_ + col;
+  addr_ %= 2 * kLineLen;
+  send(true);
+}
+
+void Lcd::put(uint8_t c) {
+  ddram_[addr_ / kLineLen][addr_ % kLineLen] = static_cast<char>(c < 0x20 ? '?' : c);
+  addr_ = (addr_ + 1) % (2 * kLineLen);
+  touch();
+  send(false);
+}
+
+void Lcd::set_display(bool on) {
+  if (display_ != on) touch();
+  display_ = on;
+  send(true);
+}
+
+void Lcd::set_backlight(bool on) {
+  if (backlight_ != on) emit((channel_ + "ctl").c_str(), on ? "backlight 1" : "backlight 0");
+  backlight_ = on;
+  expander_write();
+}
+
+std::string Lcd::row_text(uint8_t row) const {
+  if (!display_) return std::string();
+  size_t offset = (row / 2) * cols_;
+  std::string text = ddram_[row % 2].substr(std::min<size_t>(offset, kLineLen), cols_);
+  text.erase(text.find_last_not_of(' ') + 1);
+  return text;
+}
+
+void Lcd::flush() {
+  if (!dirty_) return;
+  dirty_ = false;
+  for (uint8_t r = 0; r < rows_; r++) {
+    std::string text = row_text(r);
+    if (text == shown_[r]) continue;
+    shown_[r] = text;
+    emit_at(changed_at_, channel_.c_str(), std::to_string(r) + ":" + text);
+  }
+}
+
+}  // namespace hostsim
+
+/* ------- HostLcd */
+HostLcd::HostLcd(uint8_t cols, uint8_t rows) : model_(new hostsim::Lcd(cols, rows)) {}
+
+HostLcd::~HostLcd() { delete model_; }
+
+void HostLcd::clear(void) { model_->clear(); }
+void HostLcd::home(void) { model_->home(); }
+void HostLcd::setCursor(uint8_t col, uint8_t row) { model_->set_cursor(col, row); }
+void HostLcd::display(void) { model_->set_display(true); }
+void HostLcd::noDisplay(void) { model_->set_display(false); }
+void HostLcd::cursor(void) { hostsim::call(); }
+void HostLcd::noCursor(void) { hostsim::call(); }
+void HostLcd::blink(void) { hostsim::call(); }
+void HostLcd::noBlink(void) { hostsim::call(); }
+
+size_t HostLcd::write(uint8_t c) {
+  model_->put(c);
+  return 1;
+}
+
+/* ------- LiquidCrystal */
+using hostsim::LcdBus;
+
+LiquidCrystal::LiquidCrystal(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t) : HostLcd(16, 2) {
+  model_->set_bus(LcdBus::Parallel);
+}
+
+LiquidCrystal::LiquidCrystal(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t)
+    : HostLcd(16, 2) {
+  model_->set_bus(LcdBus::Parallel);
+}
+
+void LiquidCrystal::begin(uint8_t cols, uint8_t rows) {
+  model_->resize(cols, rows);
+  model_->clear();
+}
+
+/* ------- LiquidCrystal_I2C */
+LiquidCrystal_I2C::LiquidCrystal_I2C(uint8_t, uint8_t cols, uint8_t rows) : HostLcd(cols, rows) {
+  model_->set_bus(LcdBus::I2c);
+}
+
+void LiquidCrystal_I2C::init(void) { model_->clear(); }
+void LiquidCrystal_I2C::begin(void) { model_->clear(); }
+
+void LiquidCrystal_I2C::begin(uint8_t cols, uint8_t rows) {
+  model_->resize(cols, rows);
+  model_->clear();
+}
+
+void LiquidCrystal_I2C::backlight(void) { model_->set_backlight(true); }
+void LiquidCrystal_I2C::noBacklight(void) { model_->set_backlight(false); }
@@ -0,0 +1,218 @@
+/*
+ * Sketch driver: runs setup() once and loop() forever on the virtual clock, or
+ * app_main() as the ESP-IDF main task when the program defines one.
+ *
+ *   sketch [--script events.txt] [--duration-ms 60000] [--trace out.txt|-] [--seed N] [--inputs] [--masks] [--bus]
+ *          [--timeline out.tl [--timeline-size 262144]]
+ *   sketch --batch runs.txt [--duration-ms 60000] [--timeout-s 10] ...
+ *   sketch --fleet 10000 [--spread-ms 1000] [--slice-ms 100] [--script events.txt] ...
+ *
+ * --inputs adds `stim <line>` when a script event is applied and `input <line>`
+ * when the program first sees it, for input-to-output latency.
+ * --masks adds one `mask <file:line> <return addresses> count total_us max_us open
+ * hist...` line per noInterrupts()/portENTER_CRITICAL() site and call path at
+ * the end of the run. Unwinding for the call path costs some task stack.
+ * --bus adds one `bus <lcd> <wiring> key=value...` line per LCD with the bytes,
+ * commands, clears and bus time at 100/400 kHz it put on the wire.
+ * --timeline writes the newest --timeline-size task switch, ISR, queue,
+ * semaphore and LCD bus records to a separate file (see timeline.cpp).
+ *
+ * --batch runs one script per line of `runs.txt` (`<script> <trace> [duration_ms]`),
+ * each in a child forked before the sketch has touched any state, so many short
+ * runs cost a fork instead of an exec. One `<trace> ok|exit N|signal N` status
+ * line per run goes to stdout; a child still running after --timeout-s is killed.
+ *
+ * --fleet runs that many copies of an Arduino sketch in this process (see
+ * fleet.cpp); the binary must be a fleet build. The trace is device 0's.
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+#include "hostsim_runtime.h"
+
+/* whichever entry points the sketch defines */
+extern "C" void app_main(void) __attribute__((weak));
+void setup(void) __attribute__((weak));
+void loop(void) __attribute__((weak));
+
+namespace {
+
+constexpr size_t kSketchStack = 1 << 20;
+constexpr size_t kTimelineSize = 1 << 18;
+
+const char *g_timeline = nullptr;
+
+void arduino_main() {
+  setup();
+  for (;;) {
+    loop();
+    hostsim::dev->loops++;
+    hostsim::poll_empty();
+  }
+}
+
+void esp_main() { hostsim::rtos_main(app_main); }
+
+void usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [--script FILE | --batch FILE | --fleet N] [--duration-ms MS] [--trace FILE|-] [--seed N] "
+          "[--timeout-s S] [--spread-ms MS] [--slice-ms MS] [--inputs] [--masks] [--bus] "
+          "[--timeline FILE] [--timeline-size N]\n",
+          argv0);
+}
+
+int run_one(const char *script, const char *trace, double duration_ms) {
+  if (script && !hostsim::load_script(script)) {
+    fprintf(stderr, "hostsim: cannot read script %s\n", script);
+    return 2;
+  }
+  hostsim::dev->end = static_cast<hostsim::Time>(duration_ms * 1000.0);
+  /* the program's stdio is the device console; the trace still goes to the real stdout */
+  FILE *host_stdout = stdout;
+  FILE *host_stdin = stdin;
+  stdout = hostsim::open_console(true);
+  stdin = hostsim::open_console(false);
+  hostsim::run(app_main ? esp_main : arduino_main, kSketchStack);
+  fclose(stdout);
+  fclose(stdin);
+  stdout = host_stdout;
+  stdin = host_stdin;
+  if (!hostsim::write_trace(trace)) {
+    fprintf(stderr, "hostsim: cannot write trace %s\n", trace);
+    return 2;
+  }
+  if (g_timeline && !hostsim::write_timeline(g_timeline)) {
+    fprintf(stderr, "hostsim: cannot write timeline %s\n", g_timeline);
+    return 2;
+  }
+  if (!hostsim::dev->error.empty()) {
+    fprintf(stderr, "hostsim: %s\n", hostsim::dev->error.c_str());
+    return 3;
+  }
+  return 0;
+}
+
+int run_batch(const char *list, double duration_ms, unsigned timeout_s) {
+  FILE *fp = fopen(list, "r");
+  if (!fp) {
+    fprintf(stderr, "hostsim: cannot read batch %s\n", list);
+    return 2;
+  }
+  char line[4096];
+  while (fgets(line, sizeof(line), fp)) {
+    char script[2048], trace[2048];
+    double ms = duration_ms;
+    if (sscanf(line, "%2047s %2047s %lf", script, trace, &ms) < 2 || script[0] == '#') continue;
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+      perror("hostsim: fork");
+      fclose(fp);
+      return 2;
+    }
+    if (pid == 0) {
+      fclose(fp);
+      alarm(timeout_s);
+      int code = run_one(script, trace, ms);
+      fflush(stdout);
+      fflush(stderr);
+      _exit(code);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+      printf("%s ok\n", trace);
+    } else if (WIFEXITED(status)) {
+      printf("%s exit %d\n", trace, WEXITSTATUS(status));
+    } else {
+      printf("%s signal %d\n", trace, WTERMSIG(status));
+    }
+  }
+  fclose(fp);
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const char *script = nullptr;
+  const char *trace = "-";
+  const char *batch = nullptr;
+  double duration_ms = 60000;
+  unsigned timeout_s = 10;
+  hostsim::FleetOptions fleet;
+  bool use_fleet = false;
+  size_t timeline_size = kTimelineSize;
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (strcmp(arg, "--inputs") == 0) {
+      hostsim::dev->trace_inputs = true;
+      continue;
+    }
+    if (strcmp(arg, "--masks") == 0) {
+      hostsim::dev->trace_masks = true;
+      continue;
+    }
+    if (strcmp(arg, "--bus") == 0) {
+      hostsim::dev->trace_bus = true;
+      continue;
+    }
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!value) {
+      usage(argv[0]);
+      return 2;
+    }
+    if (strcmp(arg, "--script") == 0) {
+      script = value;
+    } else if (strcmp(arg, "--duration-ms") == 0) {
+      duration_ms = atof(value);
+    } else if (strcmp(arg, "--trace") == 0) {
+      trace = value;
+    } else if (strcmp(arg, "--batch") == 0) {
+      batch = value;
+    } else if (strcmp(arg, "--timeout-s") == 0) {
+      timeout_s = static_cast<unsigned>(strtoul(value, nullptr, 0));
+    } else if (strcmp(arg, "--fleet") == 0) {
+      fleet.devices = atoi(value);
+      use_fleet = true;
+    } else if (strcmp(arg, "--spread-ms") == 0) {
+      fleet.spread = static_cast<hostsim::Time>(atof(value) * 1000.0);
+    } else if (strcmp(arg, "--slice-ms") == 0) {
+      fleet.slice = static_cast<hostsim::Time>(atof(value) * 1000.0);
+    } else if (strcmp(arg, "--timeline") == 0) {
+      g_timeline = value;
+    } else if (strcmp(arg, "--timeline-size") == 0) {
+      timeline_size = strtoul(value, nullptr, 0);
+    } else if (strcmp(arg, "--seed") == 0) {
+      randomSeed(strtoul(value, nullptr, 0));
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+    i++;
+  }
+  if (!app_main && !(setup && loop)) {
+    fprintf(stderr, "hostsim: no app_main() or setup()/loop() to run\n");
+    return 2;
+  }
+  if (g_timeline) hostsim::dev->timeline.ring.resize(std::max<size_t>(1, timeline_size));
+  if (batch) return run_batch(batch, duration_ms, timeout_s);
+  if (use_fleet) {
+    if (app_main) {
+      fprintf(stderr, "hostsim: --fleet runs Arduino sketches only\n");
+      return 2;
+    }
+    hostsim::dev->end = static_cast<hostsim::Time>(duration_ms * 1000.0);
+    int code = hostsim::run_fleet(arduino_main, kSketchStack, script, fleet, trace);
+    /* every device ran the sketch's constructors, so the registered destructors must not run */
+    fflush(stdout);
+    _exit(code);
+  }
+  return run_one(script, trace, duration_ms);
+}
@@ -0,0 +1,95 @@
+/*
+ * Arduino Print: number and float formatting on top of write(uint8_t).
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Arduino.h"
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) n += write(*buffer++);
+  return n;
+}
+
+size_t Print::write(const char *str) { return str ? write(reinterpret_cast<const uint8_t *>(str), strlen(str)) : 0; }
+
+size_t Print::write(const char *buffer, size_t size) {
+  return write(reinterpret_cast<const uint8_t *>(buffer), size);
+}
+
+size_t Print::printNumber(unsigned long long n, int base) {
+  if (base < 2) base = 10;
+  char buf[72];
+  char *str = &buf[sizeof(buf) - 1];
+  *str = '\0';
+  do {
+    int digit = static_cast<int>(n % base);
+    *--str = static_cast<char>(digit < 10 ? '0' + digit : 'A' + digit - 10);
+    n /= base;
+  } while (n);
+  return write(str);
+}
+
+size_t Print::print(const __FlashStringHelper *str) { return write(reinterpret_cast<const char *>(str)); }
+size_t Print::print(const String &s) { return write(s.c_str(), s.length()); }
+size_t Print::print(const char *str) { return write(str); }
+size_t Print::print(char c) { return write(static_cast<uint8_t>(c)); }
+size_t Print::print(unsigned char n, int base) { return print(static_cast<unsigned long long>(n), base); }
+size_t Print::print(int n, int base) { return print(static_cast<long long>(n), base); }
+size_t Print::print(unsigned int n, int base) { return print(static_cast<unsigned long long>(n), base); }
+size_t Print::print(long n, int base) { return print(static_cast<long long>(n), base); }
+size_t Print::print(unsigned long n, int base) { return print(static_cast<unsigned long long>(n), base); }
+
+size_t Print::print(long long n, int base) {
+  if (base == 0) return write(static_cast<uint8_t>(n));
+  if (base == 10 && n < 0) return print('-') + printNumber(0ULL - static_cast<unsigned long long>(n), 10);
+  return printNumber(static_cast<unsigned long long>(n), base);
+}
+
+size_t Print::print(unsigned long long n, int base) {
+  if (base == 0) return write(static_cast<uint8_t>(n));
+  return printNumber(n, base);
+}
+
+/* Same special cases as the Arduino core's printFloat. */
+size_t Print::print(double n, int digits) {
+  if (std::isnan(n)) return print("nan");
+  if (std::isinf(n)) return print("inf");
+  if (n > 4294967040.0 || n < -4294967040.0) return print("ovf");
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", digits < 0 ? 0 : digits, n);
+  return print(buf);
+}
+
+size_t Print::println(void) { return write("\r\n"); }
+size_t Print::println(const __FlashStringHelper *str) { return print(str) + println(); }
+size_t Print::println(const String &s) { return print(s) + println(); }
+size_t Print::println(const char *str) { return print(str) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(unsigned char n, int base) { return print(n, base) + println(); }
+size_t Print::println(int n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned int n, int base) { return print(n, base) + println(); }
+size_t Print::println(long n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned long n, int base) { return print(n, base) + println(); }
+size_t Print::println(long long n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned long long n, int base) { return print(n, base) + println(); }
+size_t Print::println(double n, int digits) { return print(n, digits) + println(); }
+
+size_t Print::printf(const char *format, ...) {
+  char small[128];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(small, sizeof(small), format, args);
+  va_end(args);
+  if (len < 0) return 0;
+  if (static_cast<size_t>(len) < sizeof(small)) return write(small, len);
+  std::vector<char> big(len + 1);
+  va_start(args, format);
+  vsnprintf(big.data(), big.size(), format, args);
+  va_end(args);
+  return write(big.data(), len);
+}
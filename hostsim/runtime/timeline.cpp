@@ -0,0 +1,56 @@
+/*
+ * --timeline: a flight recorder of task switches, ISRs, queue and semaphore
+ * operations and LCD bus transfers. The ring keeps the newest records; the
+ * file written at the end holds the names, then the records oldest first:
+ *
+ *   # timeline capacity=262144 recorded=1234
+ *   name 1 task 1 main
+ *   name 2 mutex sketch.c:621
+ *   <t_us> <dur_us> <what> <a> <b> <c>
+ */
+#include <cstdio>
+#include <cstring>
+
+#include "hostsim_runtime.h"
+
+namespace hostsim {
+
+namespace {
+
+const char *const kMarkNames[] = {"switch", "idle", "isr", "isr_end", "block", "wake",
+                                  "send", "receive", "take", "give", "inherit", "bus"};
+
+}  // namespace
+
+int timeline_name(const std::string &name) {
+  Timeline &tl = dev->timeline;
+  if (tl.ring.empty()) return 0;
+  tl.names.push_back(name);
+  return static_cast<int>(tl.names.size());
+}
+
+void mark(Mark what, int32_t a, int32_t b, int64_t c, Time dur) {
+  Timeline &tl = dev->timeline;
+  if (tl.ring.empty()) return;
+  tl.ring[tl.recorded++ % tl.ring.size()] = {dev->now, dur, what, a, b, c};
+}
+
+bool write_timeline(const char *path) {
+  const Timeline &tl = dev->timeline;
+  FILE *fp = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+  if (!fp) return false;
+  fprintf(fp, "# timeline capacity=%zu recorded=%llu\n", tl.ring.size(),
+          static_cast<unsigned long long>(tl.recorded));
+  for (size_t i = 0; i < tl.names.size(); i++) fprintf(fp, "name %zu %s\n", i + 1, tl.names[i].c_str());
+  uint64_t first = tl.recorded > tl.ring.size() ? tl.recorded - tl.ring.size() : 0;
+  for (uint64_t i = first; i < tl.recorded; i++) {
+    const TimelineRecord &r = tl.ring[i % tl.ring.size()];
+    fprintf(fp, "%llu %llu %s %d %d %lld\n", static_cast<unsigned long long>(r.t),
+            static_cast<unsigned long long>(r.dur), kMarkNames[static_cast<int>(r.what)], r.a, r.b,
+            static_cast<long long>(r.c));
+  }
+  if (fp != stdout) fclose(fp);
+  return true;
+}
+
+}  // namespace hostsim
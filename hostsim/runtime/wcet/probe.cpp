@@ -0,0 +1,124 @@
+/*
+ * WCET loop-bound probe. bench.wcet builds the sketch with
+ * -fsanitize-coverage=trace-pc and links this file, so every basic block of
+ * the sketch calls __sanitizer_cov_trace_pc(). The return address names the
+ * block ("site", as an offset in the executable).
+ *
+ * HOSTSIM_WCET_LOOPS lists the loops found in the binary, one per line:
+ *
+ *   <header site> <body site>...        (hex)
+ *
+ * Reaching the header from a body site of the same invocation is one more
+ * iteration; reaching it from anywhere else enters the loop afresh. The
+ * invocation is told apart by the caller's frame pointer, which also keeps
+ * FreeRTOS tasks, each on its own stack, apart. At exit the most iterations
+ * seen per entry are written to HOSTSIM_WCET_OUT:
+ *
+ *   <header site> <max iterations> <entries>
+ */
+#include <dlfcn.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+struct Loop {
+  std::unordered_set<uintptr_t> body;
+  uint64_t max_iterations = 0;
+  uint64_t entries = 0;
+};
+
+struct Pair {
+  uintptr_t frame;
+  uintptr_t site;
+  bool operator==(const Pair &o) const { return frame == o.frame && site == o.site; }
+};
+
+struct PairHash {
+  size_t operator()(const Pair &p) const { return std::hash<uintptr_t>()(p.frame * 31 + p.site); }
+};
+
+struct Probe {
+  uintptr_t base = 0;
+  std::unordered_map<uintptr_t, Loop> loops;             /* by header site */
+  std::unordered_map<uintptr_t, uintptr_t> last;         /* frame -> last site */
+  std::unordered_map<Pair, uint64_t, PairHash> running;  /* (frame, header) -> iterations so far */
+
+  void load(const char *path) {
+    FILE *fp = path ? fopen(path, "r") : nullptr;
+    if (!fp) return;
+    char line[1 << 16];
+    while (fgets(line, sizeof(line), fp)) {
+      char *p = line, *end = nullptr;
+      uintptr_t header = strtoull(p, &end, 16);
+      if (end == p) continue;
+      Loop &loop = loops[header];
+      for (p = end;; p = end) {
+        uintptr_t site = strtoull(p, &end, 16);
+        if (end == p) break;
+        loop.body.insert(site);
+      }
+    }
+    fclose(fp);
+  }
+
+  void hit(uintptr_t frame, uintptr_t site) {
+    uintptr_t &prev = last[frame];
+    auto it = loops.find(site);
+    if (it != loops.end()) {
+      uint64_t &n = running[{frame, site}];
+      if (n && it->second.body.count(prev)) {
+        n++;
+      } else {
+        if (n > it->second.max_iterations) it->second.max_iterations = n;
+        n = 1;
+        it->second.entries++;
+      }
+    }
+    prev = site;
+  }
+
+  void write(const char *path) {
+    FILE *fp = path ? fopen(path, "w") : nullptr;
+    if (!fp) return;
+    for (auto &r : running) {
+      Loop &loop = loops[r.first.site];
+      if (r.second > loop.max_iterations) loop.max_iterations = r.second;
+    }
+    for (auto &l : loops) {
+      fprintf(fp, "%lx %llu %llu\n", static_cast<unsigned long>(l.first),
+              static_cast<unsigned long long>(l.second.max_iterations),
+              static_cast<unsigned long long>(l.second.entries));
+    }
+    fclose(fp);
+  }
+};
+
+/* created on first use: the sketch's own constructors already run instrumented code */
+Probe *g_probe = nullptr;
+
+void write_probe() { g_probe->write(getenv("HOSTSIM_WCET_OUT")); }
+
+}  // namespace
+
+extern "C" void __sanitizer_cov_trace_pc(void) {
+  if (!g_probe) {
+    g_probe = new Probe;
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void *>(&__sanitizer_cov_trace_pc), &info)) {
+      g_probe->base = reinterpret_cast<uintptr_t>(info.dli_fbase);
+    }
+    g_probe->load(getenv("HOSTSIM_WCET_LOOPS"));
+    atexit(write_probe);
+  }
+  uintptr_t site = reinterpret_cast<uintptr_t>(__builtin_return_address(0)) - g_probe->base;
+  /* the sketch is built with -fno-omit-frame-pointer, so one level up is its frame */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wframe-address"
+  g_probe->hit(reinterpret_cast<uintptr_t>(__builtin_frame_address(1)), site);
+#pragma GCC diagnostic pop
+}
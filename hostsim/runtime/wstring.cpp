@@ -0,0 +1,254 @@
+/*
+ * Arduino String over std::string.
+ */
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Arduino.h"
+
+namespace {
+
+std::string format_int(unsigned long long value, bool negative, unsigned char base) {
+  if (base < 2 || base > 36) base = 10;
+  char buf[72];
+  int i = sizeof(buf) - 1;
+  buf[i] = '\0';
+  do {
+    int digit = static_cast<int>(value % base);
+    buf[--i] = static_cast<char>(digit < 10 ? '0' + digit : 'a' + digit - 10);
+    value /= base;
+  } while (value);
+  if (negative) buf[--i] = '-';
+  return std::string(buf + i);
+}
+
+std::string format_signed(long long value, unsigned char base) {
+  /* like Arduino, only base 10 prints a sign; other bases show the two's complement */
+  if (base == 10 && value < 0) return format_int(0ULL - static_cast<unsigned long long>(value), true, base);
+  return format_int(static_cast<unsigned long>(value), false, base);
+}
+
+std::string format_float(double value, unsigned char decimal_places) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", decimal_places, value);
+  return buf;
+}
+
+}  // namespace
+
+String::String(const char *cstr) : buf_(cstr ? cstr : "") {}
+String::String(const __FlashStringHelper *str) : buf_(reinterpret_cast<const char *>(str)) {}
+String::String(char c) : buf_(1, c) {}
+String::String(unsigned char value, unsigned char base) : buf_(format_int(value, false, base)) {}
+String::String(int value, unsigned char base) : buf_(format_signed(value, base)) {}
+String::String(unsigned int value, unsigned char base) : buf_(format_int(value, false, base)) {}
+String::String(long value, unsigned char base) : buf_(format_signed(value, base)) {}
+String::String(unsigned long value, unsigned char base) : buf_(format_int(value, false, base)) {}
+String::String(float value, unsigned char decimal_places) : buf_(format_float(value, decimal_places)) {}
+String::String(double value, unsigned char decimal_places) : buf_(format_float(value, decimal_places)) {}
+
+String &String::operator=(const char *cstr) {
+  buf_ = cstr ? cstr : "";
+  return *this;
+}
+
+bool String::reserve(unsigned int size) {
+  buf_.reserve(size);
+  return true;
+}
+
+bool String::concat(const String &str) {
+  buf_ += str.buf_;
+  return true;
+}
+
+bool String::concat(const char *cstr) {
+  if (!cstr) return false;
+  buf_ += cstr;
+  return true;
+}
+
+bool String::concat(char c) {
+  buf_ += c;
+  return true;
+}
+
+bool String::concat(int num) { return concat(String(num)); }
+bool String::concat(unsigned int num) { return concat(String(num)); }
+bool String::concat(long num) { return concat(String(num)); }
+bool String::concat(unsigned long num) { return concat(String(num)); }
+bool String::concat(double num) { return concat(String(num)); }
+
+String operator+(const String &lhs, const String &rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+String operator+(const String &lhs, const char *rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+String operator+(const String &lhs, char rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+String operator+(const String &lhs, int rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+String operator+(const String &lhs, unsigned int rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+String operator+(const String &lhs, long rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+String operator+(const String &lhs, unsigned long rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+String operator+(const String &lhs, double rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+String operator+(const char *lhs, const String &rhs) {
+  String s(lhs);
+  s.concat(rhs);
+  return s;
+}
+
+bool String::equalsIgnoreCase(const String &s) const {
+  if (buf_.size() != s.buf_.size()) return false;
+  for (size_t i = 0; i < buf_.size(); i++) {
+    if (tolower(static_cast<unsigned char>(buf_[i])) != tolower(static_cast<unsigned char>(s.buf_[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool String::startsWith(const String &prefix) const { return buf_.compare(0, prefix.buf_.size(), prefix.buf_) == 0; }
+
+bool String::endsWith(const String &suffix) const {
+  return buf_.size() >= suffix.buf_.size() &&
+         buf_.compare(buf_.size() - suffix.buf_.size(), suffix.buf_.size(), suffix.buf_) == 0;
+}
+
+char String::charAt(unsigned int index) const { return index < buf_.size() ? buf_[index] : '\0'; }
+
+void String::setCharAt(unsigned int index, char c) {
+  if (index < buf_.size()) buf_[index] = c;
+}
+
+char &String::operator[](unsigned int index) {
+  static char dummy;
+  if (index >= buf_.size()) {
+    dummy = '\0';
+    return dummy;
+  }
+  return buf_[index];
+}
+
+void String::getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index) const {
+  toCharArray(reinterpret_cast<char *>(buf), bufsize, index);
+}
+
+void String::toCharArray(char *buf, unsigned int bufsize, unsigned int index) const {
+  if (!buf || bufsize == 0) return;
+  if (index >= buf_.size()) {
+    buf[0] = '\0';
+    return;
+  }
+  size_t n = std::min<size_t>(bufsize - 1, buf_.size() - index);
+  buf_.copy(buf, n, index);
+  buf[n] = '\0';
+}
+
+int String::indexOf(char ch, unsigned int from_index) const {
+  size_t pos = buf_.find(ch, from_index);
+  return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+int String::indexOf(const String &str, unsigned int from_index) const {
+  size_t pos = buf_.find(str.buf_, from_index);
+  return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+int String::lastIndexOf(char ch) const {
+  size_t pos = buf_.rfind(ch);
+  return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+int String::lastIndexOf(const String &str) const {
+  size_t pos = buf_.rfind(str.buf_);
+  return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+String String::substring(unsigned int begin_index) const { return substring(begin_index, length()); }
+
+String String::substring(unsigned int begin_index, unsigned int end_index) const {
+  if (begin_index > end_index) std::swap(begin_index, end_index);
+  end_index = std::min(end_index, length());
+  String s;
+  if (begin_index < end_index) s.buf_ = buf_.substr(begin_index, end_index - begin_index);
+  return s;
+}
+
+void String::replace(char find, char replace_with) { std::replace(buf_.begin(), buf_.end(), find, replace_with); }
+
+void String::replace(const String &find, const String &replace_with) {
+  if (find.buf_.empty()) return;
+  size_t pos = 0;
+  while ((pos = buf_.find(find.buf_, pos)) != std::string::npos) {
+    buf_.replace(pos, find.buf_.size(), replace_with.buf_);
+    pos += replace_with.buf_.size();
+  }
+}
+
+void String::remove(unsigned int index) {
+  if (index < buf_.size()) buf_.erase(index);
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+  if (index < buf_.size()) buf_.erase(index, count);
+}
+
+void String::toLowerCase(void) {
+  for (char &c : buf_) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+}
+
+void String::toUpperCase(void) {
+  for (char &c : buf_) c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+}
+
+void String::trim(void) {
+  size_t begin = buf_.find_first_not_of(" \t\r\n\v\f");
+  if (begin == std::string::npos) {
+    buf_.clear();
+    return;
+  }
+  size_t end = buf_.find_last_not_of(" \t\r\n\v\f");
+  buf_ = buf_.substr(begin, end - begin + 1);
+}
+
+long String::toInt(void) const { return atol(buf_.c_str()); }
+float String::toFloat(void) const { return static_cast<float>(atof(buf_.c_str())); }
+double String::toDouble(void) const { return atof(buf_.c_str()); }
@@ -22,6 +22,7 @@ prompts: list[PromptEntry]  = [
     PromptEntry('p6', 'structured error handling'),
     PromptEntry('p7', 'code documentation and annotation'),
     PromptEntry('p8', 'consistency for naming conventions and formatting'),
+    PromptEntry('p9', 'real-time performance'),
 ]
 
 PROMPT_INDEX:dict[str, PromptEntry] = {p.prompt_name: p for p in prompts}
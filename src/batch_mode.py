@@ -0,0 +1,329 @@
+"""
+offline batch 모드.
+stage 단위로 모든 (model, query) 의 독립적인 요청을 batch-API 형식 JSONL 로 모아서 한 번에 보낸다.
+
+round k 에는 generation step k (모든 model x query) 와 아직 안 된 evaluation 이 같이 들어간다.
+결과를 ingest 하면 다음 round 의 요청이 생긴다. 로컬에서 끝나는 stage(p8 formatter 등)는 emit 시점에 바로 처리한다.
+결과 파일(.results.jsonl)이 아직 옆에 없는 batch 파일의 요청은 다시 emit 하지 않는다.
+
+결과는 repo 의 corpus 와 같은 배치로 쌓인다:
+  out_dir/<model>/gen_pipe/<query>/out_step{k}_{query}_{p}.c
+  out_dir/<model>/eval_pipe/<query>/out_step{k}_{query}_{p}.md
+  out_dir/batches/round{k}_<target model>.jsonl (+ .results.jsonl)
+
+실행:
+  PYTHONPATH=src python -m batch_mode run --out-dir batch_out --models Qwen/Qwen3-32B gpt-4.1-mini
+  PYTHONPATH=src python -m batch_mode emit --out-dir batch_out ...      # 요청 파일만 만든다
+  PYTHONPATH=src python -m batch_mode ingest --out-dir batch_out ... --results a.results.jsonl
+"""
+
+import argparse
+import json
+import re
+import shutil
+import time
+from collections import defaultdict
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import dataclass
+from pathlib import Path
+
+ROOT_DIR = Path(__file__).resolve().parent.parent
+DEFAULT_PROMPTS = ['p0', 'p1', 'p2', 'p3', 'p4', 'p5', 'p6', 'p7', 'p8', 'p9']
+CHAT_URL = '/v1/chat/completions'
+
+GEN = 'gen'
+EVAL = 'eval'
+_ROLES = {'system': 'system', 'human': 'user', 'ai': 'assistant'}
+
+
+def model_dir(model: str) -> str:
+    return re.sub(r'[^\w.-]+', '_', model)
+
+
+@dataclass
+class BatchItem:
+    kind: str       # GEN | EVAL
+    model: str      # 코드를 생성하는 model (결과 폴더)
+    target: str     # 요청을 받는 model (EVAL 이면 evaluator model)
+    query: str
+    step: int
+    prompt: str
+    messages: list[dict]
+    finish: str = ''    # GEN 응답을 코드로 바꾸는 방법 (pipe_agent.FINISH_*). ingest 가 custom_id 에서 읽는다
+
+    @property
+    def custom_id(self) -> str:
+        parts = (self.kind, self.model, self.query, str(self.step), self.prompt)
+        return '::'.join((*parts, self.finish) if self.finish else parts)
+
+    def line(self) -> dict:
+        return {'custom_id': self.custom_id, 'method': 'POST', 'url': CHAT_URL,
+                'body': {'model': self.target, 'messages': self.messages}}
+
+
+def _to_dicts(messages) -> list[dict]:
+    return [{'role': _ROLES.get(m.type, m.type), 'content': m.content} for m in messages]
+
+
+class BatchPlan:
+    def __init__(self, out_dir: Path, models: list[str], queries: dict[str, str],
+                 prompts: list[str], evaluate: bool = True):
+        from pipe_agent import PipeAgent
+        from evaluation import Evaluator
+        self.out_dir = out_dir
+        self.models = models
+        self.queries = queries
+        self.prompts = prompts
+        self.evaluate = evaluate
+        self.agent = PipeAgent()
+        self.evaluator = Evaluator()
+        self.batch_dir = out_dir / 'batches'
+        self.batch_dir.mkdir(parents=True, exist_ok=True)
+
+    # ------- 상태 (출력 파일이 곧 상태)
+    def path(self, kind: str, model: str, query: str, step: int) -> Path:
+        sub, ext = ('gen_pipe', 'c') if kind == GEN else ('eval_pipe', 'md')
+        return (self.out_dir / model_dir(model) / sub / query /
+                f'out_step{step}_{query}_{self.prompts[step]}.{ext}')
+
+    def read(self, kind: str, model: str, query: str, step: int) -> str | None:
+        p = self.path(kind, model, query, step)
+        return p.read_text(encoding='utf-8') if p.exists() else None
+
+    def write(self, kind: str, model: str, query: str, step: int, text: str):
+        p = self.path(kind, model, query, step)
+        p.parent.mkdir(parents=True, exist_ok=True)
+        tmp = p.with_suffix(p.suffix + '.tmp')
+        tmp.write_text(text, encoding='utf-8')
+        tmp.replace(p)
+
+    def _next_step(self, model: str, query: str) -> int | None:
+        for step in range(len(self.prompts)):
+            if not self.path(GEN, model, query, step).exists():
+                return step
+        return None
+
+    def _stage_request(self, model: str, query: str, step: int):
+        prev = self.read(GEN, model, query, step - 1) if step > 0 else ''
+        return self.agent.prepare_stage(self.prompts[step], prev, self.queries[query], model)
+
+    def _eval_state(self, model: str, query: str, step: int) -> dict:
+        state = {'prompt_names': [self.prompts[step]], 'user_msg': '',
+                 'code': self.read(GEN, model, query, step)}
+        baseline = self.read(GEN, model, query, step - 1)
+        if baseline:
+            state['baseline'] = baseline
+        return state
+
+    # ------- emit
+    def pending(self) -> list[BatchItem]:
+        """
+        지금 보낼 수 있는 요청 전부. 로컬 stage 는 여기서 바로 처리하고 다음 step 으로 넘어간다.
+        """
+        items = []
+        eval_model = self.evaluator.llm.model_name
+        for model in self.models:
+            for query in self.queries:
+                step = self._next_step(model, query)
+                while step is not None:
+                    req = self._stage_request(model, query, step)
+                    if req.result is None:
+                        items.append(BatchItem(GEN, model, model, query, step, self.prompts[step],
+                                               _to_dicts(req.messages()), req.finish_kind))
+                        break
+                    self.write(GEN, model, query, step, req.result)
+                    step = self._next_step(model, query)
+                if not self.evaluate:
+                    continue
+                for s in range(1, len(self.prompts)):
+                    if self.path(GEN, model, query, s).exists() and not self.path(EVAL, model, query, s).exists():
+                        msgs = self.evaluator.render(self._eval_state(model, query, s), eval_model)
+                        items.append(BatchItem(EVAL, model, eval_model, query, s, self.prompts[s], _to_dicts(msgs)))
+        return items
+
+    def request_files(self) -> list[Path]:
+        return sorted(p for p in self.batch_dir.glob('round*_*.jsonl') if not p.name.endswith('.results.jsonl'))
+
+    def outstanding(self) -> set[str]:
+        """내보냈지만 결과가 아직 ingest 되지 않은 요청의 custom_id"""
+        return {cid for path in self.request_files() if not results_path(path).exists() for cid in _custom_ids(path)}
+
+    def emit(self) -> list[Path]:
+        """target model 별로 batch 파일을 하나씩 쓴다 (batch API 는 파일당 model 하나)."""
+        outstanding = self.outstanding()
+        items = [item for item in self.pending() if item.custom_id not in outstanding]
+        if outstanding:
+            print(f'[BATCH] {len(outstanding)} requests already emitted and not ingested yet, skipped')
+        if not items:
+            return []
+        round_no = len({p.name.split('_')[0] for p in self.request_files()})
+        by_target = defaultdict(list)
+        for item in items:
+            by_target[item.target].append(item)
+        paths = []
+        for target, group in by_target.items():
+            path = self.batch_dir / f'round{round_no}_{model_dir(target)}.jsonl'
+            with open(path, 'w', encoding='utf-8') as fp:
+                for item in group:
+                    fp.write(json.dumps(item.line(), ensure_ascii=False) + '\n')
+            kinds = defaultdict(int)
+            for item in group:
+                kinds[item.kind] += 1
+            print(f'[BATCH] {path.name}: {len(group)} requests ({dict(kinds)})')
+            paths.append(path)
+        return paths
+
+    # ------- ingest
+    def ingest(self, path: Path) -> tuple[int, int]:
+        """batch 결과를 출력 파일로 쓴다. 실패한 요청은 다음 emit 때 다시 나간다."""
+        from pipe_agent import FINISH_CODE, finish_stage
+        from util.eval_report import parse_eval_report
+        from util.realtime_check import with_local_check
+        ok = failed = local_fail = 0
+        seen = set()
+        for line in path.read_text(encoding='utf-8').splitlines():
+            if not line.strip():
+                continue
+            row = json.loads(line)
+            seen.add(row['custom_id'])
+            kind, model, query, step, pname, *finish = row['custom_id'].split('::')
+            step = int(step)
+            body = (row.get('response') or {}).get('body') or {}
+            if row.get('error') or not body.get('choices'):
+                failed += 1
+                print(f'[BATCH] {row["custom_id"]} failed: {row.get("error")}')
+                continue
+            content = body['choices'][0]['message']['content']
+            if kind == GEN:
+                # 요청을 만들 때 정한 방법으로. prepare_stage (compaction, local formatter) 를 다시 돌리지 않는다
+                prev = self.read(GEN, model, query, step - 1) if step > 0 else ''
+                text = finish_stage(finish[0] if finish else FINISH_CODE, prev or '', content)
+            else:
+                text = with_local_check([pname], self.read(GEN, model, query, step) or '', content)
+                # batch 에는 escalation 이 없으므로 로컬 검사 FAIL 은 결과에 남기고 여기서 알린다
+                local_failed = parse_eval_report(text).local_failures
+                if local_failed:
+                    local_fail += 1
+                    print(f'[BATCH] {row["custom_id"]}: local check failed ({", ".join(local_failed)})')
+            self.write(kind, model, query, step, text)
+            ok += 1
+        # 다른 곳에서 받은 결과 파일이면 요청 파일 옆에 두어 ingest 된 batch 로 표시한다
+        for req in self.request_files():
+            done = results_path(req)
+            if not done.exists() and _custom_ids(req) <= seen:
+                shutil.copyfile(path, done)
+        print(f'[BATCH] ingested {path.name}: {ok} ok, {failed} failed'
+              + (f', {local_fail} with local check FAIL' if local_fail else ''))
+        return ok, failed
+
+
+# ------- executor
+class LocalExecutor:
+    """batch API 대신 chat model 을 직접 호출하는 대체 executor. 결과 형식은 batch API 와 같다."""
+
+    def __init__(self, concurrency: int = 8):
+        self.concurrency = concurrency
+
+    def _call(self, idx: int, line: dict) -> dict:
+        from models import resolve_model
+        body = line['body']
+        try:
+            # model 이름으로 endpoint 를 고른다 (gpt-* 는 OpenAI, 나머지는 settings.openai_base_url)
+            msg = resolve_model(body['model']).invoke([(m['role'], m['content']) for m in body['messages']])
+        except Exception as e:
+            return {'id': f'local-{idx}', 'custom_id': line['custom_id'], 'response': None,
+                    'error': {'message': str(e)}}
+        usage = getattr(msg, 'usage_metadata', None) or {}
+        return {'id': f'local-{idx}', 'custom_id': line['custom_id'], 'error': None, 'response': {
+            'status_code': 200,
+            'body': {'model': body['model'],
+                     'choices': [{'index': 0, 'message': {'role': 'assistant', 'content': msg.content}}],
+                     'usage': {'prompt_tokens': usage.get('input_tokens'),
+                               'completion_tokens': usage.get('output_tokens')}}}}
+
+    def run(self, input_path: Path, output_path: Path):
+        lines = [json.loads(ln) for ln in input_path.read_text(encoding='utf-8').splitlines() if ln.strip()]
+        with ThreadPoolExecutor(max_workers=self.concurrency) as pool:
+            rows = list(pool.map(self._call, range(len(lines)), lines))
+        with open(output_path, 'w', encoding='utf-8') as fp:
+            for row in rows:
+                fp.write(json.dumps(row, ensure_ascii=False) + '\n')
+
+
+class OpenAIBatchExecutor:
+    """OpenAI Batch API 에 올리고 끝날 때까지 기다린다."""
+
+    def __init__(self, poll: float = 60.0, window: str = '24h', base_url: str | None = None):
+        self.poll = poll
+        self.window = window
+        self.base_url = base_url
+
+    def run(self, input_path: Path, output_path: Path):
+        from openai import OpenAI
+        from settings import settings
+        client = OpenAI(api_key=settings.openai_api_key, base_url=self.base_url)
+        with open(input_path, 'rb') as fp:
+            upload = client.files.create(file=fp, purpose='batch')
+        batch = client.batches.create(input_file_id=upload.id, endpoint=CHAT_URL, completion_window=self.window)
+        print(f'[BATCH] submitted {input_path.name} as {batch.id}')
+        while batch.status not in ('completed', 'failed', 'expired', 'cancelled'):
+            time.sleep(self.poll)
+            batch = client.batches.retrieve(batch.id)
+        if batch.status != 'completed':
+            raise RuntimeError(f'batch {batch.id} {batch.status}')
+        chunks = [client.files.content(fid).text for fid in (batch.output_file_id, batch.error_file_id) if fid]
+        output_path.write_text(''.join(chunks), encoding='utf-8')
+
+
+EXECUTORS = {
+    'local': LocalExecutor,
+    'openai': OpenAIBatchExecutor,
+}
+
+
+def results_path(path: Path) -> Path:
+    return path.with_name(path.stem + '.results.jsonl')
+
+
+def _custom_ids(path: Path) -> set[str]:
+    return {json.loads(ln)['custom_id'] for ln in path.read_text(encoding='utf-8').splitlines() if ln.strip()}
+
+
+def run(plan: BatchPlan, executor, max_rounds: int = 100):
+    for _ in range(max_rounds):
+        paths = plan.emit()
+        if not paths:
+            print('[BATCH] nothing left to do')
+            return
+        for path in paths:
+            out = results_path(path)
+            executor.run(path, out)
+            plan.ingest(out)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('cmd', choices=['run', 'emit', 'ingest'])
+    parser.add_argument('--out-dir', required=True)
+    parser.add_argument('--models', nargs='+', default=['Qwen/Qwen3-32B'])
+    parser.add_argument('--queries', nargs='*', default=[])
+    parser.add_argument('--prompts', nargs='*', default=DEFAULT_PROMPTS)
+    parser.add_argument('--no-eval', action='store_true')
+    parser.add_argument('--executor', choices=sorted(EXECUTORS), default='local')
+    parser.add_argument('--results', nargs='*', default=[], help='ingest 할 batch 결과 파일')
+    args = parser.parse_args()
+
+    files = sorted((ROOT_DIR / 'user_queries').glob('*.txt'))
+    queries = {f.stem: f.read_text(encoding='utf-8') for f in files if not args.queries or f.stem in args.queries}
+    plan = BatchPlan(Path(args.out_dir), args.models, queries, args.prompts, not args.no_eval)
+    if args.cmd == 'run':
+        run(plan, EXECUTORS[args.executor]())
+    elif args.cmd == 'emit':
+        plan.emit()
+    else:
+        for r in args.results:
+            plan.ingest(Path(r))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,91 @@
+"""
+evaluator 입력 compaction A/B 검증.
+같은 코드에 대해 A(원본 코드) / B(compaction) 로 평가해 항목별 판정이 바뀌는지 본다.
+LLM 자체의 흔들림을 가늠하려면 --samples 2 이상으로 A 를 여러 번 돌려 A-A 일치율과 비교한다.
+
+실행:
+  PYTHONPATH=src python -m bench.ab_compaction --dry-run          # token 절감만 계산
+  PYTHONPATH=src python -m bench.ab_compaction --models qwen3 --queries i1 --samples 2
+"""
+
+import argparse
+from collections import defaultdict
+from pathlib import Path
+
+from util.compaction import compact, merge_policies
+from util.eval_report import parse_eval_report
+from settings import settings
+
+ROOT_DIR = Path(__file__).resolve().parents[2]
+
+
+def iter_corpus(models: list[str], queries: list[str]):
+    """(model, query, step, prompt_name, code, 이전 단계 code)"""
+    for model in models:
+        for qdir in sorted((ROOT_DIR / model / 'gen_pipe').iterdir()):
+            if queries and qdir.name not in queries:
+                continue
+            prev = None
+            for f in sorted(qdir.glob('out_step*.c'), key=lambda p: int(p.name.split('_')[1][4:])):
+                step = int(f.name.split('_')[1][4:])
+                pname = f.stem.split('_')[-1]
+                code = f.read_text(encoding='utf-8')
+                if step > 0:
+                    yield model, qdir.name, step, pname, code, prev
+                prev = code
+
+
+def _agreement(a: dict[str, str], b: dict[str, str]) -> tuple[int, int]:
+    keys = set(a) & set(b)
+    return sum(a[k] == b[k] for k in keys), len(set(a) | set(b))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--models', nargs='*', default=['qwen3', 'gpt4_1'])
+    parser.add_argument('--queries', nargs='*', default=[])
+    parser.add_argument('--samples', type=int, default=1)
+    parser.add_argument('--dry-run', action='store_true')
+    args = parser.parse_args()
+
+    tokens = defaultdict(lambda: [0, 0])
+    agree = defaultdict(lambda: [0, 0])
+    noise = [0, 0]
+    evaluator_a = evaluator_b = None
+    if not args.dry_run:
+        from evaluation import Evaluator
+        evaluator_a, evaluator_b = Evaluator(compaction=False), Evaluator(compaction=True)
+    model_name = 'gpt-4.1-mini' if evaluator_a is None else evaluator_a.llm.model_name
+
+    for model, query, step, pname, code, prev in iter_corpus(args.models, args.queries):
+        res = compact(code, merge_policies([pname]), model_name, settings.eval_token_budget or None, prev)
+        tokens[pname][0] += res.tokens_before
+        tokens[pname][1] += res.tokens_after
+        if args.dry_run:
+            continue
+
+        runs_a = [parse_eval_report(evaluator_a.invoke([pname], code)).verdicts for _ in range(args.samples)]
+        run_b = parse_eval_report(evaluator_b.invoke([pname], code, baseline=prev)).verdicts
+        same, total = _agreement(runs_a[0], run_b)
+        agree[pname][0] += same
+        agree[pname][1] += total
+        for other in runs_a[1:]:
+            s, t = _agreement(runs_a[0], other)
+            noise[0] += s
+            noise[1] += t
+        flips = {k: (runs_a[0].get(k), run_b.get(k)) for k in set(runs_a[0]) | set(run_b)
+                 if runs_a[0].get(k) != run_b.get(k)}
+        if flips:
+            print(f'[FLIP] {model}/{query} step{step} {pname}: {flips}')
+
+    print(f'{"rule":6}{"tokens A":>10}{"tokens B":>10}{"saved":>8}{"agree":>10}')
+    for pname in sorted(tokens):
+        before, after = tokens[pname]
+        rate = f'{agree[pname][0] / agree[pname][1] * 100:.1f}%' if agree[pname][1] else '-'
+        print(f'{pname:6}{before:>10}{after:>10}{(before - after) / max(before, 1) * 100:>7.1f}%{rate:>10}')
+    if noise[1]:
+        print(f'A-A agreement (LLM noise floor): {noise[0] / noise[1] * 100:.1f}%')
+
+
+if __name__ == '__main__':
+    main()
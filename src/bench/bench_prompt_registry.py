@@ -0,0 +1,58 @@
+"""
+prompt/template/graph 준비에 드는 stage 당 overhead 비교 (LLM 호출 제외).
+  before: 매 stage 마다 prompts/*.md 읽기 + ChatPromptTemplate 생성, invoke 마다 graph compile
+  after : registry 캐시 사용
+
+실행: PYTHONPATH=src python -m bench.bench_prompt_registry
+"""
+
+import time
+from pathlib import Path
+
+from langchain_core.prompts import ChatPromptTemplate
+
+from pipe_agent import _build_graph
+from util.prompt_registry import registry, prompt_path
+from util.prompt_util import get_prompt_template, RAW_START, RAW_END, REFINE
+
+PROMPTS = ['p0', 'p1', 'p2', 'p3', 'p4', 'p5', 'p6', 'p7', 'p8']
+SAMPLE_CODE = (Path(__file__).resolve().parents[2] / 'qwen3/gen_pipe/i1/out_step6_i1_p6.c').read_text(encoding='utf-8')
+
+
+def _before_stage(pname: str):
+    # 이전 구현: 파일을 매번 읽고 코드까지 template 문자열에 넣어 새로 만든다
+    system_text = Path(f'{prompt_path(pname)}').read_text(encoding='utf-8')
+    sys = f"{RAW_START}{system_text.rstrip()}\nReturn only the final C code after applying these rules.{RAW_END}"
+    user = f"Refine ...\n\n{RAW_START}Here is the current code:\n```c\n{SAMPLE_CODE}\n```{RAW_END}"
+    prompt = ChatPromptTemplate.from_messages([("system", sys), ("user", user)], template_format="jinja2")
+    return prompt.format_messages()
+
+
+def _after_stage(pname: str):
+    return get_prompt_template(REFINE, pname).format_messages(code=SAMPLE_CODE)
+
+
+def _timeit(fn, repeat: int) -> float:
+    start = time.perf_counter()
+    for _ in range(repeat):
+        fn()
+    return (time.perf_counter() - start) / repeat
+
+
+def main(repeat: int = 200):
+    registry.clear()
+    stage_before = _timeit(lambda: [_before_stage(p) for p in PROMPTS], repeat) / len(PROMPTS)
+    stage_after = _timeit(lambda: [_after_stage(p) for p in PROMPTS], repeat) / len(PROMPTS)
+
+    graph_before = _timeit(lambda: _build_graph(PROMPTS), max(1, repeat // 10))
+    key = ('graph', tuple(PROMPTS), 'bench')
+    graph_after = _timeit(lambda: registry.get(key, PROMPTS, lambda: _build_graph(PROMPTS)), repeat)
+
+    print(f'{"":24}{"before":>12}{"after":>12}')
+    print(f'{"per-stage prompt (us)":24}{stage_before * 1e6:12.1f}{stage_after * 1e6:12.1f}')
+    print(f'{"per-invoke graph (us)":24}{graph_before * 1e6:12.1f}{graph_after * 1e6:12.1f}')
+    print(f'registry hits={registry.hits} misses={registry.misses}')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,445 @@
+"""
+변형마다 흩어져 있는 성능 숫자(size, stack, WCET, interrupt 를 막은 시간, 입력 latency, LCD bus, CPU busy)를 모아
+정렬되는 표와 첫 step → 마지막 step 추이 sparkline 이 있는 정적 HTML dashboard 하나와 CSV 하나로 만든다.
+
+파일마다 각 도구와 같은 방법으로 잰다:
+- size / stack:  bench.prompt_cost (-Os object, -fcallgraph-info 의 최악 stack)
+- WCET:          bench.wcet. loop/task (forever loop 가 있는 app_main 포함) 중 가장 긴 것과 ISR 중 가장 긴 것
+- mask/bus/busy: 기본 script 로 한 번 (--masks --bus). busy 는 trace 첫 줄의 busy/delay/idle
+- latency:       hostsim/scripts/latency/<query>.txt 로 한 번 (--inputs)
+실행이 에러로 끝나거나 (deadlock 등) 멈춘 run (SimResult.stalled) 은 실행으로 재는 metric 을 비워 두고 note 에 이유를 남긴다.
+
+HTML 에는 (model, query) 별 step 추이 (metric 마다 sparkline 과 p0 대비 변화),
+prompt 별 비용 (바로 앞 step 대비 변화의 평균과 나빠진 (model, query) 수), 파일별 전체 표가 있다.
+표 머리를 누르면 정렬된다. 모든 metric 은 작을수록 좋다.
+
+실행:
+  PYTHONPATH=src python -m bench.dashboard                      # hostsim/build/dashboard/{index.html,metrics.csv}
+  PYTHONPATH=src python -m bench.dashboard --models qwen3 --queries i1 --out /tmp/dash
+  PYTHONPATH=src python -m bench.dashboard --from-csv hostsim/build/dashboard/metrics.csv   # 다시 재지 않고 HTML 만
+"""
+
+import argparse
+import csv
+import html
+import shutil
+from collections import defaultdict
+from dataclasses import astuple, dataclass, fields
+from pathlib import Path
+
+from bench.prompt_cost import XTENSA_PREFIX, measure
+from bench.wcet import EXTERNAL_CYCLES, MHZ, WcetReport, analyze
+from sim.build import BUILD_DIR, build_sketch
+from sim.latency import latency_script, measure_latency
+from sim.lcdbus import parse_bus
+from sim.masks import parse_masks
+from sim.run import corpus_files
+from sim.runner import run_binary, script_end_us, script_for
+from util.compile_check import PROJECT_ROOT
+
+
+@dataclass
+class Row:
+    model: str
+    query: str
+    step: int
+    prompt: str
+    ok: bool = True
+    error: str = ''
+    text: int | None = None
+    data: int | None = None
+    bss: int | None = None
+    stack: int | None = None
+    wcet_us: float | None = None        # WcetReport.loop_us: loop/task/끝나지 않는 app_main 중 최악 (한 바퀴)
+    isr_us: float | None = None
+    mask_max_us: int | None = None      # 가장 길게 interrupt 를 막은 구간
+    mask_total_us: int | None = None
+    mask_hazards: int | None = None     # 1 ms 이상 막은 구간 수
+    lat_p50_ms: float | None = None
+    lat_p90_ms: float | None = None
+    lat_max_ms: float | None = None
+    dropped: int | None = None
+    bus_ms: float | None = None         # LCD bus 시간 합 (I2C 는 100 kHz)
+    lcd_cpu_pct: float | None = None    # LCD 호출이 CPU 를 붙잡은 비율
+    busy_pct: float | None = None
+
+
+@dataclass
+class Metric:
+    key: str
+    label: str
+    unit: str
+    digits: int = 0
+
+
+# 추이와 prompt 표에 나오는 것
+METRICS = [
+    Metric('text', 'text', 'B'),
+    Metric('stack', 'stack', 'B'),
+    Metric('wcet_us', 'WCET', 'us', 1),
+    Metric('isr_us', 'ISR WCET', 'us', 1),
+    Metric('mask_max_us', 'masked max', 'us'),
+    Metric('lat_p90_ms', 'latency p90', 'ms', 1),
+    Metric('dropped', 'dropped', ''),
+    Metric('bus_ms', 'LCD bus', 'ms'),
+    Metric('busy_pct', 'CPU busy', '%', 1),
+]
+
+
+def collect(path: Path, model: str, cost_model: str, mhz: float, wcet_ms: float, run_ms: float,
+            latency_ms: float, wcet: WcetReport | None = None) -> Row:
+    """wcet 를 주면 WCET 분석은 다시 하지 않는다."""
+    cost = measure(path, model, 0, [], profile=False)
+    row = Row(model, cost.query, cost.step, cost.prompt, cost.ok, cost.error)
+    if not cost.ok:
+        return row
+    row.text, row.data, row.bss, row.stack = cost.host.text, cost.host.data, cost.host.bss, cost.stack
+
+    wcet = wcet or analyze(path, model, cost_model, wcet_ms, mhz, dict(EXTERNAL_CYCLES))
+    if wcet.ok:
+        row.wcet_us, row.isr_us = wcet.loop_us, wcet.isr_us
+
+    code = path.read_text(encoding='utf-8')
+    build = build_sketch(code)
+    if not build.ok:
+        row.error = 'sim build failed'
+        return row
+    script = script_for(row.query) if script_for(row.query).exists() else None
+    res = run_binary(build.binary, script, run_ms, extra=['--masks', '--bus'])
+    # 죽거나 멈춘 채 남은 시간을 보낸 run 의 busy/mask/latency 는 그 step 의 성능이 아니다
+    if not res.ok:
+        row.error = res.error
+        return row
+    if res.stalled(script):
+        row.error = f'stalled: no output after the last input at {script_end_us(script) / 1e6:.1f} s'
+        return row
+    if run_us := res.stats.get('end_us', 0):
+        sites = parse_masks(res, code, build.binary)
+        row.mask_max_us = max((s.max_us for s in sites), default=0)
+        row.mask_total_us = sum(s.total_us for s in sites)
+        row.mask_hazards = sum(sum(s.hist[3:]) for s in sites)
+        buses = parse_bus(res)
+        row.bus_ms = sum(b.bus_us_100k for b in buses) / 1000
+        row.lcd_cpu_pct = sum(b.cpu_us for b in buses) / run_us * 100
+        total_us = sum(res.stats.get(k, 0) for k in ('busy_us', 'delay_us', 'idle_us'))
+        row.busy_pct = res.stats.get('busy_us', 0) / total_us * 100 if total_us else None
+
+    if lat_script := latency_script(row.query):
+        lat = measure_latency(run_binary(build.binary, lat_script, latency_ms, extra=['--inputs']))
+        row.dropped = lat.dropped
+        if lat.latencies:
+            row.lat_p50_ms, row.lat_p90_ms, row.lat_max_ms = lat.percentile(50), lat.percentile(90), lat.latencies[-1]
+    return row
+
+
+# ------- CSV
+def write_csv(rows: list[Row], path: Path):
+    """Row 의 값 뒤에 추이 metric 마다 p0 (그 (model, query) 의 첫 성공 step) 대비 % 를 붙인다."""
+    names = [f.name for f in fields(Row)]
+    base = {key: _first(rs) for key, rs in _groups(rows).items()}
+    with path.open('w', newline='', encoding='utf-8') as fp:
+        w = csv.writer(fp)
+        w.writerow(names + [f'{m.key}_vs_p0_pct' for m in METRICS])
+        for r in rows:
+            first = base[(r.model, r.query)]
+            pcts = [_pct(getattr(r, m.key), getattr(first, m.key) if first else None) for m in METRICS]
+            w.writerow(['' if v is None else v for v in astuple(r)] + ['' if p is None else f'{p:.1f}' for p in pcts])
+
+
+def read_csv(path: Path) -> list[Row]:
+    types = {f.name: f.type for f in fields(Row)}
+    rows = []
+    with path.open(encoding='utf-8') as fp:
+        for rec in csv.DictReader(fp):
+            values = {}
+            for name, kind in types.items():
+                text = rec.get(name, '')
+                if kind in ('str', str):
+                    values[name] = text
+                elif kind in ('bool', bool):
+                    values[name] = text == 'True'
+                elif text == '':
+                    values[name] = None
+                else:
+                    values[name] = int(text) if 'int' in str(kind) else float(text)
+            rows.append(Row(**values))
+    return rows
+
+
+# ------- 추이 / prompt 별 변화
+def _groups(rows: list[Row]) -> dict[tuple[str, str], list[Row]]:
+    by_key = defaultdict(list)
+    for r in rows:
+        by_key[(r.model, r.query)].append(r)
+    for rs in by_key.values():
+        rs.sort(key=lambda r: r.step)
+    return dict(sorted(by_key.items()))
+
+
+def step_label(steps) -> str:
+    """있는 step 범위 ('p0 → p8'). step 이 없으면 'steps'."""
+    steps = sorted(set(steps))
+    return f'p{steps[0]} → p{steps[-1]}' if steps else 'steps'
+
+
+def _first(rows: list[Row]) -> Row | None:
+    return next((r for r in rows if r.ok), None)
+
+
+def _pct(value: float | None, base: float | None) -> float | None:
+    if value is None or base is None:
+        return None
+    if not base:
+        return 0.0 if not value else None
+    return (value - base) * 100 / base
+
+
+@dataclass
+class PromptCost:
+    """prompt 하나가 바로 앞 step 에 비해 metric 하나를 얼마나 바꿨나 ((model, query) 전부)"""
+    pcts: list[float]
+    worse: int = 0
+    pairs: int = 0
+
+    @property
+    def mean(self) -> float | None:
+        return sum(self.pcts) / len(self.pcts) if self.pcts else None
+
+
+def prompt_costs(rows: list[Row]) -> dict[str, dict[str, PromptCost]]:
+    """prompt -> metric -> 변화. 앞 step 이 빌드에 실패했으면 그 앞의 성공한 step 과 비교한다."""
+    costs: dict[str, dict[str, PromptCost]] = defaultdict(lambda: {m.key: PromptCost([]) for m in METRICS})
+    for rs in _groups(rows).values():
+        prev = None
+        for r in rs:
+            if not r.ok:
+                continue
+            if prev is not None:
+                for m in METRICS:
+                    value, base = getattr(r, m.key), getattr(prev, m.key)
+                    if value is None or base is None:
+                        continue
+                    c = costs[r.prompt][m.key]
+                    c.pairs += 1
+                    c.worse += value > base
+                    if (pct := _pct(value, base)) is not None:
+                        c.pcts.append(pct)
+            prev = r
+    return dict(sorted(costs.items(), key=lambda kv: int(kv[0][1:])))
+
+
+# ------- HTML
+STYLE = """
+body { font: 13px/1.4 system-ui, sans-serif; margin: 1.5em; color: #222; }
+table { border-collapse: collapse; margin-bottom: 2em; }
+th, td { border: 1px solid #ddd; padding: 3px 7px; text-align: right; white-space: nowrap; }
+th { background: #f4f4f4; cursor: pointer; user-select: none; }
+th[data-dir=asc]::after { content: ' \\25b2'; } th[data-dir=desc]::after { content: ' \\25bc'; }
+td.name { text-align: left; }
+.worse { color: #b00020; } .better { color: #00703c; } .failed { color: #999; }
+svg { vertical-align: middle; margin-right: 4px; }
+"""
+
+SORT_JS = """
+document.querySelectorAll('table.sortable th').forEach((th, i) => th.addEventListener('click', () => {
+  const body = th.closest('table').tBodies[0];
+  const dir = th.dataset.dir = th.dataset.dir === 'asc' ? 'desc' : 'asc';
+  th.closest('tr').querySelectorAll('th').forEach(o => { if (o !== th) delete o.dataset.dir; });
+  const key = tr => { const c = tr.cells[i], v = c.dataset.v ?? c.textContent.trim();
+                      return v === '' || v === '-' ? null : isNaN(v) ? v : +v; };
+  [...body.rows].sort((a, b) => {
+    const x = key(a), y = key(b);
+    if (x === null || y === null) return (x === null) - (y === null);
+    const c = x < y ? -1 : x > y ? 1 : 0;
+    return dir === 'asc' ? c : -c;
+  }).forEach(r => body.appendChild(r));
+}));
+"""
+
+
+def _fmt(value: float | None, digits: int = 0) -> str:
+    return '-' if value is None else f'{value:,.{digits}f}'
+
+
+def _td(text: str, sort: float | str | None = None, cls: str = '') -> str:
+    attrs = f' data-v="{html.escape(str(sort))}"' if sort is not None else ''
+    attrs += f' class="{cls}"' if cls else ''
+    return f'<td{attrs}>{html.escape(text)}</td>'
+
+
+def _change_class(pct: float | None) -> str:
+    if pct is None or abs(pct) < 0.5:
+        return ''
+    return 'worse' if pct > 0 else 'better'
+
+
+def sparkline(points: list[tuple[int, float | None]], width: int = 90, height: int = 20) -> str:
+    """step -> 값. 빌드에 실패한 step 에서는 선이 끊긴다."""
+    known = [v for _, v in points if v is not None]
+    if not known:
+        return ''
+    steps = [s for s, _ in points]
+    lo, hi = min(known), max(known)
+    x0, x1 = min(steps), max(steps)
+
+    def xy(step: int, value: float) -> str:
+        x = 2 + (step - x0) * (width - 4) / ((x1 - x0) or 1)
+        y = height - 2 - (value - lo) * (height - 4) / ((hi - lo) or 1)
+        return f'{x:.1f},{y:.1f}'
+
+    runs, run = [], []
+    for step, value in points:
+        if value is None:
+            runs.append(run)
+            run = []
+        else:
+            run.append(xy(step, value))
+    runs.append(run)
+    lines = ''.join(f'<polyline points="{" ".join(r)}" fill="none" stroke="#3461a8" stroke-width="1.3"/>'
+                    for r in runs if len(r) > 1)
+    dots = ''.join(f'<circle cx="{p.split(",")[0]}" cy="{p.split(",")[1]}" r="1.6" fill="#3461a8"/>'
+                   for r in runs for p in r)
+    title = html.escape(', '.join(f'p{s}: {"-" if v is None else f"{v:g}"}' for s, v in points))
+    return f'<svg width="{width}" height="{height}"><title>{title}</title>{lines}{dots}</svg>'
+
+
+def trend_table(rows: list[Row]) -> str:
+    head = ''.join(f'<th>{html.escape(m.label)}</th>' for m in METRICS)
+    out = ['<table class="sortable"><thead><tr><th>model</th><th>query</th><th>steps ok</th>'
+           f'{head}</tr></thead><tbody>']
+    for (model, query), rs in _groups(rows).items():
+        cells = [_td(model, cls='name'), _td(query, cls='name'),
+                 _td(f'{sum(r.ok for r in rs)}/{len(rs)}', sum(r.ok for r in rs))]
+        for m in METRICS:
+            points = [(r.step, getattr(r, m.key) if r.ok else None) for r in rs]
+            known = [(s, v) for s, v in points if v is not None]
+            if not known:
+                cells.append(_td('-'))
+                continue
+            (s0, first), (s1, last) = known[0], known[-1]
+            pct = _pct(last, first)
+            text = f'p{s0} {_fmt(first, m.digits)} → p{s1} {_fmt(last, m.digits)}'
+            if pct is not None and abs(pct) >= 0.5:
+                text += f' ({pct:+.0f}%)'
+            cls = _change_class(pct) or ('worse' if pct is None and last > first else '')
+            sort = pct if pct is not None else ('' if last == first else 1e9)
+            attrs = f' data-v="{sort}"' + (f' class="{cls}"' if cls else '')
+            cells.append(f'<td{attrs}>{sparkline(points)}{html.escape(text)}</td>')
+        out.append(f'<tr>{"".join(cells)}</tr>')
+    out.append('</tbody></table>')
+    return '\n'.join(out)
+
+
+def prompt_table(rows: list[Row]) -> str:
+    costs = prompt_costs(rows)
+    head = ''.join(f'<th>{html.escape(m.label)}</th>' for m in METRICS)
+    out = ['<table class="sortable"><thead><tr><th>prompt</th><th>mean Δ%</th>'
+           f'{head}</tr></thead><tbody>']
+    for prompt, by_metric in costs.items():
+        means = [c.mean for c in by_metric.values() if c.mean is not None]
+        overall = sum(means) / len(means) if means else None
+        cells = [_td(prompt, int(prompt[1:]), 'name'),
+                 _td('-' if overall is None else f'{overall:+.1f}%', overall, _change_class(overall))]
+        for m in METRICS:
+            c = by_metric[m.key]
+            if not c.pairs:
+                cells.append(_td('-'))
+                continue
+            mean = '-' if c.mean is None else f'{c.mean:+.1f}%'
+            cells.append(_td(f'{mean} ({c.worse}/{c.pairs} worse)', c.mean, _change_class(c.mean)))
+        out.append(f'<tr>{"".join(cells)}</tr>')
+    out.append('</tbody></table>')
+    return '\n'.join(out)
+
+
+def file_table(rows: list[Row]) -> str:
+    cols = [f for f in fields(Row) if f.name not in ('ok', 'error')]
+    head = ''.join(f'<th>{html.escape(f.name)}</th>' for f in cols) + '<th>note</th>'
+    digits = {m.key: m.digits for m in METRICS} | {'lat_p50_ms': 1, 'lat_max_ms': 1, 'lcd_cpu_pct': 2}
+    out = [f'<table class="sortable"><thead><tr>{head}</tr></thead><tbody>']
+    for rs in _groups(rows).values():
+        for r in rs:
+            cells = []
+            for f in cols:
+                value = getattr(r, f.name)
+                if isinstance(value, str):
+                    cells.append(_td(value, cls='name'))
+                else:
+                    cells.append(_td(_fmt(value, digits.get(f.name, 0)), value))
+            note = r.error if r.ok else f'build failed: {r.error}'
+            cells.append(_td(note[:80], cls='name failed' if not r.ok else 'name'))
+            out.append(f'<tr>{"".join(cells)}</tr>')
+    out.append('</tbody></table>')
+    return '\n'.join(out)
+
+
+def render_html(rows: list[Row], note: str) -> str:
+    return f"""<!doctype html>
+<html><head><meta charset="utf-8"><title>prompt step performance</title><style>{STYLE}</style></head>
+<body>
+<h1>prompt step performance</h1>
+<p>{html.escape(note)}. Lower is better everywhere; click a column header to sort.</p>
+<h2>{step_label(r.step for r in rows)} per (model, query)</h2>
+{trend_table(rows)}
+<h2>cost per prompt (change from the previous successful step)</h2>
+{prompt_table(rows)}
+<h2>all files</h2>
+{file_table(rows)}
+<script>{SORT_JS}</script>
+</body></html>
+"""
+
+
+def main():
+    parser = argparse.ArgumentParser(description='성능 숫자 dashboard (정적 HTML + CSV)')
+    parser.add_argument('--models', nargs='*', default=['qwen3', 'gpt4_1'])
+    parser.add_argument('--queries', nargs='*', default=[])
+    parser.add_argument('--steps', nargs='*', type=int, default=None)
+    parser.add_argument('--out', default=str(BUILD_DIR / 'dashboard'), help='index.html 과 metrics.csv 를 쓸 폴더')
+    parser.add_argument('--from-csv', help='다시 재지 않고 이 CSV 로 HTML 만 만든다')
+    parser.add_argument('--cost-model', choices=['auto', 'host', 'esp32s3'], default='auto')
+    parser.add_argument('--mhz', type=float, default=MHZ)
+    parser.add_argument('--wcet-ms', type=float, default=60_000, help='loop bound 를 재는 실행 시간')
+    parser.add_argument('--duration-ms', type=float, default=3_600_000, help='mask/bus/busy 실행 시간')
+    parser.add_argument('--latency-ms', type=float, default=120_000)
+    args = parser.parse_args()
+
+    out = Path(args.out)
+    out.mkdir(parents=True, exist_ok=True)
+    cost_model = args.cost_model
+    if cost_model == 'auto':
+        cost_model = 'esp32s3' if shutil.which(f'{XTENSA_PREFIX}gcc') else 'host'
+
+    if args.from_csv:
+        rows = read_csv(Path(args.from_csv))
+        note = f'from {args.from_csv}'
+    else:
+        rows = []
+        for model in args.models:
+            for f in corpus_files([model], args.queries, args.steps):
+                r = collect(f, model, cost_model, args.mhz, args.wcet_ms, args.duration_ms, args.latency_ms)
+                rows.append(r)
+                name = f.relative_to(PROJECT_ROOT)
+                if not r.ok:
+                    print(f'[DASH] {name}: build failed')
+                    continue
+                status = f' ({r.error})' if r.error else ''
+                print(f'[DASH] {name}: text {r.text} stack {r.stack} wcet {_fmt(r.wcet_us, 1)} us '
+                      f'masked max {_fmt(r.mask_max_us)} us p90 {_fmt(r.lat_p90_ms, 1)} ms '
+                      f'busy {_fmt(r.busy_pct, 1)}%{status}')
+        write_csv(rows, out / 'metrics.csv')
+        print(f'[DASH] saved {out / "metrics.csv"}')
+        note = (f'{len(rows)} files; WCET with the {cost_model} cost model at {args.mhz:.0f} MHz, '
+                f'runs of {args.duration_ms / 1000:.0f} s (latency {args.latency_ms / 1000:.0f} s)')
+
+    (out / 'index.html').write_text(render_html(rows, note), encoding='utf-8')
+    print(f'[DASH] saved {out / "index.html"}')
+    for prompt, by_metric in prompt_costs(rows).items():
+        worst = max(((m, c.mean) for m, c in by_metric.items() if c.mean is not None), key=lambda kv: kv[1],
+                    default=None)
+        if worst:
+            print(f'[DASH] {prompt}: largest mean increase {worst[0]} {worst[1]:+.1f}%')
+
+
+if __name__ == '__main__':
+    main()
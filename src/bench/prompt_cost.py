@@ -0,0 +1,327 @@
+"""
+p0..p8 단계별로 생성 코드의 실행 비용을 잰다 (model / query 별 regression 표).
+
+- size:  스케치 object 의 .text/.data/.bss (-Os, 런타임 제외). xtensa-esp32s3-elf-gcc 가 있으면 그 결과도 같이.
+- stack: -fcallgraph-info=su 의 call graph 로 구한 최악 stack (스케치 frame 합, 런타임/libc 호출은 0 으로 본다).
+- cost:  hostsim 에서 query 기본 script 를 돌린 스케치 함수들의 명령어 수.
+         valgrind 가 있으면 callgrind 의 Ir, 없으면 gcov 의 줄 실행 횟수로 대신한다 (단위가 다르므로 표에 표시).
+- hot:   call graph 의 진입점(setup/loop/app_main/task/ISR)이 아닌 함수 중 비용이 가장 큰 것.
+         --handlers 로 준 이름(HandleNumberButton, process_entry ...)은 대소문자/'_' 를 무시하고 찾아 따로 보여준다.
+
+실행:
+  PYTHONPATH=src python -m bench.prompt_cost
+  PYTHONPATH=src python -m bench.prompt_cost --models gpt4_1 --queries i4 --duration-ms 60000 --json /tmp/cost.json
+"""
+
+import argparse
+import json
+import re
+import shutil
+import subprocess
+import tempfile
+from collections import defaultdict
+from dataclasses import asdict, dataclass, field
+from pathlib import Path
+
+from sim.build import build_runtime
+from sim.run import corpus_files, query_of
+from sim.runner import script_for
+from util.compile_check import PROJECT_ROOT, compiler_command, prepare_source
+
+SIZE_FLAGS = ['-Os']
+PROFILE_FLAGS = ['-O1', '-g']
+XTENSA_PREFIX = 'xtensa-esp32s3-elf-'
+ENTRY_NAMES = {'setup', 'loop', 'app_main', 'main'}
+
+HOT_HANDLERS = ['HandleNumberButton', 'process_floor_request', 'process_entry', 'HandleValidTransaction']
+
+_STEP_RE = re.compile(r'out_step(\d+)_i\d+_(p\d+)\.c$')
+_CI_NODE_RE = re.compile(r'node: \{ title: "([^"]+)" label: "([^"\\]+)(?:\\n[^"]*?(\d+) bytes)?')
+_CI_EDGE_RE = re.compile(r'edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+
+
+@dataclass
+class Sections:
+    text: int = 0
+    data: int = 0
+    bss: int = 0
+
+
+@dataclass
+class StepCost:
+    model: str
+    query: str
+    step: int
+    prompt: str
+    ok: bool
+    error: str = ''
+    host: Sections = field(default_factory=Sections)
+    xtensa: Sections | None = None
+    stack: int = 0                  # 최악 경로의 frame 합 (bytes)
+    stack_path: list[str] = field(default_factory=list)
+    unit: str = ''                  # 'Ir' | 'lines'
+    total: int = 0                  # 스케치 함수 self 비용 합
+    hot: str = ''
+    hot_cost: int = 0
+    handlers: dict[str, int] = field(default_factory=dict)
+
+
+def _base_name(symbol: str) -> str:
+    """'lcd_update.isra.0' / 'handleDigit(char)' -> 'lcd_update' / 'handleDigit'"""
+    return re.split(r'[.(]', symbol, maxsplit=1)[0].strip()
+
+
+def _norm(name: str) -> str:
+    return name.replace('_', '').lower()
+
+
+def _demangle(symbols: set[str]) -> dict[str, str]:
+    """C++ 스케치의 mangled 이름을 c++filt 로 한 번에 푼다."""
+    mangled = sorted(s for s in symbols if '_Z' in s)
+    if not mangled or not shutil.which('c++filt'):
+        return {}
+    out = subprocess.run(['c++filt'], input='\n'.join(mangled), capture_output=True, text=True).stdout
+    return dict(zip(mangled, out.splitlines()))
+
+
+def section_sizes(obj: Path, size_tool: str = 'size') -> Sections:
+    out = subprocess.run([size_tool, str(obj)], capture_output=True, text=True, check=True).stdout
+    text, data, bss = out.splitlines()[1].split()[:3]
+    return Sections(int(text), int(data), int(bss))
+
+
+def call_graph(ci: Path) -> tuple[dict[str, int], dict[str, set[str]]]:
+    """(스케치 함수 -> static frame bytes, caller -> callees). 스케치 밖 함수는 frame 이 없다."""
+    nodes, calls = {}, []
+    for line in ci.read_text(encoding='utf-8', errors='replace').splitlines():
+        if m := _CI_NODE_RE.match(line):
+            if m[3] is not None:
+                nodes[m[1]] = max(nodes.get(m[1], 0), int(m[3]))
+        elif m := _CI_EDGE_RE.match(line):
+            calls.append((m[1], m[2]))
+    plain = _demangle({n.rsplit(':', 1)[-1] for n in nodes} | {n for c in calls for n in c})
+
+    def name(symbol: str) -> str:
+        symbol = symbol.rsplit(':', 1)[-1]
+        return _base_name(plain.get(symbol, symbol))
+
+    frames, edges = {}, defaultdict(set)
+    for node, size in nodes.items():
+        frames[name(node)] = max(frames.get(name(node), 0), size)
+    for caller, callee in calls:
+        edges[name(caller)].add(name(callee))
+    return frames, edges
+
+
+def worst_stack(frames: dict[str, int], edges: dict[str, set[str]]) -> tuple[int, list[str]]:
+    """진입점(호출되지 않는 함수)마다 가장 깊은 경로. 재귀는 한 번만 센다."""
+    memo: dict[str, tuple[int, list[str]]] = {}
+
+    def deepest(fn: str, visiting: frozenset) -> tuple[int, list[str]]:
+        if fn in memo:
+            return memo[fn]
+        best = (0, [])
+        for callee in edges.get(fn, ()):
+            if callee in frames and callee not in visiting:
+                best = max(best, deepest(callee, visiting | {fn}), key=lambda r: r[0])
+        res = (frames.get(fn, 0) + best[0], [fn, *best[1]])
+        memo[fn] = res
+        return res
+
+    called = {c for callees in edges.values() for c in callees}
+    roots = [f for f in frames if f not in called] or list(frames)
+    return max((deepest(r, frozenset()) for r in roots), default=(0, []), key=lambda r: r[0])
+
+
+def entry_points(frames: dict[str, int], edges: dict[str, set[str]]) -> set[str]:
+    called = {c for callees in edges.values() for c in callees}
+    return {f for f in frames if f not in called} | ENTRY_NAMES
+
+
+def parse_callgrind(path: Path, source: str) -> tuple[dict[str, int], dict[str, int]]:
+    """callgrind 출력에서 source 파일에 속한 함수의 (self Ir, inclusive Ir)."""
+    names: dict[str, str] = {}
+    self_cost, incl_cost = defaultdict(int), defaultdict(int)
+    fl = fn = ''
+    after_call = False
+
+    def resolve(value: str) -> str:
+        m = re.match(r'\((\d+)\)(?: (.*))?', value)
+        if not m:
+            return value
+        if m[2] is not None:
+            names[m[1]] = m[2]
+        return names.get(m[1], '')
+
+    for line in path.read_text(encoding='utf-8', errors='replace').splitlines():
+        if line.startswith('fl='):
+            fl = resolve(line[3:])
+        elif line.startswith('fn='):
+            fn = resolve(line[3:])
+        elif line.startswith(('cfn=', 'cfl=', 'cfi=', 'cob=', 'ob=', 'fi=', 'fe=')):
+            resolve(line.split('=', 1)[1])
+        elif line.startswith('calls='):
+            after_call = True
+        elif line[:1].isdigit() or line[:1] in '+-*':
+            parts = line.split()
+            cost = int(parts[1]) if len(parts) > 1 else 0
+            if fl.endswith(source) and fn:
+                name = _base_name(fn)
+                incl_cost[name] += cost
+                if not after_call:
+                    self_cost[name] += cost
+            after_call = False
+    return dict(self_cost), dict(incl_cost)
+
+
+def parse_gcov(gcda: Path) -> dict[str, int]:
+    """gcov JSON 의 함수별 줄 실행 횟수 합 (self 만 있다)."""
+    out = subprocess.run(['gcov', '--json-format', '--stdout', str(gcda)], capture_output=True, text=True,
+                         cwd=gcda.parent).stdout
+    cost = defaultdict(int)
+    for f in json.loads(out or '{"files": []}')['files']:
+        plain = {fn['name']: fn['demangled_name'] for fn in f['functions']}
+        for line in f['lines']:
+            if fn := line.get('function_name'):
+                cost[_base_name(plain.get(fn, fn))] += line['count']
+    return dict(cost)
+
+
+def _compile(src: Path, lang: str, flags: list[str], obj: Path, compiler: str | None = None) -> str:
+    cmd = compiler_command(lang, [*flags, '-c', str(src), '-o', str(obj)])
+    if compiler:
+        cmd[0] = compiler
+    proc = subprocess.run(cmd, capture_output=True, text=True, timeout=120)
+    if proc.returncode == 0:
+        return ''
+    err = next((ln for ln in proc.stderr.splitlines() if ' error: ' in ln), proc.stderr.strip()[-200:])
+    return err.replace(f'{src.parent}/', '')
+
+
+def measure(path: Path, model: str, duration_ms: float, handlers: list[str], profile: bool = True) -> StepCost:
+    """profile=False 면 size 와 stack 만 잰다."""
+    m = _STEP_RE.search(path.name)
+    query = query_of(path)
+    cost = StepCost(model, query, int(m[1]), m[2], True)
+    src_text, lang = prepare_source(path.read_text(encoding='utf-8'))
+
+    with tempfile.TemporaryDirectory() as tmp:
+        tmp = Path(tmp)
+        src = tmp / ('sketch.cpp' if lang == 'arduino' else 'sketch.c')
+        src.write_text(src_text, encoding='utf-8')
+
+        obj = tmp / 'size.o'
+        if err := _compile(src, lang, [*SIZE_FLAGS, '-fcallgraph-info=su'], obj):
+            return StepCost(model, query, cost.step, cost.prompt, False, err)
+        cost.host = section_sizes(obj)
+        frames, edges = call_graph(tmp / 'size.ci')
+
+        compiler = f'{XTENSA_PREFIX}{"g++" if lang == "arduino" else "gcc"}'
+        if shutil.which(compiler):
+            xobj = tmp / 'xtensa.o'
+            if not _compile(src, lang, [*SIZE_FLAGS, '-mlongcalls', '-fcallgraph-info=su'], xobj, compiler):
+                cost.xtensa = section_sizes(xobj, f'{XTENSA_PREFIX}size')
+                frames, edges = call_graph(tmp / 'xtensa.ci')
+        cost.stack, cost.stack_path = worst_stack(frames, edges)
+        if not profile:
+            return cost
+
+        script = script_for(query)
+        run = [f'{tmp}/sketch.bin', '--duration-ms', str(duration_ms), '--trace', '/dev/null']
+        if script.exists():
+            run += ['--script', str(script)]
+        valgrind = shutil.which('valgrind')
+        pobj = tmp / 'profile.o'
+        link = ['g++', '-o', run[0], str(pobj), str(build_runtime())]
+        if err := _compile(src, lang, [*PROFILE_FLAGS, *([] if valgrind else ['--coverage'])], pobj):
+            return StepCost(model, query, cost.step, cost.prompt, False, err)
+        subprocess.run(link + ([] if valgrind else ['--coverage']), check=True, capture_output=True)
+        if valgrind:
+            out = tmp / 'callgrind.out'
+            subprocess.run([valgrind, '--tool=callgrind', f'--callgrind-out-file={out}', *run],
+                           capture_output=True, timeout=600)
+            self_cost, incl_cost = parse_callgrind(out, src.name)
+            cost.unit = 'Ir'
+        else:
+            subprocess.run(run, capture_output=True, timeout=120, cwd=tmp)
+            self_cost = parse_gcov(tmp / 'profile.gcda') if (tmp / 'profile.gcda').exists() else {}
+            incl_cost = self_cost
+            cost.unit = 'lines'
+
+    cost.total = sum(self_cost.values())
+    entries = entry_points(frames, edges)
+    hot = [(c, f) for f, c in incl_cost.items() if f not in entries]
+    if hot:
+        cost.hot_cost, cost.hot = max(hot)
+    wanted = {_norm(h): h for h in handlers}
+    cost.handlers = {wanted[_norm(f)]: c for f, c in incl_cost.items() if _norm(f) in wanted}
+    return cost
+
+
+def _delta(value: int, base: int) -> str:
+    if not base:
+        return ''
+    pct = (value - base) * 100 / base
+    return f' ({pct:+.0f}%)' if abs(pct) >= 0.5 else ''
+
+
+def format_table(costs: list[StepCost]) -> str:
+    lines = []
+    by_key = defaultdict(list)
+    for c in costs:
+        by_key[(c.model, c.query)].append(c)
+    for (model, query), rows in sorted(by_key.items()):
+        rows.sort(key=lambda c: c.step)
+        base = next((c for c in rows if c.ok), None)
+        xt = any(c.xtensa for c in rows)
+        lines.append(f'## {model} {query}')
+        head = f'{"step":<7}{"text":>16}{"data":>7}{"bss":>7}'
+        head += f'{"xt.text":>9}' if xt else ''
+        head += f'{"stack":>14}{"cost":>22}  hot / handlers'
+        lines.append(head)
+        for c in rows:
+            if not c.ok:
+                lines.append(f'{c.step}:{c.prompt:<5} build failed: {c.error[:90]}')
+                continue
+            row = f'{c.step}:{c.prompt:<5}{c.host.text:>8}{_delta(c.host.text, base.host.text):<8}'
+            row += f'{c.host.data:>7}{c.host.bss:>7}'
+            if xt:
+                row += f'{c.xtensa.text if c.xtensa else "-":>9}'
+            row += f'{c.stack:>6}{_delta(c.stack, base.stack):<8}'
+            row += f'{c.total:>12} {c.unit:<5}{_delta(c.total, base.total):<5}'
+            row += f'  {c.hot or "-"}={c.hot_cost}' if c.hot else '  -'
+            row += ''.join(f' {h}={v}' for h, v in c.handlers.items())
+            lines.append(row)
+        lines.append('')
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='p0..p8 단계별 코드 크기 / stack / 실행 비용')
+    parser.add_argument('--models', nargs='*', default=['qwen3', 'gpt4_1'])
+    parser.add_argument('--queries', nargs='*', default=[])
+    parser.add_argument('--steps', nargs='*', type=int, default=None)
+    parser.add_argument('--duration-ms', type=float, default=60_000, help='callgrind 는 느리므로 짧게')
+    parser.add_argument('--handlers', nargs='*', default=HOT_HANDLERS)
+    parser.add_argument('--json', help='결과를 JSON 으로 저장')
+    args = parser.parse_args()
+
+    if not shutil.which('valgrind'):
+        print('[COST] valgrind 없음: 실행 비용은 gcov 줄 실행 횟수로 잰다')
+    costs = []
+    for model in args.models:
+        for f in corpus_files([model], args.queries, args.steps):
+            costs.append(measure(f, model, args.duration_ms, args.handlers))
+            c = costs[-1]
+            print(f'[COST] {f.relative_to(PROJECT_ROOT)}: '
+                  + (f'text {c.host.text} stack {c.stack} cost {c.total} {c.unit}' if c.ok else 'build failed'))
+    print()
+    print(format_table(costs))
+    if args.json:
+        Path(args.json).write_text(json.dumps([asdict(c) for c in costs], ensure_ascii=False, indent=1),
+                                   encoding='utf-8')
+        print(f'[COST] saved {args.json}')
+
+
+if __name__ == '__main__':
+    main()
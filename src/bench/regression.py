@@ -0,0 +1,270 @@
+"""
+사슬의 마지막 step 이 첫 step 보다 크거나 느려졌을 때 어느 prompt step 이 그렇게 만들었는지 찾는다.
+
+(model, query) 사슬의 모든 step 을 고른 metric 으로 재고 (bench.dashboard 와 같은 방법),
+step 마다 바로 앞의 성공한 step 과의 차이를 그 step 의 prompt 몫으로 돌린다.
+step 마다 함수 단위 차이도 같이 보여준다:
+- size:   -Os object 의 함수 크기 (nm, .isra/.part clone 은 원래 함수에 합친다). 함수가 아닌 text 는 따로 한 줄
+- stack:  같은 object 의 함수 stack frame (-fcallgraph-info=su)
+- cycles: bench.wcet 의 함수 WCET (끝나지 않는 task body 는 한 바퀴)
+text 는 크기, stack 은 frame, 나머지 metric 은 cycle 차이가 큰 함수부터 --top 개.
+
+metric: text, stack, wcet_us (loop/task/끝나지 않는 app_main 중 최악), isr_us, mask_max_us (가장 긴 critical section),
+lat_p90_ms, dropped, bus_ms, busy_pct. --handler 를 주면 그 함수의 WCET (us) 를 metric 으로 쓴다.
+기본은 마지막 성공 step 이 첫 step 보다 --threshold % 이상 나빠진 사슬만 보여준다 (--all 이면 전부).
+
+실행:
+  PYTHONPATH=src python -m bench.regression --metric text
+  PYTHONPATH=src python -m bench.regression --models gpt4_1 --queries i4 --metric mask_max_us --all
+  PYTHONPATH=src python -m bench.regression --queries i1 --handler HandleNumberButton --json /tmp/reg.json
+"""
+
+import argparse
+import json
+import shutil
+import subprocess
+import tempfile
+from dataclasses import asdict, dataclass, field
+from pathlib import Path
+
+from bench.dashboard import METRICS, Row, collect, step_label
+from bench.prompt_cost import SIZE_FLAGS, XTENSA_PREFIX, _base_name, _compile, _norm, call_graph, section_sizes
+from bench.wcet import EXTERNAL_CYCLES, MHZ, WcetReport, analyze
+from sim.run import corpus_files
+from util.compile_check import PROJECT_ROOT, prepare_source
+
+TEXT_TYPES = set('tTwW')
+OTHER_TEXT = '(non-function text)'
+# 전역 생성자 묶음. 이름이 첫 전역 symbol 에서 오므로 (_GLOBAL__sub_I_lcd, _GLOBAL__sub_I__Z5setupv) 하나로 합친다
+STATIC_INIT = '(static initializers)'
+
+
+@dataclass
+class FunctionCost:
+    size: int = 0
+    frame: int = 0              # static stack frame
+    cycles: int = 0
+
+
+@dataclass
+class FunctionDelta:
+    name: str
+    size: int
+    frame: int
+    cycles: int
+    change: str = ''            # 'new' | 'gone' | ''
+
+    def text(self) -> str:
+        parts = [f'{v:+d} {unit}' for v, unit in ((self.size, 'B'), (self.frame, 'B stack'), (self.cycles, 'cyc')) if v]
+        return f'{self.name} {" ".join(parts)}' + (f' ({self.change})' if self.change else '')
+
+
+@dataclass
+class StepDelta:
+    step: int
+    prompt: str
+    ok: bool
+    value: float | None = None
+    delta: float | None = None  # 바로 앞의 성공한 step 대비
+    share: float | None = None  # 첫 step -> 마지막 step 변화 중 이 step 몫 (%)
+    error: str = ''
+    functions: list[FunctionDelta] = field(default_factory=list)
+
+
+@dataclass
+class Chain:
+    model: str
+    query: str
+    metric: str
+    unit: str
+    first: float | None = None
+    last: float | None = None
+    culprit: str = ''           # 가장 크게 나빠지게 한 prompt
+    steps: list[StepDelta] = field(default_factory=list)
+
+    @property
+    def change_pct(self) -> float | None:
+        if self.first is None or self.last is None or not self.first:
+            return None
+        return (self.last - self.first) * 100 / self.first
+
+
+def function_sizes(path: Path) -> tuple[dict[str, int], dict[str, int]]:
+    """
+    -Os object 의 (함수별 크기, 함수별 stack frame).
+    size 의 text 중 함수가 아닌 것(문자열, 상수 표, unwind 정보)은 OTHER_TEXT 로 센다.
+    """
+    src_text, lang = prepare_source(path.read_text(encoding='utf-8'))
+    with tempfile.TemporaryDirectory() as tmp:
+        src = Path(tmp) / ('sketch.cpp' if lang == 'arduino' else 'sketch.c')
+        src.write_text(src_text, encoding='utf-8')
+        obj = Path(tmp) / 'size.o'
+        if _compile(src, lang, [*SIZE_FLAGS, '-fcallgraph-info=su'], obj):
+            return {}, {}
+        out = subprocess.run(['nm', '-S', '-C', '--defined-only', str(obj)], capture_output=True, text=True).stdout
+        total = section_sizes(obj).text
+        frames, _ = call_graph(Path(tmp) / 'size.ci')
+    sizes: dict[str, int] = {}
+    for line in out.splitlines():
+        parts = line.split(maxsplit=3)
+        if len(parts) == 4 and parts[2] in TEXT_TYPES:
+            name = _base_name(parts[3])
+            sizes[name] = sizes.get(name, 0) + int(parts[1], 16)
+    sizes[OTHER_TEXT] = total - sum(sizes.values())
+    return sizes, frames
+
+
+def _cost_key(name: str) -> str:
+    return STATIC_INIT if name.startswith('_GLOBAL__sub_I_') else name
+
+
+def function_costs(path: Path, wcet: WcetReport) -> dict[str, FunctionCost]:
+    sizes, frames = function_sizes(path)
+    costs: dict[str, FunctionCost] = {}
+    for name, size in sizes.items():
+        costs.setdefault(_cost_key(name), FunctionCost()).size += size
+    for name, frame in frames.items():
+        c = costs.setdefault(_cost_key(name), FunctionCost())
+        c.frame = max(c.frame, frame)
+    for f in wcet.functions:
+        costs.setdefault(_cost_key(f.name), FunctionCost()).cycles += f.iteration_cycles if f.forever else f.cycles
+    return costs
+
+
+def handler_us(wcet: WcetReport, handler: str, mhz: float) -> float | None:
+    f = next((f for f in wcet.functions if _norm(f.name) == _norm(handler)), None)
+    if f is None:
+        return None
+    return (f.iteration_cycles if f.forever else f.cycles) / mhz
+
+
+def diff_functions(before: dict[str, FunctionCost], after: dict[str, FunctionCost], by: str,
+                   top: int) -> list[FunctionDelta]:
+    """by ('size' | 'frame' | 'cycles') 차이가 큰 함수부터"""
+    deltas = []
+    for name in before.keys() | after.keys():
+        a, b = before.get(name, FunctionCost()), after.get(name, FunctionCost())
+        d = FunctionDelta(name, b.size - a.size, b.frame - a.frame, b.cycles - a.cycles,
+                          'new' if name not in before else 'gone' if name not in after else '')
+        if d.size or d.frame or d.cycles:
+            deltas.append(d)
+    deltas.sort(key=lambda d: (-abs(getattr(d, by)), -abs(d.size) - abs(d.cycles), d.name))
+    return deltas[:top]
+
+
+def bisect_chain(files: list[Path], model: str, metric: str, handler: str | None, top: int, cost_model: str,
+                 mhz: float, wcet_ms: float, run_ms: float, latency_ms: float) -> Chain:
+    unit = 'us' if handler else next(m.unit for m in METRICS if m.key == metric)
+    by = 'cycles' if handler else {'text': 'size', 'stack': 'frame'}.get(metric, 'cycles')
+    rows: list[Row] = []
+    funcs: list[dict[str, FunctionCost]] = []
+    values: list[float | None] = []
+    for f in files:
+        wcet = analyze(f, model, cost_model, wcet_ms, mhz, dict(EXTERNAL_CYCLES))
+        row = collect(f, model, cost_model, mhz, wcet_ms, run_ms, latency_ms, wcet)
+        rows.append(row)
+        funcs.append(function_costs(f, wcet) if row.ok else {})
+        if not row.ok:
+            values.append(None)
+        elif handler:
+            values.append(handler_us(wcet, handler, mhz) if wcet.ok else None)
+        else:
+            values.append(getattr(row, metric))
+
+    chain = Chain(model, rows[0].query, f'{handler} WCET' if handler else metric, unit)
+    known = [v for r, v in zip(rows, values) if r.ok and v is not None]
+    if known:
+        chain.first, chain.last = known[0], known[-1]
+    total = chain.last - chain.first if known else 0
+    prev = None
+    for k, (r, v) in enumerate(zip(rows, values)):
+        sd = StepDelta(r.step, r.prompt, r.ok, v, error=r.error)
+        chain.steps.append(sd)
+        if not r.ok:
+            continue
+        if prev is not None:
+            pv = values[prev]
+            if v is not None and pv is not None:
+                sd.delta = v - pv
+                sd.share = sd.delta * 100 / total if total else None
+            sd.functions = diff_functions(funcs[prev], funcs[k], by, top)
+        prev = k
+    worst = max((s for s in chain.steps if s.delta), key=lambda s: s.delta, default=None)
+    if worst and worst.delta > 0:
+        chain.culprit = worst.prompt
+    return chain
+
+
+def _fmt(value: float | None) -> str:
+    if value is None:
+        return '-'
+    return f'{value:,.0f}' if abs(value) >= 100 or value == int(value) else f'{value:,.1f}'
+
+
+def format_chain(chain: Chain) -> str:
+    pct = chain.change_pct
+    known = [s.step for s in chain.steps if s.ok and s.value is not None]
+    head = (f'## {chain.model} {chain.query} {chain.metric} ({step_label(known)}): '
+            f'{_fmt(chain.first)} -> {_fmt(chain.last)} {chain.unit}'
+            + (f' ({pct:+.1f}%)' if pct is not None else ''))
+    if chain.culprit:
+        head += f', largest increase at {chain.culprit}'
+    lines = [head, f'{"step":<8}{"value":>12}{"delta":>12}{"share":>8}  functions']
+    for s in chain.steps:
+        if not s.ok:
+            lines.append(f'{s.step}:{s.prompt:<6}build failed: {s.error[:80]}')
+            continue
+        delta = f'{"+" if s.delta and s.delta > 0 else ""}{_fmt(s.delta)}' if s.delta is not None else ''
+        share = f'{s.share:+.0f}%' if s.share is not None else ''
+        funcs = ', '.join(d.text() for d in s.functions)
+        lines.append(f'{s.step}:{s.prompt:<6}{_fmt(s.value):>12}{delta:>12}{share:>8}  {funcs}')
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='prompt 사슬의 첫 step 과 마지막 step 사이에서 성능을 나쁘게 만든 prompt 찾기')
+    parser.add_argument('--models', nargs='*', default=['qwen3', 'gpt4_1'])
+    parser.add_argument('--queries', nargs='*', default=[])
+    parser.add_argument('--metric', choices=[m.key for m in METRICS], default='text')
+    parser.add_argument('--handler', help='이 함수의 WCET (us) 를 metric 으로 쓴다 (대소문자/_ 무시)')
+    parser.add_argument('--threshold', type=float, default=1.0, help='이만큼 (%%) 나빠진 사슬만 보여준다')
+    parser.add_argument('--all', action='store_true', help='나빠지지 않은 사슬도 보여준다')
+    parser.add_argument('--top', type=int, default=3, help='step 마다 보여줄 함수 수')
+    parser.add_argument('--cost-model', choices=['auto', 'host', 'esp32s3'], default='auto')
+    parser.add_argument('--mhz', type=float, default=MHZ)
+    parser.add_argument('--wcet-ms', type=float, default=60_000)
+    parser.add_argument('--duration-ms', type=float, default=3_600_000)
+    parser.add_argument('--latency-ms', type=float, default=120_000)
+    parser.add_argument('--json', help='결과를 JSON 으로 저장')
+    args = parser.parse_args()
+
+    cost_model = args.cost_model
+    if cost_model == 'auto':
+        cost_model = 'esp32s3' if shutil.which(f'{XTENSA_PREFIX}gcc') else 'host'
+
+    chains = []
+    for model in args.models:
+        by_query: dict[str, list[Path]] = {}
+        for f in corpus_files([model], args.queries):
+            by_query.setdefault(f.parent.name, []).append(f)
+        for query, files in sorted(by_query.items()):
+            chain = bisect_chain(files, model, args.metric, args.handler, args.top, cost_model, args.mhz,
+                                 args.wcet_ms, args.duration_ms, args.latency_ms)
+            pct = chain.change_pct
+            worse = chain.first is not None and chain.last is not None and chain.last > chain.first and (
+                pct is None or pct >= args.threshold)
+            print(f'[REG] {model} {query} {chain.metric}: {_fmt(chain.first)} -> {_fmt(chain.last)} {chain.unit}'
+                  + (f' ({pct:+.1f}%)' if pct is not None else '')
+                  + (f', largest increase at {chain.culprit}' if worse and chain.culprit else ''))
+            if worse or args.all:
+                chains.append(chain)
+    print()
+    print('\n\n'.join(format_chain(c) for c in chains) or f'[REG] no chain got worse by {args.threshold}%')
+    if args.json:
+        Path(args.json).write_text(json.dumps([asdict(c) for c in chains], ensure_ascii=False, indent=1),
+                                   encoding='utf-8')
+        print(f'[REG] saved {args.json}')
+
+
+if __name__ == '__main__':
+    main()
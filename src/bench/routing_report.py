@@ -0,0 +1,107 @@
+"""
+model routing 정책의 비용/latency 를 단일 모델 baseline 과 비교한다 (user_queries 5개 기준).
+
+기본(estimate): LLM 을 부르지 않고 저장된 corpus(gen_pipe / eval_pipe)로 호출별 token 을 추정해
+            routing 정책과 baseline 정책에 각각 가격을 매긴다. latency 는 tier 의 ms_per_output_token 으로 추정.
+            p8 은 로컬 formatter 로 처리되므로 generation 호출에서 뺀다.
+--run:      실제로 routed / baseline 두 번 pipeline 을 돌려서 측정한다. ledger 는 --out-dir 에 jsonl 로 남긴다.
+
+실행:
+  PYTHONPATH=src python -m bench.routing_report --corpus qwen3
+  PYTHONPATH=src python -m bench.routing_report --run --queries i1 i2 --out-dir /tmp/routing
+"""
+
+import argparse
+from pathlib import Path
+
+from routing import DEFAULT_POLICY, EVALUATION, GENERATION, ModelRouter, RoutingPolicy, RoutingReport
+from util.compaction import count_tokens
+from util.prompt_registry import registry
+from util.usage import UsageLedger, UsageRecord
+from pipe_agent import FORMAT_PROMPT
+
+ROOT_DIR = Path(__file__).resolve().parents[2]
+PROMPTS = ['p0', 'p1', 'p2', 'p3', 'p4', 'p5', 'p6', 'p7', 'p8']
+
+
+def _step_files(qdir: Path, suffix: str) -> dict[int, Path]:
+    return {int(f.name.split('_')[1][4:]): f for f in qdir.glob(f'out_step*{suffix}')}
+
+
+def estimate_ledger(policy: RoutingPolicy, corpus: str, queries: list[str]) -> UsageLedger:
+    """corpus 의 단계별 입출력 크기로 호출을 재구성한다 (escalation 은 없다고 가정)."""
+    ledger = UsageLedger()
+    eval_prompt = registry.prompt('evaluation')
+
+    def add(kind: str, pname: str, in_text: str, out_text: str):
+        tier = policy.tiers[policy.tier_for(kind, [pname])]
+        i, o = count_tokens(in_text, tier.model), count_tokens(out_text, tier.model)
+        ledger.add(UsageRecord(kind, pname, tier.name, tier.model, i, o,
+                               o * tier.ms_per_output_token / 1000, estimated=True))
+
+    for query in queries:
+        user_msg = (ROOT_DIR / 'user_queries' / f'{query}.txt').read_text(encoding='utf-8')
+        gen = _step_files(ROOT_DIR / corpus / 'gen_pipe' / query, '.c')
+        evals = _step_files(ROOT_DIR / corpus / 'eval_pipe' / query, '.md')
+        prev = user_msg
+        for step, pname in enumerate(PROMPTS):
+            if step not in gen:
+                break
+            code = gen[step].read_text(encoding='utf-8')
+            if pname != FORMAT_PROMPT:
+                add(GENERATION, pname, registry.prompt(pname) + prev, code)
+            if step in evals:
+                add(EVALUATION, pname, eval_prompt + registry.prompt(pname) + code,
+                    evals[step].read_text(encoding='utf-8'))
+            prev = code
+    return ledger
+
+
+def run_ledger(router: ModelRouter, queries: list[str]) -> UsageLedger:
+    from pipe_agent import PipeAgent
+    from pipe_evaluation import PipeEvaluator
+
+    agent, evaluator = PipeAgent(router=router), PipeEvaluator(router=router)
+    for query in queries:
+        user_msg = (ROOT_DIR / 'user_queries' / f'{query}.txt').read_text(encoding='utf-8')
+        stages = list(agent.invoke_yield(PROMPTS, user_msg))
+        list(evaluator.invoke_yield(stages[1:]))
+        print(f'[ROUTE] {query}: {len(router.ledger)} calls so far')
+    return router.ledger
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--policy', default=str(DEFAULT_POLICY))
+    parser.add_argument('--queries', nargs='*', default=['i1', 'i2', 'i3', 'i4', 'i5'])
+    parser.add_argument('--run', action='store_true', help='실제 LLM 호출로 측정')
+    parser.add_argument('--corpus', default='qwen3', help='estimate 에서 쓸 결과 폴더')
+    parser.add_argument('--out-dir', default=None, help='--run 의 ledger 저장 위치')
+    args = parser.parse_args()
+
+    policy = RoutingPolicy.from_file(args.policy)
+    baseline = policy.single()
+    if args.run:
+        routed = run_ledger(ModelRouter(policy), args.queries)
+        single = run_ledger(ModelRouter(baseline), args.queries)
+        if args.out_dir:
+            out = Path(args.out_dir)
+            out.mkdir(parents=True, exist_ok=True)
+            routed.dump(out / 'routed.jsonl')
+            single.dump(out / 'baseline.jsonl')
+    else:
+        routed = estimate_ledger(policy, args.corpus, args.queries)
+        single = estimate_ledger(baseline, args.corpus, args.queries)
+
+    report = RoutingReport.build(routed, policy)
+    measured = RoutingReport.build(single, baseline)
+    print(report.format())
+    print(f'[ROUTE] single-model {policy.baseline}: {measured.calls} calls, cost ${measured.cost:.4f}, '
+          f'latency {measured.latency:.1f}s')
+    saving = (1 - report.cost / measured.cost) * 100 if measured.cost else 0.0
+    speedup = (1 - report.latency / measured.latency) * 100 if measured.latency else 0.0
+    print(f'[ROUTE] routed vs single-model: cost saving {saving:.1f}%, latency saving {speedup:.1f}%')
+
+
+if __name__ == '__main__':
+    main()
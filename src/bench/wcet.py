@@ -0,0 +1,711 @@
+"""
+loop() 한 번, task body 한 바퀴, ISR 한 번의 최악 실행 시간(WCET)을 어림해서 prompt step 별로 비교한다.
+방어 코드, mutex, snprintf 가 step 마다 늘고 줄면서 real-time 여유가 어떻게 바뀌는지 보려는 것이다.
+
+정적 분석 + 측정:
+- 정적: 스케치 object 를 objdump 로 풀어 함수마다 basic block CFG 와 call graph 를 만들고,
+  block 비용은 명령어 표(cost model)로 센다. 가장 비싼 경로를 loop 는 (최대 반복 수 x 한 바퀴 최악) 으로 묶어서 구한다.
+    host     x86-64 명령어의 대략적인 cycle 수 (host object)
+    esp32s3  Xtensa LX7 명령어의 cycle 수 (xtensa-esp32s3-elf-gcc 가 있을 때)
+- 측정: loop 의 반복 수는 정적으로 알 수 없으므로 hostsim 에서 query 기본 script 로 돌려 잰다.
+  -fsanitize-coverage=trace-pc 로 빌드한 스케치에 런타임 probe (hostsim/runtime/wcet/probe.cpp) 를 링크해서
+  loop 에 들어갈 때마다 header 가 몇 번 도는지 세고 그 최대를 bound 로 쓴다. loop 는 (함수, body 소스 줄) 로 맞춘다.
+  돌지 않은 loop 는 1 번으로 보고 'unmeasured' 로 표시한다. 입력 script 가 건드리지 않은 경로의 bound 는 빠진다.
+
+비용에서 빼고 따로 세는 호출:
+  wait  delay, vTaskDelay, xQueueReceive, xSemaphoreTake 처럼 기다리는 호출 (blocking). delayMicroseconds 도 여기
+  bus   LCD / I2C 전송 (sim.lcdbus 가 bus 시간을 잰다). Arduino 의 lcd.print() 는 x86-64 에서만 구분된다
+그 밖의 런타임/libc 호출은 EXTERNAL_CYCLES 표 (없으면 DEFAULT_CALL_CYCLES) 로 센다.
+함수 포인터 호출, 재귀는 한 번으로 보고 표시한다. for(;;) 로 끝나지 않는 task 는 한 바퀴를 잰다.
+
+실행:
+  PYTHONPATH=src python -m bench.wcet --models gpt4_1 --queries i4
+  PYTHONPATH=src python -m bench.wcet --models qwen3 --queries i1 --functions --json /tmp/wcet.json
+"""
+
+import argparse
+import json
+import re
+import shutil
+import subprocess
+import tempfile
+from collections import Counter, defaultdict
+from dataclasses import asdict, dataclass, field
+from pathlib import Path
+
+from bench.prompt_cost import _STEP_RE, XTENSA_PREFIX, _base_name, _compile
+from sim.build import build_sketch
+from sim.run import corpus_files, query_of
+from sim.runner import run_binary, script_for
+from util.compile_check import PROJECT_ROOT, prepare_source
+
+# 함수마다 따로 보려고 inline, clone, tail call, jump table, hot/cold 분할을 끈다
+ANALYSIS_FLAGS = ['-Os', '-g', '-fno-inline', '-fno-ipa-cp', '-fno-ipa-sra', '-fno-ipa-icf', '-fno-jump-tables',
+                  '-fno-optimize-sibling-calls', '-fno-reorder-blocks-and-partition']
+# probe 는 호출한 함수의 frame pointer 로 호출을 구분한다
+PROBE_FLAGS = [*ANALYSIS_FLAGS, '-fno-omit-frame-pointer', '-fno-shrink-wrap', '-fsanitize-coverage=trace-pc']
+PROBE_HOOK = '__sanitizer_cov_trace_pc'
+MHZ = 240
+
+WAIT_CALLS = {'delay', 'delayMicroseconds', 'vTaskDelay', 'vTaskDelayUntil', 'taskYIELD', 'xQueueReceive',
+              'xQueuePeek', 'xQueueSend', 'xQueueSendToBack', 'xQueueSendToFront', 'hostsim_semaphore_take',
+              'waitForKey', 'pulseIn', 'readString', 'readStringUntil', 'readBytes', 'readBytesUntil',
+              'parseInt', 'parseFloat'}
+BUS_CLASSES = {'LiquidCrystal', 'LiquidCrystal_I2C', 'HostLcd', 'TwoWire'}
+BUS_PREFIXES = ('lcd_', 'lcd1602_', 'i2c_master_')
+NORETURN_CALLS = {'abort', 'exit', '_exit', '__assert_fail', '__stack_chk_fail', 'esp_restart', 'esp_system_abort'}
+
+# 런타임/libc 호출 한 번의 대략적인 cycle 수 (ESP32-S3, 240 MHz 기준 어림)
+DEFAULT_CALL_CYCLES = 100
+EXTERNAL_CYCLES = {
+    'snprintf': 2500, 'sprintf': 2500, 'vsnprintf': 2500, 'printf': 4000, 'ESP_LOG': 4000, 'esp_log_write': 4000,
+    'sscanf': 3000, 'atoi': 150, 'atof': 800, 'strtol': 200, 'strtof': 800, 'strtod': 800,
+    'strlen': 60, 'strcmp': 60, 'strncmp': 60, 'strcpy': 80, 'strncpy': 80, 'strcat': 100, 'strncat': 100,
+    'memcpy': 80, 'memset': 80, 'memmove': 80, 'memcmp': 60,
+    'digitalRead': 60, 'digitalWrite': 80, 'pinMode': 300, 'analogRead': 2400, 'analogWrite': 300,
+    'gpio_get_level': 40, 'gpio_set_level': 40, 'millis': 40, 'micros': 40, 'xTaskGetTickCount': 30,
+    'esp_timer_get_time': 40, 'hostsim_port_enter_critical': 40, 'hostsim_port_exit_critical': 40,
+    'hostsim_semaphore_give': 300, 'xQueueSendFromISR': 300, 'xQueueReceiveFromISR': 300,
+    'xSemaphoreGiveFromISR': 300, 'xTaskCreate': 6000, 'xTaskCreatePinnedToCore': 6000,
+    'getKey': 2500, 'print': 400, 'println': 500, 'write': 200, 'available': 60, 'read': 80,
+    'String': 300, 'concat': 300, 'toInt': 150, 'operator+=': 300, 'operator=': 200,
+}
+
+# ------- 명령어 표
+_X86_PREFIXES = {'rep', 'repz', 'repe', 'repnz', 'repne', 'bnd', 'notrack', 'lock', 'data16'}
+_X86_CYCLES = [         # (mnemonic prefix, cycles), 앞에서부터 찾는다
+    ('div', 26), ('idiv', 26), ('imul', 3), ('mul', 3), ('sqrt', 18), ('divs', 14), ('cvt', 4),
+    ('adds', 4), ('subs', 4), ('muls', 4), ('call', 2), ('ret', 2), ('push', 1), ('pop', 1), ('nop', 0),
+]
+_XTENSA_CYCLES = {
+    'l8ui': 2, 'l16ui': 2, 'l16si': 2, 'l32i': 2, 'l32i.n': 2, 'l32r': 2, 'lsi': 2,
+    'mull': 2, 'mul16u': 2, 'mul16s': 2, 'muluh': 2, 'mulsh': 2,
+    'quos': 13, 'quou': 13, 'rems': 13, 'remu': 13,
+    'add.s': 2, 'sub.s': 2, 'mul.s': 2, 'madd.s': 2, 'msub.s': 2, 'div0.s': 2, 'sqrt0.s': 2,
+    'j': 2, 'jx': 3, 'call0': 3, 'call4': 3, 'call8': 3, 'call12': 3,
+    'callx0': 3, 'callx4': 3, 'callx8': 3, 'callx12': 3, 'ret': 3, 'ret.n': 3, 'retw': 3, 'retw.n': 3,
+    'memw': 1, 'nop': 0, 'nop.n': 0,
+}
+_XTENSA_BRANCH_TAKEN = 3
+_XTENSA_LOOPS = {'loop', 'loopnez', 'loopgtz'}
+
+_FUNC_RE = re.compile(r'^([0-9a-f]+) <(.+)>:$')
+_LINE_RE = re.compile(r'^(\S+?):(\d+)(?: \(discriminator \d+\))?$')
+_INSN_RE = re.compile(r'^\s*([0-9a-f]+):\t(\S+)\s*(.*)$')
+_RELOC_RE = re.compile(r'^\s+[0-9a-f]+: (R_\S+)\s+(.+?)(?:[+-]0x[0-9a-f]+)?$')
+_TARGET_RE = re.compile(r'([0-9a-f]+) <(.+?)(?:\+0x([0-9a-f]+))?>$')
+
+_TASK_RE = re.compile(r'xTaskCreate\w*\s*\(\s*(?:\(\w+\)\s*)?&?\s*(\w+)')
+_ISR_RE = re.compile(r'(?:attachInterrupt\s*\([^;]*?,|gpio_isr_handler_add\s*\([^,;]+,)\s*(?:\(\w+\)\s*)?&?\s*(\w+)')
+_LCD_OBJ_RE = re.compile(r'\b(?:LiquidCrystal(?:_I2C)?)\s+(\w+)\s*[(;{=]')
+
+
+@dataclass
+class Insn:
+    addr: int
+    mnemonic: str
+    operands: str
+    line: int
+    target: str = ''            # call/jump 대상 symbol (object 는 relocation 에서)
+    target_addr: int = -1       # 함수 안 branch 대상
+    reloc: str = ''             # 이 명령어가 참조하는 symbol
+
+
+@dataclass
+class Block:
+    start: int
+    insns: list[Insn]
+    succs: list[int] = field(default_factory=list)
+    cycles: int = 0
+    calls: list[tuple[str, str]] = field(default_factory=list)     # (callee, receiver)
+    sites: list[int] = field(default_factory=list)                 # probe 호출 뒤 주소
+    exits: bool = False                                            # ret / noreturn / tail call
+
+    @property
+    def line(self) -> int:
+        return next((i.line for i in self.insns if i.line), 0)
+
+
+@dataclass
+class LoopInfo:
+    header: int
+    body: set[int]
+    line: int
+    lines: frozenset[int]       # body 의 소스 줄. 다른 빌드의 같은 loop 를 찾는 데 쓴다
+    forever: bool               # 빠져나가는 edge 가 없다
+
+
+@dataclass
+class Function:
+    name: str
+    blocks: dict[int, Block]
+    entry: int
+    loops: list[LoopInfo] = field(default_factory=list)
+    indirect: bool = False
+
+    @property
+    def base(self) -> str:
+        return _base_name(self.name).rsplit('::', 1)[-1]
+
+
+# ------- objdump -> CFG
+def _control(isa: str, insn: Insn) -> str:
+    """'call' | 'jump' | 'branch' | 'ret' | 'stop' | 'loop' | ''"""
+    m = insn.mnemonic
+    if isa == 'xtensa':
+        if m.startswith('call'):
+            return 'call'
+        if m in ('j', 'jx'):
+            return 'jump'
+        if m.startswith('ret'):
+            return 'ret'
+        if m in _XTENSA_LOOPS:
+            return 'loop'
+        if m in ('ill', 'break', 'ill.n', 'break.n'):
+            return 'stop'
+        return 'branch' if m.startswith('b') and '<' in insn.operands else ''
+    if m.startswith('call'):
+        return 'call'
+    if m.startswith('jmp'):
+        return 'jump'
+    if m.startswith('j') or m in ('loop', 'loope', 'loopne'):
+        return 'branch'
+    if m.startswith('ret'):
+        return 'ret'
+    return 'stop' if m in ('ud2', 'hlt') else ''
+
+
+def insn_cycles(isa: str, insn: Insn) -> int:
+    m = insn.mnemonic
+    if isa == 'xtensa':
+        if _control(isa, insn) == 'branch':
+            return _XTENSA_BRANCH_TAKEN       # 최악은 분기하는 쪽
+        return _XTENSA_CYCLES.get(m, 1)
+    cycles = next((c for p, c in _X86_CYCLES if m.startswith(p)), 1)
+    if '(' in insn.operands and not m.startswith(('lea', 'nop')):
+        # AT&T 문법: memory operand 가 앞이면 load (L1 hit 4 cycle), 뒤면 store
+        src, _, dst = insn.operands.partition(',')
+        cycles += 3 if '(' in src else 1
+    return cycles
+
+
+def disassemble(path: Path, objdump: str = 'objdump') -> list[tuple[str, list[Insn], bool]]:
+    """(함수 이름, 명령어, 스케치 소스 줄이 있는지). objdump -dlr -C 결과를 읽는다."""
+    out = subprocess.run([objdump, '-dlr', '-C', '--no-show-raw-insn', str(path)],
+                         capture_output=True, text=True, check=True).stdout
+    funcs, insns, name, line, sketch = [], [], '', 0, False
+    for text in out.splitlines():
+        if m := _FUNC_RE.match(text):
+            if name:
+                funcs.append((name, insns, sketch))
+            name, insns, line, sketch = m[2], [], 0, False
+        elif not name:
+            continue
+        elif m := _INSN_RE.match(text):
+            mnemonic, operands = m[2], m[3].split('#', 1)[0].strip()
+            if mnemonic in _X86_PREFIXES and operands:
+                mnemonic, _, operands = operands.partition(' ')
+            insns.append(Insn(int(m[1], 16), mnemonic, operands.strip(), line))
+        elif m := _RELOC_RE.match(text):
+            if insns and not m[1].endswith('ASM_EXPAND'):
+                insns[-1].reloc = m[2].removesuffix('@plt')
+        elif m := _LINE_RE.match(text):
+            line = int(m[2])
+            sketch = sketch or Path(m[1]).name.startswith('sketch.')
+    if name:
+        funcs.append((name, insns, sketch))
+    return funcs
+
+
+def build_function(isa: str, name: str, insns: list[Insn]) -> Function:
+    start, end = insns[0].addr, insns[-1].addr
+    leaders, loop_ends = {start}, {}
+    for i, insn in enumerate(insns):
+        kind = _control(isa, insn)
+        m = _TARGET_RE.search(insn.operands) if kind in ('call', 'jump', 'branch', 'loop') else None
+        if kind == 'call':
+            # object 의 call 은 relocation 이 진짜 대상이다
+            insn.target = insn.reloc or (m[2].removesuffix('@plt') if m else '')
+        elif m:
+            sym, addr = m[2].removesuffix('@plt'), int(m[1], 16)
+            external = insn.reloc and insn.reloc != name and not insn.reloc.startswith('.')
+            if sym == name and start <= addr <= end and not external:
+                insn.target_addr = addr
+            else:
+                insn.target = insn.reloc or sym
+        nxt = insns[i + 1].addr if i + 1 < len(insns) else None
+        if kind in ('jump', 'branch', 'ret', 'stop', 'loop') or (kind == 'call' and _base_name(insn.target) in NORETURN_CALLS):
+            if nxt is not None:
+                leaders.add(nxt)
+        if insn.target_addr >= 0:
+            leaders.add(insn.target_addr)
+            if kind == 'loop':
+                loop_ends[insn.target_addr] = nxt       # zero-overhead loop: body 끝에서 body 처음으로
+
+    blocks: dict[int, Block] = {}
+    current = None
+    for insn in insns:
+        if insn.addr in leaders:
+            current = blocks[insn.addr] = Block(insn.addr, [])
+        current.insns.append(insn)
+    order = sorted(blocks)
+    receiver = ''
+    fn = Function(name, blocks, start)
+    for idx, addr in enumerate(order):
+        b = blocks[addr]
+        nxt = order[idx + 1] if idx + 1 < len(order) else None
+        for i, insn in enumerate(b.insns):
+            kind = _control(isa, insn)
+            if kind == 'call':
+                if insn.target == PROBE_HOOK:
+                    if i + 1 < len(b.insns):
+                        b.sites.append(b.insns[i + 1].addr)
+                    elif nxt is not None:
+                        b.sites.append(nxt)
+                    continue
+                if not insn.target:
+                    fn.indirect = True
+                b.calls.append((insn.target, receiver))
+                receiver = ''
+            elif insn.reloc and insn.operands.endswith(('%rdi', '%edi')):
+                receiver = _base_name(insn.reloc)
+            b.cycles += insn_cycles(isa, insn)
+        last = b.insns[-1]
+        kind = _control(isa, last)
+        if kind in ('ret', 'stop') or (kind == 'call' and _base_name(last.target) in NORETURN_CALLS):
+            b.exits = True
+        elif kind == 'jump':
+            if last.target_addr >= 0:
+                b.succs.append(last.target_addr)
+            else:
+                b.exits = True                      # tail call 또는 함수 포인터
+                if last.target:
+                    b.calls.append((last.target, ''))
+                else:
+                    fn.indirect = True
+        else:
+            if kind in ('branch', 'loop') and last.target_addr >= 0:
+                b.succs.append(last.target_addr)
+            if nxt is not None:
+                b.succs.append(nxt)
+            else:
+                b.exits = True
+        end_addr = nxt if nxt is not None else None
+        if end_addr in loop_ends and loop_ends[end_addr] is not None:
+            b.succs.append(loop_ends[end_addr])
+    fn.loops = find_loops(fn)
+    return fn
+
+
+def find_loops(fn: Function) -> list[LoopInfo]:
+    """DFS back edge 로 natural loop 를 찾는다. header 가 같은 loop 는 합친다. 안쪽 loop 가 앞에 온다."""
+    preds: dict[int, set[int]] = defaultdict(set)
+    for addr, b in fn.blocks.items():
+        for s in b.succs:
+            preds[s].add(addr)
+    back: dict[int, set[int]] = defaultdict(set)
+    state: dict[int, int] = {}
+    stack = [(fn.entry, iter(fn.blocks[fn.entry].succs))]
+    state[fn.entry] = 1
+    while stack:
+        node, it = stack[-1]
+        for s in it:
+            if s not in fn.blocks:
+                continue
+            if state.get(s) == 1:
+                back[s].add(node)
+            elif s not in state:
+                state[s] = 1
+                stack.append((s, iter(fn.blocks[s].succs)))
+                break
+        else:
+            state[node] = 2
+            stack.pop()
+    loops = []
+    for header, latches in back.items():
+        body, work = {header}, list(latches)
+        while work:
+            n = work.pop()
+            if n not in body:
+                body.add(n)
+                work.extend(preds[n])
+        forever = not any(s not in body for n in body for s in fn.blocks[n].succs) and \
+            not any(fn.blocks[n].exits for n in body)
+        lines = frozenset(i.line for n in body for i in fn.blocks[n].insns if i.line)
+        loops.append(LoopInfo(header, body, fn.blocks[header].line, lines, forever))
+    return sorted(loops, key=lambda lp: len(lp.body))
+
+
+# ------- 비용
+@dataclass
+class Cost:
+    cycles: int = 0
+    waits: Counter = field(default_factory=Counter)
+    bus: Counter = field(default_factory=Counter)
+    forever: bool = False
+
+    def __add__(self, other: 'Cost') -> 'Cost':
+        return Cost(self.cycles + other.cycles, self.waits + other.waits, self.bus + other.bus,
+                    self.forever or other.forever)
+
+    def times(self, n: int) -> 'Cost':
+        return Cost(self.cycles * n, Counter({k: v * n for k, v in self.waits.items()}),
+                    Counter({k: v * n for k, v in self.bus.items()}), self.forever)
+
+
+def _worst(costs: list[Cost]) -> Cost:
+    """가장 비싼 것. 돌아오는 경로가 있으면 for(;;) 로 빠지는 경로 (에러 처리 등) 는 보지 않는다."""
+    returning = [c for c in costs if not c.forever] or costs
+    return max(returning, key=lambda c: (c.cycles, sum(c.waits.values()), sum(c.bus.values())), default=Cost())
+
+
+@dataclass
+class FunctionReport:
+    name: str
+    cycles: int
+    waits: dict[str, int]
+    bus: dict[str, int]
+    forever: bool = False
+    iteration_cycles: int = 0           # 가장 바깥 loop 한 바퀴 (task body)
+    iteration_waits: dict[str, int] = field(default_factory=dict)
+    iteration_bus: dict[str, int] = field(default_factory=dict)
+    unmeasured: list[int] = field(default_factory=list)      # bound 를 모르는 loop header 줄
+    notes: list[str] = field(default_factory=list)
+
+
+class Analyzer:
+    def __init__(self, funcs: dict[str, Function], bounds: 'Bounds',
+                 lcd_objects: set[str], call_cycles: dict[str, int]):
+        self.funcs = funcs
+        self.by_base = {f.base: f for f in funcs.values()}
+        self.bounds = bounds
+        self.lcd_objects = lcd_objects
+        self.call_cycles = call_cycles
+        self.memo: dict[str, tuple[Cost, FunctionReport]] = {}
+        self.active: set[str] = set()
+        self.inherited: dict[str, FunctionReport] = {}     # 자기 loop 없이 돌아오지 않는 함수를 불러서 끝나는 함수
+
+    def call_cost(self, callee: str, receiver: str, report: FunctionReport) -> Cost:
+        base = _base_name(callee)
+        short = base.rsplit('::', 1)[-1]
+        cls = base.rsplit('::', 1)[0] if '::' in base else ''
+        if callee in self.funcs or short in self.by_base and not cls:
+            fn = self.funcs.get(callee) or self.by_base[short]
+            if fn.name in self.active:
+                report.notes.append(f'recursion {fn.base}')
+                return Cost()
+            cost, callee = self.function(fn)
+            if cost.forever and callee.iteration_cycles:
+                report.notes.append(f'never returns from {callee.name}')
+                self.inherited.setdefault(report.name, callee)
+            return cost
+        if short in WAIT_CALLS:
+            return Cost(waits=Counter({short: 1}))
+        if cls in BUS_CLASSES or base.startswith(BUS_PREFIXES) or receiver in self.lcd_objects:
+            return Cost(bus=Counter({short: 1}))
+        return Cost(self.call_cycles.get(short, DEFAULT_CALL_CYCLES))
+
+    def function(self, fn: Function) -> tuple[Cost, FunctionReport]:
+        if fn.name in self.memo:
+            return self.memo[fn.name]
+        self.active.add(fn.name)
+        report = FunctionReport(fn.base, 0, {}, {})
+        if fn.indirect:
+            report.notes.append('indirect call')
+        node_cost = {}
+        for addr, b in fn.blocks.items():
+            c = Cost(b.cycles)
+            for callee, receiver in b.calls:
+                c = c + (self.call_cost(callee, receiver, report) if callee else Cost())
+            node_cost[addr] = c
+        rep = {addr: addr for addr in fn.blocks}
+        iteration, outer = None, None
+        for lp in fn.loops:
+            body = {rep[n] for n in lp.body}
+            one = self._longest(fn, rep, node_cost, lp.header, body)
+            # task body 는 가장 바깥 (가장 큰) loop 한 바퀴
+            if outer is None or len(lp.body) > len(outer.body):
+                iteration, outer = one, lp
+            if lp.forever:
+                node_cost[lp.header] = Cost(one.cycles, one.waits, one.bus, True)
+            else:
+                bound = self.bounds.find(fn.base, lp.lines)
+                if bound is None:
+                    report.unmeasured.append(lp.line)
+                node_cost[lp.header] = one.times(max(1, bound or 1))
+            for n in fn.blocks:
+                if rep[n] in body:
+                    rep[n] = lp.header
+        total = self._longest(fn, rep, node_cost, fn.entry, set(rep.values()), loop=False)
+        report.cycles, report.waits, report.bus = total.cycles, dict(total.waits), dict(total.bus)
+        report.forever = total.forever
+        if total.forever and report.name in self.inherited:
+            callee = self.inherited[report.name]
+            iteration = _worst([iteration or Cost(), Cost(callee.iteration_cycles, Counter(callee.iteration_waits),
+                                                           Counter(callee.iteration_bus))])
+        if iteration:
+            report.iteration_cycles = iteration.cycles
+            report.iteration_waits, report.iteration_bus = dict(iteration.waits), dict(iteration.bus)
+        report.unmeasured = sorted(set(report.unmeasured))
+        self.active.discard(fn.name)
+        self.memo[fn.name] = (total, report)
+        return total, report
+
+    def _longest(self, fn: Function, rep: dict[int, int], node_cost: dict[int, Cost], start: int,
+                 nodes: set[int], loop: bool = True) -> Cost:
+        """start 에서 시작하는 가장 비싼 경로. loop 이면 start 로 돌아오는 edge 에서 끝난다."""
+        succs: dict[int, set[int]] = defaultdict(set)
+        for addr, b in fn.blocks.items():
+            ra = rep[addr]
+            if ra not in nodes:
+                continue
+            for s in b.succs:
+                rs = rep.get(s)
+                if rs is not None and rs != ra and rs in nodes and not (loop and rs == start):
+                    succs[ra].add(rs)
+        best: dict[int, Cost] = {}
+        on_path: set[int] = set()
+
+        def visit(n: int) -> Cost:
+            if n in best:
+                return best[n]
+            on_path.add(n)
+            # irreducible 한 나머지 cycle 은 끊는다
+            tail = _worst([visit(s) for s in succs[n] if s not in on_path])
+            on_path.discard(n)
+            best[n] = node_cost[n] + tail
+            return best[n]
+        return visit(start)
+
+
+# ------- 측정
+@dataclass
+class Bounds:
+    """probe 빌드에서 잰 loop 의 최대 반복 수. 분석 빌드의 loop 와는 함수 이름과 body 줄이 가장 많이 겹치는 것끼리 맞춘다."""
+    loops: dict[str, list[tuple[frozenset[int], int]]] = field(default_factory=dict)
+
+    def find(self, func: str, lines: frozenset[int]) -> int | None:
+        best, score = None, 0.5
+        for measured, bound in self.loops.get(func, []):
+            overlap = len(lines & measured) / len(lines | measured) if lines | measured else 0.0
+            if overlap >= score:
+                best, score = bound, overlap
+        return best
+
+
+def measure_bounds(code: str, script: str | Path | None, duration_ms: float) -> tuple[Bounds, str]:
+    build = build_sketch(code, flags=PROBE_FLAGS, wcet=True)
+    if not build.ok:
+        return Bounds(), 'probe build failed'
+    funcs = [build_function('x86', name, insns) for name, insns, sketch in disassemble(build.binary)
+             if sketch and insns]
+    headers: dict[int, tuple[str, frozenset[int]]] = {}
+    with tempfile.TemporaryDirectory() as tmp:
+        loops_file, out_file = Path(tmp) / 'loops.txt', Path(tmp) / 'bounds.txt'
+        lines = []
+        for fn in funcs:
+            for lp in fn.loops:
+                head = fn.blocks[lp.header].sites
+                if not head:
+                    continue
+                body = [s for n in lp.body for s in fn.blocks[n].sites]
+                headers[head[0]] = (fn.base, lp.lines)
+                lines.append(' '.join(f'{a:x}' for a in [head[0], *body]))
+        loops_file.write_text('\n'.join(lines) + '\n', encoding='utf-8')
+        res = run_binary(build.binary, script, duration_ms,
+                         env={'HOSTSIM_WCET_LOOPS': str(loops_file), 'HOSTSIM_WCET_OUT': str(out_file)})
+        bounds = Bounds()
+        if out_file.exists():
+            for text in out_file.read_text(encoding='utf-8').splitlines():
+                site, iterations, entries = text.split()
+                if int(site, 16) in headers and int(entries):
+                    func, lines = headers[int(site, 16)]
+                    bounds.loops.setdefault(func, []).append((lines, int(iterations)))
+    return bounds, res.error
+
+
+# ------- 리포트
+@dataclass
+class EntryReport:
+    name: str
+    kind: str                   # setup | loop | app_main | task | isr
+    cycles: int
+    us: float
+    waits: dict[str, int]
+    bus: dict[str, int]
+    per_iteration: bool = False
+
+
+@dataclass
+class WcetReport:
+    model: str
+    query: str
+    step: int
+    prompt: str
+    ok: bool
+    cost_model: str = ''
+    error: str = ''
+    loops: int = 0
+    measured: int = 0
+    entries: list[EntryReport] = field(default_factory=list)
+    functions: list[FunctionReport] = field(default_factory=list)
+
+    @property
+    def loop_us(self) -> float | None:
+        """
+        반복해서 도는 본문 중 최악: loop(), task body (한 바퀴), forever loop 가 있는 app_main (한 바퀴).
+        task 를 만들고 끝나는 app_main 은 setup 과 같은 초기화라 뺀다.
+        """
+        return max((e.us for e in self.entries
+                    if e.kind in ('loop', 'task') or e.kind == 'app_main' and e.per_iteration), default=None)
+
+    @property
+    def isr_us(self) -> float | None:
+        return max((e.us for e in self.entries if e.kind == 'isr'), default=None)
+
+
+def entry_kinds(src: str, names: set[str]) -> dict[str, str]:
+    kinds = {n: n for n in ('setup', 'loop', 'app_main') if n in names}
+    kinds.update({n: 'task' for n in _TASK_RE.findall(src) if n in names})
+    kinds.update({n: 'isr' for n in _ISR_RE.findall(src) if n in names})
+    return kinds
+
+
+def _calls_text(calls: dict[str, int]) -> str:
+    return ', '.join(f'{k} x{v}' for k, v in sorted(calls.items(), key=lambda kv: (-kv[1], kv[0])))
+
+
+def analyze(path: Path, model: str, cost_model: str, duration_ms: float, mhz: float,
+            call_cycles: dict[str, int]) -> WcetReport:
+    m = _STEP_RE.search(path.name)
+    query = query_of(path)
+    report = WcetReport(model, query, int(m[1]), m[2], True)
+    code = path.read_text(encoding='utf-8')
+    src_text, lang = prepare_source(code)
+
+    isa, objdump, compiler = 'x86', 'objdump', None
+    if cost_model == 'esp32s3':
+        isa, objdump = 'xtensa', f'{XTENSA_PREFIX}objdump'
+        compiler = f'{XTENSA_PREFIX}{"g++" if lang == "arduino" else "gcc"}'
+    report.cost_model = cost_model
+    with tempfile.TemporaryDirectory() as tmp:
+        src = Path(tmp) / ('sketch.cpp' if lang == 'arduino' else 'sketch.c')
+        src.write_text(src_text, encoding='utf-8')
+        obj = Path(tmp) / 'sketch.o'
+        if err := _compile(src, lang, ANALYSIS_FLAGS, obj, compiler):
+            return WcetReport(model, query, report.step, report.prompt, False, cost_model, err)
+        listing = disassemble(obj, objdump)
+        funcs = {name: build_function(isa, name, insns) for name, insns, _ in listing if insns}
+        # header 의 inline 함수도 분석은 하지만 리포트에는 스케치 함수만 넣는다
+        sketch_funcs = {name for name, insns, sketch in listing if insns and sketch}
+
+    script = script_for(query)
+    bounds, error = measure_bounds(code, script if script.exists() else None, duration_ms)
+    if error:
+        report.error = error
+    analyzer = Analyzer(funcs, bounds, set(_LCD_OBJ_RE.findall(src_text)), call_cycles)
+    all_loops = [(fn.base, lp.lines) for fn in funcs.values() if fn.name in sketch_funcs
+                 for lp in fn.loops if not lp.forever]
+    report.loops, report.measured = len(all_loops), sum(1 for k in all_loops if bounds.find(*k) is not None)
+
+    for fn in sorted((funcs[n] for n in sketch_funcs), key=lambda f: f.entry):
+        report.functions.append(analyzer.function(fn)[1])
+    by_base = {f.name: f for f in report.functions}
+    for name, kind in entry_kinds(src_text, set(by_base)).items():
+        f = by_base[name]
+        each = kind == 'task' and f.iteration_cycles > 0 or kind == 'app_main' and f.forever
+        cycles = f.iteration_cycles if each else f.cycles
+        report.entries.append(EntryReport(name, kind, cycles, cycles / mhz, f.iteration_waits if each else f.waits,
+                                          f.iteration_bus if each else f.bus, each))
+    order = ['setup', 'app_main', 'loop', 'task', 'isr']
+    report.entries.sort(key=lambda e: (order.index(e.kind), e.name))
+    return report
+
+
+def _delta(value: float, base: float) -> str:
+    if not base:
+        return ''
+    pct = (value - base) * 100 / base
+    return f' ({pct:+.0f}%)' if abs(pct) >= 0.5 else ''
+
+
+def format_table(reports: list[WcetReport]) -> str:
+    """(model, query) 마다 step x 진입점 WCET (us)"""
+    lines = []
+    by_key = defaultdict(list)
+    for r in reports:
+        by_key[(r.model, r.query)].append(r)
+    for (model, query), rows in sorted(by_key.items()):
+        rows.sort(key=lambda r: r.step)
+        names = []
+        for r in rows:
+            names += [e.name for e in r.entries if e.name not in names]
+        base = {}
+        for r in rows:
+            for e in r.entries:
+                base.setdefault(e.name, e.us)
+        lines.append(f'## {model} {query} (us at WCET)')
+        lines.append(f'{"step":<8}' + ''.join(f'{n[:22]:>26}' for n in names) + '  loops measured')
+        for r in rows:
+            if not r.ok:
+                lines.append(f'{r.step}:{r.prompt:<6}build failed: {r.error[:90]}')
+                continue
+            us = {e.name: e.us for e in r.entries}
+            cells = ''.join(f'{(f"{us[n]:.1f}" + _delta(us[n], base[n])) if n in us else "-":>26}' for n in names)
+            lines.append(f'{r.step}:{r.prompt:<6}{cells}  {r.measured}/{r.loops}')
+        lines.append('')
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='loop()/task/ISR 최악 실행 시간 (정적 CFG + 측정한 loop bound)')
+    parser.add_argument('--models', nargs='*', default=['qwen3', 'gpt4_1'])
+    parser.add_argument('--queries', nargs='*', default=[])
+    parser.add_argument('--steps', nargs='*', type=int, default=None)
+    parser.add_argument('--cost-model', choices=['auto', 'host', 'esp32s3'], default='auto',
+                        help='auto: xtensa-esp32s3-elf-gcc 가 있으면 esp32s3')
+    parser.add_argument('--mhz', type=float, default=MHZ, help='cycle 을 us 로 바꿀 clock')
+    parser.add_argument('--duration-ms', type=float, default=60_000, help='loop bound 를 재는 실행 시간')
+    parser.add_argument('--call-cycles', nargs='*', default=[], metavar='NAME=CYCLES',
+                        help='런타임 호출 비용 덮어쓰기 (예: snprintf=4000)')
+    parser.add_argument('--functions', action='store_true', help='함수마다 WCET 도 보여준다')
+    parser.add_argument('--json', help='결과를 JSON 으로 저장')
+    args = parser.parse_args()
+
+    cost_model = args.cost_model
+    if cost_model == 'auto':
+        cost_model = 'esp32s3' if shutil.which(f'{XTENSA_PREFIX}gcc') else 'host'
+    call_cycles = dict(EXTERNAL_CYCLES)
+    call_cycles.update({k: int(v) for k, v in (s.split('=', 1) for s in args.call_cycles)})
+
+    reports = []
+    for model in args.models:
+        for f in corpus_files([model], args.queries, args.steps):
+            r = analyze(f, model, cost_model, args.duration_ms, args.mhz, call_cycles)
+            reports.append(r)
+            name = f.relative_to(PROJECT_ROOT)
+            if not r.ok:
+                print(f'[WCET] {name}: build failed')
+                continue
+            note = f', {r.error}' if r.error else ''
+            print(f'[WCET] {name}: {r.cost_model} model, {args.mhz:.0f} MHz, {r.measured}/{r.loops} loops measured{note}')
+            for e in r.entries:
+                kind = f'{e.kind}, per iteration' if e.per_iteration else e.kind
+                extra = ''.join(f'; {label} {_calls_text(calls)}' for label, calls in (('wait', e.waits), ('bus', e.bus))
+                                if calls)
+                print(f'[WCET]   {e.name} ({kind}): {e.cycles} cycles = {e.us:.1f} us{extra}')
+            if args.functions:
+                for fr in r.functions:
+                    cycles = f'{fr.iteration_cycles} cycles per iteration (forever)' if fr.forever else f'{fr.cycles} cycles'
+                    notes = fr.notes + ([f'unmeasured loops at {", ".join(map(str, fr.unmeasured))}'] if fr.unmeasured else [])
+                    print(f'[WCET]     fn {fr.name}: {cycles}' + (f' ({"; ".join(notes)})' if notes else ''))
+    print()
+    print(format_table(reports))
+    if args.json:
+        Path(args.json).write_text(json.dumps([asdict(r) for r in reports], ensure_ascii=False, indent=1),
+                                   encoding='utf-8')
+        print(f'[WCET] saved {args.json}')
+
+
+if __name__ == '__main__':
+    main()
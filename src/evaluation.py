@@ -1,28 +1,32 @@
-from pathlib import Path
 from typing import NotRequired
-from models import gpt_model
-from langgraph.graph import StateGraph, START, END
 from typing_extensions import TypedDict
-from langchain_core.messages import SystemMessage, HumanMessage
+from util.prompt_registry import registry
+from util.compaction import TokenBudgetExceeded, compact_for_eval
+from util.realtime_check import with_local_check
+from util.run_trace import span, EVAL, LLM
 
 #------------- agent
 class State(TypedDict):
     prompt_names: list[str]
     user_msg: str
     code: str
+    baseline: NotRequired[str]   # 이전 단계 코드 (바뀌지 않은 helper 본문 생략용)
     response: NotRequired[str]
 
 def load_evaluation_prompt() -> str:
-    return Path(f'prompts/evaluation.md').read_text(encoding='utf-8')
+    return registry.prompt('evaluation')
     
 def load_prompt(name: str) -> str:
-    """prompts/{name}.md"""
-    return (Path("prompts") / f"{name}.md").read_text(encoding='utf-8')
+    """prompts/{name}.md (mtime 이 바뀔 때만 다시 읽음)"""
+    return registry.prompt(name)
 
-def build_human_prompt(state: State) -> str:
+def build_human_prompt(state: State, model_name: str, compaction: bool = True, budget: int | None = None,
+                       strict: bool = False) -> str:
     rules_text = '\n\n'.join(load_prompt(n) for n in state['prompt_names'])
     user_msg = state.get('user_msg', '').strip()
     code = state['code']
+    if compaction:
+        code = compact_for_eval(code, state['prompt_names'], model_name, state.get('baseline'), budget, strict).code
 
     return (
         "[GUIDELINES]\n"
@@ -35,8 +39,15 @@ def build_human_prompt(state: State) -> str:
     )
 
 class Evaluator():
-    def __init__(self):
-        self.llm = gpt_model
+    def __init__(self, compaction: bool = True, router=None, llm=None):
+        """
+        router: routing.ModelRouter. 있으면 평가하는 prompt 에 맞는 tier 모델을 쓴다.
+        llm: router 가 없을 때 쓰는 model. 없으면 처음 쓸 때 gpt_model 을 만든다.
+        """
+        from langgraph.graph import StateGraph, START, END
+        self._llm = llm
+        self.compaction = compaction
+        self.router = router
         
         self.graph_builder = StateGraph(State)
         self.graph_builder.add_node('agent', self._run_llm)
@@ -46,22 +57,53 @@ class Evaluator():
         self.chain = self.graph_builder.compile()
             
             
-    def _run_llm(self, state: State):
-        system_prompt = load_evaluation_prompt()
-        human_prompt = build_human_prompt(state)
-        
-        msgs = [
-            SystemMessage(content=system_prompt),
+    @property
+    def llm(self):
+        if self._llm is None:
+            import models
+            self._llm = models.gpt_model
+        return self._llm
+
+    def render(self, state: State, model_name: str | None = None, budget: int | None = None,
+               strict: bool = False) -> list:
+        """평가 요청 메시지. batch 모드도 이 메시지를 그대로 쓴다. strict 면 budget 초과 시 TokenBudgetExceeded."""
+        from langchain_core.messages import SystemMessage, HumanMessage
+        human_prompt = build_human_prompt(state, model_name or self.llm.model_name, self.compaction, budget, strict)
+        return [
+            SystemMessage(content=load_evaluation_prompt()),
             HumanMessage(content=human_prompt),
         ]
-        ai_msg = self.llm.invoke(msgs)
+
+    def _run_llm(self, state: State):
+        tier = self.router.tier_for('evaluation', state['prompt_names']) if self.router else None
+        while True:
+            spec = self.router.policy.tiers[tier] if tier else None
+            model_name = spec.model if spec else self.llm.model_name
+            next_tier = self.router.escalate(tier) if tier else None
+            try:
+                msgs = self.render(state, model_name, spec.token_budget if spec else None, next_tier is not None)
+                break
+            except TokenBudgetExceeded as e:
+                # 평가할 코드가 들어가지 않으면 더 큰 budget 의 tier 로 (마지막 tier 는 그대로 보낸다)
+                print(f'[ROUTE] evaluation: {e} on {tier}, escalating to {next_tier}')
+                tier = next_tier
+        with span('llm', LLM, backend=model_name, prompt=','.join(state['prompt_names'])):
+            if tier:
+                ai_msg = self.router.invoke('evaluation', ','.join(state['prompt_names']), tier, msgs)
+            else:
+                ai_msg = self.llm.invoke(msgs)
         return {"response": ai_msg.content}
     
-    def invoke(self, prompt_names: str | list[str], code: str, user_msg: str = '') -> str:
+    def invoke(self, prompt_names: str | list[str], code: str, user_msg: str = '', baseline: str | None = None) -> str:
         if isinstance(prompt_names, str):
             prompt_names = [prompt_names]
             
-        out = self.chain.invoke({'prompt_names': list(prompt_names), 'user_msg': user_msg, 'code': code})
-        return out['response']
+        state = {'prompt_names': list(prompt_names), 'user_msg': user_msg, 'code': code}
+        if baseline:
+            state['baseline'] = baseline
+        with span(','.join(prompt_names), EVAL):
+            out = self.chain.invoke(state)
+        # p9 는 LLM 판정 뒤에 정적 검사 결과(LOCAL CHECK)를 붙인다
+        return with_local_check(prompt_names, code, out['response'])
         
         
\ No newline at end of file
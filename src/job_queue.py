@@ -0,0 +1,240 @@
+"""
+SQLite 기반 stage job queue.
+sweep 의 (query, sample) 마다 generation p0..pN 과 evaluation 을 job 으로 넣고,
+여러 worker 프로세스(다른 host 포함, DB 파일을 공유하면)가 job 을 claim -> 실행 -> commit 한다.
+
+- job id 는 (kind, query, sample, step) 로 정해지므로 같은 sweep 을 다시 넣어도 중복되지 않는다.
+- claim 은 BEGIN IMMEDIATE 로 직렬화하고, lease 가 지난 running job 은 다른 worker 가 다시 가져간다.
+  이미 max_attempts 번 시도한 job 이면 (worker 가 죽은 경우 포함) 다시 가져가지 않고 failed 로 둔다.
+- commit 은 자기 lease 인 job 에만 반영되므로 늦게 끝난 worker 가 결과를 덮어쓰지 않는다.
+"""
+
+import os
+import socket
+import sqlite3
+import time
+from dataclasses import dataclass
+from pathlib import Path
+
+GENERATE = 'generate'
+EVALUATE = 'evaluate'
+
+PENDING = 'pending'
+RUNNING = 'running'
+DONE = 'done'
+FAILED = 'failed'
+
+_SCHEMA = """
+CREATE TABLE IF NOT EXISTS jobs (
+    id          TEXT PRIMARY KEY,
+    sweep       TEXT NOT NULL,
+    kind        TEXT NOT NULL,
+    query       TEXT NOT NULL,
+    sample      INTEGER NOT NULL,
+    step        INTEGER NOT NULL,
+    prompt      TEXT NOT NULL,
+    input_job   TEXT,               -- 입력 코드를 만드는 job (p0 은 NULL)
+    status      TEXT NOT NULL DEFAULT 'pending',
+    worker      TEXT,
+    attempts    INTEGER NOT NULL DEFAULT 0,
+    lease_until REAL,
+    created     REAL NOT NULL,
+    started     REAL,
+    finished    REAL,
+    output      TEXT,
+    error       TEXT
+);
+CREATE INDEX IF NOT EXISTS jobs_status ON jobs(status);
+CREATE TABLE IF NOT EXISTS queries (
+    name TEXT PRIMARY KEY,
+    text TEXT NOT NULL
+);
+"""
+
+
+@dataclass
+class Job:
+    id: str
+    sweep: str
+    kind: str
+    query: str
+    sample: int
+    step: int
+    prompt: str
+    input_job: str | None
+    attempts: int
+
+
+def job_id(sweep: str, kind: str, query: str, sample: int, step: int) -> str:
+    return f'{sweep}/{kind}/{query}/s{sample}/step{step}'
+
+
+def worker_name() -> str:
+    return f'{socket.gethostname()}:{os.getpid()}'
+
+
+class JobQueue:
+    def __init__(self, path: str | Path, wal: bool = True, timeout: float = 60.0):
+        """wal: 같은 host 의 worker 끼리는 WAL 이 빠르다. NFS 처럼 공유 메모리가 안 되는 곳은 False."""
+        self.path = str(path)
+        self.conn = sqlite3.connect(self.path, timeout=timeout, isolation_level=None)
+        self.conn.row_factory = sqlite3.Row
+        self.conn.execute(f'PRAGMA journal_mode={"WAL" if wal else "DELETE"}')
+        self.conn.executescript(_SCHEMA)
+
+    def close(self):
+        self.conn.close()
+
+    # ------- enqueue
+    def enqueue_sweep(self, sweep: str, queries: dict[str, str], prompts: list[str],
+                      samples: int = 1, evaluate: bool = True) -> int:
+        """
+        (query, sample) 마다 prompts 순서대로 generation chain 을 만들고,
+        step >= 1 의 결과마다 evaluation job 을 붙인다. 이미 있는 job 은 건너뛴다.
+        """
+        now = time.time()
+        rows = []
+        for query in queries:
+            for sample in range(samples):
+                prev = None
+                for step, pname in enumerate(prompts):
+                    gid = job_id(sweep, GENERATE, query, sample, step)
+                    rows.append((gid, sweep, GENERATE, query, sample, step, pname, prev, now))
+                    if evaluate and step > 0:
+                        rows.append((job_id(sweep, EVALUATE, query, sample, step), sweep, EVALUATE,
+                                     query, sample, step, pname, gid, now))
+                    prev = gid
+        with self._tx():
+            self.conn.executemany('INSERT OR REPLACE INTO queries(name, text) VALUES (?, ?)', queries.items())
+            before = self.conn.total_changes
+            self.conn.executemany(
+                'INSERT OR IGNORE INTO jobs(id, sweep, kind, query, sample, step, prompt, input_job, created) '
+                'VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)', rows)
+            added = self.conn.total_changes - before
+        return added
+
+    # ------- claim / commit
+    def claim(self, worker: str, lease: float = 900.0, max_attempts: int = 3) -> Job | None:
+        """입력 job 이 끝난 pending job 이나 lease 가 만료된 running job 하나를 가져온다."""
+        now = time.time()
+        with self._tx():
+            # 매번 worker 를 죽이는 job 이 lease 만료로 끝없이 돌지 않게 한다
+            self.conn.execute(
+                "UPDATE jobs SET status = 'failed', finished = ?, lease_until = NULL, "
+                "error = 'lease expired after ' || attempts || ' attempts (worker ' || worker || ')' "
+                "WHERE status = 'running' AND lease_until < ? AND attempts >= ?", (now, now, max_attempts))
+            row = self.conn.execute(
+                """
+                SELECT j.* FROM jobs j LEFT JOIN jobs d ON d.id = j.input_job
+                WHERE (j.status = 'pending' OR (j.status = 'running' AND j.lease_until < ?))
+                  AND (j.input_job IS NULL OR d.status = 'done')
+                ORDER BY j.step, j.kind DESC, j.created
+                LIMIT 1
+                """, (now,)).fetchone()
+            if row is None:
+                return None
+            self.conn.execute(
+                "UPDATE jobs SET status = 'running', worker = ?, lease_until = ?, started = ?, "
+                'attempts = attempts + 1 WHERE id = ?', (worker, now + lease, now, row['id']))
+        return Job(row['id'], row['sweep'], row['kind'], row['query'], row['sample'], row['step'],
+                   row['prompt'], row['input_job'], row['attempts'] + 1)
+
+    def complete(self, job: Job, worker: str, output: str) -> bool:
+        """자기 lease 인 경우에만 반영한다. 다른 worker 가 이미 끝냈으면 False."""
+        cur = self.conn.execute(
+            "UPDATE jobs SET status = 'done', output = ?, finished = ?, error = NULL "
+            "WHERE id = ? AND worker = ? AND status = 'running'", (output, time.time(), job.id, worker))
+        return cur.rowcount == 1
+
+    def fail(self, job: Job, worker: str, error: str, max_attempts: int = 3) -> bool:
+        """max_attempts 전까지는 pending 으로 되돌려 다시 시도한다."""
+        status = FAILED if job.attempts >= max_attempts else PENDING
+        cur = self.conn.execute(
+            'UPDATE jobs SET status = ?, error = ?, finished = ?, lease_until = NULL '
+            "WHERE id = ? AND worker = ? AND status = 'running'", (status, error, time.time(), job.id, worker))
+        return cur.rowcount == 1
+
+    def retry_failed(self, sweep: str | None = None) -> int:
+        cur = self.conn.execute(
+            "UPDATE jobs SET status = 'pending', attempts = 0 WHERE status = 'failed' AND (? IS NULL OR sweep = ?)",
+            (sweep, sweep))
+        return cur.rowcount
+
+    # ------- 조회
+    def output(self, job_id_: str | None) -> str | None:
+        if job_id_ is None:
+            return None
+        row = self.conn.execute('SELECT output FROM jobs WHERE id = ?', (job_id_,)).fetchone()
+        return row['output'] if row else None
+
+    def query_text(self, name: str) -> str:
+        return self.conn.execute('SELECT text FROM queries WHERE name = ?', (name,)).fetchone()['text']
+
+    def done_jobs(self, sweep: str | None = None):
+        return self.conn.execute(
+            "SELECT * FROM jobs WHERE status = 'done' AND (? IS NULL OR sweep = ?) ORDER BY query, sample, step",
+            (sweep, sweep)).fetchall()
+
+    def progress(self, sweep: str | None = None, window: float = 600.0) -> 'QueueProgress':
+        where, args = ('WHERE sweep = ?', (sweep,)) if sweep else ('', ())
+        counts = {(r['kind'], r['status']): r['n'] for r in self.conn.execute(
+            f'SELECT kind, status, COUNT(*) AS n FROM jobs {where} GROUP BY kind, status', args)}
+        now = time.time()
+        recent = self.conn.execute(
+            f"SELECT worker, COUNT(*) AS n, AVG(finished - started) AS avg, MIN(started) AS first, "
+            f"MAX(finished) AS last FROM jobs "
+            f"{where + ' AND' if where else 'WHERE'} status = 'done' AND finished >= ? GROUP BY worker",
+            (*args, now - window)).fetchall()
+        workers = {r['worker']: (r['n'], r['avg'] or 0.0) for r in recent}
+        # 처리량 구간은 window 안에서 실제로 일한 시간 (sweep 이 window 보다 짧게 끝난 경우)
+        span = (max(r['last'] for r in recent) - min(r['first'] for r in recent)) if recent else 0.0
+        return QueueProgress(counts, workers, min(max(span, 1.0), window))
+
+    # ------- 내부
+    def _tx(self):
+        return _Immediate(self.conn)
+
+
+class _Immediate:
+    """BEGIN IMMEDIATE ... COMMIT. 쓰기 lock 을 먼저 잡아서 claim 이 겹치지 않게 한다."""
+
+    def __init__(self, conn: sqlite3.Connection):
+        self.conn = conn
+
+    def __enter__(self):
+        self.conn.execute('BEGIN IMMEDIATE')
+        return self.conn
+
+    def __exit__(self, exc_type, exc, tb):
+        self.conn.execute('ROLLBACK' if exc_type else 'COMMIT')
+
+
+@dataclass
+class QueueProgress:
+    counts: dict[tuple[str, str], int]      # (kind, status) -> n
+    workers: dict[str, tuple[int, float]]   # 최근 window 동안 worker -> (완료 수, 평균 초)
+    window: float                           # 처리량 계산 구간 (초)
+
+    def total(self, status: str | None = None) -> int:
+        return sum(n for (_, s), n in self.counts.items() if status is None or s == status)
+
+    @property
+    def throughput(self) -> float:
+        """최근 window 동안 분당 완료 job 수"""
+        return sum(n for n, _ in self.workers.values()) / (self.window / 60)
+
+    def format(self) -> str:
+        total, done = self.total(), self.total(DONE)
+        lines = [f'[QUEUE] {done}/{total} done, {self.total(RUNNING)} running, '
+                 f'{self.total(PENDING)} pending, {self.total(FAILED)} failed']
+        for kind in (GENERATE, EVALUATE):
+            row = {s: self.counts.get((kind, s), 0) for s in (PENDING, RUNNING, DONE, FAILED)}
+            lines.append(f'[QUEUE]   {kind:<9} ' + ' '.join(f'{s}={n}' for s, n in row.items()))
+        rate = self.throughput
+        remaining = total - done - self.total(FAILED)
+        eta = f', ETA {remaining / rate:.1f} min' if rate and remaining else ''
+        lines.append(f'[QUEUE] throughput {rate:.2f} jobs/min over {self.window:.0f}s, '
+                     f'{len(self.workers)} active workers{eta}')
+        for w, (n, avg) in sorted(self.workers.items()):
+            lines.append(f'[QUEUE]   {w}: {n} jobs, avg {avg:.1f}s')
+        return '\n'.join(lines)
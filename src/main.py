@@ -1,10 +1,22 @@
+"""
+pipeline 실행 CLI.
 
-import os
+  python src/main.py                                   # 전체 query, p0..p9 생성 + 평가
+  python src/main.py --queries i1 i3 --steps 0-3       # 일부 query, step 0~3 만
+  python src/main.py --mode re-eval --out-dir qwen3    # 저장된 결과 다시 평가
+  python src/main.py --steps 5-8 --model gpt --dry-run # 실행 계획만 출력 (LLM 을 import 하지 않음)
+
+선택한 step 의 입력이 이번 실행에서 만들어지지 않으면 out-dir 의 gen_pipe 에 저장된 이전 step 결과를 쓴다.
+--golden check 면 생성한 코드를 out-dir 의 golden_pipe 에 저장된 golden trace 로 다시 돌려서 동작이 바뀌었는지 보여준다.
+p9 (실시간 성능) 단계는 생성 직후 util.realtime_check 결과를 이전 step 과 비교해 보여준다.
+langchain 등 무거운 모듈은 실제로 model 을 쓸 때 import 한다.
+"""
+
+import argparse
+from dataclasses import dataclass, field
 from pathlib import Path
-from agent import Agent
-from evaluation import Evaluator
-from pipe_agent import PipeAgent
-from pipe_evaluation import PipeEvaluator
+
+from settings import settings
 
 BASE_DIR = Path(__file__).resolve().parent
 ROOT_DIR = BASE_DIR.parent
@@ -16,45 +28,233 @@ eval_pipe_dir = 'eval_pipe'
 
 user_query_dir = 'user_queries'
 
-def main():
-    # user_msg = """
-    # 4x4 키패드 입력을 받아 사칙연산을 수행하는 계산기를 구현해주세요.
-    # 부동소수점 연산은 사용할 수 없고, 32비트 고정소수점(Q16.16 형식)으로 
-    # 구현해야 합니다. LCD 16x2에 결과를 표시합니다.
-    # Free RTOS를 사용하세요.
-    # """
-    user_query_path = ROOT_DIR / user_query_dir
-    for f in user_query_path.iterdir():
-        user_msg = f.read_text(encoding='utf-8')
-        
-        apply_prompts = ['p0', 'p1', 'p2', 'p3', 'p4', 'p5', 'p6', 'p7', 'p8']
-        print('code generation...')
-        agent = PipeAgent()
+DEFAULT_PROMPTS = ['p0', 'p1', 'p2', 'p3', 'p4', 'p5', 'p6', 'p7', 'p8', 'p9']
+
+MODE_ALL = 'all'        # 생성 + 평가
+MODE_GEN = 'gen'        # 생성만
+MODE_EVAL = 'eval'      # 저장된 결과 중 평가가 없는 step 만 평가
+MODE_REEVAL = 're-eval' # 저장된 결과를 다시 평가 (덮어씀)
+MODES = [MODE_ALL, MODE_GEN, MODE_EVAL, MODE_REEVAL]
+
+GOLDEN_OFF = 'off'
+GOLDEN_CHECK = 'check'    # golden 이 있으면 replay 해서 처음 달라지는 event 를 보여준다
+GOLDEN_RECORD = 'record'  # 생성 결과를 새 golden 으로 녹화한다
+GOLDEN_MODES = [GOLDEN_OFF, GOLDEN_CHECK, GOLDEN_RECORD]
+
+
+def parse_steps(specs: list[str], n: int) -> list[int]:
+    """'0-3', '5', '2,4' 형식. 비어 있으면 전체."""
+    if not specs:
+        return list(range(n))
+    steps = set()
+    for spec in specs:
+        for part in spec.split(','):
+            if '-' in part:
+                lo, hi = part.split('-', 1)
+                steps.update(range(int(lo or 0), int(hi or n - 1) + 1))
+            elif part:
+                steps.add(int(part))
+    bad = sorted(s for s in steps if not 0 <= s < n)
+    if bad:
+        raise SystemExit(f'step out of range 0..{n - 1}: {bad}')
+    return sorted(steps)
+
+
+def gen_path(out_dir: Path, query: str, step: int, pname: str) -> Path:
+    return out_dir / gen_pipe_dir / query / f'out_step{step}_{query}_{pname}.c'
+
+
+def eval_path(out_dir: Path, query: str, step: int, pname: str) -> Path:
+    return out_dir / eval_pipe_dir / query / f'out_step{step}_{query}_{pname}.md'
+
+
+@dataclass
+class QueryPlan:
+    query: str
+    user_msg: str
+    generate: list[int] = field(default_factory=list)
+    evaluate: list[int] = field(default_factory=list)
+    missing: list[str] = field(default_factory=list)    # 생성에 필요한데 없는 입력 파일
+    skipped: list[str] = field(default_factory=list)    # 생성 결과가 없어서 평가하지 않는 파일
+
+
+def make_plan(args, prompts: list[str], steps: list[int], out_dir: Path) -> list[QueryPlan]:
+    files = sorted((ROOT_DIR / user_query_dir).glob('*.txt'))
+    if args.queries:
+        unknown = set(args.queries) - {f.stem for f in files}
+        if unknown:
+            raise SystemExit(f'unknown query: {", ".join(sorted(unknown))}')
+        files = [f for f in files if f.stem in args.queries]
+
+    plans = []
+    for f in files:
+        plan = QueryPlan(f.stem, f.read_text(encoding='utf-8'))
+        if args.mode in (MODE_ALL, MODE_GEN):
+            plan.generate = steps
+            for s in steps:
+                prev = gen_path(out_dir, f.stem, s - 1, prompts[s - 1]) if s > 0 else None
+                if prev and s - 1 not in steps and not prev.exists():
+                    plan.missing.append(str(prev))
+        # p0 은 평가하지 않는다
+        eval_steps = [s for s in steps if s > 0]
+        if args.mode == MODE_ALL:
+            plan.evaluate = eval_steps
+        elif args.mode in (MODE_EVAL, MODE_REEVAL):
+            for s in eval_steps:
+                src = gen_path(out_dir, f.stem, s, prompts[s])
+                if not src.exists():
+                    plan.skipped.append(str(src))
+                elif args.mode == MODE_REEVAL or not eval_path(out_dir, f.stem, s, prompts[s]).exists():
+                    plan.evaluate.append(s)
+        plans.append(plan)
+    return plans
+
+
+def print_plan(plans: list[QueryPlan], prompts: list[str], args):
+    n_gen = sum(len(p.generate) for p in plans)
+    n_eval = sum(len(p.evaluate) for p in plans)
+    print(f'[PLAN] gen model {args.model}, eval model {args.eval_model}, mode {args.mode}, out-dir {args.out_dir}, '
+          f'golden {args.golden}')
+    for p in plans:
+        gen = ' '.join(f'{s}:{prompts[s]}' for s in p.generate) or '-'
+        ev = ' '.join(f'{s}:{prompts[s]}' for s in p.evaluate) or '-'
+        print(f'[PLAN] {p.query}: generate [{gen}] evaluate [{ev}]')
+        for m in p.missing:
+            print(f'[PLAN]   missing input {m}')
+        for m in p.skipped:
+            print(f'[PLAN]   not generated, skipped {m}')
+    print(f'[PLAN] {n_gen} generation stages, {n_eval} evaluations')
+
 
-        gen_out_dir = Path(gen_pipe_dir) / f.stem
+def check_golden(path: Path, mode: str):
+    """생성 직후 golden trace 로 다시 돌려 비교하거나(check) 새 golden 으로 녹화한다(record)."""
+    from sim.golden import golden_path, record, replay
+    from util.compile_check import has_compiler
+
+    if mode == GOLDEN_OFF or not has_compiler('arduino'):
+        return
+    if mode == GOLDEN_RECORD:
+        g = record(path)
+        print(f'[GOLDEN] {path.name} recorded ({g.status}, {len(g.events)} events)')
+    elif golden_path(path).exists():
+        r = replay(path)
+        print(f'[GOLDEN] {path.name} {r.verdict}{": " + r.detail if r.detail else ""}')
+
+
+def check_realtime(prev_code: str, code: str, prompt_name: str, name: str):
+    """p9 단계 생성 직후 정적 실시간 규칙 위반이 이전 step 보다 줄었는지 보여준다."""
+    from util.realtime_check import REALTIME_PROMPT, realtime_check
+
+    if prompt_name != REALTIME_PROMPT:
+        return
+    before, after = realtime_check(prev_code), realtime_check(code)
+    print(f'[RT] {name}: {before.summary()} -> {after.summary()}')
+    for f in after.findings[:5]:
+        print(f'[RT]   {f.rule} line {f.line} in {f.func}(): {f.detail}')
+
+
+def run_query(plan: QueryPlan, prompts: list[str], out_dir: Path, agent, evaluator, golden: str = GOLDEN_OFF):
+    from util.pipe_types import StageResult
+
+    codes: dict[int, str] = {}
+
+    def code_at(step: int) -> str:
+        if step < 0:
+            return ''
+        if step not in codes:
+            codes[step] = gen_path(out_dir, plan.query, step, prompts[step]).read_text(encoding='utf-8')
+        return codes[step]
+
+    if plan.generate:
+        print('code generation...')
+        gen_out_dir = out_dir / gen_pipe_dir / plan.query
         gen_out_dir.mkdir(parents=True, exist_ok=True)
-        
-        stages = list(agent.invoke_yield(apply_prompts, user_msg))
-        for s in stages:
-            gen_output_name = f'out_step{s.step}_{f.stem}_{s.prompt_name}.c'
+        for step in plan.generate:
+            s = next(agent.invoke_yield([prompts[step]], plan.user_msg, code=code_at(step - 1), start=step))
+            codes[step] = s.code
+            gen_output_name = f'out_step{s.step}_{plan.query}_{s.prompt_name}.c'
             (gen_out_dir / gen_output_name).write_text(s.code, encoding='utf-8')
             print(f'[CODEGEN] {gen_output_name} created')
-        
-        
+            check_golden(gen_out_dir / gen_output_name, golden)
+            check_realtime(code_at(step - 1), s.code, s.prompt_name, gen_output_name)
+
+    if plan.evaluate:
         print('evaluation...')
-        
-        evaluator = PipeEvaluator()
-        
-        eval_out_dir = Path(eval_pipe_dir) / f.stem
+        eval_out_dir = out_dir / eval_pipe_dir / plan.query
         eval_out_dir.mkdir(parents=True, exist_ok=True)
-        
-        eval_stages = list(evaluator.invoke_yield(stages[1:]))
-        for es in eval_stages:
-            eval_output_name = f'out_step{es.step}_{f.stem}_{es.prompt_name}.md'
+        for step in plan.evaluate:
+            stage = StageResult(step=step, prompt_name=prompts[step], system_prompt='', code=code_at(step))
+            es = next(evaluator.invoke_yield([stage], prev_code=code_at(step - 1) or None))
+            eval_output_name = f'out_step{es.step}_{plan.query}_{es.prompt_name}.md'
             (eval_out_dir / eval_output_name).write_text(es.evaluation, encoding='utf-8')
             print(f'[EVAL] {eval_output_name} created')
-    
-    
+
+
+def build_parser() -> argparse.ArgumentParser:
+    parser = argparse.ArgumentParser(description='prompt pipeline 생성/평가')
+    parser.add_argument('--queries', nargs='*', default=[], help='user_queries 의 파일 이름(확장자 제외). 비우면 전체')
+    parser.add_argument('--prompts', nargs='*', default=DEFAULT_PROMPTS, help='적용할 prompt chain')
+    parser.add_argument('--steps', nargs='*', default=[], help="실행할 step (예: 0-3 5). 비우면 전체")
+    parser.add_argument('--mode', choices=MODES, default=MODE_ALL)
+    parser.add_argument('--model', default='qwen', help="생성 model (qwen, gpt 또는 model 이름)")
+    parser.add_argument('--eval-model', default='gpt', help='평가 model')
+    parser.add_argument('--out-dir', default='.', help='gen_pipe / eval_pipe 를 둘 폴더')
+    parser.add_argument('--routing-policy', default=settings.routing_policy,
+                        help='model routing 정책 (지정하면 --model/--eval-model 대신 사용)')
+    parser.add_argument('--best-of-n', type=int, default=settings.best_of_n, help='p0 후보 수')
+    parser.add_argument('--smoke-run', action='store_true', default=settings.smoke_run,
+                        help='best-of-N 후보를 hostsim 으로 돌려 보고 점수에 넣는다')
+    parser.add_argument('--trace', default=settings.trace_path, help='실행 trace(jsonl) 저장 경로')
+    parser.add_argument('--golden', choices=GOLDEN_MODES, default=GOLDEN_OFF,
+                        help='생성 결과를 golden trace 와 비교(check)하거나 새로 녹화(record). 기본은 하지 않음')
+    parser.add_argument('--dry-run', action='store_true', help='실행 계획만 출력')
+    return parser
+
+
+def main(argv: list[str] | None = None):
+    # user_msg = """
+    # 4x4 키패드 입력을 받아 사칙연산을 수행하는 계산기를 구현해주세요.
+    # 부동소수점 연산은 사용할 수 없고, 32비트 고정소수점(Q16.16 형식)으로
+    # 구현해야 합니다. LCD 16x2에 결과를 표시합니다.
+    # Free RTOS를 사용하세요.
+    # """
+    args = build_parser().parse_args(argv)
+    prompts = list(args.prompts)
+    steps = parse_steps(args.steps, len(prompts))
+    out_dir = Path(args.out_dir)
+    plans = make_plan(args, prompts, steps, out_dir)
+    print_plan(plans, prompts, args)
+    if args.dry_run:
+        return
+    missing = [m for p in plans for m in p.missing]
+    if missing:
+        raise SystemExit(f'{len(missing)} input files missing, see [PLAN] above')
+
+    from models import resolve_model
+    from pipe_agent import PipeAgent
+    from pipe_evaluation import PipeEvaluator
+    from routing import ModelRouter
+    from util.run_trace import tracer, context as trace_context
+
+    router = ModelRouter.from_file(ROOT_DIR / args.routing_policy) if args.routing_policy else None
+    if args.trace:
+        tracer.enable()
+    agent = PipeAgent(router=router, samples={'p0': args.best_of_n}, llm=resolve_model(args.model),
+                      smoke_run=args.smoke_run) \
+        if any(p.generate for p in plans) else None
+    evaluator = PipeEvaluator(router=router, llm=resolve_model(args.eval_model)) \
+        if any(p.evaluate for p in plans) else None
+
+    for plan in plans:
+        with trace_context(query=plan.query):
+            run_query(plan, prompts, out_dir, agent, evaluator, args.golden)
+
+    if router is not None:
+        print(router.report().format())
+    if args.trace:
+        tracer.dump(args.trace)
+        print(f'[TRACE] {len(tracer.spans)} spans -> {args.trace}')
+
 
 if __name__ == '__main__':
-    main()
\ No newline at end of file
+    main()
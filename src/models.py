@@ -1,15 +1,48 @@
-from langchain_openai import ChatOpenAI
+"""
+ChatOpenAI client 는 처음 쓸 때 만든다 (langchain import 가 느려서 CLI 시작을 늦추지 않도록).
+qwen_model / gpt_model 은 module attribute 로 접근하면 그때 생성된다.
+"""
+
 from settings import settings
 
+OPENAI_BASE_URL = "https://api.openai.com/v1"
+
+# CLI 에서 쓰는 짧은 이름 -> (model, base_url). base_url 이 None 이면 settings.openai_base_url
+MODEL_ALIASES: dict[str, tuple[str, str | None]] = {
+    'qwen': ("Qwen/Qwen3-32B", None),
+    'gpt': ('gpt-4.1-mini', OPENAI_BASE_URL),
+}
+
+_chat_models: dict[tuple[str, str], object] = {}
+
+
+def chat_model(model: str, base_url: str | None = None):
+    """(model, base_url) 별로 ChatOpenAI 를 한 번만 만든다. base_url 이 없으면 settings 의 endpoint."""
+    base_url = base_url or settings.openai_base_url
+    key = (model, base_url)
+    if key not in _chat_models:
+        from langchain_openai import ChatOpenAI
+        _chat_models[key] = ChatOpenAI(
+            model=model,
+            openai_api_base=base_url,
+            openai_api_key=settings.openai_api_key,
+        )
+    return _chat_models[key]
+
+
+def resolve_model(name: str):
+    """alias('qwen', 'gpt') 나 model 이름으로 client 를 돌려준다."""
+    model, base_url = MODEL_ALIASES.get(name, (name, OPENAI_BASE_URL if name.startswith('gpt') else None))
+    return chat_model(model, base_url)
+
+
+def model_name(name: str) -> str:
+    return MODEL_ALIASES.get(name, (name, None))[0]
 
-qwen_model = ChatOpenAI(
-    model="Qwen/Qwen3-32B",
-    openai_api_base=settings.openai_base_url,
-    openai_api_key=settings.openai_api_key,
-)
 
-gpt_model = ChatOpenAI(
-    model='gpt-4.1-mini',
-    openai_api_base="https://api.openai.com/v1",
-    openai_api_key=settings.openai_api_key,
-)
\ No newline at end of file
+def __getattr__(name: str):
+    if name == 'qwen_model':
+        return resolve_model('qwen')
+    if name == 'gpt_model':
+        return resolve_model('gpt')
+    raise AttributeError(f'module {__name__!r} has no attribute {name!r}')
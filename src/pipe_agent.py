@@ -4,12 +4,32 @@
 각 단계의 결과물을 yield로 반환.
 """
 
-from typing import Iterator
+from concurrent.futures import ThreadPoolExecutor
+from contextvars import copy_context
+from dataclasses import dataclass, field
+from statistics import median
+from typing import TYPE_CHECKING, Callable, Iterator
 from typing_extensions import TypedDict
-from langgraph.graph import StateGraph, START, END
-from models import gpt_model, qwen_model
 from util.pipe_types import StageResult
-from util.prompt_util import load_system_prompt, build_generation_prompt, build_refine_prompt
+from util.prompt_util import load_system_prompt, get_prompt_template, GENERATION, REFINE, DOC_SKELETON
+from util.prompt_registry import registry
+from util.doc_skeleton import build_skeleton, parse_doc_blocks, splice_docs
+from util.c_source import scan_top_level
+from util.format_stage import format_and_rename
+from util.compaction import TokenBudgetExceeded, compact_for_refine
+from util.compile_check import compile_check, detect_lang, has_compiler
+from util.eval_report import parse_eval_report
+from util.candidate_score import CandidateScore, prepare_smoke_run, score_candidate
+from util.run_trace import current, span, STAGE, LLM
+from routing import ModelRouter, GENERATION as ROUTE_GENERATION
+
+if TYPE_CHECKING:
+    from langchain_core.prompts import ChatPromptTemplate
+
+# skeleton 모드로 처리할 문서화 stage
+DOC_PROMPT = 'p7'
+# 로컬 formatter/renamer 로 처리할 stage
+FORMAT_PROMPT = 'p8'
 
 class PipeState(TypedDict):
     prompt_names: list[str]
@@ -33,48 +53,212 @@ def _extract_code_only(text: str) -> str:
     return text.strip()
     
 
+def _finish_doc_skeleton(code: str, symbols, skeleton: str, content: str) -> str:
+    docs = parse_doc_blocks(content)
+    print(f'[{DOC_PROMPT}] skeleton {len(skeleton)} chars (full code {len(code)} chars), '
+          f'{len(docs)}/{len(symbols)} symbols documented')
+    return splice_docs(code, docs, symbols)
+
+
+# 응답 content 를 코드로 바꾸는 방법. batch 모드는 요청과 함께 이 이름만 남겨 둔다
+FINISH_CODE = 'code'                    # 응답의 코드 블록
+FINISH_DOC_SKELETON = 'doc_skeleton'    # p7 skeleton 응답의 주석을 입력 코드에 합친다
+
+
+def finish_stage(kind: str, code: str, content: str) -> str:
+    """요청을 만들 때와 다른 곳에서 응답을 받을 때 (batch ingest). code 는 그 stage 의 입력 코드."""
+    if kind == FINISH_DOC_SKELETON:
+        symbols = scan_top_level(code)
+        return _finish_doc_skeleton(code, symbols, build_skeleton(code, symbols), content)
+    return _extract_code_only(content)
+
+
+@dataclass
+class StageRequest:
+    prompt: 'ChatPromptTemplate | None' = None
+    params: dict = field(default_factory=dict)
+    finish: Callable[[str], str] = _extract_code_only   # 응답 content -> code
+    result: str | None = None   # LLM 없이 끝난 stage 의 결과
+    finish_kind: str = FINISH_CODE  # finish 를 finish_stage 로 다시 만들 때의 이름
+
+    def messages(self):
+        return self.prompt.invoke(self.params).to_messages()
+
+
 class PipeAgent():
-    def __init__(self):
-        # self.llm = gpt_model
-        self.llm = qwen_model
-        
-    def _make_graph(self, prompt_names: str | list[str]):
-        graph = StateGraph(PipeState)
-        
-        node_ids = []
-        for idx, pname in enumerate(prompt_names):
-            node_id = f'agent_{idx}_{pname}'
-            node_ids.append(node_id)
-            
-            def make_node(pname: str, idx: int):
-                def _node(state: PipeState):
-                    system_text = load_system_prompt(pname)
-                    if state['code'].strip() == '':
-                        # generate code - [1]
-                        prompt = build_generation_prompt(system_text, state['user_msg'])
-                    else:
-                        # edit code - [2, last_idx]
-                        prompt = build_refine_prompt(system_text, state['code'])
-                    
-                    msg = (prompt | self.llm).invoke({})
-                    new_code = _extract_code_only(msg.content)
-                    return {
-                        'code': new_code,
-                        'step': idx,
-                    }
-                return _node
-            graph.add_node(node_id, make_node(pname, idx))
-        
-        if node_ids:
-            graph.add_edge(START, node_ids[0])
-            for i in range(len(node_ids) -1 ):
-                graph.add_edge(node_ids[i], node_ids[i+1])
-            graph.add_edge(node_ids[-1], END)
-        else:
-            assert False, "no prompt"
+    def __init__(self, doc_mode: str = 'skeleton', format_mode: str = 'local', format_fallback: bool = False,
+                 router: ModelRouter | None = None, samples: dict[str, int] | None = None, llm=None,
+                 smoke_run: bool = False):
+        """
+        doc_mode: 'skeleton' 이면 p7은 선언부만 보내고 주석만 받아 로컬에서 합친다.
+                  'full' 이면 다른 stage와 같이 전체 코드를 주고받는다.
+        format_mode: 'local' 이면 p8은 clang-format + renamer 로 처리, 'llm' 이면 기존 방식.
+        format_fallback: 로컬 결과가 컴파일 검증에 실패하면 LLM 으로 다시 시도.
+        router: 있으면 stage 별 model tier 를 정책에 따라 고르고, gate 실패 시 상위 tier 로 재시도한다.
+        samples: {stage: N}. N > 1 이면 후보 N개를 동시에 만들고 로컬 점수가 가장 높은 것을 쓴다.
+        llm: router 가 없을 때 쓰는 model. 없으면 처음 쓸 때 qwen_model 을 만든다.
+        smoke_run: best-of-N 후보를 hostsim 으로 돌려 보는 run smoke test 까지 점수에 넣는다.
+        """
+        self._llm = llm
+        self.doc_mode = doc_mode
+        self.format_mode = format_mode
+        self.format_fallback = format_fallback
+        self.router = router
+        self.samples = samples or {}
+        self.smoke_run = smoke_run
+        self.last_scores: dict[str, list[float]] = {}
+        self._gate_evaluator = None
+
+    @property
+    def llm(self):
+        if self._llm is None:
+            import models
+            self._llm = models.qwen_model
+        return self._llm
+
+    def _run_stage(self, pname: str, code: str, user_msg: str) -> str:
+        n = self.samples.get(pname, 1)
+        with span(pname, STAGE, samples=n):
+            if n > 1:
+                return self._best_of_n(pname, code, user_msg, n)
+            return self._sample(pname, code, user_msg)
+
+    def _best_of_n(self, pname: str, code: str, user_msg: str, n: int) -> str:
+        """후보 생성과 채점을 후보마다 한 thread 에서 같이 돌린다. 벽시계 시간은 호출 1번 + 컴파일 1번 정도."""
+        def candidate(_: int) -> tuple[str, CandidateScore]:
+            out = self._sample(pname, code, user_msg)
+            return out, score_candidate(out, current('query'), self.smoke_run)
+
+        if self.smoke_run:
+            prepare_smoke_run()
+        with ThreadPoolExecutor(max_workers=n) as pool:
+            # trace 문맥(query, 부모 span)을 후보 thread 로 넘긴다
+            futures = [pool.submit(copy_context().run, candidate, i) for i in range(n)]
+            results = [f.result() for f in futures]
+        best = max(range(n), key=lambda i: results[i][1].total)
+        scores = [r[1].total for r in results]
+        self.last_scores[pname] = scores
+        print(f'[BEST-OF-N] {pname}: {n} candidates, score min {min(scores):.1f} / '
+              f'median {median(scores):.1f} / max {max(scores):.1f}, picked #{best}')
+        for i, (_, score) in enumerate(results):
+            print(f'[BEST-OF-N]   #{i}{"*" if i == best else " "} {score.summary()}')
+        return results[best][0]
+
+    def _sample(self, pname: str, code: str, user_msg: str) -> str:
+        if self.router is None:
+            return self._run_stage_on(pname, code, user_msg)[0]
+        return self._run_routed(pname, code, user_msg)
+
+    def _run_stage_on(self, pname: str, code: str, user_msg: str, tier: str | None = None) -> tuple[str, bool]:
+        """tier 가 None 이면 self.llm, 아니면 router 의 tier 모델로 실행. (결과, LLM 을 불렀는지)"""
+        budget = self.router.policy.tiers[tier].token_budget if tier else None
+        # 올라갈 tier 가 있을 때만 budget 초과를 실패로 본다
+        strict = tier is not None and self.router.escalate(tier) is not None
+        req = self.prepare_stage(pname, code, user_msg, self._model_name(tier), budget, strict)
+        if req.result is not None:
+            return req.result, False
+        msg = self._invoke(req.prompt, req.params, pname, tier)
+        return req.finish(msg.content), True
+
+    def prepare_stage(self, pname: str, code: str, user_msg: str, model_name: str | None = None,
+                      budget: int | None = None, strict: bool = False) -> StageRequest:
+        """
+        stage 한 번의 LLM 요청을 만든다. 로컬에서 끝나는 stage 는 result 만 채워서 돌려준다.
+        batch 모드는 이 요청을 모아서 보내고, 응답을 finish 로 코드로 바꾼다.
+        strict 면 코드가 budget 을 넘을 때 TokenBudgetExceeded, 아니면 그대로 보낸다.
+        """
+        model_name = model_name or self.llm.model_name
+        if code.strip() == '':
+            # generate code - [1]
+            return StageRequest(get_prompt_template(GENERATION, pname), {'user_msg': user_msg})
+        if pname == DOC_PROMPT and self.doc_mode == 'skeleton':
+            symbols = scan_top_level(code)
+            # 선언을 못 찾으면 기존 방식으로
+            if symbols:
+                skeleton = build_skeleton(code, symbols)
+                return StageRequest(get_prompt_template(DOC_SKELETON, pname), {'skeleton': skeleton},
+                                    lambda content: _finish_doc_skeleton(code, symbols, skeleton, content),
+                                    finish_kind=FINISH_DOC_SKELETON)
+        elif pname == FORMAT_PROMPT and self.format_mode == 'local':
+            local = self._run_local_format(code)
+            if local is not None:
+                return StageRequest(result=local)
+        # edit code - [2, last_idx]
+        return StageRequest(get_prompt_template(REFINE, pname),
+                            {'code': compact_for_refine(code, pname, model_name, budget, strict).code})
+
+    def _invoke(self, prompt, params: dict, pname: str, tier: str | None):
+        with span('llm', LLM, backend=self._model_name(tier), prompt=pname):
+            if tier is None:
+                return (prompt | self.llm).invoke(params)
+            return self.router.invoke(ROUTE_GENERATION, pname, tier, prompt.invoke(params))
+
+    def _model_name(self, tier: str | None) -> str:
+        return self.llm.model_name if tier is None else self.router.policy.tiers[tier].model
+
+    def _run_routed(self, pname: str, code: str, user_msg: str) -> str:
+        router = self.router
+        tier = router.tier_for(ROUTE_GENERATION, pname)
+        escalations = 0
+        while True:
+            try:
+                out, called = self._run_stage_on(pname, code, user_msg, tier)
+            except TokenBudgetExceeded as e:
+                # 입력이 들어가지 않으면 gate 와 상관없이 위 tier 로 (escalation 횟수에 세지 않음).
+                # strict 는 위 tier 가 있을 때만 켜지므로 escalate 는 None 이 아니다
+                next_tier = router.escalate(tier)
+                print(f'[ROUTE] {pname}: {e} on {tier}, escalating to {next_tier}')
+                tier = next_tier
+                continue
+            if not called or escalations >= router.policy.max_escalations:
+                # 로컬 처리된 stage 는 다시 돌려도 결과가 같다
+                return out
+            reason = self._gate_failure(pname, code, out, user_msg)
+            next_tier = router.escalate(tier) if reason else None
+            if next_tier is None:
+                return out
+            print(f'[ROUTE] {pname}: {reason} on {tier}, escalating to {next_tier}')
+            tier = next_tier
+            escalations += 1
+
+    def _gate_failure(self, pname: str, code: str, out: str, user_msg: str) -> str | None:
+        """escalation 사유. 통과하면 None."""
+        policy = self.router.policy
+        if policy.on_compile_fail and has_compiler(detect_lang(out)):
+            after = compile_check(out)
+            # 입력부터 컴파일이 안 되던 코드는 모델 탓이 아니므로 넘어간다
+            if not after.ok and (not code.strip() or compile_check(code).ok):
+                return f'compile failed ({len(after.errors)} errors)'
+        if policy.on_eval_fail:
+            if self._gate_evaluator is None:
+                from evaluation import Evaluator
+                self._gate_evaluator = Evaluator(router=self.router)
+            md = self._gate_evaluator.invoke([pname], out, user_msg, baseline=code or None)
+            report = parse_eval_report(md)
+            rate = report.compliance_rate
+            if rate is not None and rate < policy.min_compliance:
+                return f'compliance {rate}% < {policy.min_compliance}%'
+            if report.local_failures:
+                return f'local check failed ({", ".join(report.local_failures)})'
+        return None
+
+    def _run_local_format(self, code: str) -> str | None:
+        """검증에 실패하면 fallback 여부에 따라 None(LLM 사용) 또는 원본을 돌려준다."""
+        report = format_and_rename(code)
+        print(f'[{FORMAT_PROMPT}] {len(report.renames)} renames ({report.indexer}), '
+              f'clang-format={report.clang_format}, errors {report.errors_before}->{report.errors_after}')
+        if report.verified:
+            return report.code
+        return None if self.format_fallback else code
         
-        return graph.compile()
-    
+    def _make_graph(self, prompt_names: list[str]):
+        """
+        graph 는 (prompt 목록, model) 별로 한 번만 compile 해서 재사용한다.
+        노드는 실행할 agent 를 config['configurable']['agent'] 에서 꺼내므로 특정 인스턴스에 묶이지 않는다.
+        """
+        key = ('graph', tuple(prompt_names), self.llm.model_name)
+        return registry.get(key, prompt_names, lambda: _build_graph(prompt_names))
+
     def invoke(self, prompt_names: str | list[str], user_msg: str = '') -> str:
         names = [prompt_names] if isinstance(prompt_names, str) else list(prompt_names)
         chain = self._make_graph(names)
@@ -83,29 +267,57 @@ class PipeAgent():
             'user_msg': user_msg,
             'code': '',
             'step': -1,
-        })
+        }, config={'configurable': {'agent': self}})
 
         return out['code']
 
 # ------- graph 생성 없이 매번 llm 호출.
-    def invoke_yield(self, prompt_names: str | list[str], user_msg: str = '') -> Iterator[StageResult]:
+    def invoke_yield(self, prompt_names: str | list[str], user_msg: str = '',
+                     code: str = '', start: int = 0) -> Iterator[StageResult]:
+        """code/start: 중간 단계부터 이어서 만들 때 입력 코드와 첫 step 번호."""
         names = [prompt_names] if isinstance(prompt_names, str) else list(prompt_names)
-        code = ""
         
         # code_gen: bool = False
-        for step, pname in enumerate(names, start=0):
+        for step, pname in enumerate(names, start=start):
             system_text = load_system_prompt(pname)
-            if code.strip() == "":
-                prompt = build_generation_prompt(system_text, user_msg)
-            else:
-                prompt = build_refine_prompt(system_text, code)
-            
-            msg = (prompt | self.llm).invoke({})
-            code = _extract_code_only(msg.content)
+            code = self._run_stage(pname, code, user_msg)
             # # 처음 만든 코드를 계속 이용.
             # if not code_gen:
             #     code = _extract_code_only(msg.content)
             #     code_gen = True
             
             # yield step, pname, code
-            yield StageResult(step=step, prompt_name=pname, system_prompt=system_text, code=code)
\ No newline at end of file
+            yield StageResult(step=step, prompt_name=pname, system_prompt=system_text, code=code,
+                              scores=self.last_scores.pop(pname, []))
+
+
+def _build_graph(prompt_names: list[str]):
+    from langgraph.graph import StateGraph, START, END
+    from langchain_core.runnables import RunnableConfig
+    graph = StateGraph(PipeState)
+    
+    node_ids = []
+    for idx, pname in enumerate(prompt_names):
+        node_id = f'agent_{idx}_{pname}'
+        node_ids.append(node_id)
+        
+        def make_node(pname: str, idx: int):
+            def _node(state: PipeState, config: RunnableConfig):
+                agent: PipeAgent = config['configurable']['agent']
+                new_code = agent._run_stage(pname, state['code'], state['user_msg'])
+                return {
+                    'code': new_code,
+                    'step': idx,
+                }
+            return _node
+        graph.add_node(node_id, make_node(pname, idx))
+    
+    if node_ids:
+        graph.add_edge(START, node_ids[0])
+        for i in range(len(node_ids) -1 ):
+            graph.add_edge(node_ids[i], node_ids[i+1])
+        graph.add_edge(node_ids[-1], END)
+    else:
+        assert False, "no prompt"
+    
+    return graph.compile()
@@ -4,16 +4,18 @@ from util.pipe_types import StageEvalResult, StageResult
 from evaluation import Evaluator
 
 class PipeEvaluator:
-    def __init__(self):
-        self.evaluator = Evaluator()
+    def __init__(self, router=None, llm=None):
+        self.evaluator = Evaluator(router=router, llm=llm)
     
-    def invoke_yield(self, stages: list[StageResult]) -> Iterator[StageEvalResult]:
+    def invoke_yield(self, stages: list[StageResult], prev_code: str | None = None) -> Iterator[StageEvalResult]:
+        """prev_code: 첫 stage 의 이전 단계 코드 (중간 단계부터 평가할 때)"""
         if not stages:
             assert False, "no stage in evaluation"
         
         for s in stages:
             applied = [s.prompt_name]
-            md = self.evaluator.invoke(applied, s.code)
+            md = self.evaluator.invoke(applied, s.code, baseline=prev_code)
+            prev_code = s.code
             yield StageEvalResult(step=s.step, prompt_name=s.prompt_name, evaluation=md)
             
             
\ No newline at end of file
@@ -0,0 +1,289 @@
+"""
+pipeline profiler.
+실행 trace(util.run_trace) 나 job queue DB 에서 stage / evaluation 의 의존 그래프를 다시 만들고
+- critical path (의존성만 지켰을 때의 하한) 와 실제 실행에서 끝을 결정한 경로 + 그 사이 대기 시간
+- backend(LLM model, gcc, worker) 별 사용률 / 동시 실행 수
+를 계산해서 요약을 출력하고 Chrome trace(Perfetto) JSON 으로 내보낸다.
+
+실행:
+  TRACE_PATH=run_trace.jsonl PYTHONPATH=src python src/main.py
+  PYTHONPATH=src python -m profiler --trace run_trace.jsonl --chrome run_trace.json
+  PYTHONPATH=src python -m profiler --jobs sweep.db --chrome sweep.json
+"""
+
+import argparse
+import json
+import sqlite3
+from collections import defaultdict
+from dataclasses import dataclass, field
+from pathlib import Path
+
+from util.run_trace import COMPILE, EVAL, LLM, STAGE, Span, load_spans
+
+# 같은 chain 으로 묶는 문맥 key (prompt 는 chain 안의 위치)
+_GROUP_KEYS = ('model', 'query', 'sample')
+
+
+@dataclass
+class Node:
+    span: Span
+    group: tuple
+    deps: list[int] = field(default_factory=list)   # node index
+
+    @property
+    def label(self) -> str:
+        g = '/'.join(str(v) for v in self.group if v is not None)
+        return f'{g} {"gen" if self.span.cat == STAGE else "eval"} {self.span.name}'
+
+
+def _group(span: Span) -> tuple:
+    return tuple(span.args.get(k) for k in _GROUP_KEYS)
+
+
+def build_graph(spans: list[Span]) -> list[Node]:
+    """
+    top-level stage/eval span 을 node 로 만든다.
+    명시된 deps 가 없으면: 같은 group 의 stage 는 바로 앞 stage 에, eval 은 같은 prompt 의 stage 에 의존한다.
+    """
+    nodes = [Node(s, _group(s)) for s in sorted(spans, key=lambda s: s.start) if s.cat in (STAGE, EVAL)
+             and (s.parent is None or s.args.get('top_level'))]
+    by_id = {n.span.id: i for i, n in enumerate(nodes)}
+    last_stage: dict[tuple, int] = {}
+    stage_of: dict[tuple, int] = {}
+    for i, node in enumerate(nodes):
+        explicit = node.span.args.get('deps')
+        if explicit is not None:
+            node.deps = [by_id[d] for d in explicit if d in by_id]
+        elif node.span.cat == STAGE:
+            if node.group in last_stage:
+                node.deps = [last_stage[node.group]]
+        else:
+            dep = stage_of.get((node.group, node.span.name))
+            node.deps = [dep] if dep is not None else []
+        if node.span.cat == STAGE:
+            last_stage[node.group] = i
+            stage_of[(node.group, node.span.name)] = i
+    return nodes
+
+
+def ideal_critical_path(nodes: list[Node]) -> tuple[float, list[int]]:
+    """의존성만 지키고 무한히 병렬 실행했을 때 걸리는 시간(가장 긴 경로)."""
+    finish = [0.0] * len(nodes)
+    best_dep: list[int | None] = [None] * len(nodes)
+    for i, node in enumerate(nodes):     # start 순 = 위상 순서
+        start = 0.0
+        for d in node.deps:
+            if finish[d] > start:
+                start, best_dep[i] = finish[d], d
+        finish[i] = start + node.span.duration
+    if not nodes:
+        return 0.0, []
+    end = max(range(len(nodes)), key=lambda i: finish[i])
+    path = [end]
+    while best_dep[path[-1]] is not None:
+        path.append(best_dep[path[-1]])
+    return finish[end], path[::-1]
+
+
+def observed_critical_path(nodes: list[Node]) -> list[tuple[int, float]]:
+    """
+    실제로 끝을 결정한 경로. 마지막에 끝난 node 에서 가장 늦게 끝난 의존 node 로 거슬러 간다.
+    (node, 앞 node 가 끝난 뒤 시작까지 기다린 시간)
+    """
+    if not nodes:
+        return []
+    cur = max(range(len(nodes)), key=lambda i: nodes[i].span.end)
+    path = []
+    while True:
+        deps = nodes[cur].deps
+        prev = max(deps, key=lambda d: nodes[d].span.end) if deps else None
+        wait = nodes[cur].span.start - nodes[prev].span.end if prev is not None else 0.0
+        path.append((cur, max(wait, 0.0)))
+        if prev is None:
+            return path[::-1]
+        cur = prev
+
+
+@dataclass
+class BackendUsage:
+    busy: float             # 하나 이상 실행 중인 시간
+    work: float             # 실행 시간 합
+    peak: int               # 최대 동시 실행 수
+    at_peak: float          # 최대 동시 실행 수로 돈 시간
+    timeline: list[tuple[float, int]]   # (시각, 동시 실행 수) 변화점
+
+
+def backend_usage(spans: list[Span]) -> dict[str, BackendUsage]:
+    events = defaultdict(list)
+    for s in spans:
+        if s.backend and s.cat in (LLM, COMPILE) or (s.backend and s.args.get('top_level')):
+            events[s.backend] += [(s.start, 1), (s.end, -1)]
+    usage = {}
+    for backend, evs in events.items():
+        evs.sort(key=lambda e: (e[0], e[1]))
+        level = peak = 0
+        busy = work = 0.0
+        timeline = []
+        prev_t = evs[0][0]
+        spans_at = defaultdict(float)
+        for t, delta in evs:
+            if level > 0:
+                busy += t - prev_t
+                work += (t - prev_t) * level
+                spans_at[level] += t - prev_t
+            level += delta
+            peak = max(peak, level)
+            prev_t = t
+            timeline.append((t, level))
+        usage[backend] = BackendUsage(busy, work, peak, spans_at[peak], timeline)
+    return usage
+
+
+@dataclass
+class Profile:
+    spans: list[Span]
+    nodes: list[Node]
+    makespan: float
+    ideal: float
+    ideal_path: list[int]
+    observed_path: list[tuple[int, float]]
+    backends: dict[str, BackendUsage]
+
+    @classmethod
+    def build(cls, spans: list[Span]) -> 'Profile':
+        nodes = build_graph(spans)
+        t0 = min((s.start for s in spans), default=0.0)
+        t1 = max((s.end for s in spans), default=0.0)
+        ideal, ideal_path = ideal_critical_path(nodes)
+        return cls(spans, nodes, t1 - t0, ideal, ideal_path, observed_critical_path(nodes), backend_usage(spans))
+
+    def format(self) -> str:
+        work = sum(n.span.duration for n in self.nodes)
+        waited = sum(w for _, w in self.observed_path)
+        lines = [
+            f'[PROFILE] {len(self.nodes)} stages/evals, makespan {self.makespan:.1f}s, '
+            f'work {work:.1f}s (avg parallelism {work / self.makespan if self.makespan else 0:.2f})',
+            f'[PROFILE] critical path (dependencies only) {self.ideal:.1f}s over {len(self.ideal_path)} nodes; '
+            f'{self.makespan - self.ideal:.1f}s of the makespan is scheduling, not dependencies',
+            f'[PROFILE] observed critical path: {len(self.observed_path)} nodes, waited {waited:.1f}s between them',
+        ]
+        for idx, wait in self.observed_path:
+            node = self.nodes[idx]
+            lines.append(f'[PROFILE]   {node.label:<28} {node.span.duration:>8.1f}s'
+                         + (f'  (waited {wait:.1f}s)' if wait > 0.05 else ''))
+        for backend, u in sorted(self.backends.items()):
+            util = u.busy / self.makespan * 100 if self.makespan else 0.0
+            lines.append(f'[PROFILE] backend {backend}: busy {u.busy:.1f}s ({util:.0f}% of makespan), '
+                         f'avg in-flight {u.work / u.busy if u.busy else 0:.2f}, peak {u.peak} '
+                         f'({u.at_peak:.1f}s at peak)')
+        lines.append(f'[PROFILE] diagnosis: {self.diagnosis()}')
+        return '\n'.join(lines)
+
+    def diagnosis(self) -> str:
+        if not self.makespan:
+            return 'empty trace'
+        busy = sorted(b for b, u in self.backends.items() if u.busy / self.makespan > 0.8)
+        if busy:
+            return f'backend saturation: {", ".join(busy)} busy for >80% of the makespan'
+        if self.ideal and self.makespan > 1.5 * self.ideal:
+            return (f'waiting on sequential execution: dependencies allow a {self.makespan / self.ideal:.1f}x '
+                    f'shorter run and no backend is saturated')
+        return 'makespan is close to the dependency critical path'
+
+    def chrome_trace(self) -> dict:
+        """Chrome trace / Perfetto 형식. pid 0 = critical path, 1 = backend 동시 실행 수, 2.. = chain."""
+        t0 = min((s.start for s in self.spans), default=0.0)
+        us = lambda t: round((t - t0) * 1e6)
+        events = [
+            {'ph': 'M', 'pid': 0, 'name': 'process_name', 'args': {'name': 'critical path'}},
+            {'ph': 'M', 'pid': 1, 'name': 'process_name', 'args': {'name': 'backends'}},
+        ]
+        critical = {idx for idx, _ in self.observed_path}
+
+        # chain(group) 별 process, 실제 thread 별 lane
+        pids: dict[tuple, int] = {}
+        tids: dict[tuple, int] = {}
+        node_of_span = {n.span.id: n for n in self.nodes}
+        parent_of = {s.id: s.parent for s in self.spans}
+
+        def root_group(s: Span) -> tuple:
+            sid = s.id
+            while parent_of.get(sid) is not None:
+                sid = parent_of[sid]
+            node = node_of_span.get(sid)
+            return node.group if node else _group(s)
+
+        for s in self.spans:
+            group = root_group(s)
+            if group not in pids:
+                pids[group] = len(pids) + 2
+                name = '/'.join(str(v) for v in group if v is not None) or 'run'
+                events.append({'ph': 'M', 'pid': pids[group], 'name': 'process_name', 'args': {'name': name}})
+            pid = pids[group]
+            tid = tids.setdefault((pid, s.pid, s.tid), len([k for k in tids if k[0] == pid]) + 1)
+            ev = {'ph': 'X', 'name': s.name, 'cat': s.cat, 'pid': pid, 'tid': tid,
+                  'ts': us(s.start), 'dur': max(us(s.end) - us(s.start), 1),
+                  'args': {**s.args, 'backend': s.backend}}
+            node = node_of_span.get(s.id)
+            if node is not None and self.nodes.index(node) in critical:
+                ev['cname'] = 'terrible'
+                ev['args']['critical'] = True
+            events.append(ev)
+
+        for idx, wait in self.observed_path:
+            node = self.nodes[idx]
+            if wait > 0:
+                events.append({'ph': 'X', 'name': 'wait', 'cat': 'wait', 'pid': 0, 'tid': 1, 'cname': 'grey',
+                               'ts': us(node.span.start - wait), 'dur': max(round(wait * 1e6), 1)})
+            events.append({'ph': 'X', 'name': node.label, 'cat': node.span.cat, 'pid': 0, 'tid': 1,
+                           'cname': 'terrible', 'ts': us(node.span.start),
+                           'dur': max(us(node.span.end) - us(node.span.start), 1)})
+        for prev, (idx, _) in zip(self.observed_path, self.observed_path[1:]):
+            a, b = self.nodes[prev[0]].span, self.nodes[idx].span
+            fid = f'{a.id}->{b.id}'
+            events.append({'ph': 's', 'id': fid, 'name': 'dep', 'cat': 'critical', 'pid': 0, 'tid': 1,
+                           'ts': us(a.end) - 1})
+            events.append({'ph': 'f', 'bp': 'e', 'id': fid, 'name': 'dep', 'cat': 'critical', 'pid': 0, 'tid': 1,
+                           'ts': us(b.start)})
+
+        for backend, u in self.backends.items():
+            for t, level in u.timeline:
+                events.append({'ph': 'C', 'name': backend, 'pid': 1, 'ts': us(t), 'args': {'in_flight': level}})
+        return {'traceEvents': events, 'displayTimeUnit': 'ms'}
+
+
+def spans_from_jobs(db: str) -> list[Span]:
+    """job_queue DB 의 완료된 job 을 span 으로. backend 는 job 을 실행한 worker."""
+    conn = sqlite3.connect(db)
+    conn.row_factory = sqlite3.Row
+    rows = conn.execute("SELECT * FROM jobs WHERE status = 'done' AND started IS NOT NULL").fetchall()
+    ids = {r['id']: i + 1 for i, r in enumerate(rows)}
+    spans = []
+    for r in rows:
+        deps = [ids[r['input_job']]] if r['input_job'] in ids else []
+        spans.append(Span(ids[r['id']], r['prompt'], STAGE if r['kind'] == 'generate' else EVAL,
+                          r['started'], r['finished'], r['worker'],
+                          args={'query': r['query'], 'sample': r['sample'], 'model': r['sweep'],
+                                'deps': deps, 'top_level': True}))
+    conn.close()
+    return spans
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument('--trace', help='run_trace jsonl (TRACE_PATH)')
+    src.add_argument('--jobs', help='job_queue sqlite DB')
+    parser.add_argument('--chrome', help='Chrome trace JSON 저장 경로 (chrome://tracing, ui.perfetto.dev)')
+    args = parser.parse_args()
+
+    spans = load_spans(args.trace) if args.trace else spans_from_jobs(args.jobs)
+    profile = Profile.build(spans)
+    print(profile.format())
+    if args.chrome:
+        Path(args.chrome).write_text(json.dumps(profile.chrome_trace()), encoding='utf-8')
+        print(f'[PROFILE] chrome trace -> {args.chrome}')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,181 @@
+"""
+prompt 난이도별 model tier 라우팅.
+configs/routing.toml 에서 stage(p0..p9) / evaluation 별 tier 를 정하고,
+compile gate 나 evaluator 기준에 못 미치면 한 단계 위 tier 로 다시 돌린다(escalation).
+코드 입력이 tier 의 token_budget 을 넘어도 (compaction.TokenBudgetExceeded) 위 tier 로 보낸다.
+가장 위 tier 에서는 budget 을 넘어도 줄인 그대로 보낸다.
+모든 호출은 UsageLedger 에 남겨서 단일 모델(baseline) 대비 비용/latency 를 비교한다.
+"""
+
+import time
+import tomllib
+from collections import defaultdict
+from dataclasses import dataclass, field
+from pathlib import Path
+
+from settings import PROJECT_ROOT
+from util.usage import UsageLedger, UsageRecord, message_usage
+
+DEFAULT_POLICY = PROJECT_ROOT / 'configs' / 'routing.toml'
+
+GENERATION = 'generation'
+EVALUATION = 'evaluation'
+
+
+@dataclass(frozen=True)
+class Tier:
+    name: str
+    model: str
+    base_url: str | None = None
+    input_cost: float = 0.0            # USD / 1M tokens
+    output_cost: float = 0.0
+    ms_per_output_token: float = 0.0  # baseline latency 추정용
+    token_budget: int | None = None    # 코드 입력 token 상한. None 이면 settings 의 eval/refine budget
+
+    def cost(self, input_tokens: int, output_tokens: int) -> float:
+        return (input_tokens * self.input_cost + output_tokens * self.output_cost) / 1_000_000
+
+
+@dataclass
+class RoutingPolicy:
+    tiers: dict[str, Tier]
+    baseline: str
+    routes: dict[str, dict[str, str]]      # kind -> {prompt | 'default': tier}
+    escalation_order: list[str] = field(default_factory=list)
+    on_compile_fail: bool = False
+    on_eval_fail: bool = False
+    min_compliance: float = 0.0
+    max_escalations: int = 1
+
+    @classmethod
+    def from_file(cls, path: str | Path = DEFAULT_POLICY) -> 'RoutingPolicy':
+        with open(path, 'rb') as fp:
+            raw = tomllib.load(fp)
+        tiers = {name: Tier(name=name, **spec) for name, spec in raw['tiers'].items()}
+        esc = raw.get('escalation', {})
+        policy = cls(
+            tiers=tiers,
+            baseline=raw.get('baseline', {}).get('tier', next(iter(tiers))),
+            routes={kind: dict(raw.get(kind, {})) for kind in (GENERATION, EVALUATION)},
+            escalation_order=list(esc.get('order', [])),
+            on_compile_fail=esc.get('on_compile_fail', False),
+            on_eval_fail=esc.get('on_eval_fail', False),
+            min_compliance=float(esc.get('min_compliance', 0.0)),
+            max_escalations=int(esc.get('max_escalations', 1)),
+        )
+        policy.validate()
+        return policy
+
+    def single(self, tier: str | None = None) -> 'RoutingPolicy':
+        """모든 호출을 한 tier 로 보내는 baseline 정책 (escalation 없음)."""
+        tier = tier or self.baseline
+        return RoutingPolicy(self.tiers, tier, {k: {'default': tier} for k in (GENERATION, EVALUATION)})
+
+    def validate(self):
+        used = [self.baseline, *self.escalation_order]
+        used += [t for routes in self.routes.values() for t in routes.values()]
+        unknown = sorted(set(used) - set(self.tiers))
+        if unknown:
+            raise ValueError(f'unknown tier in routing policy: {", ".join(unknown)}')
+
+    def tier_for(self, kind: str, prompt_names: list[str]) -> str:
+        """여러 prompt 를 함께 평가하면 그중 가장 강한 tier 를 쓴다."""
+        routes = self.routes.get(kind, {})
+        default = routes.get('default', self.baseline)
+        tiers = [routes.get(n, default) for n in prompt_names] or [default]
+        return max(tiers, key=self._rank)
+
+    def escalate(self, tier: str) -> str | None:
+        if tier not in self.escalation_order:
+            return None
+        idx = self.escalation_order.index(tier)
+        return self.escalation_order[idx + 1] if idx + 1 < len(self.escalation_order) else None
+
+    def _rank(self, tier: str) -> int:
+        return self.escalation_order.index(tier) if tier in self.escalation_order else -1
+
+
+class ModelRouter:
+    def __init__(self, policy: RoutingPolicy, ledger: UsageLedger | None = None):
+        self.policy = policy
+        self.ledger = ledger if ledger is not None else UsageLedger()
+
+    @classmethod
+    def from_file(cls, path: str | Path = DEFAULT_POLICY) -> 'ModelRouter':
+        return cls(RoutingPolicy.from_file(path))
+
+    def tier_for(self, kind: str, prompt_names: str | list[str]) -> str:
+        names = [prompt_names] if isinstance(prompt_names, str) else list(prompt_names)
+        return self.policy.tier_for(kind, names)
+
+    def escalate(self, tier: str) -> str | None:
+        return self.policy.escalate(tier)
+
+    def model(self, tier: str):
+        from models import chat_model
+        spec = self.policy.tiers[tier]
+        return chat_model(spec.model, spec.base_url)
+
+    def invoke(self, kind: str, prompt: str, tier: str, messages):
+        """tier 모델로 messages 를 보내고 token/latency 를 기록한다."""
+        llm = self.model(tier)
+        start = time.perf_counter()
+        msg = llm.invoke(messages)
+        latency = time.perf_counter() - start
+        text = messages.to_string() if hasattr(messages, 'to_string') else \
+            '\n'.join(str(getattr(m, 'content', m)) for m in messages)
+        in_tok, out_tok, estimated = message_usage(msg, text, llm.model_name)
+        self.ledger.add(UsageRecord(kind, prompt, tier, llm.model_name, in_tok, out_tok, latency, estimated))
+        return msg
+
+    def report(self) -> 'RoutingReport':
+        return RoutingReport.build(self.ledger, self.policy)
+
+
+@dataclass
+class RoutingReport:
+    baseline: str
+    calls: int
+    cost: float
+    baseline_cost: float
+    latency: float
+    baseline_latency: float       # 같은 token 을 baseline tier 속도로 생성했다고 가정한 추정치
+    by_tier: dict[str, list[float]]     # tier -> [calls, input, output, cost, latency]
+    by_prompt: dict[str, list[float]]   # kind/prompt -> [calls, cost, baseline_cost]
+
+    @classmethod
+    def build(cls, ledger: UsageLedger, policy: RoutingPolicy) -> 'RoutingReport':
+        base = policy.tiers[policy.baseline]
+        by_tier = defaultdict(lambda: [0, 0, 0, 0.0, 0.0])
+        by_prompt = defaultdict(lambda: [0, 0.0, 0.0])
+        cost = base_cost = latency = base_latency = 0.0
+        for r in ledger.records:
+            tier = policy.tiers[r.tier]
+            c, bc = tier.cost(r.input_tokens, r.output_tokens), base.cost(r.input_tokens, r.output_tokens)
+            delta = r.output_tokens * (base.ms_per_output_token - tier.ms_per_output_token) / 1000
+            cost += c
+            base_cost += bc
+            latency += r.latency
+            base_latency += max(r.latency + delta, 0.0)
+            t = by_tier[r.tier]
+            t[0] += 1; t[1] += r.input_tokens; t[2] += r.output_tokens; t[3] += c; t[4] += r.latency
+            p = by_prompt[f'{r.kind}/{r.prompt}']
+            p[0] += 1; p[1] += c; p[2] += bc
+        return cls(policy.baseline, len(ledger), cost, base_cost, latency, base_latency,
+                   dict(by_tier), dict(by_prompt))
+
+    @staticmethod
+    def _saving(new: float, old: float) -> str:
+        return f'{(1 - new / old) * 100:.1f}%' if old else '-'
+
+    def format(self) -> str:
+        lines = ['[ROUTE] tier      calls   input_tok  output_tok    cost($)  latency(s)']
+        for name, (n, i, o, c, l) in sorted(self.by_tier.items()):
+            lines.append(f'[ROUTE] {name:<8} {n:>6} {i:>11} {o:>11} {c:>10.4f} {l:>11.1f}')
+        for key, (n, c, bc) in sorted(self.by_prompt.items()):
+            lines.append(f'[ROUTE] {key:<16} calls={n} cost=${c:.4f} (baseline ${bc:.4f})')
+        lines.append(f'[ROUTE] total {self.calls} calls: cost ${self.cost:.4f} vs baseline({self.baseline}) '
+                     f'${self.baseline_cost:.4f}, saving {self._saving(self.cost, self.baseline_cost)}')
+        lines.append(f'[ROUTE] latency {self.latency:.1f}s vs estimated baseline {self.baseline_latency:.1f}s, '
+                     f'saving {self._saving(self.latency, self.baseline_latency)}')
+        return '\n'.join(lines)
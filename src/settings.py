@@ -7,6 +7,17 @@ PROJECT_ROOT = Path(__file__).resolve().parents[1]
 class LLMSettings(BaseSettings):
     openai_api_key: str = Field(default='dummy')
     openai_base_url: str = Field(default="dummy")
+    # 코드 입력 token 예산 (0 이면 제한 없음). 줄여도 넘으면 routing 중에는 상위 tier 로, 아니면 그대로 보낸다
+    eval_token_budget: int = Field(default=8000)
+    refine_token_budget: int = Field(default=16000)
+    # model routing 정책 파일 (비어 있으면 routing 없이 기존 단일 모델)
+    routing_policy: str = Field(default='')
+    # p0 생성 후보 수 (best-of-N, 1 이면 한 번만 생성)
+    best_of_n: int = Field(default=1)
+    # best-of-N 채점에서 후보를 hostsim 으로 빌드해 잠깐 돌려 볼지 (후보마다 빌드 + 실행이 붙는다)
+    smoke_run: bool = Field(default=False)
+    # 실행 trace(jsonl) 저장 경로. 비어 있으면 기록하지 않는다 (profiler 입력)
+    trace_path: str = Field(default='')
     
     model_config = SettingsConfigDict(
         env_file= PROJECT_ROOT / '.env',
@@ -0,0 +1,116 @@
+"""
+생성된 코드를 hostsim 런타임과 링크해서 host 에서 실행되는 파일로 만든다.
+런타임(hostsim/runtime/*.cpp)은 소스 hash 별로 한 번만 컴파일해서 libhostsim.a 로 묶고,
+스케치는 (소스, 런타임, flag) hash 로 캐시한다. 여러 프로세스가 동시에 빌드해도 rename 으로 교체한다.
+fleet=True 이면 스케치를 fleet marker (hostsim/runtime/fleet/marks.cpp) 사이에 링크해서
+런타임 --fleet 이 device 마다 스케치 전역 변수를 따로 둘 수 있게 한다.
+wcet=True 이면 WCET loop bound probe (hostsim/runtime/wcet/probe.cpp) 를 같이 링크한다.
+스케치는 flags 에 -fsanitize-coverage=trace-pc 를 넣어서 빌드해야 한다 (sim.wcet).
+"""
+
+import hashlib
+import os
+import subprocess
+import tempfile
+from dataclasses import dataclass, field
+from pathlib import Path
+
+from util.compile_check import HOSTSIM_INCLUDE, PROJECT_ROOT, compiler_command, has_compiler, prepare_source
+
+RUNTIME_DIR = PROJECT_ROOT / 'hostsim' / 'runtime'
+FLEET_MARKS = RUNTIME_DIR / 'fleet' / 'marks.cpp'
+WCET_PROBE = RUNTIME_DIR / 'wcet' / 'probe.cpp'
+BUILD_DIR = Path(os.environ.get('HOSTSIM_BUILD_DIR', PROJECT_ROOT / 'hostsim' / 'build'))
+
+RUNTIME_FLAGS = ['-std=gnu++17', '-O2']
+SKETCH_FLAGS = ['-O1', '-g']
+
+
+@dataclass
+class SketchBuild:
+    ok: bool
+    lang: str                   # 'arduino' | 'c'
+    binary: Path | None
+    errors: list[str] = field(default_factory=list)
+    cached: bool = False
+
+
+def _digest(*parts: bytes | str) -> str:
+    h = hashlib.sha256()
+    for p in parts:
+        h.update(p.encode() if isinstance(p, str) else p)
+        h.update(b'\0')
+    return h.hexdigest()[:16]
+
+
+def _sources() -> list[Path]:
+    return sorted([*RUNTIME_DIR.glob('*.cpp'), *RUNTIME_DIR.glob('*.h'), FLEET_MARKS, WCET_PROBE, *HOSTSIM_INCLUDE.rglob('*.h')])
+
+
+def runtime_key(flags: list[str] | None = None) -> str:
+    flags = flags or RUNTIME_FLAGS
+    return _digest(*flags, *(f'{p.relative_to(PROJECT_ROOT)}\n{p.read_text(encoding="utf-8")}' for p in _sources()))
+
+
+def build_runtime(build_dir: Path = BUILD_DIR, flags: list[str] | None = None) -> Path:
+    """libhostsim.a 경로. 이미 같은 hash 로 빌드돼 있으면 그대로 쓴다. 옆에 fleet_begin.o / fleet_end.o / wcet_probe.o 도 둔다."""
+    flags = flags or RUNTIME_FLAGS
+    out = build_dir / f'runtime-{runtime_key(flags)}'
+    lib = out / 'libhostsim.a'
+    if lib.exists():
+        return lib
+    out.mkdir(parents=True, exist_ok=True)
+    with tempfile.TemporaryDirectory(dir=out) as tmp:
+        objs = []
+        for src in sorted(RUNTIME_DIR.glob('*.cpp')):
+            obj = Path(tmp) / f'{src.stem}.o'
+            subprocess.run(['g++', *flags, '-I', str(HOSTSIM_INCLUDE), '-I', str(RUNTIME_DIR),
+                            '-c', str(src), '-o', str(obj)], check=True, capture_output=True, text=True)
+            objs.append(str(obj))
+        for name, defines in (('fleet_begin.o', []), ('fleet_end.o', ['-DHOSTSIM_FLEET_END'])):
+            subprocess.run(['g++', *flags, *defines, '-c', str(FLEET_MARKS), '-o', str(Path(tmp) / name)],
+                           check=True, capture_output=True, text=True)
+            os.replace(Path(tmp) / name, out / name)
+        subprocess.run(['g++', *flags, '-c', str(WCET_PROBE), '-o', str(Path(tmp) / 'wcet_probe.o')],
+                       check=True, capture_output=True, text=True)
+        os.replace(Path(tmp) / 'wcet_probe.o', out / 'wcet_probe.o')
+        tmp_lib = Path(tmp) / 'libhostsim.a'
+        subprocess.run(['ar', 'rcs', str(tmp_lib), *objs], check=True)
+        os.replace(tmp_lib, lib)
+    return lib
+
+
+def build_sketch(code: str, lang: str | None = None, build_dir: Path = BUILD_DIR,
+                 flags: list[str] | None = None, timeout: float = 120.0, fleet: bool = False,
+                 wcet: bool = False) -> SketchBuild:
+    """code 를 런타임과 링크한다. 컴파일 에러는 errors 에 'error:' 줄로 남긴다."""
+    src, lang = prepare_source(code, lang)
+    flags = flags or SKETCH_FLAGS
+    if not has_compiler(lang):
+        return SketchBuild(False, lang, None, [f'{"g++" if lang == "arduino" else "gcc"} not found'])
+    lib = build_runtime(build_dir)
+    key = _digest(src, lang, lib.parent.name, *flags, *(['fleet'] if fleet else []), *(['wcet'] if wcet else []))
+    binary = build_dir / 'sketches' / key
+    if binary.exists():
+        return SketchBuild(True, lang, binary, cached=True)
+    binary.parent.mkdir(parents=True, exist_ok=True)
+
+    with tempfile.TemporaryDirectory(dir=binary.parent) as tmp:
+        path = Path(tmp) / ('sketch.cpp' if lang == 'arduino' else 'sketch.c')
+        path.write_text(src, encoding='utf-8')
+        obj = Path(tmp) / 'sketch.o'
+        proc = subprocess.run(compiler_command(lang, [*flags, '-c', str(path), '-o', str(obj)]),
+                              capture_output=True, text=True, timeout=timeout)
+        if proc.returncode == 0:
+            exe = Path(tmp) / 'sketch'
+            # 링커는 입력 순서대로 section 을 놓으므로 marker 가 스케치의 .data/.bss/.init_array 를 감싼다
+            objs = [lib.parent / 'fleet_begin.o', obj, lib.parent / 'fleet_end.o'] if fleet else [obj]
+            if wcet:
+                objs.append(lib.parent / 'wcet_probe.o')
+            proc = subprocess.run(['g++', '-o', str(exe), *map(str, objs), str(lib)],
+                                  capture_output=True, text=True, timeout=timeout)
+        if proc.returncode != 0:
+            errors = [ln for ln in proc.stderr.splitlines() if ' error: ' in ln or ln.startswith('error:')] or proc.stderr.splitlines()[-5:]
+            return SketchBuild(False, lang, None, errors)
+        os.replace(exe, binary)
+    return SketchBuild(True, lang, binary)
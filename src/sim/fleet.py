@@ -0,0 +1,111 @@
+"""
+자판기, 주차장처럼 여러 대가 동시에 도는 경우를 가정해 스케치 하나를 device 수천 대로 한 프로세스에서 돌리고
+core 하나가 초당 처리하는 event 수와 device 하나가 차지하는 메모리를 잰다.
+
+런타임 --fleet 은 fleet build (스케치를 fleet marker 사이에 링크) 에서 device 마다 Device, 스케치 coroutine,
+스케치 전역 변수(.data/.bss) 사본을 따로 두고 가상 시간이 가장 이른 device 부터 slice 만큼씩 돌린다.
+device k 의 입력 script 는 k * spread / devices 만큼 늦게 시작한다. Arduino 스케치(setup/loop)만 된다.
+
+event 는 적용된 입력(script event)과 출력 trace 줄이다. device 0 은 script 를 그대로 받으므로
+한 대만 돌린 trace 와 같아야 하고, 다르면 device 사이에 상태가 샌 것이다 (isolation 확인).
+
+corpus 의 i3/i5 변형은 10000 대에서 core 당 초당 약 40k ~ 850k event, device 당 14-16 KB 가 나온다.
+처리량은 event 당 API 호출 수에 달려 있어서, 입력을 busy-wait 로 기다리는 gpt4_1 i3 p6/p7 은 40k 대로 가장 느리다.
+
+실행:
+  PYTHONPATH=src python -m sim.fleet                                   # i3(자판기), i5(주차장), 10000 대
+  PYTHONPATH=src python -m sim.fleet --corpus qwen3 --queries i5 --devices 2000 --slice-ms 10
+"""
+
+import argparse
+from dataclasses import dataclass
+from pathlib import Path
+
+from sim.build import build_sketch
+from sim.golden import first_divergence
+from sim.run import CORPORA, corpus_files, query_of
+from sim.runner import SimResult, run_binary, script_for
+from util.compile_check import PROJECT_ROOT
+
+FLEET_QUERIES = ['i3', 'i5']
+
+
+@dataclass
+class FleetStats:
+    devices: int
+    sim_us: int
+    setup_us: int
+    wall_us: int
+    cpu_us: int
+    inputs: int
+    outputs: int
+    calls: int
+    switches: int
+    image_bytes: int        # device 마다 바꿔 끼우는 스케치 전역 변수 + Serial
+    device_bytes: int       # 런타임 Device 구조체
+    stack_kb: int           # 모든 device 가 실제로 건드린 stack
+    rss_base_kb: int
+    rss_peak_kb: int
+
+    @classmethod
+    def from_result(cls, res: SimResult) -> 'FleetStats | None':
+        try:
+            return cls(**{k: res.stats[k] for k in cls.__dataclass_fields__})
+        except KeyError:
+            return None
+
+    @property
+    def events_per_core_s(self) -> float:
+        return (self.inputs + self.outputs) / (self.cpu_us / 1e6) if self.cpu_us else 0.0
+
+    @property
+    def kb_per_device(self) -> float:
+        return (self.rss_peak_kb - self.rss_base_kb) / self.devices
+
+    def summary(self) -> str:
+        return (f'{self.devices} devices, {self.sim_us / 1e6 / self.devices:.0f} s each in '
+                f'{self.wall_us / 1e6:.2f} s (setup {self.setup_us / 1e6:.2f} s); '
+                f'{self.events_per_core_s / 1e3:.0f}k events/s/core, {self.calls / (self.cpu_us or 1):.1f}M calls/s, '
+                f'{self.switches / self.devices:.0f} switches/device; '
+                f'{self.kb_per_device:.1f} KB/device (globals {self.image_bytes} B, Device {self.device_bytes} B, '
+                f'stack {self.stack_kb / self.devices:.1f} KB)')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='스케치 하나를 device 수천 대로 돌리는 부하 시뮬레이션')
+    parser.add_argument('files', nargs='*', help='실행할 .c 파일. 비우면 corpus 의 --queries')
+    parser.add_argument('--corpus', nargs='*', default=CORPORA)
+    parser.add_argument('--queries', nargs='*', default=FLEET_QUERIES)
+    parser.add_argument('--steps', nargs='*', type=int, default=None)
+    parser.add_argument('--script', help='입력 event script. 비우면 hostsim/scripts/<query>.txt')
+    parser.add_argument('--devices', type=int, default=10_000)
+    parser.add_argument('--duration-ms', type=float, default=60_000)
+    parser.add_argument('--spread-ms', type=float, default=1000, help='device 사이 입력 시작 간격의 합')
+    parser.add_argument('--slice-ms', type=float, default=100, help='device 가 한 번에 도는 가상 시간')
+    parser.add_argument('--timeout', type=float, default=600)
+    args = parser.parse_args()
+
+    files = [Path(f) for f in args.files] or corpus_files(args.corpus, args.queries, args.steps)
+    for f in files:
+        name = f.resolve().relative_to(PROJECT_ROOT) if f.resolve().is_relative_to(PROJECT_ROOT) else f
+        build = build_sketch(f.read_text(encoding='utf-8'), fleet=True)
+        if not build.ok:
+            print(f'[FLEET] {name}: build failed')
+            continue
+        query = query_of(f)
+        script = args.script or (script_for(query) if query and script_for(query).exists() else None)
+        res = run_binary(build.binary, script, args.duration_ms, timeout=args.timeout,
+                         extra=['--fleet', str(args.devices), '--spread-ms', str(args.spread_ms),
+                                '--slice-ms', str(args.slice_ms)])
+        stats = FleetStats.from_result(res)
+        if not res.ok or stats is None:
+            print(f'[FLEET] {name}: {res.error or "no fleet summary"}')
+            continue
+        single = run_binary(build.binary, script, args.duration_ms)
+        d = first_divergence(single.events, res.events)
+        isolation = 'device 0 matches a single run' if d is None else f'device 0 differs from a single run: {d}'
+        print(f'[FLEET] {name}: {stats.summary()}; {isolation}')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,304 @@
+"""
+refine prompt 가 "기능을 유지한다" 는 말이 맞는지 확인하는 differential fuzzer.
+query 마다 무작위지만 유효한 입력 script 를 만들어 같은 모델의 p0 과 pN 을 가상 시간으로 나란히 돌리고
+LCD, LED(pin/pwm), Serial 출력을 비교한다.
+
+비교는 시각을 보지 않고 channel 별 값의 순서만 본다 (refine 이 delay 를 바꾸는 건 괜찮다).
+  numbers  LCD/Serial 은 글자 속 숫자만 (거스름돈, 결과, 남은 대수, 요금), pin/pwm 은 값 그대로 (기본)
+  text     LCD/Serial 글자를 공백, 대소문자만 정리해서
+  exact    payload 그대로
+같은 값이 연달아 나오는 것은 하나로 본다.
+
+script 는 런타임 --batch 로 묶어서 돌린다. 스케치마다 한 번 exec 하고 script 마다 fork 만 하므로
+core 하나에 초당 수백 run 이 나오고, --procs 로 process pool 에 chunk 를 나눈다.
+
+실행:
+  PYTHONPATH=src python -m sim.fuzz --traces 2000
+  PYTHONPATH=src python -m sim.fuzz --corpus qwen3 --queries i3 --steps 1 2 --traces 500 --procs 8
+  PYTHONPATH=src python -m sim.fuzz --queries i5 --show 1234      # seed 1234 의 script 를 보여준다
+"""
+
+import argparse
+import multiprocessing
+import os
+import random
+import re
+import subprocess
+import tempfile
+import time
+from collections import Counter
+from dataclasses import dataclass, field
+from pathlib import Path
+
+from sim.build import build_sketch
+from sim.run import CORPORA
+from sim.runner import TraceEvent, parse_trace
+from util.compile_check import PROJECT_ROOT
+
+QUERIES = ['i1', 'i2', 'i3', 'i4', 'i5']
+OBSERVED = {'lcd': 'lcd', 'serial': 'serial', 'log': 'serial', 'pin': 'pin', 'pwm': 'pin'}
+TAIL_MS = 15_000    # 마지막 입력 뒤로 더 돌리는 시간
+TIMEOUT = 'timeout' # batch 가 시간 안에 끝나지 않아 결과가 없는 run 의 상태
+
+# i1 버튼 변형의 입력 순서 (hostsim/scripts/i1.txt 와 같다): 숫자 0-9, + - * /, =, C
+_I1_BUTTON = {**{str(d): d for d in range(10)}, '+': 10, '-': 11, '*': 12, '/': 13, '=': 14, 'C': 15}
+
+
+# ------- 입력 script 생성
+def _i1(rng: random.Random) -> tuple[list[str], int]:
+    lines, t = [], 3000
+    for _ in range(rng.randint(1, 4)):
+        expr = str(rng.randint(0, 999)) + rng.choice('+-*/') + str(rng.randint(0, 999)) + '='
+        if rng.random() < 0.3:
+            expr += 'C'
+        for c in expr:
+            lines += [f'{t} key {c}', f'{t} button {_I1_BUTTON[c]}']
+            t += rng.randint(250, 900)
+        t += rng.randint(2500, 6000)    # 결과 표시
+    return lines, t
+
+
+def _i2(rng: random.Random) -> tuple[list[str], int]:
+    stop, walk = rng.randint(5, 40), rng.randint(3, 20)
+    # scanf 변형은 첫 줄에서 둘 다, fgets 변형은 한 줄에 하나씩 읽는다 (hostsim/scripts/i2.txt)
+    return [f'500 serial {stop} {walk}', f'700 serial {walk}'], 700 + 2 * (stop + walk) * 1000
+
+
+def _i3(rng: random.Random) -> tuple[list[str], int]:
+    lines, t = [], 3000
+    for _ in range(rng.randint(2, 6)):
+        if rng.random() < 0.1:
+            lines.append(f'{t} serial {rng.choice(["abc", "100", "-5 1", ""])}')
+        else:
+            lines.append(f'{t} serial {rng.randrange(0, 10001, 100)} {rng.randint(0, 10)}')
+        t += rng.randint(6000, 12000)
+    return lines, t
+
+
+def _i4(rng: random.Random) -> tuple[list[str], int]:
+    lines, t = [], 3000
+    for _ in range(rng.randint(2, 8)):
+        lines.append(f'{t} button {rng.randint(0, 4)} 200')
+        t += rng.choice([rng.randint(300, 1500), rng.randint(3000, 15000)])
+    return lines, t + 20_000    # 마지막 호출까지 움직이는 시간
+
+
+def _i5(rng: random.Random) -> tuple[list[str], int]:
+    lines, t, parked = [], 3000, []
+    for _ in range(rng.randint(3, 14)):
+        r = rng.random()
+        if r < 0.1:
+            lines.append(f'{t} serial {rng.choice(["IN", "OUT", "X", "I 25 00"])}')
+        elif parked and r < 0.45:
+            hh, mm = parked.pop(rng.randrange(len(parked)))
+            out = hh * 60 + mm + rng.randint(0, 600)
+            lines.append(f'{t} serial O {min(out // 60, 23)} {out % 60}')
+        else:
+            hh, mm = rng.randint(0, 20), rng.randint(0, 59)
+            parked.append((hh, mm))
+            lines.append(f'{t} serial I {hh} {mm}')
+        t += rng.randint(3000, 8000)
+    return lines, t
+
+
+GENERATORS = {'i1': _i1, 'i2': _i2, 'i3': _i3, 'i4': _i4, 'i5': _i5}
+
+
+def make_script(query: str, seed: int) -> tuple[str, float]:
+    """(script 본문, 실행 시간 ms). 같은 query, seed 면 항상 같은 script 다."""
+    lines, last = GENERATORS[query](random.Random(f'{query}:{seed}'))
+    return '\n'.join([f'# fuzz {query} seed {seed}', *lines]) + '\n', last + TAIL_MS
+
+
+# ------- 출력 비교
+_NUM_RE = re.compile(r'-?\d+(?:\.\d+)?')
+
+
+def observe(events: list[TraceEvent], mode: str) -> dict[str, list[str]]:
+    """channel 별로 관찰된 값의 순서. 연달아 같은 값은 하나로 줄인다."""
+    streams: dict[str, list[str]] = {}
+    for e in events:
+        channel = OBSERVED.get(e.channel)
+        if channel is None:
+            continue
+        values = [e.payload]
+        if channel in ('lcd', 'serial') and mode != 'exact':
+            text = e.payload.partition(':')[2] if channel == 'lcd' else e.payload
+            values = _NUM_RE.findall(text) if mode == 'numbers' else [' '.join(text.lower().split())]
+        elif channel == 'pin':
+            values = [f'{e.channel} {e.payload}']
+        stream = streams.setdefault(channel, [])
+        for v in values:
+            if v and (not stream or stream[-1] != v):
+                stream.append(v)
+    return streams
+
+
+@dataclass
+class Divergence:
+    seed: int
+    channel: str        # lcd | serial | pin | run
+    index: int          # 처음 달라진 값의 순번
+    base: str           # p0 의 값 ('' 면 p0 쪽이 먼저 끝남)
+    other: str
+
+
+def compare(base: dict[str, list[str]], other: dict[str, list[str]], seed: int) -> list[Divergence]:
+    diffs = []
+    for channel in sorted(set(base) | set(other)):
+        a, b = base.get(channel, []), other.get(channel, [])
+        if a == b:
+            continue
+        k = next((i for i, (x, y) in enumerate(zip(a, b)) if x != y), min(len(a), len(b)))
+        diffs.append(Divergence(seed, channel, k, a[k] if k < len(a) else '', b[k] if k < len(b) else ''))
+    return diffs
+
+
+# ------- 실행 (worker process)
+def _run_batch(binary: Path, runs: list[tuple[Path, Path, float]], tmp: Path, timeout_s: int) -> dict[Path, str]:
+    """trace -> 상태. batch 전체가 시간 안에 끝나지 않으면 끝나지 않은 run 은 TIMEOUT."""
+    listing = tmp / f'{binary.name}.runs'
+    listing.write_text(''.join(f'{s} {t} {ms}\n' for s, t, ms in runs), encoding='utf-8')
+    try:
+        proc = subprocess.run([str(binary), '--batch', str(listing), '--timeout-s', str(timeout_s)],
+                              capture_output=True, text=True, timeout=timeout_s * (len(runs) + 1))
+        stdout = proc.stdout
+    except subprocess.TimeoutExpired as e:
+        # 시간 초과 때는 text=True 여도 bytes 로 온다
+        stdout = e.stdout.decode('utf-8', errors='replace') if isinstance(e.stdout, bytes) else (e.stdout or '')
+    status = {trace: TIMEOUT for _, trace, _ in runs}
+    for line in stdout.splitlines():
+        trace, _, st = line.partition(' ')
+        status[Path(trace)] = st
+    return status
+
+
+def _fuzz_chunk(job: tuple) -> tuple[int, dict[int, list[Divergence]]]:
+    """seeds 하나씩 p0 과 각 step 을 돌려 step -> Divergence 목록을 돌려준다."""
+    query, binaries, seeds, mode, timeout_s = job
+    shm = Path('/dev/shm')
+    diffs: dict[int, list[Divergence]] = {step: [] for step in binaries if step != 0}
+    runs = 0
+    with tempfile.TemporaryDirectory(dir=shm if shm.is_dir() else None) as tmp:
+        tmp = Path(tmp)
+        scripts = {}
+        for seed in seeds:
+            text, ms = make_script(query, seed)
+            path = tmp / f'{seed}.txt'
+            path.write_text(text, encoding='utf-8')
+            scripts[seed] = (path, ms)
+        observed: dict[int, dict[int, dict | str]] = {}
+        for step, binary in binaries.items():
+            out = tmp / f'p{step}'
+            out.mkdir()
+            runs_ = [(path, out / f'{seed}.trace', ms) for seed, (path, ms) in scripts.items()]
+            status = _run_batch(Path(binary), runs_, tmp, timeout_s)
+            runs += len(runs_)
+            for seed, (_, trace, _) in zip(scripts, runs_):
+                st = status.get(trace, 'missing')
+                if st != 'ok':
+                    observed.setdefault(step, {})[seed] = st
+                    continue
+                _, events = parse_trace(trace.read_text(encoding='utf-8', errors='replace'))
+                observed.setdefault(step, {})[seed] = observe(events, mode)
+        for step in diffs:
+            for seed in seeds:
+                base, other = observed[0][seed], observed[step][seed]
+                if isinstance(base, str) or isinstance(other, str):
+                    # 시간 초과는 둘 다 그랬어도 같은 동작인지 알 수 없다
+                    if base != other or base == TIMEOUT:
+                        diffs[step].append(Divergence(seed, 'run', 0, base if isinstance(base, str) else 'ok',
+                                                      other if isinstance(other, str) else 'ok'))
+                    continue
+                diffs[step] += compare(base, other, seed)
+    return runs, diffs
+
+
+@dataclass
+class StepReport:
+    corpus: str
+    query: str
+    step: int
+    traces: int = 0
+    diverged: set[int] = field(default_factory=set)
+    channels: Counter = field(default_factory=Counter)
+    example: Divergence | None = None
+
+    def add(self, divergences: list[Divergence]):
+        for d in divergences:
+            self.diverged.add(d.seed)
+            self.channels[d.channel] += 1
+            if self.example is None or d.seed < self.example.seed:
+                self.example = d
+
+
+def _binary(corpus: str, query: str, step: int) -> Path | None:
+    f = PROJECT_ROOT / corpus / 'gen_pipe' / query / f'out_step{step}_{query}_p{step}.c'
+    if not f.exists():
+        return None
+    build = build_sketch(f.read_text(encoding='utf-8'))
+    return build.binary if build.ok else None
+
+
+def main():
+    parser = argparse.ArgumentParser(description='p0 대 pN differential fuzzing')
+    parser.add_argument('--corpus', nargs='*', default=CORPORA)
+    parser.add_argument('--queries', nargs='*', default=QUERIES)
+    parser.add_argument('--steps', nargs='*', type=int, default=list(range(1, 9)))
+    parser.add_argument('--traces', type=int, default=200, help='query 마다 만들 입력 script 수')
+    parser.add_argument('--seed', type=int, default=0, help='첫 script 의 seed')
+    parser.add_argument('--mode', choices=['numbers', 'text', 'exact'], default='numbers')
+    parser.add_argument('--procs', type=int, default=os.cpu_count() or 1)
+    parser.add_argument('--chunk', type=int, default=100, help='worker 한 번에 넘기는 script 수')
+    parser.add_argument('--timeout-s', type=int, default=10, help='run 하나의 실제 시간 제한')
+    parser.add_argument('--show', type=int, metavar='SEED', help='script 를 만들어 보여주기만 한다')
+    args = parser.parse_args()
+
+    if args.show is not None:
+        for query in args.queries:
+            print(make_script(query, args.show)[0], end='')
+        return
+
+    jobs, reports = [], {}
+    for corpus in args.corpus:
+        for query in args.queries:
+            base = _binary(corpus, query, 0)
+            if base is None:
+                print(f'[FUZZ] {corpus} {query}: p0 does not build, skipped')
+                continue
+            binaries = {0: str(base)}
+            for step in args.steps:
+                binary = _binary(corpus, query, step)
+                if binary is None:
+                    print(f'[FUZZ] {corpus} {query} p{step}: does not build, skipped')
+                    continue
+                binaries[step] = str(binary)
+                reports[corpus, query, step] = StepReport(corpus, query, step, args.traces)
+            seeds = list(range(args.seed, args.seed + args.traces))
+            for k in range(0, len(seeds), args.chunk):
+                jobs.append(((corpus, query), (query, binaries, seeds[k:k + args.chunk], args.mode, args.timeout_s)))
+
+    start = time.perf_counter()
+    total_runs = 0
+    with multiprocessing.Pool(args.procs) as pool:
+        for (key, _), (runs, diffs) in zip(jobs, pool.imap(_fuzz_chunk, [job for _, job in jobs])):
+            total_runs += runs
+            for step, divergences in diffs.items():
+                reports[(*key, step)].add(divergences)
+    wall = time.perf_counter() - start
+
+    for r in reports.values():
+        share = len(r.diverged) / r.traces * 100 if r.traces else 0
+        channels = ', '.join(f'{c} {n}' for c, n in r.channels.most_common())
+        print(f'[FUZZ] {r.corpus} {r.query} p0 vs p{r.step}: {len(r.diverged)}/{r.traces} traces differ '
+              f'({share:.0f}%){f" [{channels}]" if channels else ""}')
+        if r.example:
+            e = r.example
+            print(f'  seed {e.seed} {e.channel} #{e.index}: p0 {e.base!r} vs p{r.step} {e.other!r}')
+    comparisons = sum(r.traces for r in reports.values())
+    print(f'[FUZZ] {total_runs} runs, {comparisons} comparisons in {wall:.1f}s '
+          f'({total_runs / wall:.0f} runs/s, {comparisons / wall:.0f} comparisons/s, {args.procs} procs)')
+
+
+if __name__ == '__main__':
+    main()
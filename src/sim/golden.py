@@ -0,0 +1,276 @@
+"""
+pipeline 을 다시 돌려 나온 코드가 마지막으로 받아들인 결과와 같은 동작을 하는지 빠르게 확인한다.
+(model, query, step) 마다 입력과 출력 trace 를 golden 파일로 저장(--record)하고,
+새로 빌드한 코드를 저장된 입력 그대로 다시 돌려 처음으로 달라지는 event 를 보여준다.
+
+golden 은 생성 코드 옆 golden_pipe 폴더에 둔다:
+  qwen3/gen_pipe/i1/out_step3_i1_p3.c -> qwen3/golden_pipe/i1/out_step3_i1_p3.gtr
+런타임을 --inputs 로 돌리므로 trace 에는 출력뿐 아니라 입력 event 가 적용된 시각(stim)과
+스케치가 그 입력을 읽은 시각(input)도 들어간다. 입력 script 본문도 golden 에 들어 있어서
+hostsim/scripts 가 바뀌어도 replay 는 녹화할 때의 입력을 쓴다.
+
+파일 형식 (.gtr): 'HSGT' + version 1 byte 뒤에 zlib 으로 압축한 본문.
+본문은 varint 와 (길이 varint + utf-8) 문자열의 나열이다:
+  source hash, duration ms, 입력 script, 상태 ('ok' | 'build failed' | 'exit 134: ...'),
+  stats 수 + (이름, 값)..., 문자열 표 수 + 문자열..., event 수 + (시각 차 us, channel 번호, payload 번호)...
+LCD 줄처럼 반복되는 payload 는 문자열 표에 한 번만 들어간다.
+
+실행:
+  PYTHONPATH=src python -m sim.golden --record                      # 전체 corpus 녹화
+  PYTHONPATH=src python -m sim.golden                               # 전체 corpus replay
+  PYTHONPATH=src python -m sim.golden --corpus qwen3 --queries i1 --ignore-time
+  PYTHONPATH=src python -m sim.golden --show qwen3/golden_pipe/i1/out_step0_i1_p0.gtr
+"""
+
+import argparse
+import hashlib
+import multiprocessing
+import os
+import re
+import time
+import zlib
+from dataclasses import dataclass, field
+from pathlib import Path
+
+from sim.build import build_sketch
+from sim.run import CORPORA, corpus_files, query_of
+from sim.runner import TraceEvent, run_binary, script_for
+from util.compile_check import PROJECT_ROOT
+
+GOLDEN_DIR = 'golden_pipe'
+MAGIC = b'HSGT'
+VERSION = 1
+DURATION_MS = 120_000
+
+# assert 메시지 등에 들어가는 빌드 임시 폴더와 캐시된 binary 이름. 런타임이 바뀌면 달라지므로 지운다
+_BUILD_PATH_RE = re.compile(r'\S*/(?=sketch\.c(?:pp)?:)')
+_BINARY_NAME_RE = re.compile(r'\b[0-9a-f]{16}: ')
+
+
+@dataclass
+class Golden:
+    source: str                 # 생성 코드 hash
+    duration_ms: int
+    script: str                 # 입력 script 본문, 없으면 ''
+    status: str                 # 'ok' | 'build failed' | 런타임 에러
+    stats: dict[str, int] = field(default_factory=dict)
+    events: list[TraceEvent] = field(default_factory=list)
+
+
+@dataclass
+class Divergence:
+    index: int                  # 처음으로 다른 event 의 번호
+    t_us: int
+    expected: str               # '' 이면 golden trace 가 먼저 끝남
+    actual: str                 # '' 이면 새 trace 가 먼저 끝남
+
+    def __str__(self) -> str:
+        return (f'event #{self.index} at {self.t_us / 1000:.3f} ms: '
+                f'expected {self.expected or "<end>"!r}, got {self.actual or "<end>"!r}')
+
+
+# ------- 바이너리 형식
+def _put_varint(out: bytearray, n: int):
+    while n >= 0x80:
+        out.append(n & 0x7f | 0x80)
+        n >>= 7
+    out.append(n)
+
+
+def _put_str(out: bytearray, s: str):
+    data = s.encode('utf-8')
+    _put_varint(out, len(data))
+    out += data
+
+
+class _Reader:
+    def __init__(self, data: bytes):
+        self.data, self.pos = data, 0
+
+    def varint(self) -> int:
+        n = shift = 0
+        while True:
+            b = self.data[self.pos]
+            self.pos += 1
+            n |= (b & 0x7f) << shift
+            if b < 0x80:
+                return n
+            shift += 7
+
+    def str(self) -> str:
+        n = self.varint()
+        self.pos += n
+        return self.data[self.pos - n:self.pos].decode('utf-8')
+
+
+def encode(g: Golden) -> bytes:
+    body = bytearray()
+    _put_str(body, g.source)
+    _put_varint(body, g.duration_ms)
+    _put_str(body, g.script)
+    _put_str(body, g.status)
+    _put_varint(body, len(g.stats))
+    for k, v in g.stats.items():
+        _put_str(body, k)
+        _put_varint(body, v)
+    strings: dict[str, int] = {}
+    for e in g.events:
+        strings.setdefault(e.channel, len(strings))
+        strings.setdefault(e.payload, len(strings))
+    _put_varint(body, len(strings))
+    for s in strings:
+        _put_str(body, s)
+    _put_varint(body, len(g.events))
+    t = 0
+    for e in g.events:
+        _put_varint(body, e.t_us - t)
+        _put_varint(body, strings[e.channel])
+        _put_varint(body, strings[e.payload])
+        t = e.t_us
+    return MAGIC + bytes([VERSION]) + zlib.compress(bytes(body), 9)
+
+
+def decode(data: bytes) -> Golden:
+    if data[:4] != MAGIC or data[4] != VERSION:
+        raise ValueError('not a golden trace (or unknown version)')
+    r = _Reader(zlib.decompress(data[5:]))
+    g = Golden(r.str(), r.varint(), r.str(), r.str())
+    g.stats = {r.str(): r.varint() for _ in range(r.varint())}
+    strings = [r.str() for _ in range(r.varint())]
+    t = 0
+    for _ in range(r.varint()):
+        t += r.varint()
+        g.events.append(TraceEvent(t, strings[r.varint()], strings[r.varint()]))
+    return g
+
+
+def golden_path(src: Path) -> Path:
+    """<out-dir>/gen_pipe/<query>/<name>.c -> <out-dir>/golden_pipe/<query>/<name>.gtr"""
+    if src.parent.parent.name == 'gen_pipe':
+        return src.parent.parent.parent / GOLDEN_DIR / src.parent.name / f'{src.stem}.gtr'
+    return src.with_suffix('.gtr')
+
+
+# ------- 녹화 / replay
+def _source_hash(code: str) -> str:
+    return hashlib.sha256(code.encode('utf-8')).hexdigest()[:16]
+
+
+def execute(code: str, script: str, duration_ms: int) -> Golden:
+    """code 를 빌드해서 script 로 돌린 결과. 빌드/런타임 실패도 상태로 남긴다."""
+    g = Golden(_source_hash(code), duration_ms, script, 'ok')
+    build = build_sketch(code)
+    if not build.ok:
+        g.status = 'build failed'
+        return g
+    res = run_binary(build.binary, script + '\n' if script else None, duration_ms, extra=['--inputs'])
+    g.status = 'ok' if res.ok else _BINARY_NAME_RE.sub('', _BUILD_PATH_RE.sub('', res.error))
+    g.stats, g.events = res.stats, res.events
+    return g
+
+
+def record(src: Path, script: str | None = None, duration_ms: int = DURATION_MS) -> Golden:
+    if script is None:
+        query = query_of(src)
+        path = script_for(query) if query else None
+        script = path.read_text(encoding='utf-8') if path and path.exists() else ''
+    g = execute(src.read_text(encoding='utf-8'), script, duration_ms)
+    out = golden_path(src)
+    out.parent.mkdir(parents=True, exist_ok=True)
+    out.write_bytes(encode(g))
+    return g
+
+
+def first_divergence(expected: list[TraceEvent], actual: list[TraceEvent],
+                     ignore_time: bool = False) -> Divergence | None:
+    def key(e: TraceEvent):
+        return (e.channel, e.payload) if ignore_time else (e.t_us, e.channel, e.payload)
+
+    def text(e: TraceEvent) -> str:
+        return f'{e.channel} {e.payload}' if ignore_time else f'{e.t_us} {e.channel} {e.payload}'
+
+    for i, (a, b) in enumerate(zip(expected, actual)):
+        if key(a) != key(b):
+            return Divergence(i, min(a.t_us, b.t_us), text(a), text(b))
+    n = min(len(expected), len(actual))
+    if len(expected) > n:
+        return Divergence(n, expected[n].t_us, text(expected[n]), '')
+    if len(actual) > n:
+        return Divergence(n, actual[n].t_us, '', text(actual[n]))
+    return None
+
+
+@dataclass
+class ReplayResult:
+    file: str
+    verdict: str                # 'same' | 'diverged' | 'no golden'
+    detail: str = ''
+    source_changed: bool = False
+
+
+def replay(src: Path, ignore_time: bool = False, code: str | None = None) -> ReplayResult:
+    """src 의 golden 입력으로 code (없으면 src 내용)를 다시 돌려 golden 과 비교한다."""
+    path = golden_path(src)
+    if not path.exists():
+        return ReplayResult(str(src), 'no golden')
+    golden = decode(path.read_bytes())
+    code = src.read_text(encoding='utf-8') if code is None else code
+    new = execute(code, golden.script, golden.duration_ms)
+    result = ReplayResult(str(src), 'same', source_changed=new.source != golden.source)
+    if new.status != golden.status:
+        result.verdict, result.detail = 'diverged', f'status {golden.status!r} -> {new.status!r}'
+        return result
+    d = first_divergence(golden.events, new.events, ignore_time)
+    if d:
+        result.verdict, result.detail = 'diverged', str(d)
+    return result
+
+
+def _job(job: tuple) -> tuple[str, str, str, bool]:
+    src, do_record, ignore_time, duration_ms = job
+    if do_record:
+        g = record(Path(src), duration_ms=duration_ms)
+        return src, 'recorded', f'{g.status}, {len(g.events)} events', False
+    r = replay(Path(src), ignore_time)
+    return src, r.verdict, r.detail, r.source_changed
+
+
+def main():
+    parser = argparse.ArgumentParser(description='golden 입출력 trace 녹화와 replay')
+    parser.add_argument('files', nargs='*', help='.c 파일. 비우면 corpus 전체')
+    parser.add_argument('--corpus', nargs='*', default=CORPORA)
+    parser.add_argument('--queries', nargs='*', default=[])
+    parser.add_argument('--steps', nargs='*', type=int, default=None)
+    parser.add_argument('--record', action='store_true', help='replay 대신 golden 을 새로 녹화한다')
+    parser.add_argument('--duration-ms', type=int, default=DURATION_MS, help='녹화할 때 실행 시간')
+    parser.add_argument('--ignore-time', action='store_true', help='event 시각은 비교하지 않는다')
+    parser.add_argument('--procs', type=int, default=os.cpu_count())
+    parser.add_argument('--show', help='golden 파일 내용을 보여준다')
+    args = parser.parse_args()
+
+    if args.show:
+        g = decode(Path(args.show).read_bytes())
+        print(f'[GOLD] source {g.source}, {g.duration_ms} ms, {g.status}, {len(g.events)} events')
+        for e in g.events:
+            print(f'  {e.t_ms:>12.3f} {e.channel:<7} {e.payload}')
+        return
+
+    files = [Path(f) for f in args.files] or corpus_files(args.corpus, args.queries, args.steps)
+    jobs = [(str(f), args.record, args.ignore_time, args.duration_ms) for f in files]
+    start = time.perf_counter()
+    counts: dict[str, int] = {}
+    with multiprocessing.Pool(max(1, args.procs)) as pool:
+        for src, verdict, detail, changed in pool.imap(_job, jobs):
+            f = Path(src).resolve()
+            name = f.relative_to(PROJECT_ROOT) if f.is_relative_to(PROJECT_ROOT) else src
+            counts[verdict] = counts.get(verdict, 0) + 1
+            note = ' (source changed)' if changed else ''
+            print(f'[GOLD] {name}: {verdict}{note}{": " + detail if detail else ""}')
+    summary = ', '.join(f'{n} {v}' for v, n in sorted(counts.items()))
+    print(f'[GOLD] {len(files)} files in {time.perf_counter() - start:.1f} s: {summary}')
+    if counts.get('diverged'):
+        raise SystemExit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,151 @@
+"""
+입력 script 의 event 마다 스케치가 언제 그 입력을 읽었고 그 뒤 출력(LCD/LED/Serial ...)이 언제 바뀌었는지 재서
+입력→출력 latency 분포와 놓친 입력 수를 변형별로 보여준다.
+
+런타임을 --inputs 로 돌리면 trace 에 두 종류 줄이 더 나온다:
+  stim <script 줄>   event 가 적용된 시각 (key/serial 은 큐에 들어감, button/pin 은 level 이 바뀜)
+  input <script 줄>  스케치가 처음 본 시각 (key pop, serial 의 '\\n' 읽음, 바뀐 pin level 읽음, ISR 실행)
+delay() 중에 눌렸다 떼어진 버튼처럼 input 이 끝내 없으면 놓친 입력(dropped)이다.
+기본 입력은 blocking 구간에 입력을 몰아 넣은 hostsim/scripts/latency/<query>.txt 이다.
+
+실행:
+  PYTHONPATH=src python -m sim.latency --corpus qwen3 --queries i1
+  PYTHONPATH=src python -m sim.latency gpt4_1/gen_pipe/i3/out_step8_i3_p8.c --script burst.txt --detail
+"""
+
+import argparse
+import bisect
+import math
+from dataclasses import dataclass, field
+from pathlib import Path
+
+from sim.build import build_sketch
+from sim.run import CORPORA, corpus_files, query_of
+from sim.runner import SCRIPT_DIR, SimResult, run_binary, script_for
+from util.compile_check import PROJECT_ROOT
+
+NOT_OUTPUT = {'stim', 'input', 'end'}
+
+
+def latency_script(query: str) -> Path | None:
+    for path in (SCRIPT_DIR / 'latency' / f'{query}.txt', script_for(query)):
+        if path.exists():
+            return path
+    return None
+
+
+@dataclass
+class InputLatency:
+    line: int                   # script 줄 번호
+    what: str                   # 'key 7' | 'serial' | 'button 2 pin 4' ...
+    t_us: int
+    seen_us: int | None = None  # 스케치가 처음 읽은 시각
+    output_us: int | None = None  # 그 뒤 첫 출력
+
+    @property
+    def dropped(self) -> bool:
+        return self.seen_us is None and not self.unmapped
+
+    @property
+    def unmapped(self) -> bool:
+        """스케치에 해당 장치가 없다 (keypad 가 없거나, k 번째 입력 pin 이 없음)"""
+        return self.what.endswith('unmapped')
+
+    @property
+    def latency_ms(self) -> float | None:
+        return None if self.output_us is None or self.seen_us is None else (self.output_us - self.t_us) / 1000
+
+
+@dataclass
+class LatencyReport:
+    inputs: list[InputLatency] = field(default_factory=list)
+
+    @property
+    def latencies(self) -> list[float]:
+        return sorted(i.latency_ms for i in self.inputs if i.latency_ms is not None)
+
+    @property
+    def dropped(self) -> int:
+        return sum(i.dropped for i in self.inputs)
+
+    @property
+    def no_output(self) -> int:
+        """읽었지만 그 뒤로 아무 출력도 없었던 입력"""
+        return sum(i.seen_us is not None and i.output_us is None for i in self.inputs)
+
+    def percentile(self, q: float) -> float | None:
+        """nearest-rank: 정렬된 값 중 ceil(q% * n) 번째"""
+        values = self.latencies
+        if not values:
+            return None
+        return values[min(len(values) - 1, max(0, math.ceil(q * len(values) / 100) - 1))]
+
+    def summary(self) -> str:
+        counted = [i for i in self.inputs if not i.unmapped]
+        text = f'{len(counted)} inputs, {self.dropped} dropped, {self.no_output} no output'
+        if self.latencies:
+            p50, p90, p99 = (self.percentile(q) for q in (50, 90, 99))
+            text += f', p50 {p50:.1f} ms p90 {p90:.1f} ms p99 {p99:.1f} ms max {self.latencies[-1]:.1f} ms'
+        return text
+
+
+def measure_latency(res: SimResult) -> LatencyReport:
+    """--inputs 로 돌린 trace 에서 입력별 latency 를 만든다."""
+    inputs: dict[int, InputLatency] = {}
+    outputs = []
+    for e in res.events:
+        if e.channel == 'stim':
+            line, _, what = e.payload.partition(' ')
+            inputs[int(line)] = InputLatency(int(line), what, e.t_us)
+        elif e.channel == 'input':
+            inp = inputs.get(int(e.payload))
+            if inp and inp.seen_us is None:
+                inp.seen_us = e.t_us
+        elif e.channel not in NOT_OUTPUT:
+            outputs.append(e.t_us)
+    outputs.sort()
+    for inp in inputs.values():
+        if inp.seen_us is None:
+            continue
+        k = bisect.bisect_left(outputs, inp.seen_us)
+        if k < len(outputs):
+            inp.output_us = outputs[k]
+    return LatencyReport(sorted(inputs.values(), key=lambda i: i.t_us))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='입력→출력 latency 와 놓친 입력')
+    parser.add_argument('files', nargs='*', help='실행할 .c 파일. 비우면 corpus 전체')
+    parser.add_argument('--corpus', nargs='*', default=CORPORA)
+    parser.add_argument('--queries', nargs='*', default=[])
+    parser.add_argument('--steps', nargs='*', type=int, default=None)
+    parser.add_argument('--script', help='입력 event script. 비우면 hostsim/scripts/latency/<query>.txt')
+    parser.add_argument('--duration-ms', type=float, default=120_000)
+    parser.add_argument('--detail', action='store_true', help='입력마다 한 줄씩 보여준다')
+    args = parser.parse_args()
+
+    files = [Path(f) for f in args.files] or corpus_files(args.corpus, args.queries, args.steps)
+    for f in files:
+        name = f.resolve().relative_to(PROJECT_ROOT) if f.resolve().is_relative_to(PROJECT_ROOT) else f
+        query = query_of(f)
+        script = args.script or (latency_script(query) if query else None)
+        if script is None:
+            print(f'[LAT] {name}: no input script')
+            continue
+        build = build_sketch(f.read_text(encoding='utf-8'))
+        if not build.ok:
+            print(f'[LAT] {name}: build failed')
+            continue
+        res = run_binary(build.binary, script, args.duration_ms, extra=['--inputs'])
+        report = measure_latency(res)
+        status = '' if res.ok else f' ({res.error})'
+        print(f'[LAT] {name}: {report.summary()}{status}')
+        if args.detail:
+            for i in report.inputs:
+                seen = f'{(i.seen_us - i.t_us) / 1000:>9.1f}' if i.seen_us is not None else f'{"dropped":>9}'
+                lat = f'{i.latency_ms:>9.1f}' if i.latency_ms is not None else f'{"-":>9}'
+                print(f'  line {i.line:>3} {i.t_us / 1000:>10.1f} ms  {i.what:<22} seen +{seen} ms  output +{lat} ms')
+
+
+if __name__ == '__main__':
+    main()
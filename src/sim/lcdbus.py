@@ -0,0 +1,105 @@
+"""
+LCD 가 bus 에 올린 traffic 을 센다: 글자/명령/clear 수, 선 위의 byte, 100 kHz 와 400 kHz 에서의 bus 시간.
+PCF8574 I2C backpack 은 4-bit mode 라 HD44780 byte 하나가 2-byte I2C transaction 6개이고,
+clear()/home() 은 명령 byte 뒤에 2 ms 를 기다린다.
+
+런타임을 --bus 로 돌리면 실행이 끝날 때 LCD 마다 한 줄이 나온다:
+  bus lcd i2c data=.. commands=.. clears=.. wire_bytes=.. transfers=.. bus_us_100k=.. bus_us_400k=..
+      cpu_us=.. active_s=.. peak_us_per_s_100k=.. peak_us_per_s_400k=..
+peak 은 bus 를 가장 많이 쓴 1초 (실행 시간 기준 정렬된 1초 구간) 의 bus 시간이다.
+매초 두 줄을 지우고 다시 쓰는 loop 는 peak 과 cpu_us 에 바로 드러난다.
+
+실행:
+  PYTHONPATH=src python -m sim.lcdbus
+  PYTHONPATH=src python -m sim.lcdbus --corpus gpt4_1 --queries i4 --duration-ms 60000
+"""
+
+import argparse
+import json
+from dataclasses import asdict, dataclass
+from pathlib import Path
+
+from sim.build import build_sketch
+from sim.run import CORPORA, corpus_files, query_of
+from sim.runner import SimResult, run_binary, script_for
+from util.compile_check import PROJECT_ROOT
+
+
+@dataclass
+class LcdBus:
+    channel: str            # lcd | lcd1 ...
+    wiring: str             # i2c | parallel
+    data: int
+    commands: int
+    clears: int
+    wire_bytes: int
+    transfers: int
+    bus_us_100k: int
+    bus_us_400k: int
+    cpu_us: int             # LCD 호출이 프로그램을 붙잡은 시간 (설정된 clock 기준, clear 대기 포함)
+    active_s: int           # traffic 이 있었던 초의 수
+    peak_us_per_s_100k: int
+    peak_us_per_s_400k: int
+
+    def summary(self, run_us: int) -> str:
+        text = (f'{self.channel} {self.wiring}: {self.data} chars, {self.commands} cmds, {self.clears} clears, '
+                f'{self.wire_bytes} wire bytes')
+        if self.wiring == 'i2c':
+            text += (f'; bus {self.bus_us_100k / 1e6:.2f} s @100k / {self.bus_us_400k / 1e6:.2f} s @400k'
+                     f'; busiest second {self.peak_us_per_s_100k / 1e4:.1f}% @100k / '
+                     f'{self.peak_us_per_s_400k / 1e4:.1f}% @400k')
+        else:
+            text += f'; bus {self.bus_us_100k / 1e6:.2f} s, busiest second {self.peak_us_per_s_100k / 1e4:.1f}%'
+        if run_us:
+            text += f'; LCD calls held the CPU {self.cpu_us / run_us * 100:.2f}% of the run'
+        return text
+
+
+def parse_bus(res: SimResult) -> list[LcdBus]:
+    buses = []
+    for e in res.events:
+        if e.channel != 'bus':
+            continue
+        channel, wiring, *fields = e.payload.split()
+        values = {k: int(v) for k, _, v in (f.partition('=') for f in fields)}
+        buses.append(LcdBus(channel, wiring, **values))
+    return buses
+
+
+def main():
+    parser = argparse.ArgumentParser(description='LCD bus traffic')
+    parser.add_argument('files', nargs='*', help='실행할 .c 파일. 비우면 corpus 전체')
+    parser.add_argument('--corpus', nargs='*', default=CORPORA)
+    parser.add_argument('--queries', nargs='*', default=[])
+    parser.add_argument('--steps', nargs='*', type=int, default=None)
+    parser.add_argument('--script', help='입력 event script. 비우면 hostsim/scripts/<query>.txt')
+    parser.add_argument('--duration-ms', type=float, default=3_600_000)
+    parser.add_argument('--json', help='결과를 JSON 으로 저장할 경로')
+    args = parser.parse_args()
+
+    files = [Path(f) for f in args.files] or corpus_files(args.corpus, args.queries, args.steps)
+    results = {}
+    for f in files:
+        name = f.resolve().relative_to(PROJECT_ROOT) if f.resolve().is_relative_to(PROJECT_ROOT) else f
+        build = build_sketch(f.read_text(encoding='utf-8'))
+        if not build.ok:
+            print(f'[BUS] {name}: build failed')
+            continue
+        query = query_of(f)
+        script = args.script or (script_for(query) if query and script_for(query).exists() else None)
+        res = run_binary(build.binary, script, args.duration_ms, extra=['--bus'])
+        buses = parse_bus(res)
+        run_us = res.stats.get('end_us', 0)
+        results[str(name)] = {'run_us': run_us, 'lcds': [asdict(b) for b in buses], 'error': res.error}
+        status = '' if res.ok else f' ({res.error})'
+        if not buses:
+            print(f'[BUS] {name}: no LCD{status}')
+        for b in buses:
+            print(f'[BUS] {name}: {b.summary(run_us)}{status}')
+
+    if args.json:
+        Path(args.json).write_text(json.dumps(results, ensure_ascii=False, indent=1), encoding='utf-8')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,210 @@
+"""
+noInterrupts()/portENTER_CRITICAL() 로 interrupt 를 막은 시간을 호출한 줄마다 재서
+가장 긴 구간과 길이 분포(histogram)를 보여주고, prompt step 별로 real-time 위험을 줄 세운다.
+
+런타임을 --masks 로 돌리면 실행이 끝날 때 막은 위치와 호출 경로마다 한 줄이 나온다:
+  mask <file:line> <return address,...> <횟수> <합계 us> <최대 us> <끝까지 안 풀린 횟수> <bucket 7개>
+bucket 은 <10us, <100us, <1ms, <10ms, <100ms, <1s, >=1s 이다. 중첩된 critical section 은 가장 바깥 것만 센다.
+return address 는 addr2line 으로 스케치 줄로 바꿔서, EnterCriticalSection() 같은 wrapper 안의 줄을
+그 wrapper 를 부른 함수(caller)와 함께 보여준다.
+
+실행:
+  PYTHONPATH=src python -m sim.masks
+  PYTHONPATH=src python -m sim.masks --corpus qwen3 --queries i1 --detail
+"""
+
+import argparse
+import json
+import subprocess
+from dataclasses import asdict, dataclass, field
+from pathlib import Path
+
+from sim.build import build_sketch
+from sim.run import CORPORA, _STEP_RE, corpus_files, paired_steps, query_of, variant_of
+from sim.runner import SimResult, run_binary, script_for
+from util.c_source import line_of, scan_top_level
+from util.compile_check import PROJECT_ROOT
+
+BUCKETS = ['<10us', '<100us', '<1ms', '<10ms', '<100ms', '<1s', '>=1s']
+
+
+@dataclass
+class MaskSite:
+    line: int
+    func: str           # 줄이 속한 함수, 없으면 ''
+    caller: str         # 그 함수를 부른 스케치 쪽 'func:line', 모르면 ''
+    count: int
+    total_us: int
+    max_us: int
+    open: int           # 실행이 끝날 때까지 풀리지 않음
+    hist: list[int]
+
+    @property
+    def where(self) -> str:
+        where = f'{self.func}:{self.line}' if self.func else f'line {self.line}'
+        return f'{where} from {self.caller}' if self.caller else where
+
+    def merge(self, other: 'MaskSite'):
+        self.count += other.count
+        self.total_us += other.total_us
+        self.max_us = max(self.max_us, other.max_us)
+        self.open += other.open
+        self.hist = [a + b for a, b in zip(self.hist, other.hist)]
+
+
+@dataclass
+class MaskReport:
+    file: str
+    step: int
+    query: str
+    run_us: int = 0
+    sites: list[MaskSite] = field(default_factory=list)
+    error: str = ''
+
+    @property
+    def worst(self) -> MaskSite | None:
+        return max(self.sites, key=lambda s: s.max_us, default=None)
+
+    @property
+    def masked_us(self) -> int:
+        return sum(s.total_us for s in self.sites)
+
+    @property
+    def hazards(self) -> int:
+        """1 ms 이상 막은 구간 수. 이만큼 막으면 tick, UART, 버튼 interrupt 를 놓친다"""
+        return sum(sum(s.hist[3:]) for s in self.sites)
+
+
+def _functions(code: str) -> list[tuple[int, int, str]]:
+    return [(line_of(code, s.start) + 1, line_of(code, s.end) + 1, s.name)
+            for s in scan_top_level(code) if s.kind == 'function']
+
+
+def _symbolize(binary: Path, offsets: set[int]) -> dict[int, list[int]]:
+    """
+    return address -> 스케치 안의 줄 목록 (inline 된 것부터 바깥쪽으로). 런타임 frame 은 빠진다.
+    -i 일 때 addr2line 이 붙이는 함수 이름은 inline 경계에서 한 칸씩 어긋나므로 줄 번호만 쓴다.
+    """
+    offsets = sorted(offsets)
+    if not offsets:
+        return {}
+    # return address 는 call 다음 명령이라 1 을 빼야 호출한 줄이 나온다
+    proc = subprocess.run(['addr2line', '-a', '-i', '-e', str(binary), *(hex(o - 1) for o in offsets)],
+                          capture_output=True, text=True)
+    frames: dict[int, list[int]] = {}
+    current = None
+    for ln in proc.stdout.splitlines():
+        if ln.startswith('0x'):
+            current = frames.setdefault(int(ln, 16) + 1, [])
+            continue
+        file, _, line = ln.rpartition(':')
+        line = line.split(' ')[0]
+        if current is not None and Path(file).name.startswith('sketch.') and line.isdigit():
+            current.append(int(line))
+    return frames
+
+
+def parse_masks(res: SimResult, code: str, binary: Path | None = None) -> list[MaskSite]:
+    """--masks 로 돌린 trace 의 mask 줄을 읽는다. 줄 번호로 원본 함수 이름을 찾는다."""
+    funcs = _functions(code)
+
+    def func_at(line: int) -> str:
+        return next((name for start, end, name in funcs if start <= line <= end), '')
+
+    rows = []
+    for e in res.events:
+        if e.channel != 'mask':
+            continue
+        site, chain, *nums = e.payload.split()
+        line = site.rpartition(':')[2]
+        if not line.isdigit() or len(nums) != 4 + len(BUCKETS):
+            continue   # SREG 처럼 줄이 없는 위치
+        offsets = [] if chain == '-' else [int(o, 16) for o in chain.split(',')]
+        rows.append((int(line), offsets, list(map(int, nums))))
+
+    symbols = _symbolize(binary, {o for _, offsets, _ in rows for o in offsets}) if binary else {}
+    merged: dict[tuple[int, str], MaskSite] = {}
+    for line, offsets, (count, total, mx, open_, *hist) in rows:
+        func = func_at(line)
+        # 막은 줄이 있는 함수 바깥으로 처음 나가는 스케치 frame 이 caller
+        caller = next((f'{func_at(ln)}:{ln}' for o in offsets for ln in symbols.get(o, [])
+                       if func_at(ln) != func), '')
+        site = MaskSite(line, func, caller, count, total, mx, open_, hist)
+        if (line, caller) in merged:
+            merged[line, caller].merge(site)
+        else:
+            merged[line, caller] = site
+    return sorted(merged.values(), key=lambda s: -s.max_us)
+
+
+def _ms(us: int) -> str:
+    return f'{us / 1000:.3f} ms' if us < 10_000 else f'{us / 1000:.0f} ms'
+
+
+def main():
+    parser = argparse.ArgumentParser(description='interrupt 를 막은 시간 (call site 별)')
+    parser.add_argument('files', nargs='*', help='실행할 .c 파일. 비우면 corpus 전체')
+    parser.add_argument('--corpus', nargs='*', default=CORPORA)
+    parser.add_argument('--queries', nargs='*', default=[])
+    parser.add_argument('--steps', nargs='*', type=int, default=None)
+    parser.add_argument('--script', help='입력 event script. 비우면 hostsim/scripts/<query>.txt')
+    parser.add_argument('--duration-ms', type=float, default=3_600_000)
+    parser.add_argument('--detail', action='store_true', help='위치마다 histogram 을 보여준다')
+    parser.add_argument('--json', help='결과를 JSON 으로 저장할 경로')
+    args = parser.parse_args()
+
+    files = [Path(f) for f in args.files] or corpus_files(args.corpus, args.queries, args.steps)
+    reports = []
+    for f in files:
+        name = f.resolve().relative_to(PROJECT_ROOT) if f.resolve().is_relative_to(PROJECT_ROOT) else f
+        m = _STEP_RE.search(f.name)
+        report = MaskReport(str(name), int(m[1]) if m else -1, query_of(f) or '')
+        reports.append(report)
+        code = f.read_text(encoding='utf-8')
+        build = build_sketch(code)
+        if not build.ok:
+            report.error = 'build failed'
+            print(f'[MASK] {name}: build failed')
+            continue
+        query = report.query
+        script = args.script or (script_for(query) if query and script_for(query).exists() else None)
+        res = run_binary(build.binary, script, args.duration_ms, extra=['--masks'])
+        report.run_us = res.stats.get('end_us', 0)
+        report.sites = parse_masks(res, code, build.binary)
+        report.error = '' if res.ok else res.error
+        status = f' ({res.error})' if not res.ok else ''
+        worst = report.worst
+        if worst is None:
+            print(f'[MASK] {name}: no masked sections{status}')
+            continue
+        share = report.masked_us / report.run_us * 100 if report.run_us else 0
+        print(f'[MASK] {name}: {len(report.sites)} sites, max {_ms(worst.max_us)} at {worst.where}, '
+              f'{report.hazards} spans >= 1 ms, masked {share:.2f}% of run{status}')
+        if args.detail:
+            for s in report.sites:
+                hist = ' '.join(f'{b}:{n}' for b, n in zip(BUCKETS, s.hist) if n)
+                never = f', {s.open} never re-enabled' if s.open else ''
+                print(f'  {s.where:<44} x{s.count:<7} max {_ms(s.max_us):>10} total {_ms(s.total_us):>10}  {hist}{never}')
+
+    # step 별 순위: 끝까지 돈 변형의 가장 긴 구간이 같은 (model, query) 의 p0 보다 평균 얼마나 늘었나
+    by_file = {(variant_of(Path(r.file)), r.step): r for r in reports if not r.error}
+    paired = paired_steps({k: r.worst.max_us if r.worst else 0 for k, r in by_file.items()})
+    print('[MASK] prompt steps by longest masked span, mean change from p0 (model/query pairs that ran at both):')
+    for step, rows in sorted(paired.items(), key=lambda kv: -sum(d for _, _, d in kv[1]) / len(kv[1])):
+        rs = [by_file[v, step] for v, _, _ in rows]
+        delta = sum(d for _, _, d in rows) / len(rows)
+        worst = max((r for r in rs if r.worst), key=lambda r: r.worst.max_us, default=None)
+        hazardous = sum(r.hazards > 0 for r in rs)
+        where = f'{Path(worst.file).parent.parent.parent.name}/{Path(worst.file).name} {worst.worst.where}' \
+            if worst else '-'
+        max_us = worst.worst.max_us if worst else 0
+        print(f'  p{step}: {"+" if delta >= 0 else "-"}{_ms(abs(round(delta)))}, {hazardous}/{len(rs)} files '
+              f'mask >= 1 ms, max {_ms(max_us)} ({where})')
+
+    if args.json:
+        Path(args.json).write_text(json.dumps([asdict(r) for r in reports], ensure_ascii=False, indent=1),
+                                   encoding='utf-8')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,120 @@
+"""
+가상 시간을 CPU 가 일한 시간(busy), delay()/vTaskDelay() 로 잔 시간(delay), 입력을 기다리며 할 일이 없던 시간(idle)으로 나눠
+변형마다 active CPU 비율과 1시간 운전의 소비 전력량을 어림하고, prompt step 별로 줄 세운다.
+
+busy 에는 API 호출 비용, millis()/digitalRead()/Serial.available() busy-wait polling, delayMicroseconds,
+LCD/UART 를 기다리며 도는 시간이 들어간다. 그래서 delay 대신 polling 으로 기다리는 변형은 busy 가 커진다.
+시간 분류는 런타임이 trace 첫 줄(busy_us, delay_us, idle_us)에 남긴다.
+입력 script 가 끝난 뒤로 출력이 없는 run (SimResult.stalled) 은 멈춘 채 시간을 보낸 것이라 순위에서 뺀다.
+
+전류는 ESP32-S3 datasheet 의 대략적인 값 (3.3 V, RF off, 240 MHz):
+  busy 50 mA, CPU 가 쉬는 동안 (idle task 의 WAITI) 33 mA, automatic light sleep 0.24 mA
+
+실행:
+  PYTHONPATH=src python -m sim.power
+  PYTHONPATH=src python -m sim.power --corpus gpt4_1 --queries i3 --busy-ma 60
+"""
+
+import argparse
+from dataclasses import dataclass
+from pathlib import Path
+
+from sim.build import build_sketch
+from sim.run import CORPORA, _STEP_RE, corpus_files, paired_steps, query_of, variant_of
+from sim.runner import run_binary, script_end_us, script_for
+from util.compile_check import PROJECT_ROOT
+
+VOLTAGE = 3.3
+
+
+@dataclass
+class PowerModel:
+    busy_ma: float = 50.0
+    wait_ma: float = 33.0           # 전원 관리 없이 idle task 가 WAITI 로 쉴 때
+    light_sleep_ma: float = 0.24    # CONFIG_PM_ENABLE + automatic light sleep
+
+
+@dataclass
+class PowerReport:
+    file: str
+    step: int
+    busy_us: int
+    delay_us: int
+    idle_us: int
+
+    @property
+    def total_us(self) -> int:
+        return self.busy_us + self.delay_us + self.idle_us
+
+    def share(self, us: int) -> float:
+        return us / self.total_us if self.total_us else 0.0
+
+    @property
+    def busy_share(self) -> float:
+        return self.share(self.busy_us)
+
+    def mwh_per_hour(self, model: PowerModel, light_sleep: bool = False) -> float:
+        rest_ma = model.light_sleep_ma if light_sleep else model.wait_ma
+        return VOLTAGE * (self.busy_share * model.busy_ma + (1 - self.busy_share) * rest_ma)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='CPU busy/delay/idle 시간과 전력량')
+    parser.add_argument('files', nargs='*', help='실행할 .c 파일. 비우면 corpus 전체')
+    parser.add_argument('--corpus', nargs='*', default=CORPORA)
+    parser.add_argument('--queries', nargs='*', default=[])
+    parser.add_argument('--steps', nargs='*', type=int, default=None)
+    parser.add_argument('--script', help='입력 event script. 비우면 hostsim/scripts/<query>.txt')
+    parser.add_argument('--duration-ms', type=float, default=3_600_000)
+    parser.add_argument('--busy-ma', type=float, default=PowerModel.busy_ma)
+    parser.add_argument('--wait-ma', type=float, default=PowerModel.wait_ma)
+    parser.add_argument('--light-sleep-ma', type=float, default=PowerModel.light_sleep_ma)
+    args = parser.parse_args()
+    model = PowerModel(args.busy_ma, args.wait_ma, args.light_sleep_ma)
+
+    files = [Path(f) for f in args.files] or corpus_files(args.corpus, args.queries, args.steps)
+    reports, stalled = [], []
+    for f in files:
+        name = f.resolve().relative_to(PROJECT_ROOT) if f.resolve().is_relative_to(PROJECT_ROOT) else f
+        build = build_sketch(f.read_text(encoding='utf-8'))
+        if not build.ok:
+            print(f'[PWR] {name}: build failed')
+            continue
+        query = query_of(f)
+        script = args.script or (script_for(query) if query and script_for(query).exists() else None)
+        res = run_binary(build.binary, script, args.duration_ms)
+        if not res.ok:
+            print(f'[PWR] {name}: {res.error}')
+            continue
+        m = _STEP_RE.search(f.name)
+        r = PowerReport(str(name), int(m[1]) if m else -1,
+                        res.stats.get('busy_us', 0), res.stats.get('delay_us', 0), res.stats.get('idle_us', 0))
+        stall = res.stalled(script)
+        (stalled if stall else reports).append(r)
+        print(f'[PWR] {name}: busy {r.busy_share * 100:5.1f}% delay {r.share(r.delay_us) * 100:5.1f}% '
+              f'idle {r.share(r.idle_us) * 100:5.1f}%, {r.mwh_per_hour(model):.0f} mWh/h '
+              f'({r.mwh_per_hour(model, light_sleep=True):.1f} mWh/h with light sleep)'
+              + (f' STALLED (no output after {script_end_us(script) / 1e6:.1f}s)' if stall else ''))
+
+    if stalled:
+        print(f'[PWR] {len(stalled)} stalled runs left out of the rankings')
+    if not reports:
+        return
+    print('[PWR] most busy (worst for battery):')
+    for r in sorted(reports, key=lambda r: -r.busy_share)[:10]:
+        print(f'  {r.busy_share * 100:5.1f}% busy  {r.file}')
+    # 같은 (model, query) 의 p0 와 비교한 변화로 줄 세운다 (step 마다 돈 변형이 달라도 평균이 흔들리지 않게)
+    by_file = {(variant_of(Path(r.file)), r.step): r for r in reports}
+    paired = paired_steps({k: r.busy_share for k, r in by_file.items()})
+    print('[PWR] prompt steps by mean busy share change from p0 (model/query pairs that ran at both):')
+    for step, rows in sorted(paired.items(), key=lambda kv: -sum(d for _, _, d in kv[1]) / len(kv[1])):
+        rs = [by_file[v, step] for v, _, _ in rows]
+        busy = sum(r.busy_share for r in rs) / len(rs)
+        delta = round(sum(d for _, _, d in rows) / len(rows), 4) + 0.0   # -0.0 없이
+        sleep = sum(r.mwh_per_hour(model, light_sleep=True) for r in rs) / len(rs)
+        print(f'  p{step}: {delta * 100:+6.1f} pt, {busy * 100:5.1f}% busy over {len(rs)} pairs, '
+              f'{sum(r.mwh_per_hour(model) for r in rs) / len(rs):.0f} mWh/h ({sleep:.1f} with light sleep)')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,94 @@
+"""
+corpus 의 생성 코드를 host 에서 가상 시간으로 실행한다.
+
+실행:
+  PYTHONPATH=src python -m sim.run                                  # 전체 corpus, query 별 기본 script, 1시간
+  PYTHONPATH=src python -m sim.run --corpus qwen3 --queries i1 --steps 0 --trace
+  PYTHONPATH=src python -m sim.run qwen3/gen_pipe/i5/out_step3_i5_p3.c --script my_events.txt --duration-ms 60000
+"""
+
+import argparse
+import re
+from pathlib import Path
+
+from sim.build import build_sketch
+from sim.runner import run_binary, script_for
+from util.compile_check import PROJECT_ROOT
+
+CORPORA = ['qwen3', 'gpt4_1']
+
+_STEP_RE = re.compile(r'out_step(\d+)_(i\d+)_(p\d+)\.c$')
+
+
+def corpus_files(corpora: list[str], queries: list[str] | None = None,
+                 steps: list[int] | None = None) -> list[Path]:
+    files = []
+    for corpus in corpora:
+        for f in sorted((PROJECT_ROOT / corpus / 'gen_pipe').glob('i*/out_step*.c')):
+            m = _STEP_RE.search(f.name)
+            if m and (not queries or m[2] in queries) and (steps is None or int(m[1]) in steps):
+                files.append(f)
+    return files
+
+
+def query_of(path: Path) -> str | None:
+    m = _STEP_RE.search(path.name)
+    return m[2] if m else None
+
+
+def variant_of(path: Path) -> str:
+    """<corpus>/gen_pipe/<query>/out_step*.c -> '<corpus>/<query>'. step 끼리 비교하는 단위."""
+    if path.parent.parent.name == 'gen_pipe':
+        return f'{path.parent.parent.parent.name}/{path.parent.name}'
+    return f'{path.parent.name}/{query_of(path) or path.stem}'
+
+
+def paired_steps(values: dict[tuple[str, int], float], base: int = 0) -> dict[int, list[tuple[str, float, float]]]:
+    """
+    {(variant, step): 값} -> {step: [(variant, 값, base step 대비 변화)]}. base step 도 돈 variant 만 남긴다.
+    step 별 평균을 그냥 내면 빌드가 깨진 step 은 그 변형이 빠져서 좋아/나빠 보이므로 step 은 이 변화로 비교한다.
+    """
+    out: dict[int, list[tuple[str, float, float]]] = {}
+    for (variant, step), value in sorted(values.items()):
+        if (variant, base) in values:
+            out.setdefault(step, []).append((variant, value, value - values[variant, base]))
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description='hostsim 가상 시간 실행')
+    parser.add_argument('files', nargs='*', help='실행할 .c 파일. 비우면 corpus 전체')
+    parser.add_argument('--corpus', nargs='*', default=CORPORA)
+    parser.add_argument('--queries', nargs='*', default=[])
+    parser.add_argument('--steps', nargs='*', type=int, default=None)
+    parser.add_argument('--script', help='입력 event script. 비우면 hostsim/scripts/<query>.txt')
+    parser.add_argument('--duration-ms', type=float, default=3_600_000)
+    parser.add_argument('--trace', action='store_true', help='출력 trace 를 그대로 보여준다')
+    args = parser.parse_args()
+
+    files = [Path(f) for f in args.files] or corpus_files(args.corpus, args.queries, args.steps)
+    failed = 0
+    for f in files:
+        name = f.resolve().relative_to(PROJECT_ROOT) if f.resolve().is_relative_to(PROJECT_ROOT) else f
+        build = build_sketch(f.read_text(encoding='utf-8'))
+        if not build.ok:
+            failed += 1
+            print(f'[SIM] {name}: build failed ({build.lang}) {build.errors[0] if build.errors else ""}')
+            continue
+        query = query_of(f)
+        script = args.script or (script_for(query) if query and script_for(query).exists() else None)
+        res = run_binary(build.binary, script, args.duration_ms)
+        if not res.ok:
+            failed += 1
+        outputs = len([e for e in res.events if e.channel != 'end'])
+        status = 'ok' if res.ok else res.error
+        print(f'[SIM] {name}: {res.simulated:.1f}s simulated in {res.wall * 1000:.1f} ms, '
+              f'{outputs} outputs, {res.stats.get("loops", 0)} loops ({status})')
+        if args.trace:
+            for e in res.events:
+                print(f'  {e.t_ms:>12.3f} {e.channel:<7} {e.payload}')
+    print(f'[SIM] {len(files) - failed}/{len(files)} ran')
+
+
+if __name__ == '__main__':
+    main()
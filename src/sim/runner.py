@@ -0,0 +1,119 @@
+"""
+빌드된 스케치를 가상 시간으로 실행하고 출력 trace 를 읽는다.
+
+입력 script (한 줄에 event 하나, 시간은 ms):
+  1500 key 7            keypad 입력 (100 ms 동안 눌림, `1500 key 7 80` 이면 80 ms)
+  2000 serial I 9 30    Serial 로 한 줄 (끝에 '\\n' 이 붙는다)
+  2500 pin 4 0          pin level
+  3000 button 2 150     스케치가 pinMode 로 설정한 k 번째 입력 pin 을 150 ms 동안 누름
+  3500 adc 36 2048
+
+출력 trace (한 줄에 출력 하나, 시간은 us):
+  2003600 lcd 0:Calculator Ready     LCD row 0 의 내용 (뒤 공백 제거)
+  2004000 pin 2 1                    digitalWrite / gpio_set_level
+  2005000 serial Change: 50          Serial 한 줄
+"""
+
+import os
+import re
+import subprocess
+import tempfile
+import time
+from dataclasses import dataclass, field
+from pathlib import Path
+
+from util.compile_check import PROJECT_ROOT
+
+SCRIPT_DIR = PROJECT_ROOT / 'hostsim' / 'scripts'
+
+_HEADER_RE = re.compile(r'(\w+)=(\d+)')
+OUTPUT_CHANNELS = ('lcd', 'serial', 'log', 'pin', 'pwm')
+
+
+@dataclass
+class TraceEvent:
+    t_us: int
+    channel: str        # lcd | pin | pwm | serial | log | lcdctl | end ...
+    payload: str
+
+    @property
+    def t_ms(self) -> float:
+        return self.t_us / 1000
+
+
+@dataclass
+class SimResult:
+    ok: bool
+    events: list[TraceEvent] = field(default_factory=list)
+    stats: dict[str, int] = field(default_factory=dict)    # trace 첫 줄의 end_us, loops, api_calls ...
+    wall: float = 0.0                                       # 실제로 걸린 초
+    error: str = ''
+
+    @property
+    def simulated(self) -> float:
+        """시뮬레이션된 초"""
+        return self.stats.get('end_us', 0) / 1e6
+
+    def channel(self, name: str) -> list[TraceEvent]:
+        return [e for e in self.events if e.channel == name]
+
+    def stalled(self, script: str | Path | None = None) -> bool:
+        """
+        정상 종료했지만 입력 script 의 마지막 입력 뒤로 출력이 하나도 없는 run (script 가 없으면 출력이 전혀 없는 run).
+        deadlock 이나 빠져나오지 못하는 busy-wait 처럼 멈춘 변형이라 busy/latency 비교에서 뺀다.
+        """
+        end = script_end_us(script)
+        return self.ok and not any(e.channel in OUTPUT_CHANNELS and e.t_us >= end for e in self.events)
+
+
+def parse_trace(text: str) -> tuple[dict[str, int], list[TraceEvent]]:
+    stats, events = {}, []
+    for line in text.splitlines():
+        if line.startswith('#'):
+            stats.update({k: int(v) for k, v in _HEADER_RE.findall(line)})
+            continue
+        t, _, rest = line.partition(' ')
+        channel, _, payload = rest.partition(' ')
+        if t.isdigit():
+            events.append(TraceEvent(int(t), channel, payload))
+    return stats, events
+
+
+def script_end_us(script: str | Path | None) -> int:
+    """script 의 마지막 event 시각 (us). script 는 파일 경로이거나 본문 문자열."""
+    if script is None:
+        return 0
+    text = script if isinstance(script, str) and '\n' in script else Path(script).read_text(encoding='utf-8')
+    times = [ln.split()[0] for ln in text.splitlines() if ln.strip() and not ln.lstrip().startswith('#')]
+    return max((int(float(t) * 1000) for t in times if t.replace('.', '', 1).isdigit()), default=0)
+
+
+def script_for(query: str) -> Path:
+    """query 별 기본 입력 script (hostsim/scripts/<query>.txt)"""
+    return SCRIPT_DIR / f'{query}.txt'
+
+
+def run_binary(binary: Path, script: str | Path | None = None, duration_ms: float = 60_000,
+               timeout: float = 30.0, extra: list[str] | None = None,
+               env: dict[str, str] | None = None) -> SimResult:
+    """script 는 파일 경로이거나 script 본문 문자열. env 는 환경 변수에 더한다."""
+    with tempfile.TemporaryDirectory() as tmp:
+        cmd = [str(binary), '--duration-ms', str(duration_ms), '--trace', '-', *(extra or [])]
+        if script is not None:
+            if isinstance(script, str) and '\n' in script:
+                path = Path(tmp) / 'script.txt'
+                path.write_text(script, encoding='utf-8')
+                script = path
+            cmd += ['--script', str(script)]
+        start = time.perf_counter()
+        try:
+            proc = subprocess.run(cmd, capture_output=True, timeout=timeout,
+                                  env={**os.environ, **env} if env else None)
+        except subprocess.TimeoutExpired:
+            return SimResult(False, wall=time.perf_counter() - start, error=f'timeout after {timeout}s')
+        wall = time.perf_counter() - start
+    stats, events = parse_trace(proc.stdout.decode('utf-8', errors='replace'))
+    if proc.returncode != 0:
+        err = proc.stderr.decode('utf-8', errors='replace').strip().splitlines()
+        return SimResult(False, events, stats, wall, f'exit {proc.returncode}: {err[-1] if err else ""}')
+    return SimResult(True, events, stats, wall)
@@ -0,0 +1,357 @@
+"""
+FreeRTOS 변형의 task 전환, ISR, queue/mutex 동작, LCD bus 전송을 시간 축에 펼쳐 Chrome trace JSON 으로 내보낸다.
+ui.perfetto.dev 나 chrome://tracing 에서 열면 elevator_task 가 elevators_mutex 를 잡고 있는 동안
+button_task 가 얼마나 기다리는지, gpio_isr_handler 가 gpio_evt_queue 에 넣은 event 가 언제 꺼내지는지 보인다.
+
+런타임 --timeline 은 ring buffer (기본 262144 개) 에 최근 record 만 남긴다. 줄마다 '<t_us> <dur_us> <종류> <a> <b> <c>':
+  switch a→b, idle (dur 동안 ready task 없음), isr/isr_end (pin, handler offset), block/wake (task, 기다린 것),
+  send/receive/take/give (task 또는 -1 = ISR, queue/semaphore, 남은 개수), inherit (holder, mutex, 받은 priority),
+  bus (LCD, wire byte 수, dur = 전송이 CPU 를 잡은 시간)
+queue/semaphore 이름은 만든 줄 (sketch.c:621) 이라서 그 줄의 대입문으로 변수 이름을 찾는다.
+
+track:
+  CPU                       지금 도는 task
+  task <prio> <name>        wait <mutex|queue> / delay / hold <mutex> 구간, send/receive 표시
+  ISR                       handler 실행
+  bus lcd i2c               LCD 전송 (이어지는 전송은 하나로 묶는다)
+  queue 깊이                counter
+
+priority inversion 은 task 가 mutex 를 기다리는 동안 그보다 priority 가 낮은, holder 가 아닌 task 가 CPU 를 쓴 시간이다.
+
+실행:
+  PYTHONPATH=src python -m sim.timeline                                   # gpt4_1 i1, i2, i4
+  PYTHONPATH=src python -m sim.timeline gpt4_1/gen_pipe/i4/out_step8_i4_p8.c --out /tmp/tl
+"""
+
+import argparse
+import json
+import re
+import subprocess
+import tempfile
+from dataclasses import dataclass, field
+from pathlib import Path
+
+from sim.build import BUILD_DIR, build_sketch
+from sim.run import corpus_files, query_of
+from sim.runner import run_binary, script_for
+from util.compile_check import PROJECT_ROOT, prepare_source
+
+TIMELINE_CORPORA = ['gpt4_1']
+TIMELINE_QUERIES = ['i1', 'i2', 'i4']      # ESP-IDF (FreeRTOS task) 변형
+TIMELINE_SIZE = 1 << 18
+
+CPU_TID, ISR_TID = 1, 2
+TASK_TID, BUS_TID = 100, 1000
+
+_SITE_RE = re.compile(r'^(\S+) sketch\.c(?:pp)?:(\d+)$')
+_CREATE_RE = re.compile(r'(\w+)\s*=\s*x(?:Semaphore|Queue)Create')
+
+
+@dataclass
+class Record:
+    t: int
+    dur: int
+    what: str
+    a: int
+    b: int
+    c: int
+
+
+@dataclass
+class Timeline:
+    capacity: int = 0
+    recorded: int = 0
+    names: dict[int, str] = field(default_factory=dict)
+    records: list[Record] = field(default_factory=list)
+
+    @property
+    def wrapped(self) -> bool:
+        return self.recorded > self.capacity
+
+    def kind(self, id: int) -> str:
+        return self.names.get(id, '').split(' ', 1)[0]
+
+    def label(self, id: int) -> str:
+        """'task 5 elevator_task' -> 'elevator_task', 'mutex elevators_mutex' -> 'elevators_mutex'"""
+        name = self.names.get(id, f'#{id}')
+        if name.startswith('task '):
+            return name.split(' ', 2)[-1]
+        return name.split(' ', 1)[-1]
+
+    def prio(self, id: int) -> int:
+        parts = self.names.get(id, '').split(' ')
+        return int(parts[1]) if parts[0] == 'task' and parts[1].lstrip('-').isdigit() else 0
+
+
+def parse_timeline(text: str) -> Timeline:
+    tl = Timeline()
+    for line in text.splitlines():
+        if line.startswith('#'):
+            stats = dict(re.findall(r'(\w+)=(\d+)', line))
+            tl.capacity, tl.recorded = int(stats.get('capacity', 0)), int(stats.get('recorded', 0))
+        elif line.startswith('name '):
+            _, id, name = line.split(' ', 2)
+            tl.names[int(id)] = name
+        elif line:
+            t, dur, what, a, b, c = line.split(' ')
+            tl.records.append(Record(int(t), int(dur), what, int(a), int(b), int(c)))
+    return tl
+
+
+def name_sites(tl: Timeline, code: str):
+    """'mutex sketch.c:621' -> 'mutex elevators_mutex' (그 줄에 대입문이 있을 때)"""
+    lines = prepare_source(code)[0].splitlines()
+    for id, name in tl.names.items():
+        m = _SITE_RE.match(name)
+        line = int(m.group(2)) if m else 0
+        var = _CREATE_RE.search(lines[line - 1]) if 0 < line <= len(lines) else None
+        if var:
+            tl.names[id] = f'{m.group(1)} {var.group(1)}'
+
+
+def symbolizer(binary: Path):
+    """executable 안 offset -> 함수 이름 (nm 으로 가장 가까운 아래쪽 symbol)"""
+    proc = subprocess.run(['nm', '-C', '-n', '--defined-only', str(binary)], capture_output=True, text=True)
+    symbols = []
+    for line in proc.stdout.splitlines():
+        addr, kind, name = (line.split(' ', 2) + ['', ''])[:3]
+        if kind.lower() in ('t', 'w') and name:
+            symbols.append((int(addr, 16), name))
+
+    def lookup(offset: int) -> str:
+        best = None
+        for addr, name in symbols:
+            if addr > offset:
+                break
+            best = name
+        return best or f'0x{offset:x}'
+    return lookup
+
+
+def record_timeline(binary: Path, script: str | Path | None, duration_ms: float,
+                    size: int = TIMELINE_SIZE) -> tuple[Timeline | None, str]:
+    """(timeline, 에러). 런타임 에러로 끝나도 그때까지의 timeline 은 돌려준다."""
+    with tempfile.TemporaryDirectory() as tmp:
+        path = Path(tmp) / 'run.tl'
+        res = run_binary(binary, script, duration_ms, extra=['--timeline', str(path), '--timeline-size', str(size)])
+        if not path.exists():
+            return None, res.error or 'no timeline'
+        return parse_timeline(path.read_text(encoding='utf-8')), res.error
+
+
+# ------- Chrome trace
+@dataclass
+class Slice:
+    tid: int
+    name: str
+    start: int
+    end: int
+    args: dict = field(default_factory=dict)
+
+
+@dataclass
+class Analysis:
+    slices: list[Slice] = field(default_factory=list)
+    instants: list[dict] = field(default_factory=list)
+    counters: list[dict] = field(default_factory=list)
+    runs: list[tuple[int, int, int]] = field(default_factory=list)         # (start, end, task): CPU track
+    waits: list[tuple[int, int, int, int, int]] = field(default_factory=list)   # (start, end, task, 기다린 것, 그때 holder)
+    takes: dict[int, dict[int, int]] = field(default_factory=dict)         # mutex -> task -> 횟수
+    isrs: dict[str, int] = field(default_factory=dict)
+    switches: int = 0
+    bus_us: int = 0
+    bus_transfers: int = 0
+
+
+def analyze(tl: Timeline, symbol=None) -> Analysis:
+    an = Analysis()
+    end = max((r.t + r.dur for r in tl.records), default=0)
+    tasks = [id for id in sorted(tl.names) if tl.kind(id) == 'task']
+    running = tasks[0] if tasks and not tl.wrapped else None     # ring 이 넘쳤으면 첫 switch 부터 안다
+    run_start = tl.records[0].t if tl.records else 0
+    waiting: dict[int, tuple[int, int, int]] = {}           # task -> (시작, 기다린 것, holder)
+    holding: dict[tuple[int, int], tuple[int, int]] = {}    # (task, mutex) -> (시작, 깊이)
+    holder: dict[int, int] = {}                             # mutex -> task
+    isr_open: dict[int, tuple[int, str]] = {}
+    bus: dict[int, Slice] = {}
+
+    def run_until(t: int):
+        if running is not None and t > run_start:
+            an.runs.append((run_start, t, running))
+
+    def task_tid(task: int) -> int:
+        return ISR_TID if task < 0 else TASK_TID + task
+
+    for r in tl.records:
+        if r.what == 'switch':
+            an.switches += 1
+            run_until(r.t)
+            running, run_start = r.b, r.t
+        elif r.what == 'idle':
+            run_until(r.t)
+            run_start = r.t + r.dur                         # 다른 task 로 switch 가 없으면 같은 task 가 이어서 돈다
+        elif r.what == 'isr':
+            name = symbol(r.c) if symbol and r.c >= 0 else f'pin {r.a}'
+            isr_open[r.a] = (r.t, name)
+            an.isrs[name] = an.isrs.get(name, 0) + 1
+        elif r.what == 'isr_end' and r.a in isr_open:
+            start, name = isr_open.pop(r.a)
+            an.slices.append(Slice(ISR_TID, name, start, r.t, {'pin': r.a}))
+        elif r.what == 'block':
+            waiting[r.a] = (r.t, r.b, holder.get(r.b, 0))
+        elif r.what == 'wake' and r.a in waiting:
+            start, on, held_by = waiting.pop(r.a)
+            name = f'wait {tl.label(on)}' if on else 'delay'
+            args = {'timed_out': bool(r.c)}
+            if held_by:
+                args['holder'] = tl.label(held_by)
+            an.slices.append(Slice(task_tid(r.a), name, start, r.t, args))
+            if on:
+                an.waits.append((start, r.t, r.a, on, held_by))
+        elif r.what in ('send', 'receive'):
+            an.instants.append({'name': f'{r.what} {tl.label(r.b)}', 'ph': 'i', 's': 't', 'ts': r.t, 'pid': 1,
+                                'tid': task_tid(r.a), 'args': {'items': r.c}})
+            an.counters.append({'name': tl.label(r.b), 'ph': 'C', 'ts': r.t, 'pid': 1, 'args': {'items': r.c}})
+        elif r.what in ('take', 'give') and tl.kind(r.b) != 'mutex':
+            an.counters.append({'name': tl.label(r.b), 'ph': 'C', 'ts': r.t, 'pid': 1, 'args': {'count': r.c}})
+        elif r.what == 'take':
+            key = (r.a, r.b)
+            start, depth = holding.get(key, (r.t, 0))
+            holding[key] = (start, depth + 1)
+            holder[r.b] = r.a
+            per_task = an.takes.setdefault(r.b, {})
+            per_task[r.a] = per_task.get(r.a, 0) + 1
+        elif r.what == 'give' and (r.a, r.b) in holding:
+            key = (r.a, r.b)
+            start, depth = holding.pop(key)
+            if depth > 1:
+                holding[key] = (start, depth - 1)
+                continue
+            holder.pop(r.b, None)
+            an.slices.append(Slice(task_tid(r.a), f'hold {tl.label(r.b)}', start, r.t))
+        elif r.what == 'inherit':
+            an.instants.append({'name': f'inherit prio {r.c}', 'ph': 'i', 's': 't', 'ts': r.t, 'pid': 1,
+                                'tid': task_tid(r.a), 'args': {'mutex': tl.label(r.b)}})
+        elif r.what == 'bus':
+            an.bus_us += r.dur
+            last = bus.get(r.a)
+            if last and r.t <= last.end:
+                last.end = max(last.end, r.t + r.dur)
+                last.args['bytes'] += r.c
+                continue
+            if last:
+                an.slices.append(last)
+            an.bus_transfers += 1
+            bus[r.a] = Slice(BUS_TID + r.a, 'transfer', r.t, r.t + r.dur, {'bytes': r.c})
+    run_until(end)
+    an.slices += bus.values()
+    for task, (start, on, held_by) in waiting.items():     # 끝날 때까지 못 깨어난 task
+        an.slices.append(Slice(task_tid(task), f'wait {tl.label(on)}' if on else 'delay', start, end))
+        if on:
+            an.waits.append((start, end, task, on, held_by))
+    for (task, mutex), (start, _) in holding.items():
+        an.slices.append(Slice(task_tid(task), f'hold {tl.label(mutex)}', start, end))
+    return an
+
+
+def inversion_us(tl: Timeline, an: Analysis) -> dict[int, int]:
+    """mutex -> 기다리는 task 보다 priority 가 낮고 holder 가 아닌 task 가 CPU 를 쓴 시간"""
+    out: dict[int, int] = {}
+    for start, end, task, on, held_by in an.waits:
+        if tl.kind(on) != 'mutex':
+            continue
+        for run_start, run_end, runner in an.runs:
+            if run_end <= start or run_start >= end or runner in (task, held_by):
+                continue
+            if tl.prio(runner) < tl.prio(task):
+                out[on] = out.get(on, 0) + min(end, run_end) - max(start, run_start)
+    return out
+
+
+def chrome_trace(tl: Timeline, an: Analysis, title: str) -> dict:
+    events = [{'name': 'process_name', 'ph': 'M', 'pid': 1, 'args': {'name': title}},
+              {'name': 'thread_name', 'ph': 'M', 'pid': 1, 'tid': CPU_TID, 'args': {'name': 'CPU'}},
+              {'name': 'thread_name', 'ph': 'M', 'pid': 1, 'tid': ISR_TID, 'args': {'name': 'ISR'}}]
+    for id, name in sorted(tl.names.items()):
+        kind = tl.kind(id)
+        if kind in ('task', 'bus'):
+            tid = (TASK_TID if kind == 'task' else BUS_TID) + id
+            events.append({'name': 'thread_name', 'ph': 'M', 'pid': 1, 'tid': tid, 'args': {'name': name}})
+            events.append({'name': 'thread_sort_index', 'ph': 'M', 'pid': 1, 'tid': tid,
+                           'args': {'sort_index': -tl.prio(id) if kind == 'task' else 1000 + id}})
+    for start, end, task in an.runs:
+        events.append({'name': tl.label(task), 'ph': 'X', 'ts': start, 'dur': end - start, 'pid': 1, 'tid': CPU_TID})
+    for s in sorted(an.slices, key=lambda s: (s.start, -s.end)):
+        events.append({'name': s.name, 'ph': 'X', 'ts': s.start, 'dur': s.end - s.start, 'pid': 1, 'tid': s.tid,
+                       'args': s.args})
+    events += an.instants + an.counters
+    return {'traceEvents': events, 'displayTimeUnit': 'ms',
+            'otherData': {'capacity': tl.capacity, 'recorded': tl.recorded}}
+
+
+def summarize(tl: Timeline, an: Analysis) -> list[str]:
+    lines = []
+    span = max((r.t for r in tl.records), default=0) - (tl.records[0].t if tl.records else 0)
+    kept = f'{tl.recorded} records, the last {tl.capacity}' if tl.wrapped else f'{tl.recorded} records'
+    isrs = ', '.join(f'{name} x{n}' for name, n in sorted(an.isrs.items())) or 'none'
+    lines.append(f'{kept} over {span / 1e3:.0f} ms; '
+                 f'{an.switches} task switches; ISRs: {isrs}')
+    inversions = inversion_us(tl, an)
+    for id in sorted(tl.names):
+        if tl.kind(id) != 'mutex':
+            continue
+        takes = an.takes.get(id, {})
+        waits = [(end - start, task) for start, end, task, on, _ in an.waits if on == id]
+        by = ', '.join(f'{tl.label(t)} {n}' for t, n in sorted(takes.items(), key=lambda kv: -kv[1]))
+        text = f'mutex {tl.label(id)}: {sum(takes.values())} takes ({by or "none"}), {len(waits)} blocked'
+        if waits:
+            blocked = ', '.join(sorted({tl.label(task) for _, task in waits}))
+            text += (f' ({blocked}), wait {sum(w for w, _ in waits) / 1e3:.2f} ms total, '
+                     f'{max(w for w, _ in waits) / 1e3:.2f} ms max')
+        text += f'; priority inversion {inversions.get(id, 0) / 1e3:.2f} ms'
+        lines.append(text)
+    if an.bus_transfers:
+        share = an.bus_us / span if span else 0.0
+        lines.append(f'LCD bus: {an.bus_transfers} transfers, {an.bus_us / 1e3:.1f} ms ({share:.1%} of the time)')
+    return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description='task/ISR/queue/mutex/LCD bus timeline 을 Chrome trace JSON 으로')
+    parser.add_argument('files', nargs='*', help='실행할 .c 파일. 비우면 corpus 의 --queries')
+    parser.add_argument('--corpus', nargs='*', default=TIMELINE_CORPORA)
+    parser.add_argument('--queries', nargs='*', default=TIMELINE_QUERIES)
+    parser.add_argument('--steps', nargs='*', type=int, default=None)
+    parser.add_argument('--script', help='입력 event script. 비우면 hostsim/scripts/<query>.txt')
+    parser.add_argument('--duration-ms', type=float, default=60_000)
+    parser.add_argument('--size', type=int, default=TIMELINE_SIZE, help='ring buffer record 수')
+    parser.add_argument('--out', default=str(BUILD_DIR / 'timeline'), help='JSON 을 쓸 폴더')
+    args = parser.parse_args()
+
+    out_dir = Path(args.out)
+    out_dir.mkdir(parents=True, exist_ok=True)
+    files = [Path(f) for f in args.files] or corpus_files(args.corpus, args.queries, args.steps)
+    for f in files:
+        name = f.resolve().relative_to(PROJECT_ROOT) if f.resolve().is_relative_to(PROJECT_ROOT) else f
+        code = f.read_text(encoding='utf-8')
+        build = build_sketch(code)
+        if not build.ok:
+            print(f'[TL] {name}: build failed')
+            continue
+        query = query_of(f)
+        script = args.script or (script_for(query) if query and script_for(query).exists() else None)
+        tl, error = record_timeline(build.binary, script, args.duration_ms, args.size)
+        if tl is None:
+            print(f'[TL] {name}: {error}')
+            continue
+        name_sites(tl, code)
+        an = analyze(tl, symbolizer(build.binary))
+        out = out_dir / f'{"_".join(Path(name).with_suffix("").parts)}.json'
+        out.write_text(json.dumps(chrome_trace(tl, an, str(name))), encoding='utf-8')
+        print(f'[TL] {name} -> {out}{" (" + error + ")" if error else ""}')
+        for line in summarize(tl, an):
+            print(f'[TL]   {line}')
+
+
+if __name__ == '__main__':
+    main()
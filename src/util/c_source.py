@@ -0,0 +1,228 @@
+"""
+LLM이 생성한 C/C++(Arduino 스케치 포함) 소스를 가볍게 다루기 위한 유틸.
+컴파일러 없이 top-level 선언(함수, struct/enum/union/class)을 찾아낸다.
+"""
+
+import re
+from dataclasses import dataclass
+
+_IDENT_RE = re.compile(r'[A-Za-z_]\w*(?:\s*::\s*~?[A-Za-z_]\w*)*')
+_TYPE_KW_RE = re.compile(r'\b(struct|enum|union|class)\b')
+_CONTROL_KW = {'if', 'for', 'while', 'switch', 'return', 'sizeof', 'do', 'else'}
+
+
+@dataclass
+class CSymbol:
+    name: str
+    kind: str           # 'function' | 'struct' | 'enum' | 'union' | 'class'
+    start: int          # 선언 시작 offset
+    body_start: int     # '{' offset
+    end: int            # '}' (또는 타입 선언의 ';') 다음 offset
+    signature: str      # 공백을 정리한 선언부
+
+
+def mask_code(code: str) -> str:
+    """
+    주석과 문자열/문자 리터럴 내용을 공백으로 치환한다.
+    길이와 개행 위치는 그대로 유지되므로 offset을 원본과 공유할 수 있다.
+    """
+    out = list(code)
+    i, n = 0, len(code)
+    while i < n:
+        c = code[i]
+        if code.startswith('//', i):
+            j = code.find('\n', i)
+            j = n if j < 0 else j
+            for k in range(i, j):
+                out[k] = ' '
+            i = j
+        elif code.startswith('/*', i):
+            j = code.find('*/', i + 2)
+            j = n if j < 0 else j + 2
+            for k in range(i, j):
+                if out[k] != '\n':
+                    out[k] = ' '
+            i = j
+        elif c in '"\'':
+            j = i + 1
+            while j < n and code[j] != c and code[j] != '\n':
+                j += 2 if code[j] == '\\' else 1
+            for k in range(i + 1, min(j, n)):
+                out[k] = ' '
+            i = j + 1
+        else:
+            i += 1
+    return ''.join(out)
+
+
+def mask_preprocessor(masked: str) -> str:
+    """'#' 지시문 줄(줄 이어쓰기 포함)을 공백으로 치환한다."""
+    lines = masked.split('\n')
+    in_directive = False
+    for idx, line in enumerate(lines):
+        if in_directive or line.lstrip().startswith('#'):
+            in_directive = line.rstrip().endswith('\\')
+            lines[idx] = ' ' * len(line)
+    return '\n'.join(lines)
+
+
+def strip_comments(code: str) -> str:
+    """주석만 제거한다. 문자열 리터럴은 보존."""
+    out, i, n = [], 0, len(code)
+    while i < n:
+        c = code[i]
+        if code.startswith('//', i):
+            j = code.find('\n', i)
+            i = n if j < 0 else j
+        elif code.startswith('/*', i):
+            j = code.find('*/', i + 2)
+            block = code[i:n if j < 0 else j]
+            out.append('\n' * block.count('\n') if '\n' in block else ' ')
+            i = n if j < 0 else j + 2
+        elif c in '"\'':
+            j = i + 1
+            while j < n and code[j] != c and code[j] != '\n':
+                j += 2 if code[j] == '\\' else 1
+            out.append(code[i:j + 1])
+            i = j + 1
+        else:
+            out.append(c)
+            i += 1
+    return ''.join(out)
+
+
+def find_matching(masked: str, open_idx: int) -> int:
+    """masked[open_idx]의 괄호에 대응하는 닫는 괄호 offset. 없으면 -1."""
+    pairs = {'{': '}', '(': ')', '[': ']'}
+    open_ch = masked[open_idx]
+    close_ch = pairs[open_ch]
+    depth = 0
+    for i in range(open_idx, len(masked)):
+        ch = masked[i]
+        if ch == open_ch:
+            depth += 1
+        elif ch == close_ch:
+            depth -= 1
+            if depth == 0:
+                return i
+    return -1
+
+
+def _collapse(text: str) -> str:
+    return ' '.join(text.split())
+
+
+def _function_name(header: str) -> str | None:
+    """'static int foo(int a) const' 같은 헤더에서 함수 이름을 뽑는다."""
+    if '=' in header.split('(', 1)[0] or ')' not in header:
+        return None
+    close = header.rfind(')')
+    depth = 0
+    for i in range(close, -1, -1):
+        if header[i] == ')':
+            depth += 1
+        elif header[i] == '(':
+            depth -= 1
+            if depth == 0:
+                head = header[:i].rstrip()
+                m = re.search(r'(~?[A-Za-z_]\w*(?:\s*::\s*~?[A-Za-z_]\w*)*)$', head)
+                if not m:
+                    return None
+                name = re.sub(r'\s+', '', m.group(1))
+                if name.split('::')[-1] in _CONTROL_KW:
+                    return None
+                return name
+    return None
+
+
+def scan_top_level(code: str) -> list[CSymbol]:
+    """
+    brace depth 0 에 있는 함수 정의와 struct/enum/union/class 선언을 찾는다.
+    배열/구조체 초기화(`= {...}`)와 extern "C" / namespace 블록 자체는 심볼로 보지 않는다.
+    """
+    masked = mask_preprocessor(mask_code(code))
+    symbols: list[CSymbol] = []
+    stmt_start = 0
+    i, n = 0, len(masked)
+    while i < n:
+        ch = masked[i]
+        if ch in ';}':
+            stmt_start = i + 1
+        elif ch == '{':
+            header = masked[stmt_start:i]
+            close = find_matching(masked, i)
+            if close < 0:
+                break
+            lead = len(header) - len(header.lstrip())
+            start = stmt_start + lead
+            stripped = header.strip()
+            if re.match(r'^(extern\s+"\s*"|namespace\b)', stripped):
+                # 블록 내부를 top-level로 계속 스캔
+                stmt_start = i + 1
+                i += 1
+                continue
+            kind_match = _TYPE_KW_RE.search(stripped)
+            if '=' in stripped:
+                sym = None
+            elif kind_match and '(' not in stripped[:kind_match.start()]:
+                sym = _type_symbol(code, masked, stripped, kind_match.group(1), start, i, close)
+            else:
+                name = _function_name(stripped)
+                sym = CSymbol(name, 'function', start, i, close + 1,
+                              _collapse(code[start:i])) if name else None
+            if sym:
+                symbols.append(sym)
+                stmt_start = sym.end
+                i = sym.end
+                continue
+            stmt_start = close + 1
+            i = close + 1
+            continue
+        i += 1
+    return symbols
+
+
+def _type_symbol(code: str, masked: str, header: str, kind: str,
+                 start: int, body_start: int, close: int) -> CSymbol | None:
+    semi = masked.find(';', close)
+    end = close + 1 if semi < 0 else semi + 1
+    after = masked[close + 1:end].strip().rstrip(';').strip()
+    m = re.search(rf'\b{kind}\b(?:\s+class)?\s+([A-Za-z_]\w*)', header)
+    name = None
+    if header.startswith('typedef') and after:
+        tail = _IDENT_RE.findall(after)
+        name = tail[0] if tail else None
+    if name is None and m:
+        name = m.group(1)
+    if name is None:
+        return None
+    return CSymbol(name, kind, start, body_start, end, code[start:end])
+
+
+def line_of(code: str, offset: int) -> int:
+    """offset이 속한 줄 번호(0-base)."""
+    return code.count('\n', 0, offset)
+
+
+def leading_comment_lines(lines: list[str], line_idx: int) -> tuple[int, int]:
+    """
+    line_idx 바로 위에 붙어 있는 주석 블록의 [begin, end) 줄 범위.
+    빈 줄을 만나면 멈춘다. 주석이 없으면 (line_idx, line_idx).
+    """
+    begin = line_idx
+    in_block = False
+    for k in range(line_idx - 1, -1, -1):
+        s = lines[k].strip()
+        if in_block:
+            begin = k
+            if s.startswith('/*'):
+                in_block = False
+            continue
+        if s.startswith('//'):
+            begin = k
+        elif s.endswith('*/'):
+            begin = k
+            in_block = not s.startswith('/*')
+        else:
+            break
+    return begin, line_idx
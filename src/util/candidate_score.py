@@ -0,0 +1,119 @@
+"""
+best-of-N 후보 코드를 LLM 없이 점수화한다.
+- compile: hostsim stub 헤더로 컴파일되는지 (50점, 실패 시 error 수만큼 감점)
+- smoke: SMOKE_TESTS 의 검사를 통과한 비율 (20점). run 은 켰을 때만 hostsim 으로 빌드해서 query 의 입력
+         script 로 SMOKE_DURATION_MS 동안 돌려 보고, 정상 종료하고 LCD/Serial/log 출력이 하나라도 있어야 통과
+- static: 규칙 한도(CC 10, 중첩 4, 50줄, 매개변수 5, 동적 할당 금지)를 넘는 만큼 감점 (30점)
+"""
+
+import re
+from dataclasses import dataclass, field
+from typing import Callable
+
+from util.c_source import mask_code, scan_top_level
+from util.compile_check import compile_check, detect_lang, has_compiler
+from util.static_metrics import StaticMetrics, static_metrics
+
+COMPILE_WEIGHT = 50.0
+SMOKE_WEIGHT = 20.0
+STATIC_WEIGHT = 30.0
+
+_OUTPUT_RE = re.compile(
+    r'\b(Serial\s*\.\s*print|lcd\w*\s*(\.|->)?\s*\w*print|lcd\w*_puts|lcd_print|printf|ESP_LOG\w)'
+)
+
+
+# 출력은 대부분 setup/app_main 직후에 나오므로 짧게 돌린다
+SMOKE_DURATION_MS = 3_000
+SMOKE_TIMEOUT = 3.0
+RUN_TEST = 'run'
+_OUTPUT_CHANNELS = ('lcd', 'serial', 'log')
+
+
+def _has_entry_point(code: str, lang: str, query: str | None) -> bool:
+    names = {s.name for s in scan_top_level(code) if s.kind == 'function'}
+    if lang == 'arduino':
+        return {'setup', 'loop'} <= names
+    return 'app_main' in names or 'main' in names
+
+
+def _produces_output(code: str, lang: str, query: str | None) -> bool:
+    return _OUTPUT_RE.search(mask_code(code)) is not None
+
+
+def _runs_clean(code: str, lang: str, query: str | None) -> bool | None:
+    """컴파일러가 없으면 None (점수에서 뺀다). script 가 없는 query 는 입력 없이 돌린다."""
+    from sim.build import build_sketch
+    from sim.runner import run_binary, script_for
+
+    if not has_compiler(lang):
+        return None
+    build = build_sketch(code, lang)
+    if not build.ok:
+        return False
+    script = script_for(query) if query else None
+    result = run_binary(build.binary, script if script and script.exists() else None,
+                        SMOKE_DURATION_MS, SMOKE_TIMEOUT)
+    return result.ok and any(e.channel in _OUTPUT_CHANNELS for e in result.events)
+
+
+# (이름, 검사) 목록. 검사는 (code, lang, query) 를 받고, 해당 없으면 None
+SMOKE_TESTS: list[tuple[str, Callable[[str, str, str | None], bool | None]]] = [
+    ('entry_point', _has_entry_point),
+    ('output', _produces_output),
+    (RUN_TEST, _runs_clean),
+]
+
+
+def prepare_smoke_run():
+    """후보 thread 들이 hostsim runtime 을 저마다 빌드하지 않도록 먼저 한 번 빌드해 둔다."""
+    from sim.build import build_runtime
+    if has_compiler('arduino'):
+        build_runtime()
+
+
+@dataclass
+class CandidateScore:
+    total: float
+    compiled: bool | None          # 컴파일러가 없으면 None
+    errors: int
+    smoke: dict[str, bool] = field(default_factory=dict)
+    metrics: StaticMetrics | None = None
+
+    def summary(self) -> str:
+        comp = '-' if self.compiled is None else ('ok' if self.compiled else f'{self.errors} errors')
+        smoke = ','.join(k for k, v in self.smoke.items() if not v) or 'pass'
+        return f'{self.total:.1f} (compile {comp}, smoke {smoke})'
+
+
+def static_penalty(m: StaticMetrics) -> float:
+    over = (
+        2.0 * sum(max(f.cyclomatic - 10, 0) for f in m.functions)
+        + 3.0 * sum(max(f.nesting - 4, 0) for f in m.functions)
+        + 0.2 * sum(max(f.lines - 50, 0) for f in m.functions)
+        + 2.0 * sum(max(f.params - 5, 0) for f in m.functions)
+        + 5.0 * m.dynamic_alloc
+    )
+    return min(over, STATIC_WEIGHT)
+
+
+def score_candidate(code: str, query: str | None = None, run: bool = False) -> CandidateScore:
+    """run 이면 hostsim 실행 검사도 한다. query 가 있으면 hostsim/scripts/<query>.txt 를 입력으로 쓴다."""
+    if not code.strip():
+        return CandidateScore(0.0, False, 0)
+    lang = detect_lang(code)
+    total = 0.0
+
+    compiled, errors = None, 0
+    if has_compiler(lang):
+        result = compile_check(code, lang)
+        compiled, errors = result.ok, len(result.errors)
+        total += COMPILE_WEIGHT if result.ok else -min(errors, 20)
+
+    results = {name: test(code, lang, query) for name, test in SMOKE_TESTS if run or name != RUN_TEST}
+    smoke = {name: bool(ok) for name, ok in results.items() if ok is not None}
+    total += SMOKE_WEIGHT * sum(smoke.values()) / len(smoke)
+
+    metrics = static_metrics(code)
+    total += STATIC_WEIGHT - static_penalty(metrics)
+    return CandidateScore(round(total, 2), compiled, errors, smoke, metrics)
@@ -0,0 +1,196 @@
+"""
+evaluator / refine 프롬프트에 넣는 코드를 규칙별 정책에 맞게 줄인다.
+- 주석 제거 (주석을 보지 않는 규칙만)
+- 공백 정리
+- 함수 본문 생략 (문서화 규칙처럼 본문을 보지 않거나, 이전 단계와 같은 helper 의 본문)
+token 은 모델 tokenizer 로 세고, budget 을 넘으면 바뀌지 않은 helper 본문부터 생략한다.
+그래도 budget 을 넘을 때, 올라갈 상위 tier 가 있으면(strict) TokenBudgetExceeded 를 던지고
+없으면 줄인 그대로 보낸다.
+"""
+
+from dataclasses import dataclass
+from functools import lru_cache
+
+from settings import settings
+from util.c_source import scan_top_level, strip_comments
+
+# 본문을 생략하면 안 되는 진입점
+_ENTRY_POINTS = {'setup', 'loop', 'app_main', 'main'}
+
+
+@dataclass(frozen=True)
+class CompactionPolicy:
+    strip_comments: bool = False
+    trim_whitespace: bool = False       # 줄끝 공백, 연속 빈 줄 제거
+    collapse_whitespace: bool = False   # trim + 들여쓰기 제거
+    elide_bodies: bool = False      # 모든 함수 본문 생략 (선언과 주석만 판단하는 규칙)
+    elide_unchanged: bool = False   # budget 초과 시 baseline 과 같은 helper 본문 생략
+
+
+EVAL_POLICIES: dict[str, CompactionPolicy] = {
+    'p0': CompactionPolicy(trim_whitespace=True, elide_unchanged=True),
+    # 스택 사용량 주석을 평가하므로 주석 유지
+    'p1': CompactionPolicy(collapse_whitespace=True, elide_unchanged=True),
+    'p2': CompactionPolicy(strip_comments=True, collapse_whitespace=True, elide_unchanged=True),
+    # 함수 줄 수(빈 줄 포함)/중첩 깊이를 평가하므로 공백도 그대로
+    'p3': CompactionPolicy(elide_unchanged=True),
+    'p4': CompactionPolicy(strip_comments=True, collapse_whitespace=True, elide_unchanged=True),
+    'p5': CompactionPolicy(strip_comments=True, collapse_whitespace=True, elide_unchanged=True),
+    'p6': CompactionPolicy(strip_comments=True, collapse_whitespace=True, elide_unchanged=True),
+    'p7': CompactionPolicy(elide_bodies=True),
+    # formatting 과 모든 식별자 이름이 평가 대상이라 그대로 보낸다
+    'p8': CompactionPolicy(),
+    # 호출/반복문 구조만 보면 된다. 실시간 규칙은 p9 에서 처음 보므로 바뀌지 않은 helper 의 delay/print 도 보낸다
+    'p9': CompactionPolicy(strip_comments=True, collapse_whitespace=True),
+}
+
+# refine 은 모델이 코드 전체를 돌려줘야 하므로 정보가 사라지지 않는 정리만 한다
+REFINE_POLICY = CompactionPolicy(trim_whitespace=True)
+
+
+@dataclass
+class CompactionResult:
+    code: str
+    tokens_before: int
+    tokens_after: int
+    elided: list[str]
+    over_budget: bool
+
+    @property
+    def saved(self) -> int:
+        return self.tokens_before - self.tokens_after
+
+
+class TokenBudgetExceeded(Exception):
+    """정책이 허용하는 만큼 줄여도 budget 을 넘는 입력."""
+
+    def __init__(self, kind: str, prompt_names: list[str], result: CompactionResult, budget: int):
+        super().__init__(f'{kind} {",".join(prompt_names)}: {result.tokens_after} tokens after compaction, '
+                         f'budget {budget}')
+        self.result = result
+        self.budget = budget
+
+
+def merge_policies(names: list[str]) -> CompactionPolicy:
+    """여러 규칙을 함께 평가할 때는 가장 보수적인 조합을 쓴다."""
+    policies = [EVAL_POLICIES.get(n, CompactionPolicy()) for n in names] or [CompactionPolicy()]
+    return CompactionPolicy(
+        strip_comments=all(p.strip_comments for p in policies),
+        trim_whitespace=all(p.trim_whitespace for p in policies),
+        collapse_whitespace=all(p.collapse_whitespace for p in policies),
+        elide_bodies=all(p.elide_bodies for p in policies),
+        elide_unchanged=all(p.elide_unchanged for p in policies),
+    )
+
+
+@lru_cache(maxsize=8)
+def _encoder(model_name: str):
+    try:
+        import tiktoken
+    except ImportError:
+        return None
+    try:
+        return tiktoken.encoding_for_model(model_name)
+    except KeyError:
+        return tiktoken.get_encoding('o200k_base')
+
+
+def count_tokens(text: str, model_name: str) -> int:
+    """tiktoken 이 있으면 모델 tokenizer 로, 없으면 UTF-8 4 byte 당 1 token 으로 근사."""
+    enc = _encoder(model_name)
+    if enc is not None:
+        return len(enc.encode(text, disallowed_special=()))
+    return (len(text.encode('utf-8')) + 3) // 4
+
+
+def collapse_whitespace(code: str, dedent: bool = True) -> str:
+    """줄끝 공백과 연속 빈 줄 제거(dedent 면 들여쓰기도 제거). 줄 구조는 유지."""
+    lines = [ln.strip() if dedent else ln.rstrip() for ln in code.split('\n')]
+    out = [ln for i, ln in enumerate(lines) if ln or (i > 0 and lines[i - 1])]
+    return '\n'.join(out).strip('\n')
+
+
+def _function_bodies(code: str) -> dict[str, tuple[int, int, str]]:
+    """{함수명: (body '{' offset, '}' 다음 offset, 본문 텍스트)}"""
+    return {s.name: (s.body_start, s.end, code[s.body_start:s.end])
+            for s in scan_top_level(code) if s.kind == 'function'}
+
+
+def elide_bodies(code: str, names: set[str] | None = None, note: str = 'elided') -> tuple[str, list[str]]:
+    """names 의 함수 본문을 '{ /* ... */ }' 로 바꾼다. names 가 None 이면 진입점 제외 전부."""
+    bodies = _function_bodies(code)
+    targets = [(n, b) for n, b in bodies.items()
+               if (names is None and n not in _ENTRY_POINTS) or (names is not None and n in names)]
+    for name, (start, end, body) in sorted(targets, key=lambda t: t[1][0], reverse=True):
+        lines = body.count('\n') + 1
+        code = f'{code[:start]}{{ /* {lines} lines {note} */ }}{code[end:]}'
+    return code, [n for n, _ in targets]
+
+
+def compact(code: str, policy: CompactionPolicy, model_name: str,
+            budget: int | None = None, baseline: str | None = None) -> CompactionResult:
+    before = count_tokens(code, model_name)
+    out = code
+    elided: list[str] = []
+    if policy.elide_bodies:
+        out, elided = elide_bodies(out)
+    if policy.strip_comments:
+        out = strip_comments(out)
+    if policy.collapse_whitespace:
+        out = collapse_whitespace(out)
+    elif policy.trim_whitespace or policy.strip_comments:
+        out = collapse_whitespace(out, dedent=False)
+
+    after = count_tokens(out, model_name)
+    if budget is not None and after > budget and policy.elide_unchanged and baseline:
+        # 이전 단계와 같은 helper 본문을 큰 것부터 생략
+        old = {n: b[2] for n, b in _function_bodies(baseline).items()}
+        current = _function_bodies(code)
+        unchanged = sorted(
+            (n for n, b in current.items() if n not in _ENTRY_POINTS and old.get(n) == b[2]),
+            key=lambda n: len(current[n][2]), reverse=True,
+        )
+        for name in unchanged:
+            out, done = elide_bodies(out, {name}, 'unchanged from previous step, elided')
+            elided += done
+            after = count_tokens(out, model_name)
+            if after <= budget:
+                break
+
+    return CompactionResult(out, before, after, elided, budget is not None and after > budget)
+
+
+def compact_for_eval(code: str, prompt_names: list[str], model_name: str,
+                     baseline: str | None = None, budget: int | None = None,
+                     strict: bool = False) -> CompactionResult:
+    """
+    budget 이 None 이면 settings.eval_token_budget (0 이면 제한 없음).
+    strict 면 줄여도 넘을 때 TokenBudgetExceeded (호출한 쪽이 상위 tier 로 올라갈 수 있을 때만 쓴다).
+    """
+    budget = settings.eval_token_budget if budget is None else budget
+    result = compact(code, merge_policies(prompt_names), model_name, budget or None, baseline)
+    _log('eval', prompt_names, result)
+    if result.over_budget and strict:
+        raise TokenBudgetExceeded('eval', prompt_names, result, budget)
+    return result
+
+
+def compact_for_refine(code: str, prompt_name: str, model_name: str, budget: int | None = None,
+                       strict: bool = False) -> CompactionResult:
+    """budget 이 None 이면 settings.refine_token_budget. refine 은 본문을 생략할 수 없어 공백만 줄인다."""
+    budget = settings.refine_token_budget if budget is None else budget
+    result = compact(code, REFINE_POLICY, model_name, budget or None)
+    _log('refine', [prompt_name], result)
+    if result.over_budget and strict:
+        raise TokenBudgetExceeded('refine', [prompt_name], result, budget)
+    return result
+
+
+def _log(kind: str, prompt_names: list[str], result: CompactionResult):
+    msg = (f'[COMPACT] {kind} {",".join(prompt_names)}: {result.tokens_before} -> '
+           f'{result.tokens_after} tokens (saved {result.saved})')
+    if result.elided:
+        msg += f', elided {len(result.elided)} bodies'
+    if result.over_budget:
+        msg += ' OVER BUDGET'
+    print(msg)
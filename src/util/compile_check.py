@@ -0,0 +1,83 @@
+"""
+생성된 코드를 host의 gcc/g++ 와 hostsim/include 의 stub 헤더로 컴파일해 본다.
+Arduino 스케치는 Arduino IDE처럼 Arduino.h 를 자동 include 하고 함수 prototype 을 앞에 붙인다.
+"""
+
+import re
+import shutil
+import subprocess
+import tempfile
+from dataclasses import dataclass
+from pathlib import Path
+
+from util.c_source import scan_top_level
+from util.run_trace import span, COMPILE
+
+PROJECT_ROOT = Path(__file__).resolve().parents[2]
+HOSTSIM_INCLUDE = PROJECT_ROOT / 'hostsim' / 'include'
+
+_ARDUINO_HINT_RE = re.compile(
+    r'#\s*include\s*[<"](Arduino|LiquidCrystal|LiquidCrystal_I2C|Keypad|Wire)\.h[>"]'
+    r'|\bvoid\s+loop\s*\(|\bSerial\.'
+)
+
+
+@dataclass
+class CompileResult:
+    ok: bool
+    lang: str           # 'arduino' | 'c'
+    errors: list[str]   # 'error:' 진단 줄
+
+
+def detect_lang(code: str) -> str:
+    """Arduino(C++) 스케치인지 ESP-IDF 같은 plain C 인지 구분."""
+    return 'arduino' if _ARDUINO_HINT_RE.search(code) else 'c'
+
+
+def arduino_preprocess(code: str) -> str:
+    """
+    Arduino builder 와 같이 첫 함수 정의 앞에 모든 함수의 prototype 을 넣는다.
+    #line 으로 원본 줄 번호를 유지한다.
+    """
+    funcs = [s for s in scan_top_level(code) if s.kind == 'function' and '::' not in s.name]
+    if not funcs:
+        return code
+    first = funcs[0].start
+    line_no = code.count('\n', 0, first) + 1
+    protos = '\n'.join(f'{re.sub(r"=[^,)]*", "", f.signature)};' for f in funcs)
+    return f'{code[:first]}{protos}\n#line {line_no}\n{code[first:]}'
+
+
+def compiler_command(lang: str, extra: list[str] | None = None) -> list[str]:
+    if lang == 'arduino':
+        cmd = ['g++', '-x', 'c++', '-std=gnu++17', '-include', 'Arduino.h']
+    else:
+        cmd = ['gcc', '-x', 'c', '-std=gnu11']
+    return cmd + ['-I', str(HOSTSIM_INCLUDE), '-w'] + (extra or [])
+
+
+def prepare_source(code: str, lang: str | None = None) -> tuple[str, str]:
+    lang = lang or detect_lang(code)
+    return (arduino_preprocess(code) if lang == 'arduino' else code), lang
+
+
+def has_compiler(lang: str) -> bool:
+    return shutil.which('g++' if lang == 'arduino' else 'gcc') is not None
+
+
+def compile_check(code: str, lang: str | None = None, timeout: float = 30.0) -> CompileResult:
+    """-fsyntax-only 로 컴파일 가능 여부만 확인한다."""
+    src, lang = prepare_source(code, lang)
+    compiler = 'g++' if lang == 'arduino' else 'gcc'
+    if not has_compiler(lang):
+        return CompileResult(False, lang, [f'{compiler} not found'])
+
+    with tempfile.TemporaryDirectory() as tmp, span('compile', COMPILE, backend=compiler):
+        path = Path(tmp) / 'sketch.c'
+        path.write_text(src, encoding='utf-8')
+        proc = subprocess.run(
+            compiler_command(lang, ['-fsyntax-only', str(path)]),
+            capture_output=True, text=True, timeout=timeout,
+        )
+    errors = [ln for ln in proc.stderr.splitlines() if ' error: ' in ln or ln.startswith('error:')]
+    return CompileResult(proc.returncode == 0, lang, errors)
@@ -0,0 +1,123 @@
+"""
+p7(문서화) 전용 skeleton 모드.
+전체 코드를 보내는 대신 선언부만 모은 skeleton을 보내고,
+모델은 심볼별 주석 블록만 돌려준다. 주석은 로컬에서 원본에 끼워 넣는다.
+함수 본문은 모델에 전달되지 않으므로 재작성될 여지가 없다.
+"""
+
+import re
+from util.c_source import CSymbol, scan_top_level, line_of, leading_comment_lines
+
+FILE_KEY = '@file'
+_MARK_RE = re.compile(r'^@@\s*(\S+)\s*$')
+
+
+def symbol_keys(symbols: list[CSymbol]) -> list[str]:
+    """같은 이름(오버로드 등)은 name@2, name@3 ... 으로 구분."""
+    seen: dict[str, int] = {}
+    keys = []
+    for s in symbols:
+        seen[s.name] = seen.get(s.name, 0) + 1
+        keys.append(s.name if seen[s.name] == 1 else f'{s.name}@{seen[s.name]}')
+    return keys
+
+
+def build_skeleton(code: str, symbols: list[CSymbol] | None = None) -> str:
+    """
+    include/define 줄, 기존 주석, 함수 시그니처, 타입 선언만 남긴 요약본.
+    각 항목 앞에 '@@ key' 마커를 붙여 모델이 같은 key로 응답하게 한다.
+    """
+    symbols = scan_top_level(code) if symbols is None else symbols
+    lines = code.split('\n')
+    out = [ln for ln in lines if ln.lstrip().startswith('#')]
+    if out:
+        out.append('')
+    for key, sym in zip(symbol_keys(symbols), symbols):
+        begin, end = leading_comment_lines(lines, line_of(code, sym.start))
+        out.append(f'@@ {key}')
+        out.extend(lines[begin:end])
+        if sym.kind == 'function':
+            out.append(f'{sym.signature};')
+        else:
+            out.append(sym.signature)
+        out.append('')
+    return '\n'.join(out).rstrip() + '\n'
+
+
+def parse_doc_blocks(text: str) -> dict[str, str]:
+    """'@@ key' 마커 뒤에 오는 주석 블록들을 {key: comment} 로 파싱."""
+    text = re.sub(r'^```[a-zA-Z]*\s*$', '', text, flags=re.MULTILINE)
+    docs: dict[str, list[str]] = {}
+    current = None
+    for line in text.split('\n'):
+        m = _MARK_RE.match(line.strip())
+        if m:
+            current = m.group(1)
+            docs[current] = []
+        elif current is not None:
+            docs[current].append(line.rstrip())
+    return {k: '\n'.join(v).strip('\n') for k, v in docs.items() if ''.join(v).strip()}
+
+
+def _as_comment(doc: str, indent: str) -> list[str]:
+    """모델 응답을 반드시 주석 문법이 되도록 정리한다. 코드가 섞여 들어오면 // 로 감싼다."""
+    raw = [ln.strip() for ln in doc.strip().split('\n')]
+    joined = '\n'.join(raw)
+    if joined.startswith('/*') and joined.endswith('*/') and '*/' not in joined[2:-2]:
+        out = []
+        for i, ln in enumerate(raw):
+            if i == 0:
+                out.append(indent + ln)
+            elif ln.startswith('*'):
+                out.append(f'{indent} {ln}')
+            else:
+                out.append(f'{indent} * {ln}')
+        return out
+    return [indent + (ln if ln.startswith('//') else f'// {ln}'.rstrip()) for ln in raw]
+
+
+def _file_header(lines: list[str]) -> tuple[int, int] | None:
+    """파일 맨 앞(빈 줄 다음)의 주석 블록이 @file 헤더면 그 줄 범위 (뒤 빈 줄 하나 포함)."""
+    begin = 0
+    while begin < len(lines) and not lines[begin].strip():
+        begin += 1
+    end = begin
+    if end < len(lines) and lines[end].lstrip().startswith('/*'):
+        while end < len(lines) and '*/' not in lines[end]:
+            end += 1
+        end += 1
+    else:
+        while end < len(lines) and lines[end].lstrip().startswith('//'):
+            end += 1
+    if end == begin or not any(FILE_KEY in ln for ln in lines[begin:end]):
+        return None
+    if end < len(lines) and not lines[end].strip():
+        end += 1
+    return begin, min(end, len(lines))
+
+
+def splice_docs(code: str, docs: dict[str, str], symbols: list[CSymbol] | None = None) -> str:
+    """
+    docs의 주석을 각 심볼 선언 바로 위에 삽입한다.
+    이미 붙어 있는 주석 블록(파일 앞의 @file 헤더 포함)은 새 주석으로 교체한다. 코드 줄은 건드리지 않는다.
+    """
+    symbols = scan_top_level(code) if symbols is None else symbols
+    lines = code.split('\n')
+    targets = [(line_of(code, s.start), key) for key, s in zip(symbol_keys(symbols), symbols)]
+    if FILE_KEY in docs:
+        targets.append((0, FILE_KEY))
+
+    # 아래쪽부터 수정해야 위쪽 줄 번호가 유지된다
+    for line_idx, key in sorted(targets, key=lambda t: (t[0], t[1] != FILE_KEY), reverse=True):
+        if key not in docs:
+            continue
+        if key == FILE_KEY:
+            comment = _as_comment(docs[key], '') + ['']
+            begin, end = _file_header(lines) or (0, 0)
+            lines[begin:end] = comment
+            continue
+        decl = lines[line_idx]
+        indent = decl[:len(decl) - len(decl.lstrip())]
+        begin, end = leading_comment_lines(lines, line_idx)
+        lines[begin:end] = _as_comment(docs[key], indent)
+    return '\n'.join(lines)
@@ -0,0 +1,42 @@
+"""
+evaluator 출력(markdown)에서 항목별 판정과 요약 수치를 뽑는다.
+p9 평가 뒤에 붙는 LOCAL CHECK (util.realtime_check) 항목은 local 에 따로 담는다.
+"""
+
+import re
+from dataclasses import dataclass, field
+
+_ITEM_RE = re.compile(
+    r'Guideline_Item\s*:\s*(?P<item>.+?)\s*\n\s*\**\s*Status\s*\**\s*:\s*\**\s*(?P<status>PASS|FAIL|REVIEW(?: REQUIRED)?)',
+    re.IGNORECASE,
+)
+_LOCAL_RE = re.compile(r'Local_Item\s*:\s*(?P<item>.+?)\s*\n\s*Status\s*:\s*(?P<status>PASS|FAIL)')
+_RATE_RE = re.compile(r'Compliance Rate\s*:?\s*\**\s*([\d.]+)\s*%', re.IGNORECASE)
+
+
+@dataclass
+class EvalReport:
+    verdicts: dict[str, str] = field(default_factory=dict)   # item -> PASS | FAIL | REVIEW
+    compliance_rate: float | None = None
+    local: dict[str, str] = field(default_factory=dict)      # LOCAL CHECK item -> PASS | FAIL
+
+    @property
+    def local_failures(self) -> list[str]:
+        """LOCAL CHECK 에서 FAIL 인 항목. compliance rate 와 따로 step 을 막는다."""
+        return [item for item, v in self.local.items() if v == 'FAIL']
+
+
+def parse_eval_report(markdown: str) -> EvalReport:
+    report = EvalReport()
+    for m in _ITEM_RE.finditer(markdown):
+        item = m.group('item').strip().strip('*').strip()
+        report.verdicts[item] = m.group('status').upper().split()[0]
+    for m in _LOCAL_RE.finditer(markdown):
+        report.local[m.group('item').strip()] = m.group('status')
+    rate = _RATE_RE.search(markdown)
+    if rate:
+        report.compliance_rate = float(rate.group(1))
+    elif report.verdicts:
+        n_pass = sum(v == 'PASS' for v in report.verdicts.values())
+        report.compliance_rate = round(n_pass / len(report.verdicts) * 100, 2)
+    return report
@@ -0,0 +1,351 @@
+"""
+p8(formatting/naming) 를 LLM 없이 로컬에서 처리하는 엔진.
+1) 파일 안에서 선언된 심볼을 색인 (libclang 이 있으면 사용, 없으면 c_source 기반 스캐너)
+2) Google C++ style 이름으로 일관되게 rename
+3) clang-format (BasedOnStyle: Google) 적용
+4) stub 헤더로 컴파일해서 원본보다 나빠지지 않았는지 확인
+"""
+
+import re
+import shutil
+import subprocess
+from dataclasses import dataclass, field
+
+from util.c_source import mask_code, mask_preprocessor, scan_top_level, find_matching
+from util.compile_check import HOSTSIM_INCLUDE, compile_check, compiler_command, prepare_source
+
+CLANG_FORMAT_STYLE = '{BasedOnStyle: Google, ColumnLimit: 100, SortIncludes: Never}'
+
+# Arduino/ESP-IDF 런타임이 이름으로 찾는 진입점은 그대로 둔다
+ENTRY_POINTS = {'setup', 'loop', 'app_main', 'main'}
+
+_C_TYPES = {
+    'void', 'char', 'short', 'int', 'long', 'float', 'double', 'signed', 'unsigned', 'bool',
+    'boolean', 'byte', 'word', 'size_t', 'String', 'auto',
+}
+_QUALIFIERS = {'static', 'const', 'volatile', 'constexpr', 'extern', 'register', 'inline',
+               'struct', 'enum', 'union', 'unsigned', 'signed'}
+_KEYWORDS = _C_TYPES | _QUALIFIERS | {
+    'if', 'else', 'for', 'while', 'do', 'switch', 'case', 'default', 'break', 'continue',
+    'return', 'goto', 'sizeof', 'typedef', 'class', 'public', 'private', 'protected',
+    'true', 'false', 'nullptr', 'NULL', 'new', 'delete', 'this', 'operator', 'template',
+}
+_IDENT_RE = re.compile(r'\b[A-Za-z_]\w*\b')
+_WORD_RE = re.compile(r'[A-Z]+\d*(?=[A-Z][a-z])|[A-Z]?[a-z]+\d*|[A-Z]+\d*|\d+')
+
+
+@dataclass
+class FormatReport:
+    code: str
+    renames: dict[str, str] = field(default_factory=dict)
+    skipped: dict[str, str] = field(default_factory=dict)   # name -> 이유
+    clang_format: bool = False
+    indexer: str = 'scanner'
+    verified: bool = False
+    errors_before: int = 0
+    errors_after: int = 0
+
+
+# ------------- naming
+
+def _words(name: str) -> list[str]:
+    return [w.lower() for w in _WORD_RE.findall(name)]
+
+
+def to_pascal(name: str) -> str:
+    return ''.join(w.capitalize() for w in _words(name))
+
+
+def to_snake(name: str) -> str:
+    return '_'.join(_words(name))
+
+
+def to_constant(name: str) -> str:
+    return 'k' + to_pascal(name)
+
+
+def to_type(name: str) -> str:
+    # ErrorCode_t, elevator_t -> ErrorCode, Elevator
+    return to_pascal(re.sub(r'_t$', '', name))
+
+
+ROLE_STYLE = {
+    'function': to_pascal,
+    'type': to_type,
+    'constant': to_constant,
+    'variable': to_snake,
+    'field': to_snake,
+}
+
+
+# ------------- indexing
+
+def _type_like(word: str, declared_types: set[str]) -> bool:
+    return word in _C_TYPES or word in declared_types or word.endswith('_t') or word[:1].isupper()
+
+
+def _depths(masked: str) -> list[int]:
+    out, depth = [], 0
+    for ch in masked:
+        if ch == '{':
+            depth += 1
+        out.append(depth)
+        if ch == '}':
+            depth -= 1
+    return out
+
+
+def _decl_names(decl: str) -> list[tuple[str, bool]]:
+    """'const int a = 1, *b[3]' 같은 선언문에서 (이름, const 여부) 목록."""
+    prev = None
+    while prev != decl:
+        prev, decl = decl, re.sub(r'\([^()]*\)|\[[^\[\]]*\]|\{[^{}]*\}', ' ', decl)
+    parts = decl.split(',')
+    head_words = _IDENT_RE.findall(parts[0].split('=')[0])
+    base_const = 'const' in head_words[:-1] or 'constexpr' in head_words
+    out = []
+    for idx, part in enumerate(parts):
+        lhs = part.split('=')[0]
+        ids = _IDENT_RE.findall(lhs)
+        if not ids:
+            continue
+        name = ids[-1]
+        if name in _KEYWORDS:
+            continue
+        pointer = '*' in lhs
+        const = base_const and (not pointer or re.search(r'\*\s*const\b', lhs) is not None)
+        out.append((name, const))
+    return out
+
+
+def _statements(masked: str, depth: list[int]) -> list[tuple[str, bool]]:
+    """';' '{' '}' 로 나눈 문장들과 top-level 여부. '= {...}' 초기화 블록은 문장에 포함한다."""
+    out = []
+    start, i, n = 0, 0, len(masked)
+    while i < n:
+        ch = masked[i]
+        if ch == '{' and masked[start:i].rstrip().endswith('='):
+            close = find_matching(masked, i)
+            i = n if close < 0 else close + 1
+            continue
+        if ch in ';{}':
+            stmt = masked[start:i].strip()
+            if ch == ';' and stmt:
+                out.append((stmt, depth[i] == 0))
+            start = i + 1
+        i += 1
+    return out
+
+
+def _is_prototype(head: str, declared_types: set[str]) -> bool:
+    """'Foo bar(int a)' 는 prototype, 'Foo bar(21, PIN)' 은 생성자 호출로 본다."""
+    args = head[head.find('(') + 1:head.rfind(')')].strip()
+    if args in ('', 'void'):
+        return True
+    for part in args.split(','):
+        ids = [w for w in _IDENT_RE.findall(part) if w not in _QUALIFIERS]
+        if len(ids) >= 2 or (ids and (ids[0] in _C_TYPES or ids[0] in declared_types)):
+            return True
+    return False
+
+
+def index_with_scanner(code: str) -> dict[str, set[str]]:
+    """{이름: {role, ...}} 심볼 색인. role 이 둘 이상이면 rename 하지 않는다."""
+    masked = mask_code(code)
+    depth = _depths(masked)
+    roles: dict[str, set[str]] = {}
+
+    def add(name: str, role: str):
+        roles.setdefault(name, set()).add(role)
+
+    symbols = scan_top_level(code)
+    declared_types = set()
+    for s in symbols:
+        if s.kind == 'function':
+            add(s.name, 'function')
+            params = s.signature[s.signature.find('(') + 1:s.signature.rfind(')')]
+            for p in params.split(','):
+                ids = [w for w in _IDENT_RE.findall(re.sub(r'\[[^\]]*\]', '', p)) if w != 'const']
+                if len(ids) >= 2 and ids[-1] not in _KEYWORDS:
+                    add(ids[-1], 'variable')
+        else:
+            add(s.name, 'type')
+            declared_types.add(s.name)
+            tag = re.search(rf'\b{s.kind}\s+([A-Za-z_]\w*)', s.signature[:s.body_start - s.start])
+            if tag and tag.group(1) != s.name:
+                add(tag.group(1), 'type')
+                declared_types.add(tag.group(1))
+            body = masked[s.body_start + 1:find_matching(masked, s.body_start)]
+            if s.kind == 'enum':
+                for item in body.split(','):
+                    ids = _IDENT_RE.findall(item.split('=')[0])
+                    if ids:
+                        add(ids[0], 'constant')
+            else:
+                for stmt in body.split(';'):
+                    for name, _ in _decl_names(stmt):
+                        add(name, 'field')
+
+    # typedef <existing> Name;
+    for m in re.finditer(r'\btypedef\b[^;{}]*?\b([A-Za-z_]\w*)\s*;', masked):
+        add(m.group(1), 'type')
+        declared_types.add(m.group(1))
+
+    # 일반 변수 선언: 타입으로 시작하는 문장
+    for stmt, top in _statements(mask_preprocessor(masked), depth):
+        head = stmt.split('=')[0]
+        words = _IDENT_RE.findall(head.split('(')[0])
+        lead = [w for w in words if w not in _QUALIFIERS]
+        if len(lead) < 2 or lead[0] in _KEYWORDS - _C_TYPES or not _type_like(lead[0], declared_types):
+            continue
+        if '(' in head and _is_prototype(head, declared_types):
+            continue
+        static_local = not top and re.match(r'\s*static\b', stmt) is not None
+        for name, const in _decl_names(stmt):
+            role = 'constant' if const and (top or static_local) else 'variable'
+            add(name, role)
+    return roles
+
+
+def index_with_libclang(code: str, lang: str) -> dict[str, set[str]] | None:
+    """libclang(python clang.cindex)이 설치되어 있으면 AST 로 색인한다."""
+    try:
+        from clang import cindex
+    except ImportError:
+        return None
+    src, lang = prepare_source(code, lang)
+    args = compiler_command(lang)[1:]
+    try:
+        tu = cindex.Index.create().parse('sketch.c', args=args, unsaved_files=[('sketch.c', src)])
+    except cindex.TranslationUnitLoadError:
+        return None
+
+    K = cindex.CursorKind
+    roles: dict[str, set[str]] = {}
+    for cur in tu.cursor.walk_preorder():
+        if cur.location.file is None or cur.location.file.name != 'sketch.c' or not cur.spelling:
+            continue
+        role = None
+        if cur.kind == K.FUNCTION_DECL:
+            role = 'function'
+        elif cur.kind in (K.STRUCT_DECL, K.ENUM_DECL, K.UNION_DECL, K.CLASS_DECL, K.TYPEDEF_DECL):
+            role = 'type'
+        elif cur.kind == K.ENUM_CONSTANT_DECL:
+            role = 'constant'
+        elif cur.kind == K.FIELD_DECL:
+            role = 'field'
+        elif cur.kind in (K.VAR_DECL, K.PARM_DECL):
+            static_storage = cur.semantic_parent.kind == K.TRANSLATION_UNIT or \
+                cur.storage_class == cindex.StorageClass.STATIC
+            role = 'constant' if cur.type.is_const_qualified() and static_storage else 'variable'
+        if role:
+            roles.setdefault(cur.spelling, set()).add(role)
+    return roles
+
+
+# ------------- renaming
+
+def _header_identifiers() -> set[str]:
+    """stub 헤더가 선언하는 이름들. rename 결과가 라이브러리 이름을 가리지 않도록."""
+    names: set[str] = set()
+    for header in HOSTSIM_INCLUDE.rglob('*.h'):
+        names.update(_IDENT_RE.findall(mask_code(header.read_text(encoding='utf-8'))))
+    return names
+
+
+def plan_renames(code: str, roles: dict[str, set[str]]) -> tuple[dict[str, str], dict[str, str]]:
+    masked = mask_code(code)
+    existing = set(_IDENT_RE.findall(masked)) | _header_identifiers()
+    member_names = set(re.findall(r'(?:\.|->)\s*([A-Za-z_]\w*)', masked))
+    fields = {n for n, r in roles.items() if 'field' in r}
+
+    renames: dict[str, str] = {}
+    skipped: dict[str, str] = {}
+    for name, rs in sorted(roles.items()):
+        if name in ENTRY_POINTS or name in _KEYWORDS:
+            continue
+        targets = {ROLE_STYLE[r](name) for r in rs}
+        if len(targets) != 1:
+            skipped[name] = f'ambiguous roles {sorted(rs)}'
+            continue
+        new = targets.pop()
+        if not new or new == name:
+            continue
+        if name in member_names and name not in fields:
+            skipped[name] = 'also used as a library member'
+            continue
+        if new in existing or new in renames.values() or new in _KEYWORDS:
+            skipped[name] = f'{new} already in use'
+            continue
+        renames[name] = new
+    return renames, skipped
+
+
+def apply_renames(code: str, renames: dict[str, str]) -> str:
+    """주석/문자열/#include 를 제외한 식별자 토큰만 치환한다."""
+    if not renames:
+        return code
+    masked = mask_code(code)
+    out, last = [], 0
+    for m in _IDENT_RE.finditer(masked):
+        new = renames.get(m.group(0))
+        if new is None:
+            continue
+        line_begin = masked.rfind('\n', 0, m.start()) + 1
+        if re.match(r'\s*#\s*include\b', masked[line_begin:m.start()]):
+            continue
+        out.append(code[last:m.start()])
+        out.append(new)
+        last = m.end()
+    out.append(code[last:])
+    return ''.join(out)
+
+
+def run_clang_format(code: str) -> str | None:
+    exe = shutil.which('clang-format')
+    if exe is None:
+        return None
+    proc = subprocess.run([exe, f'--style={CLANG_FORMAT_STYLE}', '--assume-filename=sketch.cpp'],
+                          input=code, capture_output=True, text=True, timeout=30)
+    return proc.stdout if proc.returncode == 0 else None
+
+
+def _basic_format(code: str) -> str:
+    """clang-format 이 없을 때: 탭을 공백으로, 줄끝 공백 제거."""
+    lines = [ln.expandtabs(2).rstrip() for ln in code.split('\n')]
+    return '\n'.join(lines).strip('\n') + '\n'
+
+
+_DIAG_LOC_RE = re.compile(r'^.*?:\d+:\d+:\s*')
+_IDENT_RE = re.compile(r'\b[A-Za-z_]\w*\b')
+
+
+def _error_keys(errors: list[str], renames: dict[str, str] | None = None) -> set[str]:
+    """위치(file:line:col)를 뗀 진단 메시지. renames 를 주면 메시지 속 식별자도 새 이름으로 바꾼다."""
+    keys = set()
+    for e in errors:
+        msg = _DIAG_LOC_RE.sub('', e).strip()
+        if renames:
+            msg = _IDENT_RE.sub(lambda m: renames.get(m.group(0), m.group(0)), msg)
+        keys.add(msg)
+    return keys
+
+
+def format_and_rename(code: str) -> FormatReport:
+    before = compile_check(code)
+    roles = index_with_libclang(code, before.lang)
+    indexer = 'libclang'
+    if roles is None:
+        roles, indexer = index_with_scanner(code), 'scanner'
+
+    renames, skipped = plan_renames(code, roles)
+    renamed = apply_renames(code, renames)
+    formatted = run_clang_format(renamed)
+    report = FormatReport(code=formatted or _basic_format(renamed), renames=renames,
+                          skipped=skipped, clang_format=formatted is not None, indexer=indexer)
+
+    after = compile_check(report.code, before.lang)
+    report.errors_before, report.errors_after = len(before.errors), len(after.errors)
+    # 원래 있던 에러만 남아야 한다 (개수가 같아도 다른 에러로 바뀌었으면 실패)
+    report.verified = after.ok or (not before.ok and _error_keys(after.errors) <= _error_keys(before.errors, renames))
+    return report
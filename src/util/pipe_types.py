@@ -1,4 +1,4 @@
-from dataclasses import dataclass
+from dataclasses import dataclass, field
 
 
 @dataclass
@@ -7,6 +7,7 @@ class StageResult:
     prompt_name: str
     system_prompt: str
     code: str
+    scores: list[float] = field(default_factory=list)   # best-of-N 후보 점수 (샘플링하지 않았으면 비어 있음)
     
 @dataclass
 class StageEvalResult:
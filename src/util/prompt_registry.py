@@ -0,0 +1,73 @@
+"""
+프로세스 단위 prompt / template / graph 캐시.
+prompts/*.md 는 한 번만 읽고, 파일 mtime 이 바뀌면 다시 읽는다.
+template 과 compile 된 graph 도 사용한 prompt 파일의 mtime 에 묶여서 같이 무효화된다.
+"""
+
+import os
+from pathlib import Path
+from threading import Lock
+from typing import Any, Callable, Hashable
+
+from settings import PROJECT_ROOT
+
+PROMPT_DIR = PROJECT_ROOT / 'prompts'
+
+
+_paths: dict[str, str] = {}
+
+
+def prompt_path(name: str) -> str:
+    path = _paths.get(name)
+    if path is None:
+        path = _paths[name] = str(PROMPT_DIR / f'{name}.md')
+    return path
+
+
+class PromptRegistry:
+    def __init__(self):
+        self._texts: dict[str, tuple[int, str]] = {}
+        self._objects: dict[Hashable, tuple[tuple[int, ...], Any]] = {}
+        self._lock = Lock()
+        self.hits = 0
+        self.misses = 0
+
+    @staticmethod
+    def _mtime(path: str) -> int:
+        return os.stat(path).st_mtime_ns
+
+    def text(self, path: str) -> str:
+        mtime = self._mtime(path)
+        cached = self._texts.get(path)
+        if cached and cached[0] == mtime:
+            return cached[1]
+        text = Path(path).read_text(encoding='utf-8')
+        self._texts[path] = (mtime, text)
+        return text
+
+    def prompt(self, name: str) -> str:
+        return self.text(prompt_path(name))
+
+    def get(self, key: Hashable, prompt_names: list[str], build: Callable[[], Any]) -> Any:
+        """
+        key 로 캐시된 객체를 돌려준다. prompt_names 파일 중 하나라도 바뀌었으면 build() 로 다시 만든다.
+        """
+        stamp = tuple(self._mtime(prompt_path(n)) for n in prompt_names)
+        with self._lock:
+            cached = self._objects.get(key)
+            if cached and cached[0] == stamp:
+                self.hits += 1
+                return cached[1]
+            self.misses += 1
+            obj = build()
+            self._objects[key] = (stamp, obj)
+            return obj
+
+    def clear(self):
+        with self._lock:
+            self._texts.clear()
+            self._objects.clear()
+            self.hits = self.misses = 0
+
+
+registry = PromptRegistry()
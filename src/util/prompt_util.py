@@ -1,33 +1,43 @@
-from pathlib import Path
-from langchain_core.prompts import ChatPromptTemplate
+from typing import TYPE_CHECKING
+
+from util.prompt_registry import registry
+
+if TYPE_CHECKING:
+    from langchain_core.prompts import ChatPromptTemplate
 
 
 def load_system_prompt(name: str) -> str:
-    return Path(f'prompts/{name}.md').read_text(encoding='utf-8')
+    return registry.prompt(name)
 
 RAW_START = "{% raw %}"
 RAW_END = "{% endraw %}"
-    
-def build_generation_prompt(system_text: str, user_msg: str) -> ChatPromptTemplate:
+
+# template 종류. 사용자 입력/코드는 jinja 변수로 넘기므로 template 은 prompt 별로 한 번만 만든다.
+GENERATION = 'generation'
+REFINE = 'refine'
+DOC_SKELETON = 'doc_skeleton'
+
+def build_generation_prompt(system_text: str) -> 'ChatPromptTemplate':
     """
-    초기 코드 '생성'용 프롬프트 (첫 에이전트)
+    초기 코드 '생성'용 프롬프트 (첫 에이전트). 변수: user_msg
     """
     sys = (
         f"{RAW_START}{system_text.rstrip()}\n"
         "Return only C code. Do not include explanations outside code blocks."
         f'{RAW_END}'
     )
-    usr = f'{RAW_START}{user_msg}{RAW_END}'
+    usr = '{{ user_msg }}'
 
+    from langchain_core.prompts import ChatPromptTemplate
     return ChatPromptTemplate.from_messages(
         [("system", sys), ("user", usr)],
         template_format="jinja2"
     )
 
 
-def build_refine_prompt(system_text: str, prev_code: str) -> ChatPromptTemplate:
+def build_refine_prompt(system_text: str) -> 'ChatPromptTemplate':
     """
-    이전 단계 코드 '수정/강화'용 프롬프트 (후속 에이전트)
+    이전 단계 코드 '수정/강화'용 프롬프트 (후속 에이전트). 변수: code
     """
     sys = (
         f"{RAW_START}{system_text.rstrip()}\n"
@@ -37,10 +47,49 @@ def build_refine_prompt(system_text: str, prev_code: str) -> ChatPromptTemplate:
     user = (
         "Refine the following C code to fully satisfy the system rules. "
         "Preserve functionality, keep it compilable, and avoid adding external dependencies.\n\n"
-        f"{RAW_START}Here is the current code:\n```c\n{prev_code}\n```{RAW_END}"
+        "Here is the current code:\n```c\n{{ code }}\n```"
     )
+    from langchain_core.prompts import ChatPromptTemplate
     return ChatPromptTemplate.from_messages(
         [("system", sys),("user", user)],
         template_format="jinja2"
     )
 
+
+def build_doc_skeleton_prompt(system_text: str) -> 'ChatPromptTemplate':
+    """
+    p7 skeleton 모드용 프롬프트. 선언부만 보내고 심볼별 주석 블록만 돌려받는다. 변수: skeleton
+    """
+    sys = (
+        f"{RAW_START}{system_text.rstrip()}\n"
+        "You only write comments. Never output code."
+        f'{RAW_END}'
+    )
+    user = (
+        "Below is a skeleton of a C source file: includes, existing comments, "
+        "function signatures and type declarations. Each declaration is preceded by a marker line '@@ <key>'.\n"
+        "For every declaration, return the marker line followed by the complete comment block "
+        "that should be placed directly above it. Existing comments above a declaration are replaced by yours. "
+        "Use the key '@@ @file' for a file header comment. Output nothing else.\n\n"
+        "Here is the skeleton:\n```c\n{{ skeleton }}\n```"
+    )
+    from langchain_core.prompts import ChatPromptTemplate
+    return ChatPromptTemplate.from_messages(
+        [("system", sys), ("user", user)],
+        template_format="jinja2"
+    )
+
+
+_BUILDERS = {
+    GENERATION: build_generation_prompt,
+    REFINE: build_refine_prompt,
+    DOC_SKELETON: build_doc_skeleton_prompt,
+}
+
+
+def get_prompt_template(kind: str, prompt_name: str) -> 'ChatPromptTemplate':
+    """prompt 파일이 바뀌지 않았으면 캐시된 template 을 돌려준다."""
+    return registry.get(
+        ('template', kind, prompt_name), [prompt_name],
+        lambda: _BUILDERS[kind](load_system_prompt(prompt_name)),
+    )
@@ -0,0 +1,379 @@
+"""
+p9 (실시간 성능) 규칙을 컴파일러 없이 C 소스에서 확인한다.
+
+- blocking:  loop() 나 ISR 에서 닿는 함수 안의 delay(), waitForKey(), pulseIn(), Serial.readString() 같은 대기
+             (FreeRTOS task 는 delay 가 vTaskDelay 로 다른 task 에 CPU 를 넘기므로 ISR 경로만 본다)
+- critical:  noInterrupts()/portENTER_CRITICAL() ~ 짝이 되는 호출 사이의 LCD/Serial/I2C 출력, 대기, formatting,
+             while 반복문, 그리고 함수 안에서 풀지 않은 critical section.
+             EnterCriticalSection() 처럼 진입/해제만 하는 wrapper 함수도 따라간다.
+- busy-wait: millis()/digitalRead()/Serial.available() 등을 조건으로 도는 while 중 안에서 CPU 를 넘기지 않는 것
+- format:    hot path 의 sprintf/snprintf/strtod/atof 등. hot path 는 ISR 에서 닿는 함수와,
+             delay/vTaskDelay 로 주기를 두지 않고 도는 loop/task 반복부 (key 입력 처리 등) 에서 닿는 함수다.
+             한 번만 도는 초기화 코드나 1 초마다 도는 표시 갱신은 보지 않는다.
+
+주석과 문자열은 mask_code 로 지운 뒤 본다. 함수 호출 관계는 이름으로만 잇는다.
+"""
+
+import re
+from collections import Counter
+from dataclasses import dataclass, field
+
+from util.c_source import find_matching, line_of, mask_code, mask_preprocessor, scan_top_level
+
+REALTIME_PROMPT = 'p9'
+
+BLOCKING = 'blocking'
+CRITICAL = 'critical'
+BUSY_WAIT = 'busy-wait'
+FORMAT = 'format'
+
+# 평가 결과의 LOCAL CHECK 항목 (prompts/p9.md 의 항목 순서)
+RULE_ITEMS = {
+    BLOCKING: 'Non-blocking control flow',
+    CRITICAL: 'Bounded critical sections',
+    BUSY_WAIT: 'No busy-waits',
+    FORMAT: 'No heavy formatting in hot paths',
+}
+
+BLOCKING_CALLS = {'delay', 'delayMicroseconds', 'pulseIn', 'waitForKey', 'readString', 'readStringUntil',
+                  'readBytes', 'readBytesUntil', 'parseInt', 'parseFloat'}
+# CPU 를 넘기며 기다리는 호출. task 에서는 괜찮지만 critical section 안에서는 안 된다
+YIELDING_CALLS = {'vTaskDelay', 'vTaskDelayUntil', 'taskYIELD', 'yield', 'xQueueReceive', 'xQueuePeek',
+                  'xSemaphoreTake', 'ulTaskNotifyTake', 'xTaskNotifyWait', 'xEventGroupWaitBits'}
+FORMAT_CALLS = {'sprintf', 'snprintf', 'vsprintf', 'vsnprintf', 'printf', 'sscanf', 'strtod', 'strtof', 'strtold',
+                'atof', 'dtostrf'}
+# 반복부에서 조건 없이 부르면 그 loop/task 는 주기를 두고 돈다
+PACING_CALLS = {'delay', 'vTaskDelay', 'vTaskDelayUntil'}
+POLL_CALLS = {'millis', 'micros', 'digitalRead', 'analogRead', 'available', 'xTaskGetTickCount',
+              'esp_timer_get_time', 'gpio_get_level', 'getKey'}
+ENTER_CALLS = {'noInterrupts', 'cli', 'portENTER_CRITICAL', 'portENTER_CRITICAL_ISR', 'taskENTER_CRITICAL',
+               'taskENTER_CRITICAL_ISR', 'portDISABLE_INTERRUPTS', 'taskDISABLE_INTERRUPTS', 'vTaskSuspendAll'}
+EXIT_CALLS = {'interrupts', 'sei', 'portEXIT_CRITICAL', 'portEXIT_CRITICAL_ISR', 'taskEXIT_CRITICAL',
+              'taskEXIT_CRITICAL_ISR', 'portENABLE_INTERRUPTS', 'taskENABLE_INTERRUPTS', 'xTaskResumeAll'}
+OUTPUT_RECEIVERS = ('lcd', 'wire', 'display')       # 이 객체의 호출은 모두 bus 를 탄다
+SERIAL_OUTPUTS = ('print', 'write', 'flush')        # Serial.read() 는 buffer 만 읽는다
+OUTPUT_PREFIXES = ('lcd_', 'lcd1602_', 'i2c_master_', 'uart_write')
+
+_CALL_RE = re.compile(r'(?:\b([A-Za-z_]\w*)\s*(?:\.|->)\s*)?\b([A-Za-z_]\w*)\s*\(')
+_WHILE_RE = re.compile(r'\bwhile\s*\(')
+_LOOP_RE = re.compile(r'\b(?:while|for)\s*\(')
+_NOT_CALLS = {'if', 'for', 'while', 'switch', 'return', 'sizeof', 'defined'}
+_TASK_RE = re.compile(r'\bxTaskCreate\w*\s*\(\s*&?\s*([A-Za-z_]\w*)')
+_ISR_RE = re.compile(r'\b(?:attachInterrupt|gpio_isr_handler_add|timerAttachInterrupt)\s*\('
+                     r'(?:[^,()]|\([^()]*\))*,\s*&?\s*([A-Za-z_]\w*)')
+_FOREVER_RE = re.compile(r'\bwhile\s*\(\s*(?:1|true)\s*\)|\bfor\s*\(\s*;\s*;\s*\)')
+# AVR 식 wrapper 는 interrupts() 대신 저장해 둔 SREG 를 되돌려서 푼다
+_SREG_RESTORE_RE = re.compile(r'\bSREG\s*=(?!=)')
+# while (Serial.available()) 는 이미 온 byte 를 비우는 것이고, 비어 있는 동안 도는 것만 기다림이다
+_WAIT_EMPTY_RE = re.compile(r'!\s*(?:\w+\s*(?:\.|->)\s*)?available\s*\(\s*\)|available\s*\(\s*\)\s*(?:==\s*0|<\s*1|<=\s*0)')
+
+
+@dataclass
+class Finding:
+    rule: str
+    line: int           # 1-base
+    func: str
+    detail: str
+
+    @property
+    def where(self) -> str:
+        return f'{self.func}:{self.line}'
+
+
+@dataclass
+class Call:
+    receiver: str
+    name: str
+    offset: int
+
+    @property
+    def text(self) -> str:
+        return f'{self.receiver}.{self.name}()' if self.receiver else f'{self.name}()'
+
+    @property
+    def is_output(self) -> bool:
+        receiver = self.receiver.lower()
+        if receiver.startswith('serial'):
+            return self.name.startswith(SERIAL_OUTPUTS)
+        return (receiver.startswith(OUTPUT_RECEIVERS) and self.name not in POLL_CALLS) \
+            or self.name.startswith(OUTPUT_PREFIXES)
+
+
+@dataclass
+class RealtimeReport:
+    findings: list[Finding] = field(default_factory=list)
+    entries: dict[str, str] = field(default_factory=dict)     # 함수 -> loop | task | isr
+
+    @property
+    def counts(self) -> Counter:
+        return Counter(f.rule for f in self.findings)
+
+    @property
+    def passed(self) -> bool:
+        return not self.findings
+
+    def summary(self) -> str:
+        if not self.findings:
+            return 'no findings'
+        counts = self.counts
+        return f'{len(self.findings)} findings (' + ', '.join(f'{r} {counts[r]}' for r in RULE_ITEMS if counts[r]) + ')'
+
+
+@dataclass
+class _Function:
+    name: str
+    start: int
+    end: int
+    calls: list[Call]
+    restores: list[int]     # SREG 를 되돌리는 offset (critical section 해제)
+
+
+def _calls(masked: str, start: int, end: int) -> list[Call]:
+    return [Call(m[1] or '', m[2], m.start(2)) for m in _CALL_RE.finditer(masked, start, end)
+            if m[2] not in _NOT_CALLS]
+
+
+def _reach(funcs: dict[str, _Function], roots: list[str]) -> set[str]:
+    seen, todo = set(), [r for r in roots if r in funcs]
+    while todo:
+        fn = todo.pop()
+        if fn in seen:
+            continue
+        seen.add(fn)
+        todo += [c.name for c in funcs[fn].calls if c.name in funcs and not c.receiver]
+    return seen
+
+
+class _Checker:
+    def __init__(self, code: str):
+        self.code = code
+        self.masked = mask_preprocessor(mask_code(code))
+        self.funcs: dict[str, _Function] = {}
+        for s in scan_top_level(code):
+            if s.kind == 'function':
+                name = s.name.split('::')[-1]
+                self.funcs[name] = _Function(name, s.body_start, s.end, _calls(self.masked, s.body_start, s.end),
+                                             [m.start() for m in _SREG_RESTORE_RE.finditer(self.masked, s.body_start, s.end)])
+        self.report = RealtimeReport()
+        self._seen: set[tuple[str, int, str]] = set()
+        self._slow: dict[str, str | None] = {}
+
+    def add(self, rule: str, offset: int, func: str, detail: str):
+        line = line_of(self.code, offset) + 1
+        if (rule, line, detail) not in self._seen:
+            self._seen.add((rule, line, detail))
+            self.report.findings.append(Finding(rule, line, func, detail))
+
+    # ------- 진입점
+    def find_entries(self) -> tuple[set[str], set[str], set[str]]:
+        """(loop 경로, task 경로, ISR 경로) 함수"""
+        entries = self.report.entries
+        if 'loop' in self.funcs:
+            entries['loop'] = 'loop'
+        # ESP-IDF 는 app_main 이나 거기서 부른 함수의 무한 loop 가 Arduino loop() 에 해당한다
+        for name in sorted(_reach(self.funcs, ['app_main'])):
+            fn = self.funcs[name]
+            if _FOREVER_RE.search(self.masked, fn.start, fn.end):
+                entries[name] = 'loop'
+        for m in _TASK_RE.finditer(self.masked):
+            if m[1] in self.funcs:
+                entries.setdefault(m[1], 'task')
+        for m in _ISR_RE.finditer(self.masked):
+            if m[1] in self.funcs:
+                entries[m[1]] = 'isr'
+        for name, fn in self.funcs.items():
+            if 'IRAM_ATTR' in self.masked[max(0, fn.start - 200):fn.start].rsplit('}', 1)[-1]:
+                entries[name] = 'isr'
+        by_kind = {k: _reach(self.funcs, [n for n, kind in entries.items() if kind == k]) for k in ('loop', 'task', 'isr')}
+        return by_kind['loop'], by_kind['task'], by_kind['isr']
+
+    # ------- critical section
+    def _wrapper_kind(self, name: str) -> str | None:
+        fn = self.funcs.get(name)
+        if fn is None:
+            return None
+        enters = sum(c.name in ENTER_CALLS for c in fn.calls)
+        exits = sum(c.name in EXIT_CALLS for c in fn.calls) + len(fn.restores)
+        return 'enter' if enters > exits else 'exit' if exits > enters else None
+
+    def slow_reason(self, name: str) -> str | None:
+        """이 함수 (또는 부르는 함수) 안의 critical section 에 두면 안 되는 첫 호출"""
+        if name in self._slow:
+            return self._slow[name]
+        self._slow[name] = None
+        for c in self.funcs[name].calls:
+            reason = self._slow_call(c)
+            if reason:
+                self._slow[name] = reason if c.name not in self.funcs else f'{c.text} -> {reason}'
+                break
+        return self._slow[name]
+
+    def _slow_call(self, c: Call) -> str | None:
+        if c.name in BLOCKING_CALLS | YIELDING_CALLS | FORMAT_CALLS or c.is_output:
+            return c.text
+        if c.name in self.funcs and not c.receiver and not self._wrapper_kind(c.name):
+            return self.slow_reason(c.name)
+        return None
+
+    def check_critical(self):
+        for name, fn in self.funcs.items():
+            kind = self._wrapper_kind(name)
+            depth, opened = 0, 0
+            events = [(c.offset, 'call', c) for c in fn.calls]
+            events += [(m.start(), 'while', None) for m in _WHILE_RE.finditer(self.masked, fn.start, fn.end)]
+            events += [(offset, 'restore', None) for offset in fn.restores]
+            for offset, what, c in sorted(events, key=lambda e: e[0]):
+                if what == 'while':
+                    if depth:
+                        self.add(CRITICAL, offset, name, 'while loop inside critical section')
+                    continue
+                if what == 'restore':
+                    depth = max(0, depth - 1)
+                    continue
+                wrapper = None if c.receiver else self._wrapper_kind(c.name) if c.name != name else None
+                if c.name in ENTER_CALLS or wrapper == 'enter':
+                    depth, opened = depth + 1, opened if depth else offset
+                elif c.name in EXIT_CALLS or wrapper == 'exit':
+                    depth = max(0, depth - 1)
+                elif depth and (reason := self._slow_call(c)):
+                    detail = reason if reason == c.text else f'{c.text} -> {reason}'
+                    self.add(CRITICAL, c.offset, name, f'{detail} inside critical section')
+            if depth and kind != 'enter':
+                self.add(CRITICAL, opened, name, 'critical section not released in the same function')
+
+    # ------- busy-wait
+    def check_busy_wait(self, hot: set[str]):
+        for name in hot:
+            fn = self.funcs[name]
+            for m in _WHILE_RE.finditer(self.masked, fn.start, fn.end):
+                close = find_matching(self.masked, m.end() - 1)
+                if close < 0:
+                    continue
+                polled = [c for c in _calls(self.masked, m.end(), close) if c.name in POLL_CALLS]
+                if all(c.name == 'available' for c in polled) and not _WAIT_EMPTY_RE.search(self.masked, m.end(), close):
+                    continue
+                after = close + 1
+                while after < fn.end and self.masked[after].isspace():
+                    after += 1
+                body_end = find_matching(self.masked, after) if self.masked[after:after + 1] == '{' else after
+                # do { ... } while (...); 의 while 은 본문이 앞에 있다
+                before = self.masked[fn.start:m.start()].rstrip()
+                if before.endswith('}') and self.masked[after:after + 1] == ';':
+                    open_idx = self._open_of(fn.start, len(before) + fn.start - 1)
+                    body = _calls(self.masked, open_idx, m.start()) if open_idx is not None else []
+                else:
+                    body = _calls(self.masked, after, body_end) if body_end > after else []
+                if not any(c.name in BLOCKING_CALLS | YIELDING_CALLS for c in body):
+                    self.add(BUSY_WAIT, m.start(), name, f'while loop polls {polled[0].text} without yielding')
+
+    def _open_of(self, start: int, close: int) -> int | None:
+        """close 의 '}' 와 짝인 '{', 앞에 'do' 가 있을 때만"""
+        depth = 0
+        for i in range(close, start - 1, -1):
+            ch = self.masked[i]
+            if ch == '}':
+                depth += 1
+            elif ch == '{':
+                depth -= 1
+                if depth == 0:
+                    return i if self.masked[start:i].rstrip().endswith('do') else None
+        return None
+
+    # ------- blocking
+    def check_calls(self, loop: set[str], task: set[str], isr: set[str]):
+        for name in loop | task | isr:
+            in_isr = name in isr
+            where = ' in ISR path' if in_isr else ''
+            for c in self.funcs[name].calls:
+                if c.name in BLOCKING_CALLS and (name in loop or in_isr) and c.name != 'delayMicroseconds':
+                    self.add(BLOCKING, c.offset, name, f'{c.text} blocks{where}')
+                elif c.name in YIELDING_CALLS | {'delayMicroseconds'} and in_isr:
+                    self.add(BLOCKING, c.offset, name, f'{c.text}{where}')
+
+    # ------- format
+    def _repeat_body(self, name: str) -> tuple[int, int]:
+        """진입 함수에서 반복해서 도는 부분의 '{' 와 '}' offset. loop() 는 함수 전체이고,
+        task 는 while (running) 처럼 조건이 있어도 함수 바로 아래의 첫 반복문을 본다."""
+        fn = self.funcs[name]
+        if name != 'loop':
+            m = _FOREVER_RE.search(self.masked, fn.start, fn.end)
+            loops = [m] if m else [m for m in _LOOP_RE.finditer(self.masked, fn.start, fn.end)
+                                   if self._depth(fn.start, m.start()) == 1]
+            for m in loops[:1]:
+                after = find_matching(self.masked, m.end() - 1) + 1 if m[0].endswith('(') else m.end()
+                while 0 < after < fn.end and self.masked[after].isspace():
+                    after += 1
+                if self.masked[after:after + 1] == '{':
+                    return after, find_matching(self.masked, after)
+        return fn.start, fn.end - 1
+
+    def _depth(self, open_idx: int, offset: int) -> int:
+        between = self.masked[open_idx:offset]
+        return between.count('{') - between.count('}')
+
+    def _paced(self, name: str, open_idx: int, close: int) -> bool:
+        """반복부 바로 아래 (if/else 안이 아닌 곳) 에서 delay 로 주기를 두는지"""
+        for c in self.funcs[name].calls:
+            if c.name in PACING_CALLS and open_idx < c.offset < close:
+                if self._depth(open_idx, c.offset) == 1:
+                    return True
+        return False
+
+    def check_format(self, isr: set[str]):
+        # 함수 -> 검사할 범위. 진입 함수는 반복부만, 거기서 부르는 함수는 전체를 본다
+        spans = {name: (self.funcs[name].start, self.funcs[name].end) for name in isr}
+        for name, kind in self.report.entries.items():
+            if kind == 'isr':
+                continue
+            open_idx, close = self._repeat_body(name)
+            if close < 0 or self._paced(name, open_idx, close):
+                continue
+            spans.setdefault(name, (open_idx, close))
+            callees = [c.name for c in self.funcs[name].calls
+                       if open_idx < c.offset < close and c.name in self.funcs and not c.receiver and c.name != name]
+            for callee in _reach(self.funcs, callees):
+                spans[callee] = (self.funcs[callee].start, self.funcs[callee].end)
+        for name, (start, end) in spans.items():
+            where = ' in ISR path' if name in isr else ''
+            for c in self.funcs[name].calls:
+                if c.name in FORMAT_CALLS and start < c.offset < end:
+                    self.add(FORMAT, c.offset, name, f'{c.text} on hot path{where}')
+
+    def run(self) -> RealtimeReport:
+        loop, task, isr = self.find_entries()
+        self.check_calls(loop, task, isr)
+        self.check_format(isr)
+        self.check_busy_wait(loop | task | isr)
+        self.check_critical()
+        self.report.findings.sort(key=lambda f: (list(RULE_ITEMS).index(f.rule), f.line))
+        return self.report
+
+
+def realtime_check(code: str) -> RealtimeReport:
+    return _Checker(code).run()
+
+
+def format_local_check(report: RealtimeReport, limit: int = 5) -> str:
+    """평가 결과 뒤에 붙는 LOCAL CHECK 절. 형식은 COMPLIANCE MATRIX 와 같다 (Guideline_Item 대신 Local_Item)."""
+    by_rule: dict[str, list[Finding]] = {r: [] for r in RULE_ITEMS}
+    for f in report.findings:
+        by_rule[f.rule].append(f)
+    passed = sum(not fs for fs in by_rule.values())
+    lines = ['4) LOCAL CHECK (static, p9 real-time rules)', '',
+             f'Local Pass: {passed} / {len(RULE_ITEMS)}', '']
+    for rule, item in RULE_ITEMS.items():
+        fs = by_rule[rule]
+        if fs:
+            evidence = '; '.join(f'{f.where} {f.detail}' for f in fs[:limit])
+            evidence += f' (+{len(fs) - limit} more)' if len(fs) > limit else ''
+        else:
+            evidence = 'no matching pattern found'
+        lines += [f'Local_Item: {item}', f'Status: {"FAIL" if fs else "PASS"}', f'Reason: {evidence}', '']
+    return '\n'.join(lines).rstrip() + '\n'
+
+
+def with_local_check(prompt_names: list[str], code: str, markdown: str) -> str:
+    """p9 를 평가한 결과면 로컬 검사 절을 붙인다."""
+    if REALTIME_PROMPT not in prompt_names or not code:
+        return markdown
+    return markdown.rstrip() + '\n\n' + format_local_check(realtime_check(code))
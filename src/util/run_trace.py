@@ -0,0 +1,104 @@
+"""
+실행 중 stage / evaluation / LLM 호출 / 컴파일 구간을 기록한다 (profiler 입력).
+꺼져 있으면 span() 은 아무것도 하지 않는다.
+query 같은 실행 문맥은 context() 로 묶어 두면 그 안의 span 에 같이 기록된다.
+"""
+
+import json
+import os
+import threading
+import time
+from contextlib import contextmanager
+from contextvars import ContextVar
+from dataclasses import asdict, dataclass, field
+from itertools import count
+from pathlib import Path
+
+_context: ContextVar[dict] = ContextVar('run_trace_context', default={})
+_parent: ContextVar[int | None] = ContextVar('run_trace_parent', default=None)
+
+STAGE = 'stage'
+EVAL = 'eval'
+LLM = 'llm'
+COMPILE = 'compile'
+
+
+@dataclass
+class Span:
+    id: int
+    name: str
+    cat: str                # STAGE | EVAL | LLM | COMPILE
+    start: float            # epoch 초
+    end: float
+    backend: str | None = None      # LLM model, 'gcc', worker 등 시간을 쓰는 자원
+    parent: int | None = None
+    pid: int = 0
+    tid: int = 0
+    args: dict = field(default_factory=dict)
+
+    @property
+    def duration(self) -> float:
+        return self.end - self.start
+
+
+class RunTrace:
+    def __init__(self):
+        self.enabled = False
+        self.spans: list[Span] = []
+        self._ids = count(1)
+        self._lock = threading.Lock()
+
+    def enable(self):
+        self.enabled = True
+
+    def add(self, span: Span):
+        with self._lock:
+            self.spans.append(span)
+
+    def next_id(self) -> int:
+        with self._lock:
+            return next(self._ids)
+
+    def dump(self, path: str | Path):
+        with open(path, 'w', encoding='utf-8') as fp:
+            for s in self.spans:
+                fp.write(json.dumps(asdict(s), ensure_ascii=False) + '\n')
+
+
+def load_spans(path: str | Path) -> list[Span]:
+    return [Span(**json.loads(ln)) for ln in Path(path).read_text(encoding='utf-8').splitlines() if ln.strip()]
+
+
+tracer = RunTrace()
+
+
+@contextmanager
+def context(**values):
+    """with context(query='i1'): 안의 span 에 query 를 붙인다."""
+    token = _context.set({**_context.get(), **values})
+    try:
+        yield
+    finally:
+        _context.reset(token)
+
+
+def current(key: str, default=None):
+    """context() 로 묶인 값 (없으면 default)."""
+    return _context.get().get(key, default)
+
+
+@contextmanager
+def span(name: str, cat: str, backend: str | None = None, **args):
+    if not tracer.enabled:
+        yield
+        return
+    sid = tracer.next_id()
+    parent = _parent.get()
+    token = _parent.set(sid)
+    start = time.time()
+    try:
+        yield
+    finally:
+        _parent.reset(token)
+        tracer.add(Span(sid, name, cat, start, time.time(), backend, parent, os.getpid(),
+                        threading.get_ident(), {**_context.get(), **args}))
@@ -0,0 +1,90 @@
+"""
+컴파일러 없이 계산하는 함수 단위 정적 지표 (줄 수, 매개변수, 중첩 깊이, cyclomatic complexity).
+주석과 문자열은 mask_code 로 지운 뒤 센다.
+"""
+
+import re
+from dataclasses import dataclass, field
+
+from util.c_source import mask_code, scan_top_level
+
+_BRANCH_RE = re.compile(r'\b(if|for|while|case)\b|&&|\|\||\?')
+_ALLOC_RE = re.compile(r'\b(malloc|calloc|realloc|new)\b')
+
+
+@dataclass
+class FunctionMetrics:
+    name: str
+    lines: int
+    params: int
+    nesting: int        # 본문 안 최대 '{' 깊이 (본문 자체는 0)
+    cyclomatic: int
+
+
+@dataclass
+class StaticMetrics:
+    lines: int
+    functions: list[FunctionMetrics] = field(default_factory=list)
+    dynamic_alloc: int = 0
+
+    def _max(self, attr: str) -> int:
+        return max((getattr(f, attr) for f in self.functions), default=0)
+
+    @property
+    def max_lines(self) -> int:
+        return self._max('lines')
+
+    @property
+    def max_params(self) -> int:
+        return self._max('params')
+
+    @property
+    def max_nesting(self) -> int:
+        return self._max('nesting')
+
+    @property
+    def max_cyclomatic(self) -> int:
+        return self._max('cyclomatic')
+
+
+def _param_count(signature: str) -> int:
+    inner = signature[signature.find('(') + 1:signature.rfind(')')].strip()
+    if inner in ('', 'void'):
+        return 0
+    depth, count = 0, 1
+    for c in inner:
+        if c in '(<[':
+            depth += 1
+        elif c in ')>]':
+            depth -= 1
+        elif c == ',' and depth == 0:
+            count += 1
+    return count
+
+
+def _nesting(body: str) -> int:
+    depth = deepest = 0
+    for c in body:
+        if c == '{':
+            depth += 1
+            deepest = max(deepest, depth)
+        elif c == '}':
+            depth -= 1
+    return max(deepest - 1, 0)
+
+
+def static_metrics(code: str) -> StaticMetrics:
+    masked = mask_code(code)
+    metrics = StaticMetrics(lines=code.count('\n') + 1, dynamic_alloc=len(_ALLOC_RE.findall(masked)))
+    for s in scan_top_level(code):
+        if s.kind != 'function':
+            continue
+        body = masked[s.body_start:s.end]
+        metrics.functions.append(FunctionMetrics(
+            name=s.name,
+            lines=body.count('\n') + 1,
+            params=_param_count(s.signature),
+            nesting=_nesting(body),
+            cyclomatic=1 + len(_BRANCH_RE.findall(body)),
+        ))
+    return metrics
@@ -0,0 +1,57 @@
+"""
+LLM 호출별 token / latency 기록.
+provider 가 usage 를 돌려주지 않으면 token 은 compaction.count_tokens 로 추정한다.
+"""
+
+import json
+from dataclasses import asdict, dataclass
+from pathlib import Path
+from threading import Lock
+
+from util.compaction import count_tokens
+
+
+@dataclass
+class UsageRecord:
+    kind: str            # 'generation' | 'evaluation'
+    prompt: str          # prompt 이름 (평가에서 여러 개면 ','로 연결)
+    tier: str
+    model: str
+    input_tokens: int
+    output_tokens: int
+    latency: float       # 초
+    estimated: bool = False   # token 수가 추정치인지
+
+
+def message_usage(msg, input_text: str, model_name: str) -> tuple[int, int, bool]:
+    """(input, output, estimated). AIMessage.usage_metadata 가 없으면 text 로 추정."""
+    meta = getattr(msg, 'usage_metadata', None) or {}
+    if meta.get('input_tokens') is not None and meta.get('output_tokens') is not None:
+        return meta['input_tokens'], meta['output_tokens'], False
+    return count_tokens(input_text, model_name), count_tokens(msg.content or '', model_name), True
+
+
+class UsageLedger:
+    def __init__(self):
+        self.records: list[UsageRecord] = []
+        self._lock = Lock()
+
+    def __len__(self) -> int:
+        return len(self.records)
+
+    def add(self, record: UsageRecord):
+        with self._lock:
+            self.records.append(record)
+
+    def dump(self, path: str | Path):
+        with open(path, 'w', encoding='utf-8') as fp:
+            for r in self.records:
+                fp.write(json.dumps(asdict(r), ensure_ascii=False) + '\n')
+
+    @classmethod
+    def load(cls, path: str | Path) -> 'UsageLedger':
+        ledger = cls()
+        for line in Path(path).read_text(encoding='utf-8').splitlines():
+            if line.strip():
+                ledger.add(UsageRecord(**json.loads(line)))
+        return ledger
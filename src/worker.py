@@ -0,0 +1,164 @@
+"""
+job_queue 를 쓰는 sweep 실행기.
+
+  # sweep 등록 (user_queries 전체, 샘플 3개)
+  PYTHONPATH=src python -m worker enqueue --db sweep.db --sweep s1 --samples 3
+  # worker 4개 실행 (다른 host 에서도 같은 DB 파일을 가리키면 된다)
+  PYTHONPATH=src python -m worker work --db sweep.db --procs 4
+  # 진행률 / 처리량
+  PYTHONPATH=src python -m worker status --db sweep.db
+  # 결과를 gen_pipe / eval_pipe 형식으로 내보내기
+  PYTHONPATH=src python -m worker export --db sweep.db --out-dir sweep_out
+  # NFS 등 공유 파일 시스템의 DB 는 모든 명령에 --no-wal (journal mode 는 DB 파일에 남는다)
+  PYTHONPATH=src python -m worker --no-wal status --db /nfs/sweep.db
+"""
+
+import argparse
+import multiprocessing
+import time
+import traceback
+from pathlib import Path
+
+from job_queue import EVALUATE, GENERATE, Job, JobQueue, worker_name
+
+ROOT_DIR = Path(__file__).resolve().parent.parent
+DEFAULT_PROMPTS = ['p0', 'p1', 'p2', 'p3', 'p4', 'p5', 'p6', 'p7', 'p8', 'p9']
+
+
+class StageRunner:
+    """job 하나 = LLM stage 하나. agent/evaluator 는 worker 프로세스마다 한 번만 만든다."""
+
+    def __init__(self, router_policy: str | None = None):
+        from pipe_agent import PipeAgent
+        from evaluation import Evaluator
+        router = None
+        if router_policy:
+            from routing import ModelRouter
+            router = ModelRouter.from_file(router_policy)
+        self.agent = PipeAgent(router=router)
+        self.evaluator = Evaluator(router=router)
+
+    def run(self, queue: JobQueue, job: Job) -> str:
+        if job.kind == GENERATE:
+            code = queue.output(job.input_job) or ''
+            return self.agent._run_stage(job.prompt, code, queue.query_text(job.query))
+        if job.kind == EVALUATE:
+            code = queue.output(job.input_job)
+            # 평가 baseline 은 이전 단계 code (generation job 의 입력)
+            prev_job = queue.conn.execute('SELECT input_job FROM jobs WHERE id = ?', (job.input_job,)).fetchone()
+            baseline = queue.output(prev_job['input_job']) if prev_job else None
+            return self.evaluator.invoke([job.prompt], code, baseline=baseline)
+        raise ValueError(f'unknown job kind: {job.kind}')
+
+
+def work(db: str, lease: float, max_attempts: int, idle_exit: float, router_policy: str | None,
+         wal: bool = True) -> int:
+    queue = JobQueue(db, wal=wal)
+    runner = StageRunner(router_policy)
+    me = worker_name()
+    done, idle_since = 0, time.time()
+    while True:
+        job = queue.claim(me, lease, max_attempts)
+        if job is None:
+            if time.time() - idle_since > idle_exit:
+                break
+            time.sleep(1.0)
+            continue
+        try:
+            output = runner.run(queue, job)
+        except Exception:
+            queue.fail(job, me, traceback.format_exc(limit=5), max_attempts)
+            print(f'[WORKER] {me} {job.id} failed (attempt {job.attempts})')
+        else:
+            if queue.complete(job, me, output):
+                done += 1
+                print(f'[WORKER] {me} {job.id} done')
+            else:
+                print(f'[WORKER] {me} {job.id} lost lease, result dropped')
+        idle_since = time.time()
+    queue.close()
+    return done
+
+
+def _work_proc(args):
+    return work(*args)
+
+
+def export(queue: JobQueue, out_dir: Path, sweep: str | None):
+    """main.py 와 같은 이름 규칙. sample 이 여러 개면 query 폴더 아래 s{n} 으로 나눈다."""
+    n = 0
+    samples = {r[0] for r in queue.conn.execute('SELECT DISTINCT sample FROM jobs')}
+    for row in queue.done_jobs(sweep):
+        sub = Path(row['query']) / f's{row["sample"]}' if len(samples) > 1 else Path(row['query'])
+        kind_dir, ext = ('gen_pipe', 'c') if row['kind'] == GENERATE else ('eval_pipe', 'md')
+        path = out_dir / kind_dir / sub / f'out_step{row["step"]}_{row["query"]}_{row["prompt"]}.{ext}'
+        path.parent.mkdir(parents=True, exist_ok=True)
+        path.write_text(row['output'], encoding='utf-8')
+        n += 1
+    print(f'[WORKER] exported {n} files to {out_dir}')
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--no-wal', action='store_true', help='NFS 등 공유 파일 시스템에서 사용 (모든 명령)')
+    sub = parser.add_subparsers(dest='cmd', required=True)
+
+    p = sub.add_parser('enqueue')
+    p.add_argument('--db', required=True)
+    p.add_argument('--sweep', default='default')
+    p.add_argument('--queries', nargs='*', default=[], help='user_queries 의 파일 이름(확장자 제외). 비우면 전체')
+    p.add_argument('--prompts', nargs='*', default=DEFAULT_PROMPTS)
+    p.add_argument('--samples', type=int, default=1)
+    p.add_argument('--no-eval', action='store_true')
+
+    p = sub.add_parser('work')
+    p.add_argument('--db', required=True)
+    p.add_argument('--procs', type=int, default=1)
+    p.add_argument('--lease', type=float, default=900.0, help='job 하나의 lease (초)')
+    p.add_argument('--max-attempts', type=int, default=3)
+    p.add_argument('--idle-exit', type=float, default=30.0, help='할 일이 없으면 이 시간 뒤 종료 (초)')
+    p.add_argument('--routing-policy', default=None)
+
+    p = sub.add_parser('status')
+    p.add_argument('--db', required=True)
+    p.add_argument('--sweep', default=None)
+    p.add_argument('--window', type=float, default=600.0, help='처리량 계산 구간 (초)')
+
+    p = sub.add_parser('retry')
+    p.add_argument('--db', required=True)
+    p.add_argument('--sweep', default=None)
+
+    p = sub.add_parser('export')
+    p.add_argument('--db', required=True)
+    p.add_argument('--sweep', default=None)
+    p.add_argument('--out-dir', required=True)
+
+    args = parser.parse_args()
+    if args.cmd == 'work':
+        params = (args.db, args.lease, args.max_attempts, args.idle_exit, args.routing_policy, not args.no_wal)
+        if args.procs == 1:
+            total = work(*params)
+        else:
+            with multiprocessing.Pool(args.procs) as pool:
+                total = sum(pool.map(_work_proc, [params] * args.procs))
+        print(f'[WORKER] {total} jobs completed')
+        return
+
+    queue = JobQueue(args.db, wal=not args.no_wal)
+    if args.cmd == 'enqueue':
+        files = sorted((ROOT_DIR / 'user_queries').glob('*.txt'))
+        queries = {f.stem: f.read_text(encoding='utf-8') for f in files
+                   if not args.queries or f.stem in args.queries}
+        added = queue.enqueue_sweep(args.sweep, queries, args.prompts, args.samples, not args.no_eval)
+        print(f'[QUEUE] {added} jobs added to sweep {args.sweep}')
+    elif args.cmd == 'status':
+        print(queue.progress(args.sweep, args.window).format())
+    elif args.cmd == 'retry':
+        print(f'[QUEUE] {queue.retry_failed(args.sweep)} failed jobs reset')
+    elif args.cmd == 'export':
+        export(queue, Path(args.out_dir), args.sweep)
+    queue.close()
+
+
+if __name__ == '__main__':
+    main()
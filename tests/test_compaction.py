@@ -0,0 +1,93 @@
+"""util.compaction: 규칙별 정책과 token budget 처리."""
+
+import sys
+import unittest
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[1] / 'src'))
+
+from util.compaction import (EVAL_POLICIES, CompactionPolicy, TokenBudgetExceeded, compact,
+                             compact_for_eval, compact_for_refine, merge_policies)
+
+MODEL = 'gpt-4.1'
+
+BASELINE = """\
+static int helper(int x)
+{
+    int y = x * 2;
+    for (int i = 0; i < 8; i++) {
+        y += i * x;
+    }
+    return y + 1;
+}
+
+void loop()
+{
+    helper(1);
+}
+"""
+
+CODE = BASELINE.replace('helper(1);', 'helper(2);')
+
+
+class PolicyTest(unittest.TestCase):
+    def test_p3_keeps_whitespace(self):
+        # 빈 줄과 들여쓰기까지 함수 줄 수에 들어간다
+        code = 'void f()\n{\n    int a;\n\n\n    a = 1;   \n}\n'
+        self.assertEqual(compact(code, EVAL_POLICIES['p3'], MODEL).code, code)
+
+    def test_p8_sends_code_as_is(self):
+        self.assertEqual(EVAL_POLICIES['p8'], CompactionPolicy())
+        result = compact(CODE, EVAL_POLICIES['p8'], MODEL, budget=1, baseline=BASELINE)
+        self.assertEqual(result.code, CODE)
+        self.assertEqual(result.elided, [])
+
+    def test_p9_keeps_unchanged_helpers(self):
+        # 실시간 규칙은 바뀌지 않은 helper 의 delay/print 도 봐야 한다
+        self.assertFalse(EVAL_POLICIES['p9'].elide_unchanged)
+        result = compact(CODE, EVAL_POLICIES['p9'], MODEL, budget=1, baseline=BASELINE)
+        self.assertEqual(result.elided, [])
+        self.assertIn('y += i * x;', result.code)
+
+    def test_merge_is_conservative(self):
+        merged = merge_policies(['p2', 'p3'])
+        self.assertFalse(merged.strip_comments)
+        self.assertFalse(merged.collapse_whitespace)
+        self.assertEqual(merge_policies([]), CompactionPolicy())
+
+
+class BudgetTest(unittest.TestCase):
+    def test_elides_unchanged_helper_first(self):
+        policy = CompactionPolicy(elide_unchanged=True)
+        full = compact(CODE, policy, MODEL).tokens_after
+        result = compact(CODE, policy, MODEL, budget=full - 1, baseline=BASELINE)
+        self.assertEqual(result.elided, ['helper'])
+        self.assertIn('helper(2);', result.code)
+        self.assertFalse(result.over_budget)
+
+    def test_entry_points_are_kept(self):
+        policy = CompactionPolicy(elide_unchanged=True)
+        result = compact(BASELINE, policy, MODEL, budget=1, baseline=BASELINE)
+        self.assertNotIn('loop', result.elided)
+        self.assertTrue(result.over_budget)
+
+    def test_over_budget_is_sent_unless_strict(self):
+        result = compact_for_eval(CODE, ['p8'], MODEL, BASELINE, budget=1)
+        self.assertTrue(result.over_budget)
+        self.assertEqual(result.code, CODE)
+        self.assertTrue(compact_for_refine(CODE, 'p2', MODEL, budget=1).over_budget)
+
+    def test_strict_raises(self):
+        with self.assertRaises(TokenBudgetExceeded) as cm:
+            compact_for_eval(CODE, ['p8'], MODEL, BASELINE, budget=1, strict=True)
+        self.assertEqual(cm.exception.budget, 1)
+        with self.assertRaises(TokenBudgetExceeded):
+            compact_for_refine(CODE, 'p2', MODEL, budget=1, strict=True)
+
+    def test_zero_budget_is_unlimited(self):
+        result = compact_for_eval(CODE, ['p8'], MODEL, budget=0, strict=True)
+        self.assertFalse(result.over_budget)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,100 @@
+"""job_queue: enqueue / claim / complete / fail 과 lease 처리."""
+
+import sys
+import tempfile
+import unittest
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[1] / 'src'))
+
+from job_queue import DONE, EVALUATE, FAILED, GENERATE, PENDING, JobQueue, job_id
+
+QUERIES = {'i1': 'blink', 'i2': 'calc'}
+PROMPTS = ['p0', 'p1', 'p2']
+
+
+class JobQueueTest(unittest.TestCase):
+    def setUp(self):
+        self.tmp = tempfile.TemporaryDirectory()
+        self.queue = JobQueue(Path(self.tmp.name) / 'q.db', wal=False)
+
+    def tearDown(self):
+        self.queue.close()
+        self.tmp.cleanup()
+
+    def status(self, id_: str) -> str:
+        return self.queue.conn.execute('SELECT status FROM jobs WHERE id = ?', (id_,)).fetchone()['status']
+
+    def expire(self, id_: str):
+        self.queue.conn.execute('UPDATE jobs SET lease_until = 0 WHERE id = ?', (id_,))
+
+    def test_enqueue_is_idempotent(self):
+        # query 마다 generation 3 + evaluation 2
+        self.assertEqual(self.queue.enqueue_sweep('s', QUERIES, PROMPTS), 10)
+        self.assertEqual(self.queue.enqueue_sweep('s', QUERIES, PROMPTS), 0)
+        self.assertEqual(self.queue.enqueue_sweep('s', QUERIES, PROMPTS, samples=2), 10)
+
+    def test_claim_waits_for_input_job(self):
+        self.queue.enqueue_sweep('s', {'i1': 'blink'}, PROMPTS)
+        first = self.queue.claim('w1')
+        self.assertEqual((first.kind, first.step), (GENERATE, 0))
+        # p0 이 끝나기 전에는 p1 을 가져갈 수 없다
+        self.assertIsNone(self.queue.claim('w2'))
+        self.assertTrue(self.queue.complete(first, 'w1', 'code0'))
+        second = self.queue.claim('w2')
+        self.assertEqual((second.step, second.input_job), (1, first.id))
+        self.assertEqual(self.queue.output(second.input_job), 'code0')
+
+    def test_evaluation_before_next_generation(self):
+        self.queue.enqueue_sweep('s', {'i1': 'blink'}, PROMPTS)
+        self.queue.complete(self.queue.claim('w'), 'w', 'code0')
+        self.queue.complete(self.queue.claim('w'), 'w', 'code1')
+        job = self.queue.claim('w')
+        self.assertEqual((job.kind, job.step), (EVALUATE, 1))
+
+    def test_expired_lease_is_reclaimed(self):
+        self.queue.enqueue_sweep('s', {'i1': 'blink'}, PROMPTS)
+        job = self.queue.claim('w1')
+        self.assertIsNone(self.queue.claim('w2'))
+        self.expire(job.id)
+        again = self.queue.claim('w2')
+        self.assertEqual((again.id, again.attempts), (job.id, 2))
+        # 늦게 끝난 w1 은 결과를 덮어쓰지 못한다
+        self.assertFalse(self.queue.complete(job, 'w1', 'late'))
+        self.assertTrue(self.queue.complete(again, 'w2', 'code0'))
+        self.assertEqual(self.queue.output(job.id), 'code0')
+
+    def test_expired_lease_after_max_attempts_fails(self):
+        self.queue.enqueue_sweep('s', {'i1': 'blink'}, PROMPTS)
+        id_ = job_id('s', GENERATE, 'i1', 0, 0)
+        for attempt in range(1, 3):
+            job = self.queue.claim(f'w{attempt}', max_attempts=2)
+            self.assertEqual((job.id, job.attempts), (id_, attempt))
+            self.expire(id_)
+        self.assertIsNone(self.queue.claim('w3', max_attempts=2))
+        self.assertEqual(self.status(id_), FAILED)
+        error = self.queue.conn.execute('SELECT error FROM jobs WHERE id = ?', (id_,)).fetchone()['error']
+        self.assertIn('lease expired after 2 attempts', error)
+
+    def test_fail_retries_until_max_attempts(self):
+        self.queue.enqueue_sweep('s', {'i1': 'blink'}, PROMPTS)
+        job = self.queue.claim('w')
+        self.assertTrue(self.queue.fail(job, 'w', 'boom', max_attempts=2))
+        self.assertEqual(self.status(job.id), PENDING)
+        job = self.queue.claim('w')
+        self.queue.fail(job, 'w', 'boom', max_attempts=2)
+        self.assertEqual(self.status(job.id), FAILED)
+        self.assertEqual(self.queue.retry_failed('s'), 1)
+        self.assertEqual(self.queue.claim('w').attempts, 1)
+
+    def test_progress_counts(self):
+        self.queue.enqueue_sweep('s', {'i1': 'blink'}, PROMPTS)
+        self.queue.complete(self.queue.claim('w'), 'w', 'code0')
+        progress = self.queue.progress('s')
+        self.assertEqual(progress.total(), 5)
+        self.assertEqual(progress.total(DONE), 1)
+        self.assertEqual(progress.workers['w'][0], 1)
+
+
+if __name__ == '__main__':
+    unittest.main()
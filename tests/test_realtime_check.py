@@ -0,0 +1,121 @@
+"""util.realtime_check: p9 규칙별 검출과 LOCAL CHECK 절."""
+
+import sys
+import unittest
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[1] / 'src'))
+
+from util.eval_report import parse_eval_report
+from util.realtime_check import (BLOCKING, BUSY_WAIT, CRITICAL, FORMAT, RULE_ITEMS, format_local_check,
+                                 realtime_check, with_local_check)
+
+
+def rules(code: str) -> list[tuple[str, str]]:
+    return [(f.rule, f.func) for f in realtime_check(code).findings]
+
+
+class BlockingTest(unittest.TestCase):
+    def test_delay_in_loop(self):
+        self.assertEqual(rules('void loop() {\n  delay(100);\n}\n'), [(BLOCKING, 'loop')])
+
+    def test_task_may_delay(self):
+        code = ('void worker(void *arg) {\n  for (;;) {\n    vTaskDelay(10);\n    delay(5);\n  }\n}\n'
+                'void app_main(void) {\n  xTaskCreate(worker, "w", 2048, NULL, 1, NULL);\n}\n')
+        self.assertEqual(rules(code), [])
+
+    def test_yield_in_isr(self):
+        code = ('void IRAM_ATTR on_edge(void *arg) {\n  vTaskDelay(1);\n}\n'
+                'void app_main(void) {\n  gpio_isr_handler_add(4, on_edge, NULL);\n}\n')
+        self.assertEqual(rules(code), [(BLOCKING, 'on_edge')])
+
+
+class CriticalTest(unittest.TestCase):
+    def test_output_inside_section(self):
+        code = 'void loop() {\n  noInterrupts();\n  lcd.print("x");\n  interrupts();\n}\n'
+        self.assertEqual(rules(code), [(CRITICAL, 'loop')])
+
+    def test_wrapper_pair(self):
+        code = ('static void enter(void) { noInterrupts(); }\n'
+                'static void leave(void) { interrupts(); }\n'
+                'void loop() {\n  enter();\n  Serial.println(1);\n  leave();\n}\n')
+        self.assertEqual(rules(code), [(CRITICAL, 'loop')])
+
+    def test_enter_wrapper_is_not_unreleased(self):
+        # 진입만 하는 함수는 wrapper 로 보고, 부른 쪽에서 짝을 맞춘다
+        code = 'void f(void) {\n  portENTER_CRITICAL(&mux);\n  count++;\n}\n'
+        self.assertEqual(rules(code), [])
+
+    def test_unreleased(self):
+        code = 'void f(void) {\n  interrupts();\n  noInterrupts();\n  count++;\n}\n'
+        self.assertEqual(rules(code), [(CRITICAL, 'f')])
+
+
+class BusyWaitTest(unittest.TestCase):
+    def test_polling_millis(self):
+        code = 'void loop() {\n  unsigned long t = millis();\n  while (millis() - t < 50) {\n  }\n}\n'
+        self.assertEqual(rules(code), [(BUSY_WAIT, 'loop')])
+
+    def test_draining_serial_is_not_a_wait(self):
+        code = 'void loop() {\n  while (Serial.available()) {\n    Serial.read();\n  }\n}\n'
+        self.assertEqual(rules(code), [])
+
+    def test_waiting_for_serial(self):
+        code = 'void loop() {\n  while (!Serial.available()) {\n  }\n}\n'
+        self.assertEqual(rules(code), [(BUSY_WAIT, 'loop')])
+
+
+class FormatTest(unittest.TestCase):
+    def test_key_handler(self):
+        code = ('static void show(char key) {\n  char buf[8];\n  snprintf(buf, sizeof(buf), "%c", key);\n}\n'
+                'void loop() {\n  char key = keypad.getKey();\n  if (key) {\n    show(key);\n  }\n}\n')
+        self.assertEqual(rules(code), [(FORMAT, 'show')])
+
+    def test_isr(self):
+        code = ('void IRAM_ATTR on_edge(void *arg) {\n  char buf[8];\n  sprintf(buf, "%d", 1);\n}\n'
+                'void app_main(void) {\n  gpio_isr_handler_add(4, on_edge, NULL);\n}\n')
+        self.assertEqual(rules(code), [(FORMAT, 'on_edge')])
+
+    def test_periodic_task_is_not_hot(self):
+        # gpt4_1 i4: 1 초마다 LCD 두 줄을 만드는 task
+        code = ('static void lcd_update(void) {\n  char line[17];\n  snprintf(line, sizeof(line), "F%d", 1);\n}\n'
+                'static void elevator_task(void *arg) {\n  BaseType_t running = pdTRUE;\n'
+                '  while (running != pdFALSE) {\n    lcd_update();\n    vTaskDelay(pdMS_TO_TICKS(1000));\n  }\n}\n'
+                'void app_main(void) {\n  xTaskCreate(elevator_task, "e", 4096, NULL, 5, NULL);\n}\n')
+        self.assertEqual(rules(code), [])
+
+    def test_conditional_delay_does_not_pace(self):
+        code = ('void loop() {\n  char key = keypad.getKey();\n  char buf[8];\n'
+                '  snprintf(buf, sizeof(buf), "%c", key);\n  if (key == 0) {\n    delay(10);\n  }\n}\n')
+        self.assertIn((FORMAT, 'loop'), rules(code))
+
+    def test_setup_before_forever_loop_is_not_hot(self):
+        # gpt4_1 i2: app_main 이 한 번 묻고 나서 신호 주기를 돈다
+        code = ('void app_main(void) {\n  float t = 0;\n  printf("time: ");\n  scanf("%f", &t);\n'
+                '  while (1) {\n    gpio_set_level(2, 1);\n    vTaskDelay(pdMS_TO_TICKS((int)(t * 1000)));\n  }\n}\n')
+        self.assertEqual(rules(code), [])
+
+    def test_unpaced_forever_loop(self):
+        code = ('void app_main(void) {\n  printf("start\\n");\n  while (1) {\n'
+                '    if (gpio_get_level(4) == 0) {\n      printf("pressed\\n");\n    }\n  }\n}\n')
+        self.assertEqual([(f.rule, f.line) for f in realtime_check(code).findings if f.rule == FORMAT],
+                         [(FORMAT, 5)])
+
+
+class LocalCheckTest(unittest.TestCase):
+    def test_section_round_trips(self):
+        report = realtime_check('void loop() {\n  delay(100);\n}\n')
+        local = parse_eval_report(format_local_check(report)).local
+        self.assertEqual(list(local), list(RULE_ITEMS.values()))
+        self.assertEqual(parse_eval_report(format_local_check(report)).local_failures,
+                         [RULE_ITEMS[BLOCKING]])
+
+    def test_only_p9_gets_section(self):
+        code = 'void loop() {\n  delay(100);\n}\n'
+        self.assertEqual(with_local_check(['p8'], code, 'md'), 'md')
+        self.assertIn('LOCAL CHECK', with_local_check(['p9'], code, 'md'))
+        self.assertEqual(with_local_check(['p9'], '', 'md'), 'md')
+
+
+if __name__ == '__main__':
+    unittest.main()
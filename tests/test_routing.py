@@ -0,0 +1,145 @@
+"""routing: tier 선택, escalation, 사용량 집계와 PipeAgent 의 routed 실행."""
+
+import sys
+import tempfile
+import unittest
+from pathlib import Path
+from types import SimpleNamespace
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[1] / 'src'))
+
+from routing import DEFAULT_POLICY, EVALUATION, GENERATION, ModelRouter, RoutingPolicy
+from util.compaction import CompactionResult, TokenBudgetExceeded
+from util.usage import UsageRecord
+
+
+class FakeModel:
+    model_name = 'fake'
+
+    def invoke(self, messages):
+        return SimpleNamespace(content='ok', usage_metadata={'input_tokens': 1000, 'output_tokens': 500})
+
+
+class PolicyTest(unittest.TestCase):
+    def setUp(self):
+        self.policy = RoutingPolicy.from_file(DEFAULT_POLICY)
+
+    def test_tier_for_uses_strongest_prompt(self):
+        self.assertEqual(self.policy.tier_for(GENERATION, ['p7']), 'small')
+        self.assertEqual(self.policy.tier_for(GENERATION, ['p7', 'p5']), 'large')
+        self.assertEqual(self.policy.tier_for(EVALUATION, ['p2']), 'medium')
+        self.assertEqual(self.policy.tier_for(EVALUATION, []), 'medium')
+
+    def test_escalate_stops_at_top(self):
+        self.assertEqual(self.policy.escalate('small'), 'medium')
+        self.assertEqual(self.policy.escalate('medium'), 'large')
+        self.assertIsNone(self.policy.escalate('large'))
+
+    def test_single_never_escalates(self):
+        single = self.policy.single()
+        self.assertEqual(single.tier_for(GENERATION, ['p7']), 'large')
+        self.assertIsNone(single.escalate('large'))
+
+    def test_unknown_tier_is_rejected(self):
+        with tempfile.NamedTemporaryFile('w', suffix='.toml', delete=False) as fp:
+            fp.write('[tiers.small]\nmodel = "m"\n\n[generation]\ndefault = "huge"\n')
+        with self.assertRaises(ValueError):
+            RoutingPolicy.from_file(fp.name)
+        Path(fp.name).unlink()
+
+
+class RouterTest(unittest.TestCase):
+    def test_invoke_records_usage_and_report(self):
+        router = ModelRouter.from_file()
+        router.model = lambda tier: FakeModel()
+        router.invoke(GENERATION, 'p7', 'small', ['hello'])
+        router.invoke(GENERATION, 'p7', 'large', ['hello'])
+        self.assertEqual([r.tier for r in router.ledger.records], ['small', 'large'])
+        report = router.report()
+        self.assertEqual(report.calls, 2)
+        small, large = router.policy.tiers['small'], router.policy.tiers['large']
+        self.assertAlmostEqual(report.cost, small.cost(1000, 500) + large.cost(1000, 500))
+        self.assertAlmostEqual(report.baseline_cost, 2 * large.cost(1000, 500))
+        self.assertEqual(report.by_prompt['generation/p7'][0], 2)
+
+
+class RoutedAgentTest(unittest.TestCase):
+    """LLM 호출 대신 _run_stage_on / _gate_failure 를 바꿔 끼워 escalation 흐름만 본다."""
+
+    def agent(self, steps, gate=None):
+        from pipe_agent import PipeAgent
+        router = ModelRouter.from_file()
+        agent = PipeAgent(router=router, llm=FakeModel())
+        tiers, gates = [], []
+
+        def run_stage_on(pname, code, user_msg, tier=None):
+            tiers.append(tier)
+            step = steps[len(tiers) - 1]
+            if isinstance(step, Exception):
+                raise step
+            return step
+
+        def gate_failure(pname, code, out, user_msg):
+            gates.append(out)
+            return gate(out) if gate else None
+
+        agent._run_stage_on = run_stage_on
+        agent._gate_failure = gate_failure
+        return agent, tiers, gates
+
+    def test_local_stage_skips_gate_while_other_calls_run(self):
+        agent, tiers, gates = self.agent([])
+
+        def run_stage_on(pname, code, user_msg, tier=None):
+            # best-of-N 의 다른 후보 thread 가 그 사이에 LLM 을 부른 상황
+            agent.router.ledger.add(UsageRecord(GENERATION, pname, tier, 'fake', 1, 1, 0.0))
+            tiers.append(tier)
+            return 'local', False
+
+        agent._run_stage_on = run_stage_on
+        self.assertEqual(agent._run_routed('p8', 'int x;', ''), 'local')
+        self.assertEqual(tiers, ['small'])
+        self.assertEqual(gates, [])
+
+    def test_gate_failure_escalates_once(self):
+        agent, tiers, gates = self.agent([('bad', True), ('still bad', True)], gate=lambda out: 'compile failed')
+        self.assertEqual(agent._run_routed('p7', 'int x;', ''), 'still bad')
+        self.assertEqual(tiers, ['small', 'medium'])
+        self.assertEqual(gates, ['bad'])
+
+    def test_budget_escalation_is_not_counted(self):
+        result = CompactionResult('', 10, 10, [], True)
+        over = TokenBudgetExceeded('refine', ['p7'], result, 1)
+        agent, tiers, gates = self.agent([over, ('bad', True), ('good', True)],
+                                         gate=lambda out: 'compile failed' if out == 'bad' else None)
+        self.assertEqual(agent._run_routed('p7', 'int x;', ''), 'good')
+        self.assertEqual(tiers, ['small', 'medium', 'large'])
+
+
+class GateTest(unittest.TestCase):
+    """평가 결과 markdown 만 바꿔 끼워 _gate_failure 의 판정을 본다."""
+
+    def gate(self, markdown):
+        from dataclasses import replace
+        from pipe_agent import PipeAgent
+        router = ModelRouter.from_file()
+        router.policy = replace(router.policy, on_compile_fail=False, on_eval_fail=True, min_compliance=80.0)
+        agent = PipeAgent(router=router, llm=FakeModel())
+        agent._gate_evaluator = SimpleNamespace(invoke=lambda *args, **kwargs: markdown)
+        return agent._gate_failure('p9', '', 'void loop() {}', '')
+
+    def test_low_compliance_fails(self):
+        self.assertEqual(self.gate('Compliance Rate: 50%'), 'compliance 50.0% < 80.0%')
+
+    def test_local_fail_fails_despite_compliance(self):
+        md = ('Compliance Rate: 100%\n\n'
+              'Local_Item: Non-blocking control flow\nStatus: PASS\nReason: -\n\n'
+              'Local_Item: No busy-waits\nStatus: FAIL\nReason: loop:3 ...\n')
+        self.assertEqual(self.gate(md), 'local check failed (No busy-waits)')
+
+    def test_all_pass(self):
+        self.assertIsNone(self.gate('Compliance Rate: 100%\n\nLocal_Item: No busy-waits\nStatus: PASS\n'))
+
+
+if __name__ == '__main__':
+    unittest.main()